@@ -106,30 +106,37 @@ void AutoComplete::ClearDemofileList() {
 }
 
 void AutoComplete::AddSymbols(wxString xml) {
-  if(m_addSymbols_backgroundThread.joinable())
-    m_addSymbols_backgroundThread.join();
+  m_addSymbols_backgroundThread.Wait();
 
   if((m_configuration->UseThreads() && xml.Length() > 300))
-    m_addSymbols_backgroundThread = jthread(&AutoComplete::AddSymbols_Backgroundtask_string,
-                                                this, std::move(xml));
+    m_addSymbols_backgroundThread =
+      ThreadPool::Get().Submit(ThreadPool::indexing, [this, xml] {
+        AddSymbols_Backgroundtask_string(xml);
+      });
   else
     AddSymbols_Backgroundtask_string(std::move(xml));
 }
 
 void AutoComplete::AddSymbols(wxXmlDocument xml) {
-  if(m_addSymbols_backgroundThread.joinable())
+  if(m_addSymbols_backgroundThread.Pending())
     {
       wxLogMessage(_("Waiting for m_addSymbols_backgroundThread to finish"));
-      m_addSymbols_backgroundThread.join();
+      m_addSymbols_backgroundThread.Wait();
     }
   wxLogMessage(_("Scheduling a background task that compiles a new list "
                  "of autocompletable maxima commands."));
 
   if(m_configuration->UseThreads())
-    m_addSymbols_backgroundThread = jthread(&AutoComplete::AddSymbols_Backgroundtask,
-                                                this, std::move(xml));
+    {
+      // Shared, so the task's closure can be copied without copying the document
+      auto xmldoc = std::make_shared<wxXmlDocument>(xml);
+      m_addSymbols_backgroundThread =
+        ThreadPool::Get().Submit(ThreadPool::indexing, [this, xmldoc] {
+          AddSymbols_Backgroundtask(*xmldoc);
+        });
+    }
   else
-    AddSymbols_Backgroundtask(std::move(xml));
+    AddSymbols_Backgroundtask(xml);
 }
 
 void AutoComplete::AddSymbols_Backgroundtask_string(wxString xml) {
@@ -139,7 +146,7 @@ void AutoComplete::AddSymbols_Backgroundtask_string(wxString xml) {
   AddSymbols_Backgroundtask(xmldoc);
 }
 
-void AutoComplete::AddSymbols_Backgroundtask(wxXmlDocument xmldoc) {
+void AutoComplete::AddSymbols_Backgroundtask(const wxXmlDocument &xmldoc) {
   wxXmlNode *node = xmldoc.GetRoot();
   if (node != NULL) {
     wxXmlNode *children = node->GetChildren();
@@ -216,10 +223,8 @@ void AutoComplete::AddWorksheetWords(const WordList &words) {
 }
 
 AutoComplete::~AutoComplete() {
-   if (m_addSymbols_backgroundThread.joinable())
-     m_addSymbols_backgroundThread.join();
-   if(m_addFiles_backgroundThread.joinable())
-     m_addFiles_backgroundThread.join();
+   m_addSymbols_backgroundThread.Wait();
+   m_addFiles_backgroundThread.Wait();
 }
 
 void AutoComplete::LoadSymbols() {
@@ -229,22 +234,26 @@ void AutoComplete::LoadSymbols() {
   wxString demodir = m_configuration->MaximaDemoDir();
   demodir.Replace("\n", "");
   demodir.Replace("\r", "");
-  if(m_addFiles_backgroundThread.joinable())
+  if(m_addFiles_backgroundThread.Pending())
     {
       wxLogMessage(_("Waiting for m_addFiles_backgroundThread to finish"));
-      m_addFiles_backgroundThread.join();
+      m_addFiles_backgroundThread.Wait();
     }
-  if(m_addSymbols_backgroundThread.joinable())
+  if(m_addSymbols_backgroundThread.Pending())
     {
       wxLogMessage(_("Waiting for m_addSymbols_backgroundThread to finish"));
-      m_addSymbols_backgroundThread.join();
+      m_addSymbols_backgroundThread.Wait();
     }
   if(m_configuration->UseThreads())
     {
-      m_addSymbols_backgroundThread = jthread(&AutoComplete::BuiltinSymbols_BackgroundTask,
-                                              this);
-      m_addFiles_backgroundThread = jthread(&AutoComplete::LoadableFiles_BackgroundTask,
-                                            this, sharedir, demodir);
+      m_addSymbols_backgroundThread =
+        ThreadPool::Get().Submit(ThreadPool::indexing, [this] {
+          BuiltinSymbols_BackgroundTask();
+        });
+      m_addFiles_backgroundThread =
+        ThreadPool::Get().Submit(ThreadPool::indexing, [this, sharedir, demodir] {
+          LoadableFiles_BackgroundTask(sharedir, demodir);
+        });
     }
   else
     {
@@ -30,7 +30,6 @@
 #ifndef AUTOCOMPLETE_H
 #define AUTOCOMPLETE_H
 
-#include <thread>
 #include <algorithm>
 #include <memory>
 #include <mutex>
@@ -43,6 +42,7 @@
 #include <wx/regex.h>
 #include <wx/filename.h>
 #include <wx/hashmap.h>
+#include "ThreadPool.h"
 #include "Configuration.h"
 #include "precomp.h"
 #include "Version.h"
@@ -99,7 +99,7 @@ public:
   //! The real work of AddSymbols is made here and in the background
   void AddSymbols_Backgroundtask_string(wxString xml);
   //! The real work of AddSymbols is made here and in the background
-  void AddSymbols_Backgroundtask(wxXmlDocument xmldoc);
+  void AddSymbols_Backgroundtask(const wxXmlDocument &xmldoc);
 
 
   //! Replace the list of files in the directory the worksheet file is in to the demo files list
@@ -324,8 +324,8 @@ private:
       }
   };
 
-  jthread m_addSymbols_backgroundThread;
-  jthread m_addFiles_backgroundThread;
+  ThreadPool::Task m_addSymbols_backgroundThread;
+  ThreadPool::Task m_addFiles_backgroundThread;
   //! Is locked when someone accesses a keyword list
   std::mutex m_keywordsLock;
   //! The lists of autocompletable symbols for the classes defined in autoCompletionType
@@ -0,0 +1,208 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  Defines BatchRenderer, which renders the outputs of .wxmx files to image files.
+*/
+
+#include "BatchRenderer.h"
+#include "MathParser.h"
+#include "ThreadPool.h"
+#include "WxmxArchive.h"
+#include "WxmxRecovery.h"
+#include "graphical_io/BitmapOut.h"
+#include "graphical_io/SVGout.h"
+#include <atomic>
+#include <wx/filename.h>
+#include <wx/log.h>
+#include <wx/mstream.h>
+#include <wx/tokenzr.h>
+#include <wx/xml/xml.h>
+
+BatchRenderer::BatchRenderer(const wxString &outputDir, Format format):
+  m_outputDir(outputDir),
+  m_format(format),
+  m_bitmap(1, 1),
+  m_configuration(&m_dc),
+  m_configPointer(&m_configuration)
+{
+  m_dc.SelectObject(m_bitmap);
+}
+
+bool BatchRenderer::SelectCells(const wxString &list) {
+  m_cells.clear();
+  wxStringTokenizer ranges(list, wxS(","));
+  while (ranges.HasMoreTokens()) {
+    wxString range = ranges.GetNextToken().Trim(true).Trim(false);
+    long first, last;
+    if (!range.BeforeFirst(wxS('-')).ToLong(&first))
+      return false;
+    if (!range.Contains(wxS("-")))
+      last = first;
+    else if (!range.AfterFirst(wxS('-')).ToLong(&last))
+      return false;
+    if ((first < 1) || (last < first))
+      return false;
+    m_cells.push_back({first, last});
+  }
+  return true;
+}
+
+bool BatchRenderer::IsSelected(long cell) const {
+  if (m_cells.empty())
+    return true;
+  for (const auto &range : m_cells)
+    if ((cell >= range.first) && (cell <= range.second))
+      return true;
+  return false;
+}
+
+std::unique_ptr<GroupCell> BatchRenderer::Load(const wxString &file) {
+  std::shared_ptr<const WxmxArchive> archive = WxmxArchive::Open(file);
+  std::unique_ptr<wxInputStream> contents;
+  if (archive)
+    contents = archive->OpenEntry(wxS("content.xml"));
+  if (!contents) {
+    wxLogMessage(_("Render: %s doesn't contain a wxMaxima document"), file);
+    return nullptr;
+  }
+
+  wxXmlDocument xmldoc;
+#if wxCHECK_VERSION(3, 3, 0)
+  xmldoc.Load(*contents, wxXMLDOC_KEEP_WHITESPACE_NODES);
+#else
+  xmldoc.Load(*contents, wxS("UTF-8"), wxXMLDOC_KEEP_WHITESPACE_NODES);
+#endif
+  if (!xmldoc.IsOk()) {
+    // Render what can be recovered from a damaged document
+    wxLogMessage(_("Render: Trying to recover a broken .wxmx file."));
+    contents = archive->OpenEntry(wxS("content.xml"));
+    WxmxRecovery recovery;
+    std::vector<char> buffer(1 << 16);
+    while (contents->IsOk() && !contents->Eof()) {
+      contents->Read(buffer.data(), buffer.size());
+      recovery.Feed(buffer.data(), contents->LastRead());
+    }
+    std::string recovered = recovery.Finish();
+    if (!recovered.empty()) {
+      wxMemoryInputStream istream(recovered.data(), recovered.size());
+#if wxCHECK_VERSION(3, 3, 0)
+      xmldoc.Load(istream, wxXMLDOC_KEEP_WHITESPACE_NODES);
+#else
+      xmldoc.Load(istream, wxS("UTF-8"), wxXMLDOC_KEEP_WHITESPACE_NODES);
+#endif
+    }
+  }
+  if ((!xmldoc.IsOk()) || (xmldoc.GetRoot()->GetName() != wxS("wxMaximaDocument"))) {
+    wxLogMessage(_("Render: %s doesn't contain a wxMaxima document"), file);
+    return nullptr;
+  }
+
+  MathParser mp(&m_configuration, file);
+  CellListBuilder<GroupCell> tree;
+  for (wxXmlNode *xmlcells = xmldoc.GetRoot()->GetChildren(); xmlcells;
+       xmlcells = xmlcells->GetNext()) {
+    if (xmlcells->GetType() != wxXML_TEXT_NODE)
+      tree.DynamicAppend(mp.ParseTag(xmlcells, false));
+  }
+  /* The warning from gcc is correct. But an old MacOs compiler errors out
+     on correct code, here. */
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wredundant-move"
+#endif
+  return std::move(tree);
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+}
+
+bool BatchRenderer::Render(const wxString &file) {
+  auto tree = Load(file);
+  if (!tree)
+    return false;
+  if (!wxDirExists(m_outputDir) &&
+      !wxFileName::Mkdir(m_outputDir, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL)) {
+    wxLogMessage(_("Render: Cannot create the directory %s"), m_outputDir);
+    return false;
+  }
+  wxString name = wxFileName(file).GetName();
+
+  // Cells can only be drawn in the GUI thread. Compressing the bitmaps into
+  // .png files is the slow part, though, and is done in the background. Only
+  // the task may access its image: wxImage's reference counting isn't
+  // thread-safe.
+  std::vector<ThreadPool::Task> tasks;
+  std::atomic<bool> filesOK(true);
+  // Only files that actually have been written count as images.
+  std::atomic<std::size_t> written(0);
+  long cell = 0;
+  for (GroupCell &group : OnList(tree.get())) {
+    cell++;
+    if ((!group.GetOutput()) || (!IsSelected(cell)))
+      continue;
+    wxString imageFile = m_outputDir + wxS("/") +
+      wxString::Format(wxS("%s_%li."), name, cell);
+    auto output = group.GetOutput()->CopyList(&group);
+    if (m_format == svg) {
+      wxString svgFile = imageFile + wxS("svg");
+      {
+        // Svgout changes the working directory until it is destroyed, which
+        // would change what a relative svgFile points to.
+        Svgout svgout(&m_configPointer, std::move(output), svgFile);
+        if (!svgout.IsOk()) {
+          wxLogMessage(_("Render: Cannot render cell %li of %s"), cell, file);
+          filesOK = false;
+          continue;
+        }
+      }
+      if (wxFileExists(svgFile))
+        written++;
+      else
+        filesOK = false;
+    } else {
+      BitmapOut bitmap(&m_configPointer, std::move(output), m_configuration.BitmapScale());
+      if (!bitmap.IsOk()) {
+        wxLogMessage(_("Render: Cannot render cell %li of %s"), cell, file);
+        filesOK = false;
+        continue;
+      }
+      auto image = std::make_shared<wxImage>(bitmap.ToImage());
+      wxString pngFile = imageFile + wxS("png");
+      std::function<void()> save = [image, pngFile, &filesOK, &written] {
+        if (image->SaveFile(pngFile, wxBITMAP_TYPE_PNG))
+          written++;
+        else
+          filesOK = false;
+      };
+      if (Configuration::UseThreads())
+        tasks.push_back(ThreadPool::Get().Submit(ThreadPool::visible, std::move(save)));
+      else
+        save();
+    }
+  }
+  for (auto &task : tasks)
+    task.Wait();
+  m_images += written;
+  if (!filesOK)
+    wxLogMessage(_("Render: Not all images of %s could be written"), file);
+  return filesOK;
+}
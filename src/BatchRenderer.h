@@ -0,0 +1,105 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  Declares BatchRenderer, which renders the outputs of .wxmx files to image files.
+*/
+
+#ifndef BATCHRENDERER_H
+#define BATCHRENDERER_H
+
+#include "precomp.h"
+#include "Configuration.h"
+#include "cells/GroupCell.h"
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <wx/bitmap.h>
+#include <wx/dcmemory.h>
+#include <wx/string.h>
+
+/*! Renders the outputs of the cells of .wxmx files to .png or .svg files
+
+  Is used by the --render command-line option and doesn't need a window:
+  The cells are laid out using a configuration of its own that reads the
+  style settings from the config file.
+
+  The output of the cell number n of the document "doc.wxmx" is written to
+  the file "doc_n.png" or "doc_n.svg" in the output directory, cells counting
+  from 1. Cells without output don't produce a file.
+*/
+class BatchRenderer
+{
+public:
+  enum Format
+  {
+    png,
+    svg
+  };
+
+  /*! The constructor
+
+    \param outputDir The directory the image files are written to. Is created
+    if it doesn't exist.
+    \param format The format of the image files
+  */
+  explicit BatchRenderer(const wxString &outputDir, Format format = png);
+
+  /*! Selects the cells whose outputs are rendered
+
+    \param list A comma-separated list of cell numbers and ranges of cell
+    numbers, for example "1,4,7-9". An empty list selects all cells.
+    \return false, if the list cannot be read.
+  */
+  bool SelectCells(const wxString &list);
+
+  /*! Renders the outputs of the selected cells of a .wxmx file
+
+    \return false, if the file cannot be read or an image file cannot be written.
+  */
+  bool Render(const wxString &file);
+
+  //! The number of image files that have been written
+  std::size_t GetImages() const { return m_images; }
+
+private:
+  //! Reads the cells of a .wxmx file
+  std::unique_ptr<GroupCell> Load(const wxString &file);
+  //! Is the output of the cell number "cell" to be rendered?
+  bool IsSelected(long cell) const;
+
+  wxString m_outputDir;
+  Format m_format;
+  //! The ranges of cell numbers that are to be rendered. Empty = all cells.
+  std::vector<std::pair<long, long>> m_cells;
+  //! The bitmap m_dc draws to. The DC needs one to report its resolution.
+  wxBitmap m_bitmap;
+  //! The context the cells are laid out for
+  wxMemoryDC m_dc;
+  //! The configuration the outputs are rendered with
+  Configuration m_configuration;
+  //! The renderers want a pointer to a pointer to the configuration
+  Configuration *m_configPointer;
+  std::size_t m_images = 0;
+};
+
+#endif // BATCHRENDERER_H
@@ -87,6 +87,15 @@ void CellPointers::ErrorList::Add(GroupCell *cell) {
   m_errors.emplace_back(cell);
 }
 
+void CellPointers::WaitForImage(GroupCell *group) {
+  if (!group)
+    return;
+  // An animation or a group with several images asks for every image.
+  if ((!m_groupsWaitingForImages.empty()) && (m_groupsWaitingForImages.back() == group))
+    return;
+  m_groupsWaitingForImages.emplace_back(group);
+}
+
 void CellPointers::SetWorkingGroup(GroupCell *group) {
   if (group)
     m_lastWorkingGroup = group;
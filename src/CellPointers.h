@@ -167,6 +167,15 @@ public:
   */
   CellPtr<Cell> m_selectionEnd;
 
+  /*! Remembers a group that has been laid out for an image that is still being loaded
+
+    The worksheet lays these groups out again as soon as an image has been
+    loaded.
+  */
+  void WaitForImage(GroupCell *group);
+  //! The groups WaitForImage() has remembered
+  std::vector<CellPtr<GroupCell>> m_groupsWaitingForImages;
+
   void SetTimerIdForCell(Cell *cell, int timerId);
   int GetTimerIdForCell(Cell *cell) const;
   Cell *GetCellForTimerId(int timerId) const;
@@ -31,8 +31,10 @@
 #include "cells/Cell.h"
 #include "cells/TextStyle.h"
 #include "Dirstructure.h"
+#include "ImageCacheBudget.h"
 #include "StringUtils.h"
 #include <wx/config.h>
+#include <wx/datstrm.h>
 #include <wx/fileconf.h>
 #include <wx/font.h>
 #include <wx/mimetype.h>
@@ -48,7 +50,7 @@
 
 Configuration::Configuration(wxDC *dc, InitOpt options) :
   m_initOpts(options),
-  m_eng{m_rd()},
+  m_eng{std::random_device()()},
   m_dc(dc)
 {
   wxConfigBase *config = wxConfig::Get();
@@ -145,38 +147,38 @@ Configuration::Configuration(wxDC *dc, InitOpt options) :
       m_colorOnlyStyles.push_back(TS_EQUALSSELECTION);
       m_colorOnlyStyles.push_back(TS_OUTDATED);
     }
-  m_maximaOperators[wxS("(")] = 1;
-  m_maximaOperators[wxS("/")] = 1;
-  m_maximaOperators[wxS("{")] = 1;
-  m_maximaOperators[wxS("-")] = 1;
-  m_maximaOperators[wxS("^")] = 1;
-  m_maximaOperators[wxS("#")] = 1;
-  m_maximaOperators[wxS("=")] = 1;
-  m_maximaOperators[wxS(":")] = 1;
-  m_maximaOperators[wxS("[")] = 1;
-  m_maximaOperators[wxS("'")] = 1;
-  m_maximaOperators[wxS("!")] = 1;
-  m_maximaOperators[wxS("+")] = 1;
-  m_maximaOperators[wxS("*")] = 1;
-  m_maximaOperators[wxS("or")] = 1;
-  m_maximaOperators[wxS("and")] = 1;
-  m_maximaOperators[wxS("do_in")] = 1;
-  m_maximaOperators[wxS(">")] = 1;
-  m_maximaOperators[wxS("$SUBVAR")] = 1;
-  m_maximaOperators[wxS("<")] = 1;
-  m_maximaOperators[wxS("if")] = 1;
-  m_maximaOperators[wxS("::=")] = 1;
-  m_maximaOperators[wxS("::")] = 1;
-  m_maximaOperators[wxS("@")] = 1;
-  m_maximaOperators[wxS(".")] = 1;
-  m_maximaOperators[wxS("-->")] = 1;
-  m_maximaOperators[wxS("^^")] = 1;
-  m_maximaOperators[wxS("not")] = 1;
-  m_maximaOperators[wxS("<=")] = 1;
-  m_maximaOperators[wxS(":=")] = 1;
-  m_maximaOperators[wxS(">=")] = 1;
-  m_maximaOperators[wxS("$BFLOAT")] = 1;
-  m_maximaOperators[wxS("do")] = 1;
+  m_shared->maximaOperators[wxS("(")] = 1;
+  m_shared->maximaOperators[wxS("/")] = 1;
+  m_shared->maximaOperators[wxS("{")] = 1;
+  m_shared->maximaOperators[wxS("-")] = 1;
+  m_shared->maximaOperators[wxS("^")] = 1;
+  m_shared->maximaOperators[wxS("#")] = 1;
+  m_shared->maximaOperators[wxS("=")] = 1;
+  m_shared->maximaOperators[wxS(":")] = 1;
+  m_shared->maximaOperators[wxS("[")] = 1;
+  m_shared->maximaOperators[wxS("'")] = 1;
+  m_shared->maximaOperators[wxS("!")] = 1;
+  m_shared->maximaOperators[wxS("+")] = 1;
+  m_shared->maximaOperators[wxS("*")] = 1;
+  m_shared->maximaOperators[wxS("or")] = 1;
+  m_shared->maximaOperators[wxS("and")] = 1;
+  m_shared->maximaOperators[wxS("do_in")] = 1;
+  m_shared->maximaOperators[wxS(">")] = 1;
+  m_shared->maximaOperators[wxS("$SUBVAR")] = 1;
+  m_shared->maximaOperators[wxS("<")] = 1;
+  m_shared->maximaOperators[wxS("if")] = 1;
+  m_shared->maximaOperators[wxS("::=")] = 1;
+  m_shared->maximaOperators[wxS("::")] = 1;
+  m_shared->maximaOperators[wxS("@")] = 1;
+  m_shared->maximaOperators[wxS(".")] = 1;
+  m_shared->maximaOperators[wxS("-->")] = 1;
+  m_shared->maximaOperators[wxS("^^")] = 1;
+  m_shared->maximaOperators[wxS("not")] = 1;
+  m_shared->maximaOperators[wxS("<=")] = 1;
+  m_shared->maximaOperators[wxS(":=")] = 1;
+  m_shared->maximaOperators[wxS(">=")] = 1;
+  m_shared->maximaOperators[wxS("$BFLOAT")] = 1;
+  m_shared->maximaOperators[wxS("do")] = 1;
   m_maximaHelpFormat = frontend;
   m_printing = false;
   m_clipToDrawRegion = true;
@@ -192,7 +194,34 @@ Configuration::Configuration(wxDC *dc, InitOpt options) :
                          "\u2264\u2265\u2211\u2260+-*/^:=#'!()[]{}"));
   for (wxString::const_iterator it = operators.begin(); it != operators.end();
        ++it)
-    m_maximaOperators[wxString(*it)] = 1;
+    m_shared->maximaOperators[wxString(*it)] = 1;
+}
+
+Configuration::Configuration(const Configuration &base, wxDC *dc) :
+  Configuration(base)
+{
+  m_initOpts = temporary;
+  m_dc = dc;
+  m_workSheet = NULL;
+  m_worksheetDC.reset();
+  m_cellRedrawTrace.reset();
+  m_filesToSave.clear();
+  m_lastActiveTextCtrl = NULL;
+  m_eng.seed(std::random_device()());
+  // The cells we get were laid out for the screen
+  RecalculateForce();
+}
+
+void Configuration::UnshareStyles()
+{
+  if (m_shared.use_count() > 1)
+    m_shared = std::make_shared<SharedStyles>(*m_shared);
+}
+
+void Configuration::AddMaximaOperator(const wxString &name)
+{
+  UnshareStyles();
+  m_shared->maximaOperators[name] = 1;
 }
 
 void Configuration::SetWorkSheet(wxWindow *workSheet)
@@ -242,10 +271,12 @@ void Configuration::ResetAllToDefaults() {
   m_printMargin_Right = 10;
 
   m_wizardTab = 0;
-  for (const auto &i : m_renderableChars)
-    m_renderableChars[i.first].Clear();
-  for (const auto &i : m_nonRenderableChars)
-    m_nonRenderableChars[i.first].Clear();
+  {
+    const std::lock_guard<std::mutex> lock(m_glyphCoverageMutex);
+    for (auto &i : m_glyphCoverage)
+      i.second.Clear();
+    m_glyphCoverageChanged = true;
+  }
   m_showAllDigits = false;
   m_lineBreaksInLongNums = false;
   m_autoSaveMinutes = 3;
@@ -295,6 +326,7 @@ void Configuration::ResetAllToDefaults() {
 
   m_TeXExponentsAfterSubscript = false;
   m_saveUntitled = true;
+  m_verifySavedFiles = false;
   m_cursorJump = true;
   m_autoSaveAsTempFile = false;
   m_htmlEquationFormat = mathJaX_TeX;
@@ -323,6 +355,7 @@ void Configuration::ResetAllToDefaults() {
   m_abortOnError = true;
   m_defaultPort = 49152;
   m_maxGnuplotMegabytes = 12;
+  m_imageCacheMegabytes = 256;
   m_indentMaths = true;
   m_indent = -1;
   m_autoSubscript = 2;
@@ -479,60 +512,61 @@ static const Configuration::EscCodeContainer &EscCodes() {
 }
 
 void Configuration::InitStyles() {
+  UnshareStyles();
   m_showInputLabels = true;
-  std::fill(std::begin(m_styles), std::end(m_styles), Style{});
+  std::fill(std::begin(m_shared->styles), std::end(m_shared->styles), Style{});
 
   Style defaultStyle;
 
   // TODO It's a fat chance that this font actually will be monospace.
   wxFont monospace(10, wxFONTFAMILY_MODERN, wxFONTSTYLE_NORMAL,
                    wxFONTWEIGHT_NORMAL);
-  m_styles[TS_ASCIIMATHS].SetFontName(monospace.GetFaceName());
-  m_styles[TS_ASCIIMATHS].FontSize(12.0);
-  m_styles[TS_TEXT].SetFontName(monospace.GetFaceName());
-  m_styles[TS_TEXT].FontSize(12.0);
-  m_styles[TS_MATH].FontSize(12.0);
-
-  m_styles[TS_TEXT].FontSize(12);
-  m_styles[TS_CODE_VARIABLE].Color(0, 128, 0).Slant();
-  m_styles[TS_CODE_FUNCTION].Color(128, 0, 0).Slant();
-  m_styles[TS_CODE_COMMENT].Color(64, 64, 64).Slant();
-  m_styles[TS_CODE_NUMBER].Color(128, 64, 0).Slant();
-  m_styles[TS_CODE_STRING].Color(0, 0, 128).Slant();
-  m_styles[TS_CODE_OPERATOR].Slant();
-  m_styles[TS_CODE_LISP].Color(255, 0, 128).Slant();
-  m_styles[TS_CODE_ENDOFLINE].Color(128, 128, 128).Slant();
-  m_styles[TS_GREEK_CONSTANT].Slant();
-  m_styles[TS_HEADING6].Bold().FontSize(14);
-  m_styles[TS_HEADING5].Bold().FontSize(15);
-  m_styles[TS_SUBSUBSECTION].Bold().FontSize(16);
-  m_styles[TS_SUBSECTION].Bold().FontSize(16);
-  m_styles[TS_SECTION].Bold().Slant().FontSize(18);
-  m_styles[TS_TITLE].Bold().Underlined().FontSize(24);
-  m_styles[TS_WARNING].Color(wxS("orange")).Bold().FontSize(12);
-  m_styles[TS_ERROR].Color(*wxRED).FontSize(12);
-  m_styles[TS_MAIN_PROMPT].Color(255, 128, 128);
-  m_styles[TS_OTHER_PROMPT].Color(*wxRED).Slant();
-  m_styles[TS_LABEL].Color(255, 192, 128);
-  m_styles[TS_USERLABEL].Color(255, 64, 0);
-  // m_styles[TS_SPECIAL_CONSTANT];
-  m_styles[TS_CODE_DEFAULT].Bold().Slant().FontSize(12);
-  // m_styles[TS_NUMBER];
-  m_styles[TS_STRING].Slant();
-  // m_styles[TS_GREEK_CONSTANT];
-  m_styles[TS_VARIABLE].Slant();
-  // m_styles[TS_FUNCTION];
-  m_styles[TS_HIGHLIGHT].Color(*wxRED);
-  m_styles[TS_TEXT_BACKGROUND].Color(*wxWHITE);
-  m_styles[TS_DOCUMENT_BACKGROUND].Color(*wxWHITE);
-  // m_styles[TS_CELL_BRACKET];
-  m_styles[TS_ACTIVE_CELL_BRACKET].Color(*wxRED);
-  // m_styles[TS_CURSOR];
-  m_styles[TS_SELECTION].Color(wxSYS_COLOUR_HIGHLIGHT);
-  m_styles[TS_EQUALSSELECTION]
+  m_shared->styles[TS_ASCIIMATHS].SetFontName(monospace.GetFaceName());
+  m_shared->styles[TS_ASCIIMATHS].FontSize(12.0);
+  m_shared->styles[TS_TEXT].SetFontName(monospace.GetFaceName());
+  m_shared->styles[TS_TEXT].FontSize(12.0);
+  m_shared->styles[TS_MATH].FontSize(12.0);
+
+  m_shared->styles[TS_TEXT].FontSize(12);
+  m_shared->styles[TS_CODE_VARIABLE].Color(0, 128, 0).Slant();
+  m_shared->styles[TS_CODE_FUNCTION].Color(128, 0, 0).Slant();
+  m_shared->styles[TS_CODE_COMMENT].Color(64, 64, 64).Slant();
+  m_shared->styles[TS_CODE_NUMBER].Color(128, 64, 0).Slant();
+  m_shared->styles[TS_CODE_STRING].Color(0, 0, 128).Slant();
+  m_shared->styles[TS_CODE_OPERATOR].Slant();
+  m_shared->styles[TS_CODE_LISP].Color(255, 0, 128).Slant();
+  m_shared->styles[TS_CODE_ENDOFLINE].Color(128, 128, 128).Slant();
+  m_shared->styles[TS_GREEK_CONSTANT].Slant();
+  m_shared->styles[TS_HEADING6].Bold().FontSize(14);
+  m_shared->styles[TS_HEADING5].Bold().FontSize(15);
+  m_shared->styles[TS_SUBSUBSECTION].Bold().FontSize(16);
+  m_shared->styles[TS_SUBSECTION].Bold().FontSize(16);
+  m_shared->styles[TS_SECTION].Bold().Slant().FontSize(18);
+  m_shared->styles[TS_TITLE].Bold().Underlined().FontSize(24);
+  m_shared->styles[TS_WARNING].Color(wxS("orange")).Bold().FontSize(12);
+  m_shared->styles[TS_ERROR].Color(*wxRED).FontSize(12);
+  m_shared->styles[TS_MAIN_PROMPT].Color(255, 128, 128);
+  m_shared->styles[TS_OTHER_PROMPT].Color(*wxRED).Slant();
+  m_shared->styles[TS_LABEL].Color(255, 192, 128);
+  m_shared->styles[TS_USERLABEL].Color(255, 64, 0);
+  // m_shared->styles[TS_SPECIAL_CONSTANT];
+  m_shared->styles[TS_CODE_DEFAULT].Bold().Slant().FontSize(12);
+  // m_shared->styles[TS_NUMBER];
+  m_shared->styles[TS_STRING].Slant();
+  // m_shared->styles[TS_GREEK_CONSTANT];
+  m_shared->styles[TS_VARIABLE].Slant();
+  // m_shared->styles[TS_FUNCTION];
+  m_shared->styles[TS_HIGHLIGHT].Color(*wxRED);
+  m_shared->styles[TS_TEXT_BACKGROUND].Color(*wxWHITE);
+  m_shared->styles[TS_DOCUMENT_BACKGROUND].Color(*wxWHITE);
+  // m_shared->styles[TS_CELL_BRACKET];
+  m_shared->styles[TS_ACTIVE_CELL_BRACKET].Color(*wxRED);
+  // m_shared->styles[TS_CURSOR];
+  m_shared->styles[TS_SELECTION].Color(wxSYS_COLOUR_HIGHLIGHT);
+  m_shared->styles[TS_EQUALSSELECTION]
     .Color(wxSYS_COLOUR_HIGHLIGHT)
     .ChangeLightness(150);
-  m_styles[TS_OUTDATED].Color(153, 153, 153);
+  m_shared->styles[TS_OUTDATED].Color(153, 153, 153);
 }
 
 const wxString &Configuration::GetEscCode(const wxString &key) {
@@ -561,6 +595,13 @@ wxString Configuration::GetAutosubscript_string() const {
   }
 }
 
+void Configuration::ImageCacheMegabytes(long megaBytes) {
+  if (megaBytes < 1)
+    megaBytes = 1;
+  m_imageCacheMegabytes = megaBytes;
+  ImageCacheBudget::SetBudget(static_cast<std::size_t>(megaBytes) * 1024 * 1024);
+}
+
 void Configuration::ShowCodeCells(bool show) {
   if(m_showCodeCells != show)
     RecalculateForce();
@@ -622,25 +663,7 @@ void Configuration::ReadConfig() {
 
   config->Read(wxS("configID"), &m_configId);
 
-  wxString str;
-  long dummy;
-  config->SetPath("/renderability/good");
-  bool bCont = config->GetFirstEntry(str, dummy);
-  while (bCont) {
-    wxString chars;
-    config->Read(str, &chars);
-    m_renderableChars[str] = chars;
-    bCont = config->GetNextEntry(str, dummy);
-  }
-  config->SetPath("/renderability/bad");
-  bCont = config->GetFirstEntry(str, dummy);
-  while (bCont) {
-    wxString chars;
-    config->Read(str, &chars);
-    m_nonRenderableChars[str] = chars;
-    bCont = config->GetNextEntry(str, dummy);
-  }
-  config->SetPath("/");
+  ReadGlyphCoverage();
 
   {
     wxString hideMessagesConfigString;
@@ -785,6 +808,8 @@ void Configuration::ReadConfig() {
   config->Read("undoLimit", &m_undoLimit);
   config->Read("recentItems", &m_recentItems);
   config->Read("maxGnuplotMegabytes", &m_maxGnuplotMegabytes);
+  config->Read("imageCacheMegabytes", &m_imageCacheMegabytes);
+  ImageCacheMegabytes(m_imageCacheMegabytes);
   config->Read("offerKnownAnswers", &m_offerKnownAnswers);
   config->Read(wxS("documentclass"), &m_documentclass);
   config->Read(wxS("documentclassoptions"), &m_documentclassOptions);
@@ -883,6 +908,7 @@ void Configuration::ReadConfig() {
   config->Read(wxS("printBrackets"), &m_printBrackets);
   config->Read(wxS("keepPercent"), &m_keepPercent);
   config->Read(wxS("saveUntitled"), &m_saveUntitled);
+  config->Read(wxS("verifySavedFiles"), &m_verifySavedFiles);
   config->Read(wxS("cursorJump"), &m_cursorJump);
 
   ReadStyles();
@@ -914,46 +940,47 @@ bool Configuration::HideMarkerForThisMessage(wxString message) {
 //TODO: Don't underline the section number of titles
 void Configuration::MakeStylesConsistent()
 {
+  UnshareStyles();
   for(const auto &style : GetCodeStylesList())
     {
-      m_styles[style].SetFamily(GetStyle(TS_CODE_DEFAULT)->GetFamily());
-      m_styles[style].SetEncoding(GetStyle(TS_CODE_DEFAULT)->GetEncoding());
-      m_styles[style].SetFontSize(GetStyle(TS_CODE_DEFAULT)->GetFontSize());
-      m_styles[style].SetFontName(GetStyle(TS_CODE_DEFAULT)->GetFontName());
-      m_styles[style].SetBold(GetStyle(TS_CODE_DEFAULT)->IsBold());
-      m_styles[style].SetItalic(GetStyle(TS_CODE_DEFAULT)->IsItalic());
-      m_styles[style].SetSlant(GetStyle(TS_CODE_DEFAULT)->IsSlant());
-      m_styles[style].SetStrikethrough(GetStyle(TS_CODE_DEFAULT)->IsStrikethrough());
-      m_styles[style].SetUnderlined(GetStyle(TS_CODE_DEFAULT)->IsUnderlined());
-      m_styles[style].CantChangeFontName(true);
-      m_styles[style].CantChangeFontVariant(true);
+      m_shared->styles[style].SetFamily(GetStyle(TS_CODE_DEFAULT)->GetFamily());
+      m_shared->styles[style].SetEncoding(GetStyle(TS_CODE_DEFAULT)->GetEncoding());
+      m_shared->styles[style].SetFontSize(GetStyle(TS_CODE_DEFAULT)->GetFontSize());
+      m_shared->styles[style].SetFontName(GetStyle(TS_CODE_DEFAULT)->GetFontName());
+      m_shared->styles[style].SetBold(GetStyle(TS_CODE_DEFAULT)->IsBold());
+      m_shared->styles[style].SetItalic(GetStyle(TS_CODE_DEFAULT)->IsItalic());
+      m_shared->styles[style].SetSlant(GetStyle(TS_CODE_DEFAULT)->IsSlant());
+      m_shared->styles[style].SetStrikethrough(GetStyle(TS_CODE_DEFAULT)->IsStrikethrough());
+      m_shared->styles[style].SetUnderlined(GetStyle(TS_CODE_DEFAULT)->IsUnderlined());
+      m_shared->styles[style].CantChangeFontName(true);
+      m_shared->styles[style].CantChangeFontVariant(true);
     }
 
   for(const auto &style : GetMathStylesList())
     {
       if((style != TS_ASCIIMATHS) && (style != TS_TEXT))
         {
-          m_styles[style].SetFontSize(GetStyle(TS_MATH)->GetFontSize());
-          m_styles[style].SetFamily(GetStyle(TS_MATH)->GetFamily());
-          m_styles[style].SetEncoding(GetStyle(TS_MATH)->GetEncoding());
-          m_styles[style].SetFontName(GetStyle(TS_MATH)->GetFontName());
-          m_styles[style].CantChangeFontName(true);
+          m_shared->styles[style].SetFontSize(GetStyle(TS_MATH)->GetFontSize());
+          m_shared->styles[style].SetFamily(GetStyle(TS_MATH)->GetFamily());
+          m_shared->styles[style].SetEncoding(GetStyle(TS_MATH)->GetEncoding());
+          m_shared->styles[style].SetFontName(GetStyle(TS_MATH)->GetFontName());
+          m_shared->styles[style].CantChangeFontName(true);
         }
     }
 
   for(const auto &style : GetColorOnlyStylesList())
     {
-      m_styles[style].SetFamily(GetStyle(TS_CODE_DEFAULT)->GetFamily());
-      m_styles[style].SetEncoding(GetStyle(TS_CODE_DEFAULT)->GetEncoding());
-      m_styles[style].SetFontSize(GetStyle(TS_CODE_DEFAULT)->GetFontSize());
-      m_styles[style].SetFontName(GetStyle(TS_CODE_DEFAULT)->GetFontName());
-      m_styles[style].SetBold(GetStyle(TS_CODE_DEFAULT)->IsBold());
-      m_styles[style].SetItalic(GetStyle(TS_CODE_DEFAULT)->IsItalic());
-      m_styles[style].SetUnderlined(GetStyle(TS_CODE_DEFAULT)->IsUnderlined());
-      m_styles[style].SetSlant(GetStyle(TS_CODE_DEFAULT)->IsSlant());
-      m_styles[style].SetStrikethrough(GetStyle(TS_CODE_DEFAULT)->IsStrikethrough());
-      m_styles[style].CantChangeFontName(true);
-      m_styles[style].CantChangeFontVariant(true);
+      m_shared->styles[style].SetFamily(GetStyle(TS_CODE_DEFAULT)->GetFamily());
+      m_shared->styles[style].SetEncoding(GetStyle(TS_CODE_DEFAULT)->GetEncoding());
+      m_shared->styles[style].SetFontSize(GetStyle(TS_CODE_DEFAULT)->GetFontSize());
+      m_shared->styles[style].SetFontName(GetStyle(TS_CODE_DEFAULT)->GetFontName());
+      m_shared->styles[style].SetBold(GetStyle(TS_CODE_DEFAULT)->IsBold());
+      m_shared->styles[style].SetItalic(GetStyle(TS_CODE_DEFAULT)->IsItalic());
+      m_shared->styles[style].SetUnderlined(GetStyle(TS_CODE_DEFAULT)->IsUnderlined());
+      m_shared->styles[style].SetSlant(GetStyle(TS_CODE_DEFAULT)->IsSlant());
+      m_shared->styles[style].SetStrikethrough(GetStyle(TS_CODE_DEFAULT)->IsStrikethrough());
+      m_shared->styles[style].CantChangeFontName(true);
+      m_shared->styles[style].CantChangeFontVariant(true);
     }
 }
 
@@ -986,16 +1013,16 @@ bool Configuration::StyleAffectsColorOnly(TextStyle style) const
 
 wxColor Configuration::DefaultBackgroundColor() {
   if (InvertBackground())
-    return InvertColour(m_styles[TS_DOCUMENT_BACKGROUND].GetColor());
+    return InvertColour(m_shared->styles[TS_DOCUMENT_BACKGROUND].GetColor());
   else
-    return m_styles[TS_DOCUMENT_BACKGROUND].GetColor();
+    return m_shared->styles[TS_DOCUMENT_BACKGROUND].GetColor();
 }
 
 wxColor Configuration::EditorBackgroundColor() {
   if (InvertBackground())
-    return InvertColour(m_styles[TS_TEXT_BACKGROUND].GetColor());
+    return InvertColour(m_shared->styles[TS_TEXT_BACKGROUND].GetColor());
   else
-    return m_styles[TS_TEXT_BACKGROUND].GetColor();
+    return m_shared->styles[TS_TEXT_BACKGROUND].GetColor();
 }
 
 void Configuration::NotifyOfCellRedraw(const Cell *cell) {
@@ -1091,7 +1118,7 @@ void Configuration::SetZoomFactor(double newzoom) {
 
   RecalculateForce();
 
-  for (const auto &i: m_styles)
+  for (const auto &i: m_shared->styles)
     i.ClearCache();
   if (newzoom > GetMaxZoomFactor())
     newzoom = GetMaxZoomFactor();
@@ -1178,7 +1205,7 @@ Configuration::~Configuration() {
 
 wxString Configuration::GetFontName(TextStyle const ts) const {
   wxString retval;
-  retval = m_styles[ts].GetFontName();
+  retval = m_shared->styles[ts].GetFontName();
   return retval;
 }
 
@@ -1194,6 +1221,7 @@ wxString Configuration::MaximaDefaultLocation() {
 }
 
 void Configuration::ReadStyles(const wxString &file) {
+  UnshareStyles();
   RecalculateForce();
   wxConfigBase *config = NULL;
   if (file == wxEmptyString)
@@ -1207,56 +1235,56 @@ void Configuration::ReadStyles(const wxString &file) {
   // Read legacy defaults for the math font name and size
   long tmpLong;
   if (config->Read(wxS("mathfontsize"), &tmpLong) && tmpLong > 1)
-    m_styles[TS_MATH].SetFontSize(AFontSize(tmpLong));
+    m_shared->styles[TS_MATH].SetFontSize(AFontSize(tmpLong));
   config->Read(wxS("showInputLabels"), &m_showInputLabels);
   wxString tmpString;
   if (config->Read(wxS("Style/Math/fontname"), &tmpString) &&
       tmpString.size() > 1)
-    m_styles[TS_MATH].SetFontName(tmpString);
-
-  m_styles[TS_MATH].Read(config, "Style/Math/");
-  m_styles[TS_TEXT].Read(config, "Style/Text/");
-  m_styles[TS_CODE_VARIABLE].Read(config, "Style/CodeHighlighting/Variable/");
-  m_styles[TS_CODE_FUNCTION].Read(config, "Style/CodeHighlighting/Function/");
-  m_styles[TS_CODE_COMMENT].Read(config, "Style/CodeHighlighting/Comment/");
-  m_styles[TS_CODE_NUMBER].Read(config, "Style/CodeHighlighting/Number/");
-  m_styles[TS_CODE_STRING].Read(config, "Style/CodeHighlighting/String/");
-  m_styles[TS_CODE_OPERATOR].Read(config, "Style/CodeHighlighting/Operator/");
-  m_styles[TS_CODE_LISP].Read(config, "Style/CodeHighlighting/Lisp/");
-  m_styles[TS_CODE_ENDOFLINE].Read(config, "Style/CodeHighlighting/EndOfLine/");
-  m_styles[TS_HEADING6].Read(config, "Style/Heading6/");
-  m_styles[TS_HEADING5].Read(config, "Style/Heading5/");
-  m_styles[TS_SUBSUBSECTION].Read(config, "Style/Subsubsection/");
-  m_styles[TS_SUBSECTION].Read(config, "Style/Subsection/");
-  m_styles[TS_SECTION].Read(config, "Style/Section/");
-  m_styles[TS_TITLE].Read(config, "Style/Title/");
-  m_styles[TS_WARNING].Read(config, "Style/Warning/");
-  m_styles[TS_MAIN_PROMPT].Read(config, "Style/MainPrompt/");
-  m_styles[TS_OTHER_PROMPT].Read(config, "Style/OtherPrompt/");
-  m_styles[TS_LABEL].Read(config, "Style/Label/");
-  m_styles[TS_USERLABEL].Read(config, "Style/UserDefinedLabel/");
-  m_styles[TS_SPECIAL_CONSTANT].Read(config, "Style/Special/");
-  m_styles[TS_GREEK_CONSTANT].Read(config, "Style/Greek/");
-  m_styles[TS_CODE_DEFAULT].Read(config, "Style/Default/");
-  m_styles[TS_NUMBER].Read(config, "Style/Number/");
-  m_styles[TS_STRING].Read(config, "Style/String/");
-  m_styles[TS_ASCIIMATHS].Read(config, "Style/ASCIImaths/");
-  m_styles[TS_VARIABLE].Read(config, "Style/Variable/");
-  m_styles[TS_OPERATOR].Read(config, "Style/Operator/");
-  m_styles[TS_FUNCTION].Read(config, "Style/Function/");
-  m_styles[TS_HIGHLIGHT].Read(config, "Style/Highlight/");
-  m_styles[TS_TEXT_BACKGROUND].Read(config, "Style/Background/");
-  m_styles[TS_DOCUMENT_BACKGROUND].Read(config, "Style/DocumentBackground/");
-  m_styles[TS_ERROR].Read(config, "Style/Error/");
-  m_styles[TS_CELL_BRACKET].Read(config, "Style/CellBracket/");
-  m_styles[TS_ACTIVE_CELL_BRACKET].Read(config,
+    m_shared->styles[TS_MATH].SetFontName(tmpString);
+
+  m_shared->styles[TS_MATH].Read(config, "Style/Math/");
+  m_shared->styles[TS_TEXT].Read(config, "Style/Text/");
+  m_shared->styles[TS_CODE_VARIABLE].Read(config, "Style/CodeHighlighting/Variable/");
+  m_shared->styles[TS_CODE_FUNCTION].Read(config, "Style/CodeHighlighting/Function/");
+  m_shared->styles[TS_CODE_COMMENT].Read(config, "Style/CodeHighlighting/Comment/");
+  m_shared->styles[TS_CODE_NUMBER].Read(config, "Style/CodeHighlighting/Number/");
+  m_shared->styles[TS_CODE_STRING].Read(config, "Style/CodeHighlighting/String/");
+  m_shared->styles[TS_CODE_OPERATOR].Read(config, "Style/CodeHighlighting/Operator/");
+  m_shared->styles[TS_CODE_LISP].Read(config, "Style/CodeHighlighting/Lisp/");
+  m_shared->styles[TS_CODE_ENDOFLINE].Read(config, "Style/CodeHighlighting/EndOfLine/");
+  m_shared->styles[TS_HEADING6].Read(config, "Style/Heading6/");
+  m_shared->styles[TS_HEADING5].Read(config, "Style/Heading5/");
+  m_shared->styles[TS_SUBSUBSECTION].Read(config, "Style/Subsubsection/");
+  m_shared->styles[TS_SUBSECTION].Read(config, "Style/Subsection/");
+  m_shared->styles[TS_SECTION].Read(config, "Style/Section/");
+  m_shared->styles[TS_TITLE].Read(config, "Style/Title/");
+  m_shared->styles[TS_WARNING].Read(config, "Style/Warning/");
+  m_shared->styles[TS_MAIN_PROMPT].Read(config, "Style/MainPrompt/");
+  m_shared->styles[TS_OTHER_PROMPT].Read(config, "Style/OtherPrompt/");
+  m_shared->styles[TS_LABEL].Read(config, "Style/Label/");
+  m_shared->styles[TS_USERLABEL].Read(config, "Style/UserDefinedLabel/");
+  m_shared->styles[TS_SPECIAL_CONSTANT].Read(config, "Style/Special/");
+  m_shared->styles[TS_GREEK_CONSTANT].Read(config, "Style/Greek/");
+  m_shared->styles[TS_CODE_DEFAULT].Read(config, "Style/Default/");
+  m_shared->styles[TS_NUMBER].Read(config, "Style/Number/");
+  m_shared->styles[TS_STRING].Read(config, "Style/String/");
+  m_shared->styles[TS_ASCIIMATHS].Read(config, "Style/ASCIImaths/");
+  m_shared->styles[TS_VARIABLE].Read(config, "Style/Variable/");
+  m_shared->styles[TS_OPERATOR].Read(config, "Style/Operator/");
+  m_shared->styles[TS_FUNCTION].Read(config, "Style/Function/");
+  m_shared->styles[TS_HIGHLIGHT].Read(config, "Style/Highlight/");
+  m_shared->styles[TS_TEXT_BACKGROUND].Read(config, "Style/Background/");
+  m_shared->styles[TS_DOCUMENT_BACKGROUND].Read(config, "Style/DocumentBackground/");
+  m_shared->styles[TS_ERROR].Read(config, "Style/Error/");
+  m_shared->styles[TS_CELL_BRACKET].Read(config, "Style/CellBracket/");
+  m_shared->styles[TS_ACTIVE_CELL_BRACKET].Read(config,
                                         wxS("Style/ActiveCellBracket/"));
-  m_styles[TS_CURSOR].Read(config, wxS("Style/ActiveCellBracket/"));
-  m_styles[TS_SELECTION].Read(config, wxS("Style/Selection/"));
-  m_styles[TS_EQUALSSELECTION].Read(config, wxS("Style/EqualsSelection/"));
-  m_styles[TS_OUTDATED].Read(config, wxS("Style/Outdated/"));
+  m_shared->styles[TS_CURSOR].Read(config, wxS("Style/ActiveCellBracket/"));
+  m_shared->styles[TS_SELECTION].Read(config, wxS("Style/Selection/"));
+  m_shared->styles[TS_EQUALSSELECTION].Read(config, wxS("Style/EqualsSelection/"));
+  m_shared->styles[TS_OUTDATED].Read(config, wxS("Style/Outdated/"));
   m_BackgroundBrush = *wxTheBrushList->FindOrCreateBrush(
-                                                         m_styles[TS_DOCUMENT_BACKGROUND].GetColor(), wxBRUSHSTYLE_SOLID);
+                                                         m_shared->styles[TS_DOCUMENT_BACKGROUND].GetColor(), wxBRUSHSTYLE_SOLID);
   MakeStylesConsistent();
 }
 
@@ -1342,6 +1370,7 @@ void Configuration::WriteSettings(const wxString &file) {
   config->Write(wxS("keepPercent"), m_keepPercent);
   config->Write(wxS("labelWidth"), m_labelWidth);
   config->Write(wxS("saveUntitled"), m_saveUntitled);
+  config->Write(wxS("verifySavedFiles"), m_verifySavedFiles);
   config->Write(wxS("cursorJump"), m_cursorJump);
   config->Write(wxS("autoSaveMinutes"), m_autoSaveMinutes);
 
@@ -1349,10 +1378,11 @@ void Configuration::WriteSettings(const wxString &file) {
                 m_maxClipbrd_BitmapMegabytes);
 
   WriteStyles(config);
-  for (const auto &i : m_renderableChars)
-    config->Write(wxS("renderability/good/") + i.first, i.second);
-  for (const auto &i : m_nonRenderableChars)
-    config->Write(wxS("renderability/bad/") + i.first, i.second);
+  if (file == wxEmptyString) {
+    // Older versions stored the renderability info in the config
+    config->DeleteGroup(wxS("/renderability"));
+    WriteGlyphCoverage();
+  }
   if (file != wxEmptyString) {
     config->Flush();
     delete config;
@@ -1360,25 +1390,25 @@ void Configuration::WriteSettings(const wxString &file) {
 }
 
 wxFontWeight Configuration::IsBold(long st) const {
-  if (m_styles[st].IsBold())
+  if (m_shared->styles[st].IsBold())
     return wxFONTWEIGHT_BOLD;
   return wxFONTWEIGHT_NORMAL;
 }
 
 wxFontStyle Configuration::IsItalic(long st) const {
-  if (m_styles[st].IsItalic())
+  if (m_shared->styles[st].IsItalic())
     return wxFONTSTYLE_ITALIC;
   return wxFONTSTYLE_NORMAL;
 }
 
 wxString Configuration::GetSymbolFontName() const {
-  return m_styles[TS_CODE_DEFAULT].GetFontName();
+  return m_shared->styles[TS_CODE_DEFAULT].GetFontName();
 }
 
 wxColour Configuration::GetColor(TextStyle style) {
-  wxColour col = m_styles[style].GetColor();
+  wxColour col = m_shared->styles[style].GetColor();
   if (m_outdated)
-    col = m_styles[TS_OUTDATED].GetColor();
+    col = m_shared->styles[TS_OUTDATED].GetColor();
 
   if (InvertBackground() && (style != TS_TEXT_BACKGROUND) &&
       (style != TS_DOCUMENT_BACKGROUND))
@@ -1429,27 +1459,120 @@ bool Configuration::InUpdateRegion(wxRect const rect) const {
   return updateRegion.Intersects(rect);
 }
 
+//! The header of the glyph coverage cache file. Change it if the file format changes.
+static const wxString GlyphCoverageMagic = wxS("wxMaxima glyph coverage 1");
+
+GlyphCoverage &Configuration::GetGlyphCoverage(const wxFont &font) {
+  wxString fontDesc = font.GetNativeFontInfoDesc();
+  auto known = m_fontGlyphCoverage.find(fontDesc);
+  if (known != m_fontGlyphCoverage.end())
+    return *known->second;
+
+  // wxWidgets doesn't tell which file a font was loaded from. The extents of a
+  // few glyphs tell apart different versions of a font file well enough, though.
+  wxBitmap bmp(wxSize(1, 1));
+  wxMemoryDC dc(bmp);
+  dc.SetFont(font);
+  wxString key = fontDesc;
+  for (const auto &probe : {wxString(L"Mg"), wxString(L"\u03b1\u2211"), wxString(L"\u222b\u2192")}) {
+    wxSize extent = dc.GetTextExtent(probe);
+    key += wxString::Format(wxS("@%ix%i"), extent.x, extent.y);
+  }
+  GlyphCoverage *coverage = &m_glyphCoverage[key];
+  m_fontGlyphCoverage[fontDesc] = coverage;
+  return *coverage;
+}
+
+bool Configuration::FontRenderabilityKnown(wxUniChar ch, const wxFont &font) {
+  const std::lock_guard<std::mutex> lock(m_glyphCoverageMutex);
+  return GetGlyphCoverage(font).Get(ch) != GlyphCoverage::unknown;
+}
+
 bool Configuration::FontRendersChar(wxUniChar ch, const wxFont &font) {
-  wxString fontName = font.GetNativeFontInfoDesc();
-  fontName.Replace("/", "_");
-  if (m_renderableChars[fontName].Contains(ch))
-    return true;
-  if (m_nonRenderableChars[fontName].Contains(ch))
-    return false;
+  {
+    const std::lock_guard<std::mutex> lock(m_glyphCoverageMutex);
+    switch (GetGlyphCoverage(font).Get(ch)) {
+    case GlyphCoverage::renders:
+      return true;
+    case GlyphCoverage::missing:
+      return false;
+    case GlyphCoverage::unknown:
+      break;
+    }
+  }
 
+  // Drawing the char is slow: Don't block the other threads meanwhile.
   bool retval = FontDisplaysChar(ch, font) &&
     CharVisiblyDifferent(ch, wxS('\1'), font) &&
     CharVisiblyDifferent(ch, L'\uF299', font) &&
     CharVisiblyDifferent(ch, L'\uF000', font);
 
-  if (retval)
-    m_renderableChars[fontName] += ch;
-  else
-    m_nonRenderableChars[fontName] += ch;
-
+  const std::lock_guard<std::mutex> lock(m_glyphCoverageMutex);
+  GetGlyphCoverage(font).Set(ch, retval);
+  m_glyphCoverageChanged = true;
   return retval;
 }
 
+void Configuration::ReadGlyphCoverage() {
+  const std::lock_guard<std::mutex> lock(m_glyphCoverageMutex);
+  static bool alreadyRead = false;
+  if (alreadyRead)
+    return;
+  alreadyRead = true;
+  wxString fileName = Dirstructure::GlyphCoverageCacheFile();
+  if (!wxFileExists(fileName))
+    return;
+  wxFileInputStream file(fileName);
+  if (!file.IsOk())
+    return;
+  wxDataInputStream data(file);
+  if ((data.ReadString() != GlyphCoverageMagic) || !file.IsOk())
+  {
+    wxLogMessage(_("Ignoring the outdated glyph coverage cache %s"), fileName.mb_str());
+    return;
+  }
+  uint32_t fonts = data.Read32();
+  for (uint32_t i = 0; (i < fonts) && file.IsOk(); i++) {
+    wxString key = data.ReadString();
+    GlyphCoverage coverage;
+    if (!coverage.Read(file))
+    {
+      wxLogMessage(_("The glyph coverage cache %s seems to be damaged"), fileName.mb_str());
+      return;
+    }
+    if (m_glyphCoverage[key].IsEmpty())
+      m_glyphCoverage[key] = std::move(coverage);
+  }
+}
+
+void Configuration::WriteGlyphCoverage() {
+  const std::lock_guard<std::mutex> lock(m_glyphCoverageMutex);
+  if (!m_glyphCoverageChanged)
+    return;
+  wxString fileName = Dirstructure::GlyphCoverageCacheFile();
+  // Write to a temp file that replaces the old cache only after everything is written
+  wxTempFileOutputStream file(fileName);
+  if (!file.IsOk())
+    return;
+  wxDataOutputStream data(file);
+  data.WriteString(GlyphCoverageMagic);
+  uint32_t fonts = 0;
+  for (const auto &i : m_glyphCoverage)
+    if (!i.second.IsEmpty())
+      fonts++;
+  data.Write32(fonts);
+  for (const auto &i : m_glyphCoverage) {
+    if (i.second.IsEmpty())
+      continue;
+    data.WriteString(i.first);
+    i.second.Write(file);
+  }
+  if (file.IsOk() && file.Commit())
+    m_glyphCoverageChanged = false;
+  else
+    wxLogMessage(_("Cannot write the glyph coverage cache %s"), fileName.mb_str());
+}
+
 bool Configuration::FontDisplaysChar(wxUniChar ch, const wxFont &font) {
   int width = 200;
   int height = 200;
@@ -1636,6 +1759,7 @@ void Configuration::WriteStyles(wxConfigBase *config) {
   config->Write("abortOnError", m_abortOnError);
   config->Write("language", m_language);
   config->Write("maxGnuplotMegabytes", m_maxGnuplotMegabytes);
+  config->Write("imageCacheMegabytes", m_imageCacheMegabytes);
   config->Write("offerKnownAnswers", m_offerKnownAnswers);
   config->Write("documentclass", m_documentclass);
   config->Write("documentclassoptions", m_documentclassOptions);
@@ -1643,48 +1767,48 @@ void Configuration::WriteStyles(wxConfigBase *config) {
   config->Write("autosubscript", m_autoSubscript);
   config->Write(wxS("ZoomFactor"), m_zoomFactor);
   // Fonts
-  m_styles[TS_MATH].Write(config, "Style/Math/");
-  m_styles[TS_TEXT].Write(config, "Style/Text/");
-  m_styles[TS_CODE_VARIABLE].Write(config, "Style/CodeHighlighting/Variable/");
-  m_styles[TS_CODE_FUNCTION].Write(config, "Style/CodeHighlighting/Function/");
-  m_styles[TS_CODE_COMMENT].Write(config, "Style/CodeHighlighting/Comment/");
-  m_styles[TS_CODE_NUMBER].Write(config, "Style/CodeHighlighting/Number/");
-  m_styles[TS_CODE_STRING].Write(config, "Style/CodeHighlighting/String/");
-  m_styles[TS_CODE_OPERATOR].Write(config, "Style/CodeHighlighting/Operator/");
-  m_styles[TS_CODE_LISP].Write(config, "Style/CodeHighlighting/Lisp/");
-  m_styles[TS_CODE_ENDOFLINE].Write(config,
+  m_shared->styles[TS_MATH].Write(config, "Style/Math/");
+  m_shared->styles[TS_TEXT].Write(config, "Style/Text/");
+  m_shared->styles[TS_CODE_VARIABLE].Write(config, "Style/CodeHighlighting/Variable/");
+  m_shared->styles[TS_CODE_FUNCTION].Write(config, "Style/CodeHighlighting/Function/");
+  m_shared->styles[TS_CODE_COMMENT].Write(config, "Style/CodeHighlighting/Comment/");
+  m_shared->styles[TS_CODE_NUMBER].Write(config, "Style/CodeHighlighting/Number/");
+  m_shared->styles[TS_CODE_STRING].Write(config, "Style/CodeHighlighting/String/");
+  m_shared->styles[TS_CODE_OPERATOR].Write(config, "Style/CodeHighlighting/Operator/");
+  m_shared->styles[TS_CODE_LISP].Write(config, "Style/CodeHighlighting/Lisp/");
+  m_shared->styles[TS_CODE_ENDOFLINE].Write(config,
                                     "Style/CodeHighlighting/EndOfLine/");
-  m_styles[TS_HEADING6].Write(config, "Style/Heading6/");
-  m_styles[TS_HEADING5].Write(config, "Style/Heading5/");
-  m_styles[TS_SUBSUBSECTION].Write(config, "Style/Subsubsection/");
-  m_styles[TS_SUBSECTION].Write(config, "Style/Subsection/");
-  m_styles[TS_SECTION].Write(config, "Style/Section/");
-  m_styles[TS_TITLE].Write(config, "Style/Title/");
-  m_styles[TS_WARNING].Write(config, "Style/Warning/");
-  m_styles[TS_MAIN_PROMPT].Write(config, "Style/MainPrompt/");
-  m_styles[TS_OTHER_PROMPT].Write(config, "Style/OtherPrompt/");
-  m_styles[TS_LABEL].Write(config, "Style/Label/");
-  m_styles[TS_USERLABEL].Write(config, "Style/UserDefinedLabel/");
-  m_styles[TS_SPECIAL_CONSTANT].Write(config, "Style/Special/");
-  m_styles[TS_GREEK_CONSTANT].Write(config, "Style/Greek/");
-  m_styles[TS_CODE_DEFAULT].Write(config, "Style/Default/");
-  m_styles[TS_NUMBER].Write(config, "Style/Number/");
-  m_styles[TS_STRING].Write(config, "Style/String/");
-  m_styles[TS_ASCIIMATHS].Write(config, "Style/ASCIImaths/");
-  m_styles[TS_VARIABLE].Write(config, "Style/Variable/");
-  m_styles[TS_OPERATOR].Write(config, "Style/Operator/");
-  m_styles[TS_FUNCTION].Write(config, "Style/Function/");
-  m_styles[TS_HIGHLIGHT].Write(config, "Style/Highlight/");
-  m_styles[TS_TEXT_BACKGROUND].Write(config, "Style/Background/");
-  m_styles[TS_DOCUMENT_BACKGROUND].Write(config, "Style/DocumentBackground/");
-  m_styles[TS_ERROR].Write(config, "Style/Error/");
-  m_styles[TS_CELL_BRACKET].Write(config, "Style/CellBracket/");
-  m_styles[TS_ACTIVE_CELL_BRACKET].Write(config,
+  m_shared->styles[TS_HEADING6].Write(config, "Style/Heading6/");
+  m_shared->styles[TS_HEADING5].Write(config, "Style/Heading5/");
+  m_shared->styles[TS_SUBSUBSECTION].Write(config, "Style/Subsubsection/");
+  m_shared->styles[TS_SUBSECTION].Write(config, "Style/Subsection/");
+  m_shared->styles[TS_SECTION].Write(config, "Style/Section/");
+  m_shared->styles[TS_TITLE].Write(config, "Style/Title/");
+  m_shared->styles[TS_WARNING].Write(config, "Style/Warning/");
+  m_shared->styles[TS_MAIN_PROMPT].Write(config, "Style/MainPrompt/");
+  m_shared->styles[TS_OTHER_PROMPT].Write(config, "Style/OtherPrompt/");
+  m_shared->styles[TS_LABEL].Write(config, "Style/Label/");
+  m_shared->styles[TS_USERLABEL].Write(config, "Style/UserDefinedLabel/");
+  m_shared->styles[TS_SPECIAL_CONSTANT].Write(config, "Style/Special/");
+  m_shared->styles[TS_GREEK_CONSTANT].Write(config, "Style/Greek/");
+  m_shared->styles[TS_CODE_DEFAULT].Write(config, "Style/Default/");
+  m_shared->styles[TS_NUMBER].Write(config, "Style/Number/");
+  m_shared->styles[TS_STRING].Write(config, "Style/String/");
+  m_shared->styles[TS_ASCIIMATHS].Write(config, "Style/ASCIImaths/");
+  m_shared->styles[TS_VARIABLE].Write(config, "Style/Variable/");
+  m_shared->styles[TS_OPERATOR].Write(config, "Style/Operator/");
+  m_shared->styles[TS_FUNCTION].Write(config, "Style/Function/");
+  m_shared->styles[TS_HIGHLIGHT].Write(config, "Style/Highlight/");
+  m_shared->styles[TS_TEXT_BACKGROUND].Write(config, "Style/Background/");
+  m_shared->styles[TS_DOCUMENT_BACKGROUND].Write(config, "Style/DocumentBackground/");
+  m_shared->styles[TS_ERROR].Write(config, "Style/Error/");
+  m_shared->styles[TS_CELL_BRACKET].Write(config, "Style/CellBracket/");
+  m_shared->styles[TS_ACTIVE_CELL_BRACKET].Write(config,
                                          wxS("Style/ActiveCellBracket/"));
-  m_styles[TS_CURSOR].Write(config, wxS("Style/ActiveCellBracket/"));
-  m_styles[TS_SELECTION].Write(config, wxS("Style/Selection/"));
-  m_styles[TS_EQUALSSELECTION].Write(config, wxS("Style/EqualsSelection/"));
-  m_styles[TS_OUTDATED].Write(config, wxS("Style/Outdated/"));
+  m_shared->styles[TS_CURSOR].Write(config, wxS("Style/ActiveCellBracket/"));
+  m_shared->styles[TS_SELECTION].Write(config, wxS("Style/Selection/"));
+  m_shared->styles[TS_EQUALSSELECTION].Write(config, wxS("Style/EqualsSelection/"));
+  m_shared->styles[TS_OUTDATED].Write(config, wxS("Style/Outdated/"));
 }
 
 //! Saves the style settings to a file.
@@ -1734,4 +1858,8 @@ wxString Configuration::m_configfileLocation_override;
 std::unordered_map<TextStyle, wxString> Configuration::m_styleNames;
 bool Configuration::m_debugMode = false;
 bool Configuration::m_use_threads = true;
+Configuration::GlyphCoverageHash Configuration::m_glyphCoverage;
+std::unordered_map<wxString, GlyphCoverage *, wxStringHash> Configuration::m_fontGlyphCoverage;
+bool Configuration::m_glyphCoverageChanged = false;
+std::mutex Configuration::m_glyphCoverageMutex;
 wxString Configuration::m_maxima_LANG;
@@ -30,6 +30,7 @@
 #include <wx/hashmap.h>
 #include "dialogs/LoggingMessageDialog.h"
 #include "cells/TextStyle.h"
+#include "GlyphCoverage.h"
 #include <cstdint>
 #include <memory>
 #include <mutex>
@@ -128,13 +129,14 @@ public:
   };
 
   typedef std::unordered_map <wxString, bool, wxStringHash> StringBoolHash;
-  typedef std::unordered_map <wxString, wxString, wxStringHash> RenderablecharsHash;
+  typedef std::unordered_map <wxString, GlyphCoverage, wxStringHash> GlyphCoverageHash;
   typedef std::unordered_map <wxString, int, wxStringHash> StringHash;
-  /*! All maxima operator names we know
-   */
-  StringHash m_maximaOperators;
+  //! All maxima operator names we know
+  const StringHash &MaximaOperators() const {return m_shared->maximaOperators;}
+  //! Remember that name is the name of an operator maxima knows
+  void AddMaximaOperator(const wxString &name);
   //! Coincides name with a operator known to maxima?
-  bool IsOperator(wxString name){return !(m_maximaOperators.find(name) == m_maximaOperators.end());}
+  bool IsOperator(wxString name){return !(MaximaOperators().find(name) == MaximaOperators().end());}
   const wxEnvVariableHashMap& MaximaEnvVars() const {return m_maximaEnvVars;}
   wxEnvVariableHashMap m_maximaEnvVars;
 
@@ -160,6 +162,22 @@ public:
   */
   explicit Configuration(wxDC *dc = {}, InitOpt options = none);
 
+  /*! A temporary configuration for printing or exporting
+
+    Takes all settings from an existing configuration instead of reading them
+    from the operating system's config storage, which is way cheaper. The text
+    styles and the operator list aren't copied, but shared with base until one
+    of both configurations changes them. Zoom, PPI, canvas and the like are
+    the temporary configuration's own. The new configuration doesn't belong to
+    any worksheet, doesn't save anything and makes all cells that are moved to
+    it recalculate themselves: They have been laid out for another DC.
+
+    \param base The configuration to take the settings from, normally the one
+    of the worksheet.
+    \param dc The drawing context that is to be used for drawing objects
+  */
+  Configuration(const Configuration &base, wxDC *dc);
+
   //! Reset the whole configuration to its default values
   void ResetAllToDefaults();
 
@@ -220,7 +238,7 @@ public:
       if (ShowAutomaticLabels())
         return 0;
       else
-        return GetZoomFactor() * m_styles[TS_MATH].GetFontSize() / 2;
+        return GetZoomFactor() * m_shared->styles[TS_MATH].GetFontSize() / 2;
     }
 
   //! The width we allocate for our cell brackets
@@ -290,7 +308,7 @@ public:
 
   wxFontStyle IsItalic(long st) const;
 
-  bool IsUnderlined(long st) const {return m_styles[st].IsUnderlined();}
+  bool IsUnderlined(long st) const {return m_shared->styles[st].IsUnderlined();}
 
   /*! Get the width of worksheet labels [in unscaled pixels]
 
@@ -425,6 +443,10 @@ public:
   bool SaveUntitled() const { return m_saveUntitled;}
   void SaveUntitled(bool save) {m_saveUntitled = save;}
 
+  //! Read .wxmx files again after saving them and compare all files in them with their checksums?
+  bool VerifySavedFiles() const { return m_verifySavedFiles;}
+  void VerifySavedFiles(bool verify) {m_verifySavedFiles = verify;}
+
   bool CursorJump() const { return m_cursorJump;}
   void CursorJump(bool save){m_cursorJump = save;}
 
@@ -463,7 +485,7 @@ public:
     if(m_indentMaths != indent)
       RecalculateForce();
     m_indentMaths = indent;}
-  AFontSize GetFontSize(TextStyle st) const { return m_styles[st].GetFontSize(); }
+  AFontSize GetFontSize(TextStyle st) const { return m_shared->styles[st].GetFontSize(); }
 
   static const wxString &GetStyleName(TextStyle textStyle);
 
@@ -622,7 +644,7 @@ public:
       {
       }
     const wxString FileName() const{return m_filename;}
-    const wxMemoryBuffer Data() const{return m_data;}
+    const wxMemoryBuffer &Data() const{return m_data;}
   private:
     const wxMemoryBuffer m_data;
     const wxString m_filename;
@@ -654,6 +676,9 @@ public:
   wxRect GetUpdateRegion() const {return m_updateRegion;}
   const std::list<FileToSave> &GetFilesToSave() const {return m_filesToSave;}
   void ClearFilesToSave () { m_filesToSave.clear();}
+  //! Hands over the list of files to save, leaving an empty list here
+  std::list<FileToSave> TakeFilesToSave()
+    { std::list<FileToSave> files; files.swap(m_filesToSave); return files; }
   void SetUpdateRegion(wxRect rect){m_updateRegion = rect;}
 
   //! Whether any part of the given rectangle is within the current update region,
@@ -869,7 +894,7 @@ public:
 
     \param textStyle The text style to resolve the style for.
   */
-  const Style *GetStyle(TextStyle textStyle) const { return &m_styles[textStyle]; }
+  const Style *GetStyle(TextStyle textStyle) const { return &m_shared->styles[textStyle]; }
   /*! Get the text Style for a given text style identifier.
 
     Theoretically GetStyle and GetWritableStyle wouldn't collide if they had the
@@ -877,7 +902,10 @@ public:
     that performance degrades if a const is missing while the rest works fine.
     \param textStyle The text style to resolve the style for.
   */
-  Style *GetWritableStyle(TextStyle textStyle) { return &m_styles[textStyle]; }
+  Style *GetWritableStyle(TextStyle textStyle) {
+    UnshareStyles();
+    return &m_shared->styles[textStyle];
+  }
 
   //! Get the worksheet this configuration storage is valid for
   wxWindow *GetWorkSheet() const {return m_workSheet;}
@@ -897,6 +925,10 @@ public:
   void MaxGnuplotMegabytes(long megaBytes)
     {m_maxGnuplotMegabytes = megaBytes;}
 
+  //! The maximum number of Megabytes the scaled images of the worksheet may use
+  long ImageCacheMegabytes() const {return m_imageCacheMegabytes;}
+  void ImageCacheMegabytes(long megaBytes);
+
   bool OfferKnownAnswers() const {return m_offerKnownAnswers;}
   void OfferKnownAnswers(bool offerKnownAnswers)
     {m_offerKnownAnswers = offerKnownAnswers;}
@@ -911,8 +943,8 @@ public:
   void HTMLequationFormat(htmlExportFormat HTMLequationFormat)
     {m_htmlEquationFormat = HTMLequationFormat;}
 
-  AFontSize GetDefaultFontSize() const        { return m_styles[TS_CODE_DEFAULT].GetFontSize(); }
-  AFontSize GetMathFontSize() const           { return m_styles[TS_MATH].GetFontSize(); }
+  AFontSize GetDefaultFontSize() const        { return m_shared->styles[TS_CODE_DEFAULT].GetFontSize(); }
+  AFontSize GetMathFontSize() const           { return m_shared->styles[TS_MATH].GetFontSize(); }
 
   //! Get the worksheet this configuration storage is valid for
   long GetAutosubscript_Num() const {return m_autoSubscript;}
@@ -1018,11 +1050,20 @@ public:
   void SetLispType(const wxString &type){m_lispType = type;}
   wxString GetLispType() const {return m_lispType;}
 
-  Style m_styles[NUMBEROFSTYLES];
   //! Initialize the text styles on construction.
   void InitStyles();
   //! True if we are confident that the font renders this char
   bool FontRendersChar(wxUniChar ch, const wxFont &font = *wxNORMAL_FONT);
+  /*! True if FontRendersChar() can answer without drawing the char
+
+    Drawing a char in order to find out if it is rendered is slow, so code that
+    asks about many chars can use this for deferring the slow cases.
+  */
+  static bool FontRenderabilityKnown(wxUniChar ch, const wxFont &font = *wxNORMAL_FONT);
+  //! Reads the info which chars the fonts can render from the disk cache
+  static void ReadGlyphCoverage();
+  //! Writes the info which chars the fonts can render to the disk cache
+  static void WriteGlyphCoverage();
   wxTextCtrl *LastActiveTextCtrl() const { return m_lastActiveTextCtrl; }
   void LastActiveTextCtrl(wxTextCtrl *last);
 
@@ -1058,8 +1099,6 @@ private:
   */
   long m_configId;
 public:
-  //! Our random device
-  std::random_device m_rd;
   //! Our random engine
   std::default_random_engine m_eng;
   /*! A counter that increases every time we need to recalculate all worksheet cells
@@ -1072,10 +1111,35 @@ public:
   std::int_fast32_t CellCfgCnt() const {return m_cellCfgCnt;}
   void RecalculateForce() { m_cellCfgCnt++; }
   static bool UseThreads(){return m_use_threads;}
+  /*! Is this a temporary configuration, used for printing or exporting?
+
+    Output to such configurations must be complete on the first draw.
+  */
+  bool IsTemporary() const {return m_initOpts == temporary;}
   static void UseThreads(bool use){m_use_threads = use;}
   static void SetMaximaLang(const wxString &LANG){m_maxima_LANG = LANG;}
   static wxString GetMaximaLang(){return m_maxima_LANG;}
 private:
+  /*! Copies all settings and all state
+
+    Only used by the constructor for temporary configurations, which then
+    drops everything that belongs to the worksheet.
+  */
+  Configuration(const Configuration &) = default;
+  //! The state temporary configurations share with the configuration they were created from
+  struct SharedStyles
+  {
+    Style styles[NUMBEROFSTYLES];
+    StringHash maximaOperators;
+  };
+  /*! The text styles and the operator list
+
+    Shared with all temporary configurations that have been created from this
+    one, see UnshareStyles().
+  */
+  std::shared_ptr<SharedStyles> m_shared = std::make_shared<SharedStyles>();
+  //! Gives us our own copy of m_shared before we change it
+  void UnshareStyles();
   //! Which LANG environment variable to communicate to maxima?
   static wxString m_maxima_LANG;
   //! Which styles affect how code is displayed?
@@ -1085,8 +1149,20 @@ private:
   //! Which styles affect only colors?
   std::vector<TextStyle> m_colorOnlyStyles;
   std::list<FileToSave> m_filesToSave;
-  RenderablecharsHash m_renderableChars;
-  RenderablecharsHash m_nonRenderableChars;
+  /*! Which chars each font is known to render
+
+    The key is the font description plus a fingerprint of the font's metrics
+    so an updated font file doesn't re-use outdated info.
+  */
+  static GlyphCoverageHash m_glyphCoverage;
+  //! Which of the m_glyphCoverage entries a font description translates to
+  static std::unordered_map<wxString, GlyphCoverage *, wxStringHash> m_fontGlyphCoverage;
+  //! True, if m_glyphCoverage contains info the disk cache doesn't know about
+  static bool m_glyphCoverageChanged;
+  //! Guards m_glyphCoverage, m_fontGlyphCoverage and m_glyphCoverageChanged
+  static std::mutex m_glyphCoverageMutex;
+  //! Returns the info which chars the font is known to render. Needs m_glyphCoverageMutex.
+  static GlyphCoverage &GetGlyphCoverage(const wxFont &font);
   //! True if drawing the char this button displays alters at least one pixel
   static bool FontDisplaysChar(wxUniChar ch, const wxFont &font = *wxNORMAL_FONT);
   //! True if drawing the char this button displays differs visibly from otherChar
@@ -1121,7 +1197,7 @@ private:
   //! The worksheet this configuration storage is valid for
   wxWindow *m_workSheet = NULL;
   //! A drawing context that knows the text sizes for the worksheet
-  std::unique_ptr<wxClientDC> m_worksheetDC;
+  std::shared_ptr<wxClientDC> m_worksheetDC;
   /*! Do these chars exist in the given font?
 
     wxWidgets currently doesn't define such a function. But we can do the following:
@@ -1228,9 +1304,11 @@ private:
   bool m_offerKnownAnswers;
   long m_defaultPort;
   long m_maxGnuplotMegabytes;
+  long m_imageCacheMegabytes;
   long m_defaultPlotHeight;
   long m_defaultPlotWidth;
   bool m_saveUntitled;
+  bool m_verifySavedFiles;
   bool m_cursorJump;
   bool m_numpadEnterEvaluates;
   bool m_saveImgFileName;
@@ -1241,7 +1319,7 @@ private:
     draws its sub-cells, but didn't remove them from the list of cells to draw
     after this cell has been drawn.
   */
-  std::unique_ptr<CellRedrawTrace> m_cellRedrawTrace;
+  std::shared_ptr<CellRedrawTrace> m_cellRedrawTrace;
   wxString m_documentclass;
   wxString m_documentclassOptions;
   htmlExportFormat m_htmlEquationFormat;
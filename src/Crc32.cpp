@@ -0,0 +1,73 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  Defines Crc32, the checksum .zip files (and therefore .wxmx files) use.
+*/
+
+#include "Crc32.h"
+#include <array>
+
+namespace {
+  typedef std::array<std::array<uint32_t, 256>, 8> Tables;
+
+  /*! The tables for processing 8 bytes at once ("slicing-by-8")
+
+    tables[0] is the classic byte-wise table, tables[n] tells what a byte
+    contributes to the checksum once n more bytes have been processed.
+  */
+  const Tables &CrcTables() {
+    static const Tables tables = [] {
+      Tables t;
+      for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++)
+          crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320U : 0);
+        t[0][i] = crc;
+      }
+      for (uint32_t i = 0; i < 256; i++)
+        for (std::size_t n = 1; n < t.size(); n++)
+          t[n][i] = (t[n - 1][i] >> 8) ^ t[0][t[n - 1][i] & 0xFF];
+      return t;
+    }();
+    return tables;
+  }
+}
+
+uint32_t Crc32::Update(uint32_t crc, const void *data, std::size_t length) {
+  const Tables &t = CrcTables();
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  crc = ~crc;
+  while (length >= 8) {
+    uint32_t low = crc ^ (static_cast<uint32_t>(bytes[0]) |
+                          (static_cast<uint32_t>(bytes[1]) << 8) |
+                          (static_cast<uint32_t>(bytes[2]) << 16) |
+                          (static_cast<uint32_t>(bytes[3]) << 24));
+    crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^
+      t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+      t[3][bytes[4]] ^ t[2][bytes[5]] ^ t[1][bytes[6]] ^ t[0][bytes[7]];
+    bytes += 8;
+    length -= 8;
+  }
+  while (length-- > 0)
+    crc = (crc >> 8) ^ t[0][(crc ^ *bytes++) & 0xFF];
+  return ~crc;
+}
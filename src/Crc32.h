@@ -0,0 +1,52 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  Declares Crc32, the checksum .zip files (and therefore .wxmx files) use.
+
+  Doesn't depend on wxWidgets, so it can be tested on its own.
+*/
+
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*! The CRC-32 checksum of the .zip format (the one zlib's crc32() calculates)
+
+  wxWidgets doesn't publish the checksum function of its zip streams, so we
+  need our own one in order to find out if the contents of an entry have
+  changed without writing them.
+*/
+namespace Crc32 {
+  /*! Continues a checksum with the next part of the data
+
+    \param crc The checksum of the data before this part; 0 for the first part
+    \return The checksum of all data up to including this part
+  */
+  uint32_t Update(uint32_t crc, const void *data, std::size_t length);
+  //! The checksum of a block of data
+  inline uint32_t Compute(const void *data, std::size_t length)
+  { return Update(0, data, length); }
+}
+
+#endif // CRC32_H
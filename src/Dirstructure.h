@@ -102,6 +102,18 @@ public:
       return UserConfDir() + "/manual_anchors.xml";
     }
 
+  //! The file we cache the info which chars the fonts can render in
+  static wxString GlyphCoverageCacheFile()
+    {
+      return UserConfDir() + "/glyph_coverage.bin";
+    }
+
+  //! The file we cache the heights of the cells of recently opened documents in
+  static wxString LayoutCacheFile()
+    {
+      return UserConfDir() + "/layout_cache.bin";
+    }
+
   static Dirstructure *Get()
     {
       return m_dirStructure;
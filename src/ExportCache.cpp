@@ -0,0 +1,182 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  Defines ExportCache, which lets exports reuse the image files of the last export.
+*/
+
+#include "ExportCache.h"
+#include <wx/dir.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/txtstrm.h>
+#include <wx/wfstream.h>
+#ifdef __WXMSW__
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+ExportCache::ExportCache(const wxString &directory):
+  m_directory(directory)
+{
+  // Files an export that didn't end has moved aside
+  wxDir dir(m_directory);
+  if (!dir.IsOpened())
+    return;
+  wxArrayString oldFiles;
+  wxString oldFile;
+  for (bool found = dir.GetFirst(&oldFile, wxS(".old_*"), wxDIR_FILES | wxDIR_HIDDEN); found;
+       found = dir.GetNext(&oldFile))
+    oldFiles.Add(oldFile);
+  for (const auto &i : oldFiles)
+    wxRemoveFile(Path(i));
+
+  wxString manifest = Path(ManifestName());
+  if (!wxFileExists(manifest))
+    return;
+  {
+    wxFileInputStream file(manifest);
+    if (!file.IsOk())
+      return;
+    wxTextInputStream text(file);
+    if (text.ReadLine() == wxS("wxMaxima export cache 1")) {
+      while (!file.Eof()) {
+        // The file name comes last, since it may contain spaces
+        wxString line = text.ReadLine();
+        wxString key = line.BeforeFirst(wxS(' '));
+        line = line.AfterFirst(wxS(' '));
+        wxString fileSize = line.BeforeFirst(wxS(' '));
+        line = line.AfterFirst(wxS(' '));
+        wxString width = line.BeforeFirst(wxS(' '));
+        line = line.AfterFirst(wxS(' '));
+        wxString height = line.BeforeFirst(wxS(' '));
+        line = line.AfterFirst(wxS(' '));
+        unsigned long long keyValue, fileSizeValue;
+        long widthValue, heightValue;
+        if (line.IsEmpty() || !key.ToULongLong(&keyValue, 16) ||
+            !fileSize.ToULongLong(&fileSizeValue) ||
+            !width.ToLong(&widthValue) || !height.ToLong(&heightValue))
+          continue;
+        // Files somebody else has changed or deleted cannot be reused
+        if (wxFileName::GetSize(Path(line)) != wxULongLong(fileSizeValue))
+          continue;
+        m_files[line] = File{keyValue, fileSizeValue,
+                             wxSize(widthValue, heightValue), false};
+        m_byKey[keyValue] = line;
+      }
+    }
+  }
+  // The files will change before the new manifest is written
+  wxRemoveFile(manifest);
+}
+
+uint64_t ExportCache::Key(const wxString &data, uint64_t key) {
+  wxScopedCharBuffer utf8 = data.utf8_str();
+  return Key(utf8.data(), utf8.length(), key);
+}
+
+bool ExportCache::Reuse(const wxString &name, uint64_t key, wxSize *size) {
+  auto file = m_files.find(name);
+  if (file != m_files.end()) {
+    if ((file->second.key == key) && (!file->second.used)) {
+      file->second.used = true;
+      if (size)
+        *size = file->second.size;
+      m_reused++;
+      return true;
+    }
+    if (!file->second.used) {
+      // The file is overwritten. Its old contents may be needed under another
+      // name later in the export, though, so it is moved aside instead of
+      // being deleted. Commit() deletes it if it isn't needed.
+      File old = file->second;
+      m_files.erase(file);
+      auto source = m_byKey.find(old.key);
+      if ((source != m_byKey.end()) && (source->second == name)) {
+        wxString aside = wxString::Format(wxS(".old_%llx"),
+                                          static_cast<unsigned long long>(old.key));
+        if (wxRenameFile(Path(name), Path(aside))) {
+          m_files[aside] = old;
+          source->second = aside;
+        } else
+          m_byKey.erase(source);
+      }
+    }
+  }
+  // Deleting the file before it is written keeps hard links to it unchanged
+  if (wxFileExists(Path(name)))
+    wxRemoveFile(Path(name));
+
+  auto source = m_byKey.find(key);
+  if ((source == m_byKey.end()) || !Link(Path(source->second), Path(name)))
+    return false;
+  File linked = m_files[source->second];
+  linked.used = true;
+  m_files[name] = linked;
+  if (size)
+    *size = linked.size;
+  m_reused++;
+  return true;
+}
+
+void ExportCache::Stored(const wxString &name, uint64_t key, wxSize size) {
+  // The file may still be being written by a background task => it cannot be
+  // the source of a link, yet.
+  m_files[name] = File{key, wxInvalidSize, size, true};
+}
+
+bool ExportCache::Commit() {
+  wxFileOutputStream file(Path(ManifestName()));
+  if (!file.IsOk())
+    return false;
+  wxTextOutputStream text(file);
+  text << wxS("wxMaxima export cache 1\n");
+  for (auto &i : m_files) {
+    if (!i.second.used) {
+      wxRemoveFile(Path(i.first));
+      continue;
+    }
+    if (i.second.fileSize == wxInvalidSize)
+      i.second.fileSize = wxFileName::GetSize(Path(i.first));
+    // Files that couldn't be written aren't remembered
+    if (i.second.fileSize == wxInvalidSize)
+      continue;
+    text << wxString::Format(wxS("%llx %llu %i %i "),
+                             static_cast<unsigned long long>(i.second.key),
+                             static_cast<unsigned long long>(i.second.fileSize.GetValue()),
+                             i.second.size.x, i.second.size.y)
+         << i.first << wxS("\n");
+  }
+  return file.Close();
+}
+
+bool ExportCache::Link(const wxString &from, const wxString &to) const {
+  // If the file system doesn't support hard links a copy will do.
+#ifdef __WXMSW__
+  if (CreateHardLinkW(to.wc_str(), from.wc_str(), NULL))
+    return true;
+#else
+  if (link(from.fn_str(), to.fn_str()) == 0)
+    return true;
+#endif
+  return wxCopyFile(from, to);
+}
@@ -0,0 +1,126 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  Declares ExportCache, which lets exports reuse the image files of the last export.
+*/
+
+#ifndef EXPORTCACHE_H
+#define EXPORTCACHE_H
+
+#include "precomp.h"
+#include "LayoutCache.h"
+#include <wx/buffer.h>
+#include <wx/gdicmn.h>
+#include <wx/string.h>
+#include <cstdint>
+#include <unordered_map>
+
+/*! The image files the last export to a directory has written, keyed by what they show
+
+  An HTML or TeX export writes a file for every image and, depending on the
+  settings, for every equation. After a small change re-exporting a big
+  document wrote all of them again. The export cache remembers the key each
+  file has been created from, which is a hash of the cell's contents and of
+  the settings the file depends on:
+
+  - If a file is to be written with the key it already has, it is kept.
+  - If another file of the last export has this key, for example since a cell
+    has been inserted before it, it is hard-linked, or if that doesn't work,
+    copied.
+  - Files of the last export that the new export doesn't need are deleted
+    by Commit().
+
+  The keys are stored in a manifest in the directory. The manifest is deleted
+  as soon as a new export starts and written again only by Commit(), so a
+  cancelled export never leaves behind keys that don't match their files. A
+  file whose size doesn't match the one in the manifest has been changed by
+  someone else and is never reused.
+*/
+class ExportCache
+{
+public:
+  //! Reads the manifest the last export has left in the directory
+  explicit ExportCache(const wxString &directory);
+
+  /*! Hashes data into a key
+
+    \param key The key of the data before this part, in order to hash data
+    that consists of several parts
+  */
+  static uint64_t Key(const void *data, std::size_t length, uint64_t key = LayoutCache::HashStart)
+    { return LayoutCache::Hash(data, length, key); }
+  static uint64_t Key(const wxString &data, uint64_t key = LayoutCache::HashStart);
+  static uint64_t Key(const wxMemoryBuffer &data, uint64_t key = LayoutCache::HashStart)
+    { return Key(data.GetData(), data.GetDataLen(), key); }
+
+  /*! Makes a file contain what the last export wrote for this key
+
+    \param name The name of the file, relative to the directory
+    \param key The key of the contents the file is to have
+    \param size Receives the size of the image that has been passed to Stored()
+    \return true, if the file now exists with this contents and doesn't need
+    to be written. If not, the old file has been deleted, so writing the new
+    one cannot change a file that is hard-linked to it.
+  */
+  bool Reuse(const wxString &name, uint64_t key, wxSize *size = NULL);
+  /*! Records that a file is written for this key
+
+    \param size The size of the image, if the export needs it for its markup
+  */
+  void Stored(const wxString &name, uint64_t key, wxSize size = wxDefaultSize);
+  /*! Deletes the files of the last export the new one didn't need and writes the manifest
+
+    Must only be called after all files have been written.
+
+    \return false, if the manifest couldn't be written.
+  */
+  bool Commit();
+
+  //! The number of files Reuse() has provided
+  std::size_t GetReused() const { return m_reused; }
+  //! The name of the manifest
+  static wxString ManifestName() { return wxS(".wxmaxima_export_cache"); }
+
+private:
+  struct File
+  {
+    uint64_t key;
+    //! The size of the file, or wxInvalidSize if it isn't known, yet
+    wxULongLong fileSize;
+    //! The size of the image
+    wxSize size;
+    //! Is the file part of the new export?
+    bool used;
+  };
+  //! Hard-links or copies a file
+  bool Link(const wxString &from, const wxString &to) const;
+  wxString Path(const wxString &name) const { return m_directory + wxS("/") + name; }
+
+  wxString m_directory;
+  //! The files of the last and of the new export, by name
+  std::unordered_map<wxString, File, wxStringHash> m_files;
+  //! A file that has the contents for a key, by key
+  std::unordered_map<uint64_t, wxString> m_byKey;
+  std::size_t m_reused = 0;
+};
+
+#endif // EXPORTCACHE_H
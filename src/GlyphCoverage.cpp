@@ -0,0 +1,132 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  Defines GlyphCoverage, which remembers which characters a font can render.
+*/
+
+#include "GlyphCoverage.h"
+#include <wx/datstrm.h>
+#include <algorithm>
+
+GlyphCoverage::GlyphCoverage():
+  m_known(BMP_Words, 0),
+  m_rendered(BMP_Words, 0)
+{
+}
+
+GlyphCoverage::State GlyphCoverage::Get(wxUniChar ch) const {
+  uint32_t code = ch.GetValue();
+  if (code < BMP_Size) {
+    uint64_t mask = uint64_t(1) << (code % 64);
+    if (!(m_known[code / 64] & mask))
+      return unknown;
+    return (m_rendered[code / 64] & mask) ? renders : missing;
+  }
+  auto astral = m_astral.find(code);
+  if (astral == m_astral.end())
+    return unknown;
+  return astral->second ? renders : missing;
+}
+
+void GlyphCoverage::Set(wxUniChar ch, bool rendered) {
+  uint32_t code = ch.GetValue();
+  if (code < BMP_Size) {
+    uint64_t mask = uint64_t(1) << (code % 64);
+    if (!(m_known[code / 64] & mask))
+      m_knownCount++;
+    m_known[code / 64] |= mask;
+    if (rendered)
+      m_rendered[code / 64] |= mask;
+    else
+      m_rendered[code / 64] &= ~mask;
+    return;
+  }
+  if (m_astral.find(code) == m_astral.end())
+    m_knownCount++;
+  m_astral[code] = rendered;
+}
+
+void GlyphCoverage::Clear() {
+  std::fill(m_known.begin(), m_known.end(), 0);
+  std::fill(m_rendered.begin(), m_rendered.end(), 0);
+  m_astral.clear();
+  m_knownCount = 0;
+}
+
+void GlyphCoverage::Write(wxOutputStream &stream) const {
+  wxDataOutputStream data(stream);
+  // Only the words that contain at least one known character are written
+  uint32_t usedWords = 0;
+  for (auto i : m_known)
+    if (i != 0)
+      usedWords++;
+  data.Write32(usedWords);
+  for (std::size_t i = 0; i < BMP_Words; i++) {
+    if (m_known[i] == 0)
+      continue;
+    data.Write32(static_cast<wxUint32>(i));
+    data.Write64(m_known[i]);
+    data.Write64(m_rendered[i]);
+  }
+  data.Write32(static_cast<wxUint32>(m_astral.size()));
+  for (const auto &i : m_astral) {
+    data.Write32(i.first);
+    data.Write8(i.second);
+  }
+}
+
+bool GlyphCoverage::Read(wxInputStream &stream) {
+  Clear();
+  wxDataInputStream data(stream);
+  uint32_t usedWords = data.Read32();
+  if (!stream.IsOk() || (usedWords > BMP_Words))
+    return false;
+  for (uint32_t i = 0; i < usedWords; i++) {
+    uint32_t word = data.Read32();
+    uint64_t known = data.Read64();
+    uint64_t rendered = data.Read64();
+    if (!stream.IsOk() || (word >= BMP_Words)) {
+      Clear();
+      return false;
+    }
+    m_known[word] = known;
+    m_rendered[word] = rendered & known;
+    for (; known != 0; known &= known - 1)
+      m_knownCount++;
+  }
+  uint32_t astralChars = data.Read32();
+  if (!stream.IsOk()) {
+    Clear();
+    return false;
+  }
+  for (uint32_t i = 0; i < astralChars; i++) {
+    uint32_t code = data.Read32();
+    bool rendered = data.Read8() != 0;
+    if (!stream.IsOk()) {
+      Clear();
+      return false;
+    }
+    m_astral[code] = rendered;
+    m_knownCount++;
+  }
+  return true;
+}
@@ -0,0 +1,84 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  Declares GlyphCoverage, which remembers which characters a font can render.
+*/
+
+#ifndef GLYPHCOVERAGE_H
+#define GLYPHCOVERAGE_H
+
+#include "precomp.h"
+#include <wx/string.h>
+#include <wx/stream.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/*! Which characters a font is known to render and which ones it is known not to
+
+  Finding out if a font renders a character means drawing it to a bitmap, which
+  is slow. This class remembers the outcome for each character, using two bits
+  per character of the Basic Multilingual Plane and a small hashmap for the
+  rest of unicode. Looking up a character therefore is O(1).
+*/
+class GlyphCoverage
+{
+public:
+  //! What we know about a character
+  enum State : uint8_t
+  {
+    unknown,  //!< Not probed, yet
+    renders,  //!< The font renders this character
+    missing   //!< The font doesn't render this character
+  };
+
+  GlyphCoverage();
+  //! What do we know about the character ch?
+  State Get(wxUniChar ch) const;
+  //! Remember if the font renders ch
+  void Set(wxUniChar ch, bool rendered);
+  //! Forget everything we know about this font
+  void Clear();
+  //! True if no character of this font has been probed, yet
+  bool IsEmpty() const {return m_knownCount == 0;}
+
+  //! Writes this coverage info to a stream
+  void Write(wxOutputStream &stream) const;
+  //! Reads coverage info written by Write(). Returns false if the data is unusable.
+  bool Read(wxInputStream &stream);
+
+private:
+  //! The number of characters that fit into the bitsets
+  static constexpr uint32_t BMP_Size = 0x10000;
+  //! The number of 64-bit words each bitset consists of
+  static constexpr std::size_t BMP_Words = BMP_Size / 64;
+  //! One bit per BMP character: Has this character been probed?
+  std::vector<uint64_t> m_known;
+  //! One bit per BMP character: Does the font render this character?
+  std::vector<uint64_t> m_rendered;
+  //! What we know about characters outside the BMP
+  std::unordered_map<uint32_t, bool> m_astral;
+  //! How many characters we know about
+  std::size_t m_knownCount = 0;
+};
+
+#endif // GLYPHCOVERAGE_H
@@ -37,11 +37,16 @@
 #include "nanosvg_private.h"
 #include "nanosvgrast_private.h"
 #include <Image.h>
+#include "ImageCacheBudget.h"
+#include "WxmxArchive.h"
+#include <algorithm>
+#include <chrono>
 #include <vector>
 #include <utility>
 #include <wx/log.h>
 #include "StringUtils.h"
 #include "SvgBitmap.h"
+#include "RasterBands.h"
 #include <wx/mstream.h>
 #include <wx/regex.h>
 #include <wx/stdpaths.h>
@@ -97,6 +102,7 @@ Image::Image(Configuration *config, const wxString &image,
 }
 
 Image::Image(Configuration *config, const Image &image) {
+  image.m_loadImageTask.Wait();
   m_svgImage = NULL;
   m_configuration = config;
   m_scaledBitmap.Create(1, 1);
@@ -110,10 +116,16 @@ Image::Image(Configuration *config, const Image &image) {
 }
 
 Image::~Image() {
-  if(m_loadImageTask.joinable())
-    m_loadImageTask.join();
-  if(m_loadGnuplotSourceTask.joinable())
-    m_loadGnuplotSourceTask.join();
+  ImageCacheBudget::Forget(this);
+  // Don't decode or scale images nobody will see any more. A load that now
+  // never starts still has to delete the temporary file it was to read.
+  if (m_loadImageTask.Cancel() && (!m_fileToRemove.IsEmpty())) {
+    wxLogNull suppressor;
+    wxRemoveFile(m_fileToRemove);
+  }
+  m_loadImageTask.CancelAndWait();
+  m_rescaleTask.CancelAndWait();
+  m_loadGnuplotSourceTask.CancelAndWait();
   if (!m_gnuplotSource.IsEmpty()) {
     if (wxFileExists(m_gnuplotSource))
     {
@@ -155,14 +167,14 @@ wxMemoryBuffer Image::ReadCompressedImage(wxInputStream *data) {
 }
 
 wxBitmap Image::GetUnscaledBitmap() {
-  if(m_loadImageTask.joinable())
-    m_loadImageTask.join();
+  m_loadImageTask.Wait();
+  // The svg rasterizer mustn't be used by two threads at once
+  WaitForRescale();
 
   if (m_svgRast) {
     std::vector<unsigned char> imgdata(m_originalWidth * m_originalHeight * 4);
 
-    wxm_nsvgRasterize(m_svgRast.get(), m_svgImage, 0, 0, 1, imgdata.data(),
-                      m_originalWidth, m_originalHeight, m_originalWidth * 4);
+    RasterizeSVG(imgdata.data(), m_originalWidth, m_originalHeight, 1);
     return RGBA2wxBitmap(imgdata.data(), m_originalWidth,
                          m_originalHeight);
   } else {
@@ -177,49 +189,45 @@ wxBitmap Image::GetUnscaledBitmap() {
 }
 
 const wxMemoryBuffer Image::GetCompressedImage() const {
-  if(m_loadImageTask.joinable())
-    m_loadImageTask.join();
+  m_loadImageTask.Wait();
   return m_compressedImage;
 }
 
 std::size_t Image::GetOriginalWidth() const {
-  if(m_loadImageTask.joinable())
-    m_loadImageTask.join();
+  m_loadImageTask.Wait();
 
   return m_originalWidth;
 }
 
 std::size_t Image::GetOriginalHeight() const {
-  if(m_loadImageTask.joinable())
-    m_loadImageTask.join();
+  m_loadImageTask.Wait();
 
   return m_originalHeight;
 }
 
 void Image::GnuplotSource(wxString gnuplotFilename, wxString dataFilename,
                           const wxString &wxmxFile) {
-  if(m_loadGnuplotSourceTask.joinable())
-    m_loadGnuplotSourceTask.join();
+  m_loadGnuplotSourceTask.Wait();
   m_gnuplotSource = std::move(gnuplotFilename);
   m_gnuplotData = std::move(dataFilename);
-  std::unique_ptr<ThreadNumberLimiter> limiter(new
-                                               ThreadNumberLimiter(&m_gnuplotDataThreadRunning));
   if(m_configuration->UseThreads())
-    m_loadGnuplotSourceTask = jthread(&Image::LoadGnuplotSource_Backgroundtask,
-                                      this,
-                                      std::move(limiter),
-                                      m_gnuplotSource, m_gnuplotData, wxmxFile);
+  {
+    wxString gnuplotSource = m_gnuplotSource;
+    wxString gnuplotData = m_gnuplotData;
+    m_loadGnuplotSourceTask =
+      ThreadPool::Get().Submit(ThreadPool::indexing,
+                               [this, gnuplotSource, gnuplotData, wxmxFile] {
+                                 LoadGnuplotSource_Backgroundtask(
+                                   gnuplotSource, gnuplotData, wxmxFile);
+                               });
+  }
   else
-    LoadGnuplotSource_Backgroundtask(
-      std::move(limiter),
-      m_gnuplotSource, m_gnuplotData, wxmxFile);
+    LoadGnuplotSource_Backgroundtask(m_gnuplotSource, m_gnuplotData, wxmxFile);
 }
 
 void Image::LoadGnuplotSource_Backgroundtask(
-  std::unique_ptr<ThreadNumberLimiter> limiter,
   wxString gnuplotFile, wxString dataFile, wxString wxmxFile)
 {
-  std::unique_ptr<ThreadNumberLimiter> threadNumLimit = std::move(limiter);
   if(wxmxFile.IsEmpty())
   {
     {
@@ -233,39 +241,37 @@ void Image::LoadGnuplotSource_Backgroundtask(
   }
   else
   {
-    {
-      wxFileInputStream wxmx(wxmxFile);
-      WxmxStream source(wxmx, gnuplotFile);
-      LoadGnuplotSource(&source);
-    }
-    {
-      wxFileInputStream wxmx(wxmxFile);
-      WxmxStream data(wxmx, dataFile);
-      LoadGnuplotData(&data);
-    }
+    std::shared_ptr<const WxmxArchive> wxmx = WxmxArchive::Open(wxmxFile);
+    if (!wxmx)
+      return;
+    std::unique_ptr<wxInputStream> source = wxmx->OpenEntry(gnuplotFile);
+    if (source)
+      LoadGnuplotSource(source.get());
+    std::unique_ptr<wxInputStream> data = wxmx->OpenEntry(dataFile);
+    if (data)
+      LoadGnuplotData(data.get());
   }
 }
 
 void Image::CompressedGnuplotSource(wxString gnuplotFilename, wxString dataFilename,
                                     const wxString &wxmxFile) {
-  if(m_loadGnuplotSourceTask.joinable())
-    m_loadGnuplotSourceTask.join();
-  std::unique_ptr<ThreadNumberLimiter> limiter(new
-                                               ThreadNumberLimiter(&m_gnuplotDataThreadRunning));
+  m_loadGnuplotSourceTask.Wait();
 
   m_gnuplotSource = std::move(gnuplotFilename);
   m_gnuplotData = std::move(dataFilename);
   if(m_configuration->UseThreads())
+  {
+    wxString gnuplotSource = m_gnuplotSource;
+    wxString gnuplotData = m_gnuplotData;
     m_loadGnuplotSourceTask =
-      jthread(&Image::LoadCompressedGnuplotSource_Backgroundtask,
-              this,
-              std::move(limiter),
-              m_gnuplotSource,
-              m_gnuplotData,
-              wxmxFile);
+      ThreadPool::Get().Submit(ThreadPool::indexing,
+                               [this, gnuplotSource, gnuplotData, wxmxFile] {
+                                 LoadCompressedGnuplotSource_Backgroundtask(
+                                   gnuplotSource, gnuplotData, wxmxFile);
+                               });
+  }
   else
     LoadCompressedGnuplotSource_Backgroundtask(
-      std::move(limiter),
       m_gnuplotSource,
       m_gnuplotData,
       wxmxFile);
@@ -313,7 +319,7 @@ void Image::LoadGnuplotSource(
     textOut.Flush();
     zstream.Close();
 
-    m_gnuplotSource_Compressed.Clear();
+    m_gnuplotSource_Compressed = wxMemoryBuffer();
     m_gnuplotSource_Compressed.AppendData(
       mstream.GetOutputStreamBuffer()->GetBufferStart(),
       mstream.GetOutputStreamBuffer()->GetBufferSize());
@@ -345,7 +351,7 @@ void Image::LoadGnuplotData(
     textOut.Flush();
     zstream.Close();
 
-    m_gnuplotData_Compressed.Clear();
+    m_gnuplotData_Compressed = wxMemoryBuffer();
     m_gnuplotData_Compressed.AppendData(
       mstream.GetOutputStreamBuffer()->GetBufferStart(),
       mstream.GetOutputStreamBuffer()->GetBufferSize());
@@ -353,57 +359,32 @@ void Image::LoadGnuplotData(
 }
 
 void Image::LoadCompressedGnuplotSource_Backgroundtask(
-  std::unique_ptr<ThreadNumberLimiter> limiter,
   wxString sourcefile,
   wxString datafile,
   wxString wxmxFile
   ) {
-  std::unique_ptr<ThreadNumberLimiter> threadNumLimit = std::move(limiter);
+  std::shared_ptr<const WxmxArchive> wxmx = WxmxArchive::Open(wxmxFile);
+  if (!wxmx)
+    return;
+  // Read the gnuplot source
   {
-    // Read the gnuplot source
-    {
-      wxFileInputStream wxmx(wxmxFile);
-      WxmxStream source(wxmx, sourcefile);
-      if (!source.Eof()) {
-        m_gnuplotSource_Compressed.Clear();
-        wxMemoryOutputStream mstream;
-        source.Read(mstream);
-        m_gnuplotSource_Compressed.AppendData(
-          mstream.GetOutputStreamBuffer()->GetBufferStart(),
-          mstream.GetOutputStreamBuffer()->GetBufferSize());
-      }
-    }
-    // Read the gnuplot data
-    {
-      m_gnuplotData_Compressed.Clear();
-      wxFileInputStream wxmx(wxmxFile);
-      WxmxStream data(wxmx, datafile);
-      if (!data.Eof()) { // open successful
-        wxMemoryOutputStream mstream;
-        data.Read(mstream);
-        m_gnuplotData_Compressed.AppendData(
-          mstream.GetOutputStreamBuffer()->GetBufferStart(),
-          mstream.GetOutputStreamBuffer()->GetBufferSize());
-      }
+    std::unique_ptr<wxInputStream> source = wxmx->OpenEntry(sourcefile);
+    if (source) {
+      m_gnuplotSource_Compressed = ReadCompressedImage(source.get());
     }
   }
-}
-
-Image::WxmxStream::WxmxStream(wxInputStream &wxmxFile, const wxString &fileInWxmx):
-  wxZipInputStream(wxmxFile, wxConvLocal)
-{
-  while(!Eof())
+  // Read the gnuplot data
   {
-    wxZipEntry *contentsEntry = NULL;
-    contentsEntry = GetNextEntry();
-    if((!contentsEntry) || (contentsEntry->GetName() == fileInWxmx))
-      break;
+    m_gnuplotData_Compressed = wxMemoryBuffer();
+    std::unique_ptr<wxInputStream> data = wxmx->OpenEntry(datafile);
+    if (data) { // open successful
+      m_gnuplotData_Compressed = ReadCompressedImage(data.get());
+    }
   }
 }
 
 const wxMemoryBuffer Image::GetGnuplotSource() {
-  if(m_loadGnuplotSourceTask.joinable())
-    m_loadGnuplotSourceTask.join();
+  m_loadGnuplotSourceTask.Wait();
 
   wxMemoryBuffer retval;
   if ((m_gnuplotSource_Compressed.GetDataLen() < 2) ||
@@ -434,21 +415,18 @@ const wxMemoryBuffer Image::GetGnuplotSource() {
 
 const wxMemoryBuffer Image::GetCompressedGnuplotSource()
 {
-  if(m_loadGnuplotSourceTask.joinable())
-    m_loadGnuplotSourceTask.join();
+  m_loadGnuplotSourceTask.Wait();
   return m_gnuplotSource_Compressed;
 }
 
 const wxMemoryBuffer Image::GetCompressedGnuplotData()
 {
-  if(m_loadGnuplotSourceTask.joinable())
-    m_loadGnuplotSourceTask.join();
+  m_loadGnuplotSourceTask.Wait();
   return m_gnuplotData_Compressed;
 }
 
 const wxMemoryBuffer Image::GetGnuplotData() {
-  if(m_loadGnuplotSourceTask.joinable())
-    m_loadGnuplotSourceTask.join();
+  m_loadGnuplotSourceTask.Wait();
   wxMemoryBuffer retval;
   if ((m_gnuplotSource_Compressed.GetDataLen() < 2) ||
       (m_gnuplotData_Compressed.GetDataLen() < 2)) {
@@ -477,8 +455,7 @@ const wxMemoryBuffer Image::GetGnuplotData() {
 }
 
 wxString Image::GnuplotData() {
-  if(m_loadGnuplotSourceTask.joinable())
-    m_loadGnuplotSourceTask.join();
+  m_loadGnuplotSourceTask.Wait();
   if ((!m_gnuplotData.IsEmpty()) && (!wxFileExists(m_gnuplotData))) {
     // Move the gnuplot data and data file into our temp directory
     wxFileName gnuplotSourceFile(m_gnuplotSource);
@@ -512,8 +489,7 @@ wxString Image::GnuplotData() {
 }
 
 wxString Image::GnuplotSource() {
-  if(m_loadGnuplotSourceTask.joinable())
-    m_loadGnuplotSourceTask.join();
+  m_loadGnuplotSourceTask.Wait();
   if ((!m_gnuplotSource.IsEmpty()) && (!wxFileExists(m_gnuplotSource))) {
     // Move the gnuplot source and data file into our temp directory
     wxFileName gnuplotSourceFile(m_gnuplotSource);
@@ -553,8 +529,7 @@ wxString Image::GnuplotSource() {
 }
 
 wxSize Image::ToImageFile(wxString filename) {
-  if(m_loadImageTask.joinable())
-    m_loadImageTask.join();
+  m_loadImageTask.Wait();
   wxFileName fn(filename);
   wxString ext = fn.GetExt();
   if (filename.Lower().EndsWith(GetExtension().Lower())) {
@@ -622,26 +597,181 @@ wxSize Image::ToImageFile(wxString filename) {
   }
 }
 
+long long Image::m_firstPlotTimerStart = -1;
+long Image::m_timeToFirstVisiblePlot = -1;
+
+//! The current time [in milliseconds], for measuring durations
+static long long MonotonicMilliseconds() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Image::StartFirstPlotTimer() {
+  m_firstPlotTimerStart = MonotonicMilliseconds();
+  m_timeToFirstVisiblePlot = -1;
+}
+
+void Image::StopFirstPlotTimer() {
+  if ((m_firstPlotTimerStart < 0) || (!InWorksheet()) || (m_width < 2) ||
+      (m_scaledBitmap.GetWidth() != m_width) || (m_scaledBitmap.GetHeight() != m_height))
+    return;
+  m_timeToFirstVisiblePlot =
+    static_cast<long>(MonotonicMilliseconds() - m_firstPlotTimerStart);
+  m_firstPlotTimerStart = -1;
+  wxLogMessage(_("Time to the first visible plot: %li ms"), m_timeToFirstVisiblePlot);
+}
+
 wxBitmap Image::GetBitmap(double scale) {
-  if(m_loadImageTask.joinable())
-    m_loadImageTask.join();
+  wxBitmap bitmap = ScaledBitmap(scale);
+  if (IsLoading())
+    return bitmap;
+  TouchCache();
+  StopFirstPlotTimer();
+  return bitmap;
+}
+
+wxBitmap Image::BlankBitmap(wxSize size) {
+  wxBitmap placeholder(size);
+  wxMemoryDC dc(placeholder);
+  dc.SetBackground(*wxWHITE_BRUSH);
+  dc.Clear();
+  return placeholder;
+}
+
+bool Image::IsLoading() const {
+  return m_loading && InWorksheet();
+}
+
+bool Image::InWorksheet() const {
+  // Printouts and exports use temporary configurations and delete their
+  // images afterwards.
+  return m_configuration && (!m_configuration->GetPrinting()) &&
+    (!m_configuration->IsTemporary());
+}
+
+void Image::TouchCache() {
+  // Nothing has been cached for an image that is still being loaded.
+  if (IsLoading())
+    return;
+  m_loadImageTask.Wait();
+  if (InWorksheet())
+    ImageCacheBudget::Touch(this, CachedBytes());
+}
+
+void Image::SetViewportDistance(double screens) {
+  ThreadPool::Priority priority = ThreadPool::visible;
+  if (screens > 0)
+    priority = ThreadPool::prefetch;
+  if (screens > PrefetchDistance)
+    priority = ThreadPool::indexing;
+
+  if (screens > CancelDistance) {
+    // The worksheet cannot be laid out before the image has been loaded, so
+    // loading is never cancelled, just done in a different order.
+    if ((!m_loadImageTask.Done()) && InWorksheet())
+      m_loadImageTask.SetPriority(priority);
+    else
+      CancelPrefetch();
+  }
+  else
+    Prefetch(priority);
+}
+
+void Image::Prefetch(ThreadPool::Priority priority) {
+  if ((!InWorksheet()) || (!m_configuration->UseThreads()))
+    return;
+  if (!m_loadImageTask.Done()) {
+    m_loadImageTask.SetPriority(priority);
+    return;
+  }
+  // Images that are further away only need to be loaded.
+  if (priority == ThreadPool::indexing)
+    return;
+
+  // Recalculate() hasn't told us the size the image will be drawn with, yet.
+  if ((m_width < 2) || (m_height < 2))
+    return;
+  wxSize size(m_width, m_height);
+  if (m_scaledBitmap.GetSize() == size)
+    return;
+  {
+    const std::lock_guard<std::mutex> lock(m_rescaleMutex);
+    if ((m_rescaledSize == size) && (!m_rescaling))
+      return;
+  }
+  StartRescale(size, priority);
+}
+
+void Image::CancelPrefetch() {
+  if (m_rescaleTask.Cancel()) {
+    const std::lock_guard<std::mutex> lock(m_rescaleMutex);
+    m_rescaling = false;
+    m_rescaleTask = ThreadPool::Task();
+  }
+}
+
+bool Image::ScaledBitmapReady() {
+  if (IsLoading())
+    return false;
+  m_loadImageTask.Wait();
+  wxSize size(m_width, m_height);
+  if (m_scaledBitmap.GetSize() == size)
+    return true;
+  const std::lock_guard<std::mutex> lock(m_rescaleMutex);
+  return (m_rescaledSize == size) && m_rescaledImage.IsOk();
+}
+
+wxBitmap Image::ScaledBitmap(double scale) {
+  // Drawing doesn't wait for an image that is still being loaded: The
+  // worksheet is laid out and drawn again once it has been loaded.
+  if (IsLoading()) {
+    Recalculate(scale);
+    return BlankBitmap(wxSize(m_width, m_height));
+  }
+  m_loadImageTask.Wait();
   // Recalculate contains its own WaitForLoad object.
   Recalculate(scale);
 
-  wxLogBuffer errorAggregator;
   // Let's see if we have cached the scaled bitmap with the right size
-  if (m_scaledBitmap.GetWidth() == m_width)
+  if ((m_scaledBitmap.GetWidth() == m_width) && (m_scaledBitmap.GetHeight() == m_height))
     return m_scaledBitmap;
 
+  if (m_configuration->UseThreads() && InWorksheet()) {
+    wxSize size(m_width, m_height);
+    bool rescaleFailed = false;
+    {
+      const std::lock_guard<std::mutex> lock(m_rescaleMutex);
+      if (m_rescaledSize == size) {
+        if (m_rescaledImage.IsOk()) {
+          m_scaledBitmap = ScaledImage2Bitmap(m_rescaledImage);
+          m_rescaledImage = wxImage();
+          m_rescaledSize = wxDefaultSize;
+          return m_scaledBitmap;
+        }
+        // The background task could not decode the image => Let the
+        // synchronous code below generate the error message.
+        rescaleFailed = !m_rescaling;
+      }
+    }
+    if (!rescaleFailed) {
+      StartRescale(size);
+      wxImage preview = PyramidPreview(size);
+      if (preview.IsOk())
+        return ScaledImage2Bitmap(preview);
+      // No preview, yet: Show an empty frame until the image is ready.
+      return BlankBitmap(size);
+    }
+  }
+  WaitForRescale();
+
+  wxLogBuffer errorAggregator;
   // Seems like we need to create a new scaled bitmap.
   if (m_svgRast) {
     // First create rgba data
     std::vector<unsigned char> imgdata(static_cast<std::size_t>(m_width) * m_height * 4);
 
-    wxm_nsvgRasterize(m_svgRast.get(), m_svgImage, 0, 0,
-                      static_cast<double>(m_width) / (static_cast<double>(m_originalWidth)),
-                      imgdata.data(),
-                      m_width, m_height, m_width * 4);
+    RasterizeSVG(imgdata.data(), m_width, m_height,
+                 static_cast<double>(m_width) / (static_cast<double>(m_originalWidth)));
     return m_scaledBitmap =
       RGBA2wxBitmap(imgdata.data(), m_width, m_height);
   } else {
@@ -680,11 +810,202 @@ wxBitmap Image::GetBitmap(double scale) {
   return m_scaledBitmap;
 }
 
+void Image::ClearCache() {
+  // An image that is still being loaded hasn't cached anything, yet. Waiting
+  // for it would block the caller.
+  if (!m_loadImageTask.Done())
+    return;
+  m_loadImageTask.Wait();
+  if ((m_scaledBitmap.GetWidth() > 1) || (m_scaledBitmap.GetHeight() > 1))
+    m_scaledBitmap.Create(1, 1);
+  {
+    const std::lock_guard<std::mutex> lock(m_rescaleMutex);
+    m_rescaledImage = wxImage();
+    m_rescaledSize = wxDefaultSize;
+    if (m_pyramid.size() > 1)
+      m_pyramid.erase(m_pyramid.begin(), m_pyramid.end() - 1);
+  }
+  ImageCacheBudget::Update(this, CachedBytes());
+}
+
+std::size_t Image::CachedBytes() {
+  auto bytes = [](const wxImage &image) {
+    if (!image.IsOk())
+      return static_cast<std::size_t>(0);
+    return static_cast<std::size_t>(image.GetWidth()) * image.GetHeight() *
+      (image.HasAlpha() ? 4 : 3);
+  };
+  std::size_t cached = 0;
+  if ((m_scaledBitmap.GetWidth() > 1) || (m_scaledBitmap.GetHeight() > 1))
+    cached += static_cast<std::size_t>(m_scaledBitmap.GetWidth()) *
+      m_scaledBitmap.GetHeight() * 4;
+  const std::lock_guard<std::mutex> lock(m_rescaleMutex);
+  cached += bytes(m_rescaledImage);
+  // ClearCache() keeps the smallest level of the pyramid
+  if (m_pyramid.size() > 1)
+    for (auto level = m_pyramid.begin(); level != m_pyramid.end() - 1; ++level)
+      cached += bytes(*level);
+  return cached;
+}
+
+void Image::StartRescale(wxSize size, ThreadPool::Priority priority) {
+  {
+    const std::lock_guard<std::mutex> lock(m_rescaleMutex);
+    m_wantedSize = size;
+    // A running task will notice the new size when it is done with the old one
+    if (m_rescaling) {
+      // An image that has been prefetched might now be needed on the screen.
+      if (priority < m_rescaleTask.GetPriority())
+        m_rescaleTask.SetPriority(priority);
+      return;
+    }
+    m_rescaling = true;
+  }
+  // If there is a task it has ended already: Waiting for it doesn't block.
+  WaitForRescale();
+  wxEvtHandler *worksheet = m_configuration->GetWorkSheet();
+  m_rescaleTask = ThreadPool::Get().Submit(priority, [this, worksheet] {
+    Rescale_Backgroundtask(worksheet);
+  });
+}
+
+void Image::Rescale_Backgroundtask(wxEvtHandler *worksheet) {
+  wxSize size;
+  {
+    const std::lock_guard<std::mutex> lock(m_rescaleMutex);
+    size = m_wantedSize;
+  }
+  while (true) {
+    long long start = MonotonicMilliseconds();
+    wxImage scaled = CreateScaledImage(size);
+    m_scalingTime = static_cast<long>(MonotonicMilliseconds() - start);
+    const std::lock_guard<std::mutex> lock(m_rescaleMutex);
+    m_rescaledImage = scaled;
+    m_rescaledSize = size;
+    // Drop our reference while still holding the lock: wxImage's reference
+    // counter isn't thread-safe.
+    scaled = wxImage();
+    if (m_wantedSize == size) {
+      m_rescaling = false;
+      break;
+    }
+    size = m_wantedSize;
+  }
+  if (worksheet)
+    worksheet->QueueEvent(new wxCommandEvent(IMAGE_RESCALED_EVENT));
+}
+
+wxImage Image::CreateScaledImage(wxSize size) {
+  if ((size.x < 1) || (size.y < 1))
+    return wxImage();
+
+  if (m_svgRast) {
+    // Rasterizing the svg at the right size gives a better result than scaling
+    // any pre-rendered image.
+    std::vector<unsigned char> imgdata(static_cast<std::size_t>(size.x) * size.y * 4);
+    RasterizeSVG(imgdata.data(), size.x, size.y,
+                 static_cast<double>(size.x) / (static_cast<double>(m_originalWidth)));
+    wxImage image(size.x, size.y, false);
+    image.InitAlpha();
+    unsigned char *rgb = image.GetData();
+    unsigned char *alpha = image.GetAlpha();
+    for (std::size_t i = 0; i < static_cast<std::size_t>(size.x) * size.y; i++) {
+      *rgb++ = imgdata[4 * i];
+      *rgb++ = imgdata[4 * i + 1];
+      *rgb++ = imgdata[4 * i + 2];
+      *alpha++ = imgdata[4 * i + 3];
+    }
+    bool needPyramid;
+    {
+      const std::lock_guard<std::mutex> lock(m_rescaleMutex);
+      needPyramid = m_pyramid.size() < 2;
+    }
+    if (needPyramid)
+      BuildPyramid(image);
+    return image;
+  }
+
+  // Find the smallest pyramid level that still is at least as big as the
+  // image we want to create.
+  wxImage source;
+  {
+    const std::lock_guard<std::mutex> lock(m_rescaleMutex);
+    for (auto level = m_pyramid.rbegin(); level != m_pyramid.rend(); ++level)
+      if ((level->GetWidth() >= size.x) && (level->GetHeight() >= size.y)) {
+        // A deep copy, so source doesn't share a reference counter with the pyramid
+        source = level->Copy();
+        break;
+      }
+  }
+  if (!source.IsOk()) {
+    if (m_compressedImage.GetDataLen() == 0)
+      return wxImage();
+    wxLogNull suppressor;
+    wxMemoryInputStream istream(m_compressedImage.GetData(),
+                                m_compressedImage.GetDataLen());
+    source = wxImage(istream, wxBITMAP_TYPE_ANY);
+    if (!source.IsOk())
+      return wxImage();
+    BuildPyramid(source);
+  }
+  if ((source.GetWidth() == size.x) && (source.GetHeight() == size.y))
+    return source;
+  return source.Scale(size.x, size.y, wxIMAGE_QUALITY_BICUBIC);
+}
+
+void Image::BuildPyramid(const wxImage &image) {
+  std::vector<wxImage> pyramid;
+  wxImage level = image.Copy();
+  // Don't store huge images: We can re-create them from m_compressedImage
+  while (level.GetWidth() > MaxPyramidWidth)
+    level = level.Scale((level.GetWidth() + 1) / 2, (level.GetHeight() + 1) / 2,
+                        wxIMAGE_QUALITY_BOX_AVERAGE);
+  while (true) {
+    pyramid.push_back(level);
+    if ((level.GetWidth() / 2 < MinPyramidWidth) || (level.GetHeight() < 2))
+      break;
+    level = level.Scale((level.GetWidth() + 1) / 2, (level.GetHeight() + 1) / 2,
+                        wxIMAGE_QUALITY_BOX_AVERAGE);
+  }
+  level = wxImage();
+  const std::lock_guard<std::mutex> lock(m_rescaleMutex);
+  m_pyramid.swap(pyramid);
+  // The old pyramid is freed while we still hold the lock
+  pyramid.clear();
+}
+
+wxImage Image::PyramidPreview(wxSize size) {
+  const std::lock_guard<std::mutex> lock(m_rescaleMutex);
+  if (m_pyramid.empty())
+    return wxImage();
+  // Prefer the smallest level that is bigger than the preview as scaling it
+  // down looks better than scaling a smaller image up.
+  const wxImage *source = &m_pyramid.front();
+  for (auto level = m_pyramid.rbegin(); level != m_pyramid.rend(); ++level)
+    if ((level->GetWidth() >= size.x) && (level->GetHeight() >= size.y)) {
+      source = &*level;
+      break;
+    }
+  return source->Scale(size.x, size.y, wxIMAGE_QUALITY_NORMAL);
+}
+
+wxBitmap Image::ScaledImage2Bitmap(const wxImage &image) const {
+  // svg images are transparent, pixel images historically aren't.
+  if (m_svgRast)
+    return wxBitmap(image);
+  else
+    return wxBitmap(image, 24);
+}
+
 void Image::InvalidBitmap(const wxString &message) {
-  m_originalWidth = m_width = 1200 * m_ppi / 96;
-  m_originalHeight = m_height = 900 * m_ppi / 96;
+  // Might be called by the task that loads the image, while the GUI thread lays
+  // out a placeholder: The displayed size is set by Recalculate(), only.
+  const wxCoord bitmapWidth = 1200 * m_ppi / 96;
+  const wxCoord bitmapHeight = 900 * m_ppi / 96;
+  m_originalWidth = bitmapWidth;
+  m_originalHeight = bitmapHeight;
   // Create a "image not loaded" bitmap.
-  m_scaledBitmap.Create(m_width, m_height);
+  m_scaledBitmap.Create(bitmapWidth, bitmapHeight);
   wxString fileSystemMessage;
   if(m_fromWxFS)
     fileSystemMessage = _("\nImage was loaded from a .wxmx file");
@@ -715,30 +1036,35 @@ void Image::InvalidBitmap(const wxString &message) {
     wxCoord width = 0, height = 0;
     dc.GetTextExtent(error, &width, &height);
 
-    dc.DrawRectangle(0, 0, m_width - 1, m_height - 1);
-    dc.DrawLine(0, 0, m_width - 1, m_height - 1);
-    dc.DrawLine(0, m_height - 1, m_width - 1, 0);
+    dc.DrawRectangle(0, 0, bitmapWidth - 1, bitmapHeight - 1);
+    dc.DrawLine(0, 0, bitmapWidth - 1, bitmapHeight - 1);
+    dc.DrawLine(0, bitmapHeight - 1, bitmapWidth - 1, 0);
 
     dc.GetTextExtent(error, &width, &height);
-    dc.DrawText(error, (m_width - width) / 2, (m_height - height) / 2);
+    dc.DrawText(error, (bitmapWidth - width) / 2, (bitmapHeight - height) / 2);
   }
   wxMemoryOutputStream mstream;
   wxASSERT(m_scaledBitmap.IsOk());
   wxImage image = m_scaledBitmap.ConvertToImage();
   wxASSERT(image.IsOk());
   image.SaveFile(mstream, wxBITMAP_TYPE_PNG);
-  m_compressedImage.Clear();
+  m_compressedImage = wxMemoryBuffer();
   m_compressedImage.AppendData(mstream.GetOutputStreamBuffer()->GetBufferStart(),
                                mstream.GetOutputStreamBuffer()->GetBufferSize());
+  const std::lock_guard<std::mutex> lock(m_rescaleMutex);
+  m_pyramid.clear();
 }
 
 void Image::LoadImage(const wxBitmap &bitmap) {
-  if(m_loadImageTask.joinable())
-    m_loadImageTask.join();
+  m_loadImageTask.Wait();
+  WaitForRescale();
+  m_pyramid.clear();
   // Convert the bitmap to a png image we can use as m_compressedImage
   wxImage image = bitmap.ConvertToImage();
   wxMemoryOutputStream stream;
   image.SaveFile(stream, wxBITMAP_TYPE_PNG);
+  // A save in the background might still use the old buffer.
+  m_compressedImage = wxMemoryBuffer();
   m_compressedImage.AppendData(stream.GetOutputStreamBuffer()->GetBufferStart(),
                                stream.GetOutputStreamBuffer()->GetBufferSize());
 
@@ -752,47 +1078,59 @@ void Image::LoadImage(const wxBitmap &bitmap) {
 }
 
 wxString Image::GetExtension() const {
-  if(m_loadImageTask.joinable())
-    m_loadImageTask.join();
+  m_loadImageTask.Wait();
   return m_extension;
 }
 
 void Image::LoadImage(wxString image, const wxString &wxmxFile,
                       bool remove) {
-  if(m_loadImageTask.joinable())
-    m_loadImageTask.join();
+  m_loadImageTask.Wait();
+  WaitForRescale();
+  m_pyramid.clear();
   m_fromWxFS = !wxmxFile.IsEmpty();
   m_extension = wxFileName(image).GetExt();
   m_extension = m_extension.Lower();
   m_imageName = image;
-  std::unique_ptr<ThreadNumberLimiter> limiter(new ThreadNumberLimiter());
-  m_compressedImage.Clear();
+  m_compressedImage = wxMemoryBuffer();
   m_scaledBitmap.Create(1, 1);
-  if(m_configuration->UseThreads())
-    m_loadImageTask = jthread(&Image::LoadImage_Backgroundtask,
-                              this,
-                              std::move(limiter),
-                              std::move(image), wxmxFile,
-                              remove
-      );
+  if (remove && wxmxFile.IsEmpty())
+    m_fileToRemove = image;
   else
+    m_fileToRemove.Clear();
+  if(m_configuration->UseThreads()) {
+    wxEvtHandler *worksheet = NULL;
+    if (InWorksheet())
+      worksheet = m_configuration->GetWorkSheet();
+    m_loading = true;
+    m_loadImageTask = ThreadPool::Get().Submit(ThreadPool::prefetch,
+                                               [this, image, wxmxFile, remove, worksheet] {
+                                                 LoadImage_Backgroundtask(image, wxmxFile,
+                                                                          remove);
+                                                 // The worksheet might have laid out
+                                                 // a placeholder instead of the image.
+                                                 m_loading = false;
+                                                 if (worksheet)
+                                                   worksheet->QueueEvent(
+                                                     new wxCommandEvent(IMAGE_LOADED_EVENT));
+                                               });
+  } else
     LoadImage_Backgroundtask(
-      std::move(limiter),
       std::move(image), wxmxFile,
       remove
       );
 }
 
-void Image::LoadImage_Backgroundtask(std::unique_ptr<ThreadNumberLimiter> limiter,
-                                     wxString image, wxString wxmxFile,
+void Image::LoadImage_Backgroundtask(wxString image, wxString wxmxFile,
                                      bool remove) {
-  std::unique_ptr<ThreadNumberLimiter> threadNumLimit = std::move(limiter);
   wxLogBuffer errorAggregator;
 
   if (!wxmxFile.IsEmpty()) {
-    wxFileInputStream wxmx(wxmxFile);
-    WxmxStream imgData(wxmx, image);
-    m_compressedImage = ReadCompressedImage(&imgData);
+    std::shared_ptr<const WxmxArchive> wxmx = WxmxArchive::Open(wxmxFile);
+    std::unique_ptr<wxInputStream> imgData;
+    if (wxmx)
+      imgData = wxmx->OpenEntry(image);
+    if (imgData)
+      m_compressedImage = ReadCompressedImage(imgData.get());
   } else {
     wxFile file;
     // Support relative and absolute paths.
@@ -844,7 +1182,7 @@ void Image::LoadImage_Backgroundtask(std::unique_ptr<ThreadNumberLimiter> limite
         textOut << svgContents_string;
         textOut.Flush();
         zstream.Close();
-        m_compressedImage.Clear();
+        m_compressedImage = wxMemoryBuffer();
         m_compressedImage.AppendData(
           mstream.GetOutputStreamBuffer()->GetBufferStart(),
           mstream.GetOutputStreamBuffer()->GetBufferSize());
@@ -910,12 +1248,13 @@ void Image::LoadImage_Backgroundtask(std::unique_ptr<ThreadNumberLimiter> limite
 }
 
 void Image::Recalculate(double scale) {
-  if(m_loadImageTask.joinable())
-    m_loadImageTask.join();
-  // It would better to use a jthread for joining no-more used threads.
-  // But that is C++20, which now (in 2023) is still too early.
-  if((!m_gnuplotDataThreadRunning) && m_loadGnuplotSourceTask.joinable())
-    m_loadGnuplotSourceTask.join();
+  // Until the image has been loaded it is laid out as a placeholder.
+  if (IsLoading()) {
+    m_width = std::min<long>(PlaceholderWidth, m_configuration->GetLineWidth());
+    m_height = PlaceholderHeight;
+    return;
+  }
+  m_loadImageTask.Wait();
   wxCoord width = m_originalWidth;
   wxCoord height = m_originalHeight;
 
@@ -974,10 +1313,10 @@ void Image::Recalculate(double scale) {
     m_height = 1;
     m_width = 1;
   }
-  // Clear this cell's image cache if it doesn't contain an image of the size
-  // we need right now.
-  if (m_scaledBitmap.GetWidth() != m_width)
-    ClearCache();
+  // Forget the scaled bitmap if it doesn't have the size we need right now.
+  // The image pyramid is kept as it provides a fast preview of the new size.
+  if ((m_scaledBitmap.GetWidth() != m_width) && (m_scaledBitmap.GetWidth() > 1))
+    m_scaledBitmap.Create(1, 1);
 }
 
 const wxString Image::GetBadImageToolTip() {
@@ -990,6 +1329,29 @@ const wxString Image::GetBadImageToolTip() {
     "empty images");
 }
 
+void Image::RasterizeSVG(unsigned char *rgba, int width, int height, double scale) {
+  int bands = RasterBands::NumberOfBands(width, height);
+  // nanoSVG's rasterizer keeps its state in the rasterizer object => each
+  // band needs a rasterizer of its own.
+  while (static_cast<int>(m_bandRasts.size()) < bands - 1) {
+    wxm_NSVGrasterizer *rast = wxm_nsvgCreateRasterizer();
+    if (!rast) {
+      bands = m_bandRasts.size() + 1;
+      break;
+    }
+    m_bandRasts.emplace_back(rast);
+  }
+  RasterBands::Rasterize(height, bands, [&](int band, int firstLine, int lines) {
+    wxm_NSVGrasterizer *rast = (band == 0) ? m_svgRast.get() : m_bandRasts[band - 1].get();
+    wxm_nsvgRasterize(rast, m_svgImage, 0, -firstLine, scale,
+                      rgba + static_cast<std::size_t>(firstLine) * width * 4,
+                      width, lines, width * 4);
+  });
+}
+
+wxDEFINE_EVENT(IMAGE_RESCALED_EVENT, wxCommandEvent);
+wxDEFINE_EVENT(IMAGE_LOADED_EVENT, wxCommandEvent);
+
 wxBitmap Image::RGBA2wxBitmap(const unsigned char imgdata[],
                               const int &width, const int &height,
 
@@ -1008,17 +1370,21 @@ wxBitmap Image::RGBA2wxBitmap(const unsigned char imgdata[],
   if (!retval.Ok())
     return retval;
 
+  // Access the pixels by row pointer and fixed channel offsets: This lets the
+  // compiler vectorize the premultiplication.
+  using Format = wxAlphaPixelData::PixelFormat;
   wxAlphaPixelData bmpdata(retval);
   wxAlphaPixelData::Iterator dst(bmpdata);
   for (int y = 0; y < height; y++) {
     dst.MoveTo(bmpdata, 0, y);
+    unsigned char *row = reinterpret_cast<unsigned char *>(dst.m_ptr);
     for (int x = 0; x < width; x++) {
-      unsigned char a = rgba[3];
-      dst.Red() = rgba[0] * a / 255;
-      dst.Green() = rgba[1] * a / 255;
-      dst.Blue() = rgba[2] * a / 255;
-      dst.Alpha() = a;
-      dst++;
+      unsigned int a = rgba[3];
+      row[Format::RED] = rgba[0] * a / 255;
+      row[Format::GREEN] = rgba[1] * a / 255;
+      row[Format::BLUE] = rgba[2] * a / 255;
+      row[Format::ALPHA] = a;
+      row += Format::SizePixel;
       rgba += 4;
     }
   }
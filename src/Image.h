@@ -29,9 +29,12 @@
 #ifndef IMAGE_H
 #define IMAGE_H
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <thread>
-#include "ThreadNumberLimiter.h"
+#include <vector>
+#include "ThreadPool.h"
 #include "precomp.h"
 #include "Version.h"
 #include "Configuration.h"
@@ -66,6 +69,12 @@
   to store them in their uncompressed form.
   - One could even delete the cached scaled images for all cells that currently
   are off-screen in order to save memory.
+
+  Scaling a big image is slow. Therefore, if threads are enabled, we keep a small
+  pyramid of pre-scaled versions of the image, each half the size of the previous
+  one. On a zoom the nearest pyramid level is shown immediately while a background
+  task creates the exactly-scaled bitmap, which replaces the preview as soon as it
+  is ready: The worksheet is informed by an IMAGE_RESCALED_EVENT.
 */
 class Image final
 {
@@ -105,18 +114,15 @@ public:
                                 const int &scaleFactor = 1);
 
   void SetConfiguration(Configuration *config){
-    if(m_loadImageTask.joinable())
-      m_loadImageTask.join();
+    m_loadImageTask.Wait();
     m_configuration = config; }
   //! Return the image's resolution
   int GetPPI() const {
-    if(m_loadImageTask.joinable())
-      m_loadImageTask.join();
+    m_loadImageTask.Wait();
     return m_ppi;}
   //! Set the image's resolution
   void SetPPI(int ppi) {
-    if(m_loadImageTask.joinable())
-      m_loadImageTask.join();
+    m_loadImageTask.Wait();
     m_ppi = ppi;}
 
   //! Creates a bitmap showing an error message
@@ -167,40 +173,63 @@ public:
 
   /*! Temporarily forget the scaled image in order to save memory
 
-    Will recreate the scaled image as soon as needed.
+    Will recreate the scaled image as soon as needed. Of the image pyramid only
+    the smallest level is kept, so the image can be previewed without delay.
+    Called by ImageCacheBudget if the images use up too much memory.
+  */
+  void ClearCache();
+
+  /*! Tells ImageCacheBudget that the scaled image is in use
+
+    Images that don't belong to the worksheet, but to a printout or an export,
+    aren't held within the budget.
+  */
+  void TouchCache();
+
+  /*! Tells the image how far it is away from the visible part of the worksheet
+
+    \param screens The distance in screen heights; 0 means: The image is visible.
+
+    Images that will probably be scrolled into view soon are scaled in the
+    background before they are drawn. Images the user has scrolled away from
+    aren't scaled if their scaling hasn't started, yet.
+  */
+  void SetViewportDistance(double screens);
+  /*! Starts scaling the image in the background if it isn't scaled, yet
+
+    Only works for images of the worksheet, and only if Recalculate() has
+    already told the image its size.
+  */
+  void Prefetch(ThreadPool::Priority priority);
+  //! Cancels scaling the image in the background if it hasn't started, yet
+  void CancelPrefetch();
+  //! Can GetBitmap() return the image at the right size without scaling it first?
+  bool ScaledBitmapReady();
+  //! How long [in milliseconds] scaling the image in the background took the last time, or -1
+  long GetScalingTime() const { return m_scalingTime; }
+  //! Images nearer to the screen than this many screen heights are prefetched
+  static constexpr double PrefetchDistance = 1.5;
+  //! Scaling images further away from the screen than this is cancelled
+  static constexpr double CancelDistance = 4;
+
+  //! Starts measuring how long it takes until the first image is drawn in full resolution
+  static void StartFirstPlotTimer();
+  /*! How long [in milliseconds] it took to draw the first image after opening the last file
+
+    -1 if the timer hasn't been started or no image has been drawn, yet.
   */
-  void ClearCache()
-    {
-      if(m_loadImageTask.joinable())
-        m_loadImageTask.join();
-      if ((m_scaledBitmap.GetWidth() > 1) || (m_scaledBitmap.GetHeight() > 1))
-        m_scaledBitmap.Create(1, 1);
-    }
+  static long GetTimeToFirstVisiblePlot() { return m_timeToFirstVisiblePlot; }
 
   //! Returns the file name extension of the current image
   wxString GetExtension() const;
   //! The maximum width this image shall be displayed with
-  double GetMaxWidth() const {
-    if(m_loadImageTask.joinable())
-      m_loadImageTask.join();
-    return m_maxWidth;}
+  double GetMaxWidth() const {return m_maxWidth;}
   //! The maximum height this image shall be displayed with
-  double GetHeightList() const {
-    if(m_loadImageTask.joinable())
-      m_loadImageTask.join();
-    return m_maxHeight;}
+  double GetHeightList() const {return m_maxHeight;}
   //! Set the maximum width this image shall be displayed with
-  void   SetMaxWidth(double width){
-    if(m_loadImageTask.joinable())
-      m_loadImageTask.join();
-    m_maxWidth = width;
-  }
+  void   SetMaxWidth(double width){m_maxWidth = width;}
   //! Set the maximum height this image shall be displayed with
-  void   SetMaxHeight(double height){
-    if(m_loadImageTask.joinable())
-      m_loadImageTask.join();
-    m_maxHeight = height;
-  }
+  void   SetMaxHeight(double height){m_maxHeight = height;}
 
   //! "Loads" an image from a bitmap
   void LoadImage(const wxBitmap &bitmap);
@@ -208,7 +237,12 @@ public:
   //! Saves the image in its original form, or as .png if it originates in a bitmap
   wxSize ToImageFile(wxString filename);
 
-  //! Returns the bitmap being displayed with custom scale
+  /*! Returns the bitmap being displayed with custom scale
+
+    If the bitmap of the right size isn't ready, yet, and threads are enabled
+    this function returns a preview from the image pyramid and starts creating
+    the real bitmap in the background.
+  */
   wxBitmap GetBitmap(double scale = 1.0);
 
   //! Returns the image in its unscaled form
@@ -217,6 +251,14 @@ public:
   //! Can be called to specify a specific scale
   void Recalculate(double scale = 1.0);
 
+  /*! Is this image of the worksheet still being loaded in the background?
+
+    Until it has been loaded Recalculate() and GetBitmap() use a placeholder
+    instead of waiting for it. As soon as it has been loaded the worksheet
+    receives an IMAGE_LOADED_EVENT.
+  */
+  bool IsLoading() const;
+
   //! The width of the scaled image
   long m_width = 1;
   //! The height of the scaled image
@@ -238,23 +280,15 @@ public:
 
   //! Can this image be exported in SVG format?
   bool CanExportSVG() const {
-    if(m_loadImageTask.joinable())
-      m_loadImageTask.join();
+    m_loadImageTask.Wait();
     return m_svgRast != nullptr;}
 
   //! The tooltip to use wherever an image that's not Ok is shown.
   static const wxString GetBadImageToolTip();
 
-  class WxmxStream: public wxZipInputStream
-  {
-  public:
-    WxmxStream(wxInputStream &wxmxFile, const wxString &fileInWxmx);
-  };
-
   bool HasGnuplotSource() const {return m_gnuplotSource_Compressed.GetDataLen() > 20;}
 private:
   bool m_fromWxFS = false;
-  bool m_gnuplotDataThreadRunning = false;
   //! A zipped version of the gnuplot commands that produced this image.
   wxMemoryBuffer m_gnuplotSource_Compressed;
   //! A zipped version of the gnuplot data needed in order to create this image.
@@ -265,19 +299,82 @@ private:
   std::size_t m_originalHeight = 480;
   //! The bitmap, scaled down to the screen size
   wxBitmap m_scaledBitmap;
+  //! Does the work for GetBitmap()
+  wxBitmap ScaledBitmap(double scale);
+  //! The number of bytes of bitmaps ClearCache() would free
+  std::size_t CachedBytes();
+  //! The widest level of the image pyramid we create
+  static constexpr int MaxPyramidWidth = 1024;
+  //! The narrowest level of the image pyramid we create
+  static constexpr int MinPyramidWidth = 64;
+  //! Does the rescaling in the background and keeps m_wantedSize up-to-date
+  mutable ThreadPool::Task m_rescaleTask;
+  /*! Starts creating the scaled image in the background, if it isn't running already
+
+    If the task is still queued with a lower priority it is given the new one.
+  */
+  void StartRescale(wxSize size, ThreadPool::Priority priority = ThreadPool::visible);
+  //! Does this image belong to the worksheet, not to a printout or an export?
+  bool InWorksheet() const;
+  //! The size of the placeholder that is shown while the image is being loaded
+  static constexpr int PlaceholderWidth = 700;
+  static constexpr int PlaceholderHeight = 300;
+  //! Stops the time to the first visible plot, if the timer is running
+  void StopFirstPlotTimer();
+  //! The time StartFirstPlotTimer() has been called, if the timer is running
+  static long long m_firstPlotTimerStart;
+  static long m_timeToFirstVisiblePlot;
+  void Rescale_Backgroundtask(wxEvtHandler *worksheet);
+  //! Waits for the background rescaling to finish
+  void WaitForRescale() const {
+    m_rescaleTask.Wait();
+  }
+  //! Creates an exactly scaled image. Doesn't touch anything the GUI thread uses unlocked.
+  wxImage CreateScaledImage(wxSize size);
+  //! Creates the image pyramid from a decoded version of the image
+  void BuildPyramid(const wxImage &image);
+  //! A fast preview of the image at the size "size", or an invalid image.
+  wxImage PyramidPreview(wxSize size);
+  //! Converts an image we have scaled to a bitmap in the format we display it in
+  wxBitmap ScaledImage2Bitmap(const wxImage &image) const;
+  //! An empty frame that is shown until the image can be drawn
+  static wxBitmap BlankBitmap(wxSize size);
+  //! Locks m_pyramid, m_rescaledImage, m_rescaledSize, m_wantedSize and m_rescaling
+  std::mutex m_rescaleMutex;
+  /*! Pre-scaled versions of the image, largest first
+
+    wxImage's reference counting isn't thread-safe: All wxImages stored here
+    mustn't share their data with any other wxImage.
+  */
+  std::vector<wxImage> m_pyramid;
+  //! The result of the background rescaling
+  wxImage m_rescaledImage;
+  //! The size m_rescaledImage was created for
+  wxSize m_rescaledSize;
+  //! The size the background rescaling is to create
+  wxSize m_wantedSize;
+  //! True while the background rescaling is running
+  bool m_rescaling = false;
+  //! How long the last background rescaling took [in milliseconds]
+  std::atomic<long> m_scalingTime{-1};
   //! The file extension for the current image type
   wxString m_extension;
   //! The gnuplot source file for this image, if any.
   wxString m_gnuplotSource;
   //! The gnuplot data file for this image, if any.
   wxString m_gnuplotData;
-  mutable jthread m_loadImageTask;
-  void LoadImage_Backgroundtask(std::unique_ptr<ThreadNumberLimiter> limiter,
-                                wxString image, wxString wxmxFile,
+  mutable ThreadPool::Task m_loadImageTask;
+  /*! The file m_loadImageTask is to delete after loading it
+
+    Deleted by the destructor if the task is cancelled before it starts.
+  */
+  wxString m_fileToRemove;
+  //! True from the start of m_loadImageTask until it has loaded the image
+  std::atomic<bool> m_loading{false};
+  void LoadImage_Backgroundtask(wxString image, wxString wxmxFile,
                                 bool remove);
-  jthread m_loadGnuplotSourceTask;
+  ThreadPool::Task m_loadGnuplotSourceTask;
   void LoadGnuplotSource_Backgroundtask(
-    std::unique_ptr<ThreadNumberLimiter> limiter,
     wxString gnuplotFile, wxString dataFile, wxString wxmxFile);
   void LoadGnuplotSource(wxInputStream *source);
   void LoadGnuplotData(wxInputStream *data);
@@ -286,8 +383,7 @@ private:
     wxInputStream *data);
 
 
-  void LoadCompressedGnuplotSource_Backgroundtask(std::unique_ptr<ThreadNumberLimiter> limiter,
-                                                  wxString sourcefile,
+  void LoadCompressedGnuplotSource_Backgroundtask(wxString sourcefile,
                                                   wxString datafile,
                                                   wxString wxmxFile
     );
@@ -306,8 +402,23 @@ private:
   //! The image resolution
   double m_ppi = 72;
   struct free_deleter { void operator()(void *p) const { std::free(p); } };
+  struct rasterizer_deleter {
+    void operator()(wxm_NSVGrasterizer *r) const { wxm_nsvgDeleteRasterizer(r); } };
   wxm_NSVGimage* m_svgImage = {};
   std::unique_ptr<struct wxm_NSVGrasterizer, free_deleter> m_svgRast{nullptr};
+  //! The rasterizers for the 2nd, 3rd,... band RasterizeSVG() renders in parallel
+  std::vector<std::unique_ptr<wxm_NSVGrasterizer, rasterizer_deleter>> m_bandRasts;
+  /*! Renders the svg image to non-premultiplied rgba data
+
+    Big images are split into horizontal bands that are rendered in parallel.
+    Must not be called from two threads at once.
+  */
+  void RasterizeSVG(unsigned char *rgba, int width, int height, double scale);
 };
 
+//! Sent to the worksheet when Image has created a scaled bitmap in the background
+wxDECLARE_EVENT(IMAGE_RESCALED_EVENT, wxCommandEvent);
+//! Sent to the worksheet when an image has been loaded in the background
+wxDECLARE_EVENT(IMAGE_LOADED_EVENT, wxCommandEvent);
+
 #endif // IMAGE_H
@@ -0,0 +1,136 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  Defines ImageCacheBudget, which limits the memory the worksheet's images cache.
+*/
+
+#include "ImageCacheBudget.h"
+#include "Image.h"
+#include <vector>
+#include <wx/log.h>
+
+std::mutex ImageCacheBudget::m_mutex;
+std::size_t ImageCacheBudget::m_budget = 256 * 1024 * 1024;
+std::size_t ImageCacheBudget::m_usage = 0;
+uint64_t ImageCacheBudget::m_frame = 0;
+
+// The lists are never freed: Images might still report to us while the static
+// objects are being destroyed.
+ImageCacheBudget::LRUList &ImageCacheBudget::LRU() {
+  static LRUList *lru = new LRUList;
+  return *lru;
+}
+
+std::unordered_map<const Image *, ImageCacheBudget::LRUList::iterator> &
+ImageCacheBudget::Entries() {
+  static auto *entries =
+    new std::unordered_map<const Image *, LRUList::iterator>;
+  return *entries;
+}
+
+void ImageCacheBudget::SetBudget(std::size_t bytes) {
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  m_budget = bytes;
+}
+
+std::size_t ImageCacheBudget::GetBudget() {
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  return m_budget;
+}
+
+std::size_t ImageCacheBudget::GetUsage() {
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  return m_usage;
+}
+
+std::size_t ImageCacheBudget::GetNumberOfImages() {
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  return Entries().size();
+}
+
+void ImageCacheBudget::Touch(Image *image, std::size_t bytes) {
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  auto entry = Entries().find(image);
+  if (entry != Entries().end()) {
+    m_usage -= entry->second->bytes;
+    if (bytes == 0) {
+      LRU().erase(entry->second);
+      Entries().erase(entry);
+      return;
+    }
+    LRU().splice(LRU().begin(), LRU(), entry->second);
+    entry->second->bytes = bytes;
+    entry->second->frame = m_frame;
+  } else {
+    if (bytes == 0)
+      return;
+    LRU().push_front(Entry{image, bytes, m_frame});
+    Entries()[image] = LRU().begin();
+  }
+  m_usage += bytes;
+}
+
+void ImageCacheBudget::Update(const Image *image, std::size_t bytes) {
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  auto entry = Entries().find(image);
+  if (entry == Entries().end())
+    return;
+  m_usage -= entry->second->bytes;
+  if (bytes == 0) {
+    LRU().erase(entry->second);
+    Entries().erase(entry);
+    return;
+  }
+  entry->second->bytes = bytes;
+  m_usage += bytes;
+}
+
+void ImageCacheBudget::Forget(const Image *image) { Update(image, 0); }
+
+void ImageCacheBudget::Enforce() {
+  std::vector<Image *> victims;
+  {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    std::size_t usage = m_usage;
+    for (auto entry = LRU().rbegin();
+         (entry != LRU().rend()) && (usage > m_budget); ++entry) {
+      // All images from here on have been drawn since the last call to Enforce()
+      if (entry->frame == m_frame)
+        break;
+      victims.push_back(entry->image);
+      usage -= entry->bytes;
+    }
+    m_frame++;
+  }
+  if (victims.empty())
+    return;
+
+  // Image::ClearCache() calls Update(), which needs the mutex.
+  for (auto &image : victims)
+    image->ClearCache();
+  wxLogDebug("Image cache: Evicted %li images, now caching %li MB in %li images "
+             "(budget: %li MB)",
+             static_cast<long>(victims.size()),
+             static_cast<long>(GetUsage() / 1024 / 1024),
+             static_cast<long>(GetNumberOfImages()),
+             static_cast<long>(GetBudget() / 1024 / 1024));
+}
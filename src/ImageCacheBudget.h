@@ -0,0 +1,97 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  Declares ImageCacheBudget, which limits the memory the worksheet's images cache.
+*/
+
+#ifndef IMAGECACHEBUDGET_H
+#define IMAGECACHEBUDGET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+class Image;
+
+/*! Keeps the decoded and scaled versions of all images within a memory budget
+
+  Every Image of the worksheet (the ones in ImgCells as well as the frames of
+  AnimationCells) reports here how many bytes of bitmaps it caches each time it
+  is drawn: Only the bytes Image::ClearCache() would free are counted. If all
+  images together cache more than the budget the ones that haven't been drawn
+  for the longest time are told to clear their cache.
+
+  Eviction only happens in Enforce(), which the worksheet calls from the GUI
+  thread after each redraw. Images that have been drawn since the last call to
+  Enforce() are never evicted, so the images on the screen cannot push each
+  other out of the cache.
+*/
+class ImageCacheBudget
+{
+public:
+  //! Sets the budget [in bytes]
+  static void SetBudget(std::size_t bytes);
+  //! The budget [in bytes]
+  static std::size_t GetBudget();
+  //! The number of bytes all images together currently cache
+  static std::size_t GetUsage();
+  //! The number of images that currently cache anything
+  static std::size_t GetNumberOfImages();
+  //! Informs us that image has just been drawn and now caches bytes bytes
+  static void Touch(Image *image, std::size_t bytes);
+  /*! Informs us that image now caches bytes bytes without marking it as drawn
+
+    Images we don't know about, yet, are ignored: They are registered by Touch().
+  */
+  static void Update(const Image *image, std::size_t bytes);
+  //! Informs us that image is about to be deleted
+  static void Forget(const Image *image);
+  /*! Clears the caches of the least recently drawn images until we are within budget
+
+    Must be called from the GUI thread.
+  */
+  static void Enforce();
+
+private:
+  struct Entry
+  {
+    //! The image. Only used for clearing its cache.
+    Image *image;
+    //! The number of bytes the image caches
+    std::size_t bytes;
+    //! The value m_frame had when the image was drawn last
+    uint64_t frame;
+  };
+  //! All images that cache anything, the most recently drawn one first
+  typedef std::list<Entry> LRUList;
+  static LRUList &LRU();
+  static std::unordered_map<const Image *, LRUList::iterator> &Entries();
+  static std::mutex m_mutex;
+  static std::size_t m_budget;
+  static std::size_t m_usage;
+  //! Counts the calls to Enforce()
+  static uint64_t m_frame;
+};
+
+#endif // IMAGECACHEBUDGET_H
@@ -0,0 +1,94 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  Defines LayoutCache, which remembers the heights of the cells of recently opened documents.
+*/
+
+#include "LayoutCache.h"
+#include <wx/datstrm.h>
+
+LayoutCache::LayoutCache(std::size_t capacity):
+  m_capacity(capacity)
+{
+}
+
+uint64_t LayoutCache::Hash(const void *data, std::size_t length, uint64_t hash) {
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  for (std::size_t i = 0; i < length; i++) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+const LayoutCache::Layout *LayoutCache::Find(uint64_t key) {
+  for (auto i = m_layouts.begin(); i != m_layouts.end(); ++i)
+    if (i->first == key) {
+      m_layouts.splice(m_layouts.begin(), m_layouts, i);
+      return &m_layouts.front().second;
+    }
+  return nullptr;
+}
+
+void LayoutCache::Store(uint64_t key, Layout layout) {
+  m_layouts.remove_if([key](const std::pair<uint64_t, Layout> &i) {return i.first == key;});
+  m_layouts.emplace_front(key, std::move(layout));
+  while (m_layouts.size() > m_capacity)
+    m_layouts.pop_back();
+}
+
+void LayoutCache::Write(wxOutputStream &stream) const {
+  wxDataOutputStream data(stream);
+  data.Write32(static_cast<wxUint32>(m_layouts.size()));
+  for (const auto &i : m_layouts) {
+    data.Write64(i.first);
+    data.Write32(static_cast<wxUint32>(i.second.size()));
+    for (auto height : i.second)
+      data.Write32(static_cast<wxUint32>(height));
+  }
+}
+
+bool LayoutCache::Read(wxInputStream &stream) {
+  m_layouts.clear();
+  wxDataInputStream data(stream);
+  uint32_t layouts = data.Read32();
+  if (!stream.IsOk() || (layouts > m_capacity))
+    return false;
+  for (uint32_t i = 0; i < layouts; i++) {
+    uint64_t key = data.Read64();
+    uint32_t cells = data.Read32();
+    // Even a huge document will contain far less cells
+    if (!stream.IsOk() || (cells > 10000000)) {
+      m_layouts.clear();
+      return false;
+    }
+    Layout layout(cells);
+    for (auto &height : layout)
+      height = static_cast<int32_t>(data.Read32());
+    if (!stream.IsOk()) {
+      m_layouts.clear();
+      return false;
+    }
+    m_layouts.emplace_back(key, std::move(layout));
+  }
+  return true;
+}
@@ -0,0 +1,83 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  Declares LayoutCache, which remembers the heights of the cells of recently opened documents.
+*/
+
+#ifndef LAYOUTCACHE_H
+#define LAYOUTCACHE_H
+
+#include "precomp.h"
+#include <wx/stream.h>
+#include <cstdint>
+#include <list>
+#include <utility>
+#include <vector>
+
+/*! The heights the GroupCells of recently opened documents had
+
+  Laying out a big document takes a while, but the size of the worksheet is
+  needed as soon as it is shown, for the scrollbars. The heights cells had
+  the last time a document was opened with the same fonts, zoom factor and
+  window width are a good estimate until the cells have been recalculated.
+
+  The cache is keyed by a hash of the document's contents and of these
+  settings: If anything has changed the key doesn't match and the cache is
+  ignored.
+*/
+class LayoutCache
+{
+public:
+  //! The heights of the GroupCells of a document, in document order
+  typedef std::vector<int32_t> Layout;
+
+  //! The value Hash() starts with
+  static constexpr uint64_t HashStart = 14695981039346656037ULL;
+
+  explicit LayoutCache(std::size_t capacity = 32);
+  /*! Hashes data (using FNV-1a)
+
+    \param hash The hash of the data before this part, in order to hash
+    data that consists of several parts
+  */
+  static uint64_t Hash(const void *data, std::size_t length, uint64_t hash = HashStart);
+
+  //! The layout stored for this key, or nullptr. Makes it the most recently used one.
+  const Layout *Find(uint64_t key);
+  //! Stores a layout. If the cache is full the least recently used one is dropped.
+  void Store(uint64_t key, Layout layout);
+  //! The number of layouts in the cache
+  std::size_t Size() const {return m_layouts.size();}
+
+  //! Writes the cache to a stream
+  void Write(wxOutputStream &stream) const;
+  //! Reads a cache written by Write(). Returns false if the data is unusable.
+  bool Read(wxInputStream &stream);
+
+private:
+  //! The layouts, the most recently used one first
+  std::list<std::pair<uint64_t, Layout>> m_layouts;
+  //! How many layouts we keep
+  std::size_t m_capacity;
+};
+
+#endif // LAYOUTCACHE_H
@@ -43,7 +43,6 @@
 wxDECLARE_APP(MyApp);
 
 MaximaManual::MaximaManual(Configuration *configuration):
-  m_abortBackgroundTask(false),
   m_configuration(configuration)
 {
 }
@@ -163,7 +162,7 @@ void MaximaManual::CompileHelpFileAnchors(const wxString &maximaHtmlDir,
     }
 
     for (const auto &file : helpFiles) {
-      if(m_abortBackgroundTask)
+      if(m_abortBackgroundTask.IsCancelled())
             return;
       bool is_Singlepage = file.Contains("_singlepage.");
       std::size_t foundAnchors = 0;
@@ -194,7 +193,7 @@ void MaximaManual::CompileHelpFileAnchors(const wxString &maximaHtmlDir,
         wxTextInputStream text(input, wxS('\t'),
                                wxConvAuto(wxFONTENCODING_UTF8));
         while (input.IsOk() && !input.Eof()) {
-          if(m_abortBackgroundTask)
+          if(m_abortBackgroundTask.IsCancelled())
             return;
           wxString line = text.ReadLine();
           wxStringTokenizer tokens(line, wxS(">"));
@@ -529,19 +528,25 @@ void MaximaManual::LoadHelpFileAnchors(const wxString &docdir,
   }
   if (!LoadManualAnchorsFromCache()) {
     if (!m_maximaHtmlDir.IsEmpty()) {
-      if (m_helpfileanchorsThread.joinable()) {
+      if (m_helpfileanchorsThread.Pending()) {
         wxLogMessage(_("Waiting for the Manual anchors background task."));
-        m_helpfileanchorsThread.join();
+        m_helpfileanchorsThread.Wait();
       }
       wxLogMessage(_("Background task that compiles the Manual anchors scheduled."));
-      m_abortBackgroundTask = false;
+      m_abortBackgroundTask = ThreadPool::CancellationToken();
       if(m_configuration->UseThreads())
-        m_helpfileanchorsThread = jthread(&MaximaManual::CompileHelpFileAnchors,
-                                          this,
-                                          m_maximaHtmlDir,
-                                          m_maximaVersion,
-                                          Dirstructure::AnchorsCacheFile()
-                                          );
+        {
+          wxString maximaHtmlDir = m_maximaHtmlDir;
+          wxString maximaVersion = m_maximaVersion;
+          wxString anchorsCacheFile = Dirstructure::AnchorsCacheFile();
+          m_helpfileanchorsThread =
+            ThreadPool::Get().Submit(ThreadPool::indexing,
+                                     [this, maximaHtmlDir, maximaVersion, anchorsCacheFile] {
+                                       CompileHelpFileAnchors(maximaHtmlDir, maximaVersion,
+                                                              anchorsCacheFile);
+                                     },
+                                     m_abortBackgroundTask);
+        }
       else
         CompileHelpFileAnchors(
                                m_maximaHtmlDir,
@@ -556,10 +561,9 @@ void MaximaManual::LoadHelpFileAnchors(const wxString &docdir,
 }
 
 MaximaManual::~MaximaManual() {
-  if(m_helpfileanchorsThread.joinable())
+  if(m_helpfileanchorsThread.Pending())
     {
-      m_abortBackgroundTask = true;
       wxLogMessage(_("Waiting for the thread that parses the maxima manual to finish"));
-      m_helpfileanchorsThread.join();
+      m_helpfileanchorsThread.CancelAndWait();
     }
 }
@@ -31,13 +31,13 @@
 #define MAXIMAMANUAL_H
 
 #include <atomic>
-#include <thread>
 #include <mutex>
 #include <memory>
 #include <vector>
 #include <wx/dir.h>
 #include <wx/wx.h>
 #include <wx/arrstr.h>
+#include "ThreadPool.h"
 #include <wx/regex.h>
 #include <wx/xml/xml.h>
 #include <wx/filename.h>
@@ -84,7 +84,8 @@ public:
                                 const wxString &saveName);
   virtual ~MaximaManual();
 private:
-  std::atomic_bool m_abortBackgroundTask;
+  //! Tells CompileHelpFileAnchors() to stop early
+  ThreadPool::CancellationToken m_abortBackgroundTask;
   //! Add our aliases to a list of anchors
   static void AnchorAliasses(HelpFileAnchors &anchors);
   //! Scans the maxima directory for a list of loadable files
@@ -116,8 +117,8 @@ private:
 
   //    m_configuration.MaximaShareDir(dir);
 
-  //! The thread the help file anchors are compiled in
-  jthread m_helpfileanchorsThread;
+  //! The background task the help file anchors are compiled in
+  ThreadPool::Task m_helpfileanchorsThread;
   std::mutex m_helpFileAnchorsLock;
   //! The configuration storage
   Configuration *m_configuration = NULL;
@@ -29,310 +29,255 @@
 
 #include "MaximaTokenizer.h"
 #include "precomp.h"
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
 #include <vector>
 #include <wx/string.h>
 #include <wx/wx.h>
 
 MaximaTokenizer::MaximaTokenizer(const wxString &commands,
                                  const Configuration * const configuration)
-  : m_configuration(configuration) {
-  if (m_hardcodedFunctions.empty()) {
-    m_hardcodedFunctions["for"] = 1;
-    m_hardcodedFunctions["in"] = 1;
-    m_hardcodedFunctions["then"] = 1;
-    m_hardcodedFunctions["while"] = 1;
-    m_hardcodedFunctions["do"] = 1;
-    m_hardcodedFunctions["thru"] = 1;
-    m_hardcodedFunctions["next"] = 1;
-    m_hardcodedFunctions["step"] = 1;
-    m_hardcodedFunctions["unless"] = 1;
-    m_hardcodedFunctions["from"] = 1;
-    m_hardcodedFunctions["if"] = 1;
-    m_hardcodedFunctions["else"] = 1;
-    m_hardcodedFunctions["elseif"] = 1;
-    m_hardcodedFunctions["and"] = 1;
-    m_hardcodedFunctions["or"] = 1;
-    m_hardcodedFunctions["not"] = 1;
-    m_hardcodedFunctions["true"] = 1;
-    m_hardcodedFunctions["false"] = 1;
-  }
+  : MaximaTokenizer(commands, configuration, 0, {})
+{
+}
 
+MaximaTokenizer::MaximaTokenizer(const wxString &commands,
+                                 const Configuration * const configuration,
+                                 std::size_t start,
+                                 const std::function<bool (std::size_t)> &stopAt)
+  : m_configuration(configuration) {
   // ----------------------------------------------------------------
   // --------------------- Step one:                -----------------
   // --------------------- Break a line into tokens -----------------
   // ----------------------------------------------------------------
-  wxString::const_iterator it = commands.begin();
-  if (configuration->InLispMode()) {
-    wxString token;
-    while ((it < commands.end()) && ((!token.EndsWith("(to-maxima)"))) &&
-           ((!token.EndsWith(wxString("(to") + wxS("\u2212") + "maxima)")))) {
-      token += *it;
-      ++it;
-    }
-
+  // Tokens are cut out of the commands in one piece, not assembled char by char.
+  const wxString::const_iterator end = commands.end();
+  wxString::const_iterator it = commands.begin() + static_cast<std::ptrdiff_t>(start);
+  if ((start == 0) && configuration && configuration->InLispMode()) {
+    wxString::const_iterator lispEnd = LispEnd(commands, it);
+    wxString token(it, lispEnd);
+    it = lispEnd;
     token.Trim(true);
     if (!token.IsEmpty())
-      m_tokens.emplace_back(token, TS_CODE_LISP);
+      m_tokens.emplace_back(std::move(token), TS_CODE_LISP);
   }
-  while (it < commands.end()) {
+  while (it < end) {
     // Determine the current char and the one that will follow it
     wxUniChar Ch = *it;
+    const std::uint8_t chClass = Classes(Ch);
+    wxString::const_iterator tokenStart(it);
     wxString::const_iterator it2(it);
-    if (it2 < commands.end())
-      ++it2;
+    ++it2;
     wxUniChar nextChar;
 
-    if (it2 < commands.end())
+    if (it2 < end)
       nextChar = *it2;
     else
       nextChar = wxS(' ');
 
     // Handle newline characters (hard+soft line break)
-    if (m_linebreaks.Contains(Ch)) {
-      m_tokens.emplace_back(wxUniChar(Ch));
+    if (chClass & linebreakChar) {
+      m_tokens.emplace_back(wxString(Ch));
       ++it;
+      if (stopAt && stopAt(static_cast<std::size_t>(it - commands.begin())))
+        break;
       continue;
     }
     // Check for comments
     if ((Ch == '/') &&
         ((nextChar == wxS('*')) || (nextChar == L'\u00B7'))) {
-      wxString token;
-      // Add the comment start
-      token += *it;
+      // Skip the comment start
       ++it;
-      token += *it;
       ++it;
 
       int commentDepth = 0;
-      while (it < commands.end()) {
+      while (it < end) {
         // Handle escaped chars
         if (*it == '\\') {
-          token += *it;
           ++it;
-          if (it < commands.end()) {
-            token += *it;
+          if (it < end)
             ++it;
-          }
           continue;
         }
 
         wxString::const_iterator it3(it);
-        if (it3 < commands.end())
-          ++it3;
+        ++it3;
         wxUniChar nextCh = ' ';
-        if (it3 < commands.end())
+        if (it3 < end)
           nextCh = *it3;
 
         // handle comment begins within comments.
         if ((*it == '/') && ((nextCh == '*') || (nextCh == L'\u00B7'))) {
           commentDepth++;
-          token += *it;
           ++it;
-          if (it < commands.end()) {
-            token += *it;
+          if (it < end)
             ++it;
-          }
           continue;
         }
         // handle comment endings
         if (((*it == '*') || (*it == L'\u00B7')) && (nextCh == '/')) {
           commentDepth--;
-          token += *it;
           ++it;
-          if (it < commands.end()) {
-            token += *it;
+          if (it < end)
             ++it;
-          }
           if (commentDepth < 0)
             break;
           continue;
         }
-        if (it < commands.end()) {
-          token += *it;
-          ++it;
-        }
+        ++it;
       }
-      m_tokens.emplace_back(token, TS_CODE_COMMENT);
+      m_tokens.emplace_back(wxString(tokenStart, it), TS_CODE_COMMENT);
       continue;
     }
     // Handle operators and :lisp commands
-    if (Operators().Find(Ch) != wxNOT_FOUND) {
+    if (chClass & operatorChar) {
       if (Ch == ':') {
-        wxString breakCommand;
-        wxString::const_iterator it3(it);
-        int len = 14;  // why 14??
-        while ((len > 0) && (it3 < commands.end())) {
-          len--;
-          breakCommand += wxString(*it3);
-          ++it3;
-        }
-        if (breakCommand.Lower().StartsWith(":lisp ") ||
-            breakCommand.Lower().StartsWith(":lisp-quiet ") ||
-            breakCommand.Lower().StartsWith(":lisp\t") ||
-            breakCommand.Lower().StartsWith(":lisp-quiet\t")) {
-          wxString token;
-          while ((it < commands.end()) && (*it != '\n')) {
-            token += wxString(*it);
+        if (IsLispCommand(commands, it)) {
+          while ((it < end) && (*it != '\n'))
             ++it;
-          }
-          m_tokens.emplace_back(token, TS_CODE_LISP);
+          m_tokens.emplace_back(wxString(tokenStart, it), TS_CODE_LISP);
         } else {
           m_tokens.emplace_back(wxString(Ch), TS_CODE_OPERATOR);
           ++it;
         }
       } else {
-        wxString token = wxString(Ch);
-        if (configuration->GetChangeAsterisk()) {
-          token.Replace(wxS("*"), L"\u00B7");
-          token.Replace(wxS("-"), wxS("\u2212"));
+        if (configuration && configuration->GetChangeAsterisk()) {
+          if (Ch == '*')
+            Ch = L'\u00B7';
+          else if (Ch == '-')
+            Ch = L'\u2212';
         }
-
-        m_tokens.emplace_back(token, TS_CODE_OPERATOR);
+        m_tokens.emplace_back(wxString(Ch), TS_CODE_OPERATOR);
         ++it;
       }
       continue;
     }
     // Handle strings
     if (Ch == wxS('\"')) {
-      wxString token;
-      // Add the opening quote
-      token = Ch;
+      // Skip the opening quote
       ++it;
 
       // Add the string contents
-      while (it < commands.end()) {
+      while (it < end) {
         Ch = *it;
-        token += Ch;
         ++it;
         if (Ch == wxS('\\')) {
-          if (it < commands.end()) {
-            token += *it;
+          if (it < end)
             ++it;
-          }
         } else if (Ch == wxS('\"'))
           break;
       }
-      m_tokens.emplace_back(token, TS_CODE_STRING);
+      m_tokens.emplace_back(wxString(tokenStart, it), TS_CODE_STRING);
       continue;
     }
     // Handle number-like symbols
-    if (UnicodeNumbers().Find(Ch) != wxNOT_FOUND) {
-      wxString token = Ch;
+    if (chClass & numberChar) {
       ++it;
-      m_tokens.emplace_back(token, TS_CODE_NUMBER);
+      m_tokens.emplace_back(wxString(Ch), TS_CODE_NUMBER);
       continue;
     }
     // Handle numbers. Numbers begin with a digit, but can continue with letters
     // and can contain a + or - that follows an e, f, g, h or l.
-    if (IsNum(Ch)) {
-      wxString token;
+    if (chClass & digitChar) {
       wxUniChar lastChar = *it;
-      while (
-             (it < commands.end()) &&
-             ((IsNum(*it) || ((*it >= 'a') && (*it <= 'z')) ||
-               ((*it >= 'A') && (*it <= 'Z'))) ||
-              (((lastChar == 'e') || (lastChar == 'E') || (lastChar == 'f') ||
-                (lastChar == 'F') || (lastChar == 'g') || (lastChar == 'G') ||
-                (lastChar == 'h') || (lastChar == 'H') || (lastChar == 'l') ||
-                (lastChar == 'L')) &&
-               ((m_plusSigns.Contains(*it)) || (m_minusSigns.Contains(*it)))))) {
-        wxUniChar ch = *it;
-        for (wxString::const_iterator it3 = m_plusSigns.begin();
-             it3 != m_plusSigns.end(); ++it3)
-          if (ch == *it3)
-            ch = '+';
-        for (wxString::const_iterator it3 = m_minusSigns.begin();
-             it3 != m_minusSigns.end(); ++it3)
-          if (ch == *it3)
-            ch = '-';
-        token += ch;
-        lastChar = *it;
+      bool unicodeSigns = false;
+      while (it < end) {
+        const wxUniChar c = *it;
+        const std::uint8_t cClass = Classes(c);
+        if (!((cClass & digitChar) || ((c >= 'a') && (c <= 'z')) ||
+              ((c >= 'A') && (c <= 'Z')))) {
+          if (!((cClass & (plusChar | minusChar)) &&
+                ((lastChar == 'e') || (lastChar == 'E') || (lastChar == 'f') ||
+                 (lastChar == 'F') || (lastChar == 'g') || (lastChar == 'G') ||
+                 (lastChar == 'h') || (lastChar == 'H') || (lastChar == 'l') ||
+                 (lastChar == 'L'))))
+            break;
+          if ((c != '+') && (c != '-'))
+            unicodeSigns = true;
+        }
+        lastChar = c;
         ++it;
       }
-
-      m_tokens.emplace_back(token, TS_CODE_NUMBER);
+      wxString token(tokenStart, it);
+      // Maxima only understands ASCII signs
+      if (unicodeSigns)
+        for (wxString::iterator i = token.begin(); i != token.end(); ++i) {
+          if (Classes(*i) & plusChar)
+            *i = '+';
+          else if (Classes(*i) & minusChar)
+            *i = '-';
+        }
+      m_tokens.emplace_back(std::move(token), TS_CODE_NUMBER);
       continue;
     }
-    if (m_plusSigns.Contains(Ch)) {
-      wxString token = "+";
-      m_tokens.emplace_back(token);
+    if (chClass & plusChar) {
+      m_tokens.emplace_back(wxString(wxS("+")));
+      ++it;
       continue;
     }
-    if (m_minusSigns.Contains(Ch)) {
-      wxString token = "-";
-      m_tokens.emplace_back(token);
+    if (chClass & minusChar) {
+      m_tokens.emplace_back(wxString(wxS("-")));
+      ++it;
       continue;
     }
     // Merge consecutive spaces into one single token
-    if (IsSpace(Ch)) {
-      wxString token;
-      while ((it < commands.end()) && IsSpace(Ch)) {
-        if (Ch == '\t')
-          token += "\t";
-        else
-          token += " ";
-        if (++it < commands.end())
-          Ch = *it;
+    if (chClass & spaceChar) {
+      bool otherSpaces = false;
+      while ((it < end) && (Classes(*it) & spaceChar)) {
+        if ((*it != ' ') && (*it != '\t'))
+          otherSpaces = true;
+        ++it;
       }
-      m_tokens.emplace_back(token);
+      wxString token(tokenStart, it);
+      // All spaces except tabs become ordinary spaces
+      if (otherSpaces)
+        for (wxString::iterator i = token.begin(); i != token.end(); ++i)
+          if (*i != '\t')
+            *i = ' ';
+      m_tokens.emplace_back(std::move(token));
       continue;
     }
     // Handle keywords
-    if (IsAlpha(Ch) || (Ch == '\\') || (Ch == '?')) {
-      wxString token;
-      if (Ch == '?') {
-        token += Ch;
+    if ((chClass & alphaChar) || (Ch == '\\') || (Ch == '?')) {
+      if (Ch == '?')
         ++it;
-      }
 
-      while ((it < commands.end()) && (IsAlphaNum(*it) || (*it == '\\'))) {
-        Ch = *it;
-        token += Ch;
-        if (Ch == wxS('\\')) {
+      while ((it < end) && ((Classes(*it) & (alphaChar | digitChar)) || (*it == '\\'))) {
+        if (*it == wxS('\\')) {
           ++it;
-          if (it < commands.end()) {
-            Ch = *it;
-            if (Ch != wxS('\n'))
-              token += Ch;
-            else {
-              m_tokens.emplace_back(token);
-              token.Clear();
-
-              break;
-            }
+          // A backslash at the end of a line doesn't escape the line break
+          if ((it < end) && (*it == wxS('\n'))) {
+            m_tokens.emplace_back(wxString(tokenStart, it));
+            tokenStart = it;
+            break;
           }
         }
-        if (it < commands.end())
+        if (it < end)
           ++it;
       }
-      if (token == ("to_lisp")) {
-        while (
-               (it < commands.end()) && ((!token.EndsWith("(to-maxima)"))) &&
-               ((!token.EndsWith(wxString("(to") + wxS("\u2212") + "maxima)")))) {
-          token += wxString(*it);
-          ++it;
-        }
-        m_tokens.emplace_back(token, TS_CODE_LISP);
+      wxString token(tokenStart, it);
+      if (token == wxS("to_lisp")) {
+        it = LispEnd(commands, it);
+        m_tokens.emplace_back(wxString(tokenStart, it), TS_CODE_LISP);
       } else {
-        if (m_hardcodedFunctions.find(token) != m_hardcodedFunctions.end())
-          m_tokens.emplace_back(token, TS_CODE_FUNCTION);
-        else if (m_configuration->m_maximaOperators.find(token) !=
-                 m_configuration->m_maximaOperators.end())
-          m_tokens.emplace_back(token, TS_CODE_OPERATOR);
+        if (IsHardcodedFunction(token))
+          m_tokens.emplace_back(std::move(token), TS_CODE_FUNCTION);
+        else if (m_configuration &&
+                 (m_configuration->MaximaOperators().find(token) !=
+                  m_configuration->MaximaOperators().end()))
+          m_tokens.emplace_back(std::move(token), TS_CODE_OPERATOR);
         else {
           // Let's look what the next char looks like
           wxString::const_iterator it3(it);
-          while ((it3 < commands.end()) && ((*it3 == ' ') || (*it3 == '\t') ||
-                                            (*it3 == '\n') || (*it3 == '\r')))
+          while ((it3 < end) && ((*it3 == ' ') || (*it3 == '\t') ||
+                                 (*it3 == '\n') || (*it3 == '\r')))
             ++it3;
-          if (it3 >= commands.end())
-            m_tokens.emplace_back(token, TS_CODE_VARIABLE);
-          else {
-            if (*it3 == '(')
-              m_tokens.emplace_back(token, TS_CODE_FUNCTION);
-            else
-              m_tokens.emplace_back(token, TS_CODE_VARIABLE);
-          }
+          if ((it3 < end) && (*it3 == '('))
+            m_tokens.emplace_back(std::move(token), TS_CODE_FUNCTION);
+          else
+            m_tokens.emplace_back(std::move(token), TS_CODE_VARIABLE);
         }
       }
       continue;
@@ -360,31 +305,198 @@ MaximaTokenizer::MaximaTokenizer(const wxString &commands,
   m_tokens = initialTokens;
 }
 
-bool MaximaTokenizer::IsAlpha(wxUniChar ch) {
-  if (wxIsalpha(ch))
+MaximaTokenizer::Change MaximaTokenizer::Retokenize(TokenList &tokens,
+                                                    const wxString &oldText,
+                                                    const wxString &newText,
+                                                    const Configuration * const configuration) {
+  Change change;
+  // In lisp mode the first token extends up to the next (to-maxima)
+  if (configuration && configuration->InLispMode()) {
+    change.removed = tokens.size();
+    tokens = MaximaTokenizer(newText, configuration).PopTokens();
+    change.inserted = tokens.size();
+    return change;
+  }
+
+  // How much of the text before and after the edit is unchanged?
+  std::size_t prefix = 0;
+  {
+    wxString::const_iterator oldChar = oldText.begin();
+    wxString::const_iterator newChar = newText.begin();
+    while ((oldChar != oldText.end()) && (newChar != newText.end()) &&
+           (*oldChar == *newChar)) {
+      ++oldChar;
+      ++newChar;
+      ++prefix;
+    }
+  }
+  const std::size_t oldLength = oldText.Length();
+  const std::size_t newLength = newText.Length();
+  if ((prefix == oldLength) && (prefix == newLength)) {
+    change.first = tokens.size();
+    return change;
+  }
+  std::size_t suffix = 0;
+  {
+    const std::size_t maxSuffix = std::min(oldLength, newLength) - prefix;
+    wxString::const_reverse_iterator oldChar = oldText.rbegin();
+    wxString::const_reverse_iterator newChar = newText.rbegin();
+    while ((suffix < maxSuffix) && (*oldChar == *newChar)) {
+      ++oldChar;
+      ++newChar;
+      ++suffix;
+    }
+  }
+  const std::size_t oldEditEnd = oldLength - suffix;
+  const std::size_t newEditEnd = newLength - suffix;
+
+  // Find the last line start before the edit. A word only becomes a function
+  // name if a "(" follows it, even if there are line breaks in between: If a
+  // word is followed by nothing but whitespace the line start before it has
+  // to be used instead.
+  std::size_t token = 0;
+  std::size_t pos = 0;
+  std::size_t start = 0;
+  bool wordPending = false;
+  for (; token < tokens.size(); ++token) {
+    const wxString &text = tokens[token].GetText();
+    const std::size_t end = pos + text.Length();
+    if (end > prefix)
+      break;
+    if (IsLinebreak(tokens[token])) {
+      if (!wordPending) {
+        change.first = token + 1;
+        start = end;
+      }
+    }
+    else if (text.IsEmpty() || ((text[0] != ' ') && (text[0] != '\t')))
+      wordPending = (tokens[token].GetTextStyle() == TS_CODE_VARIABLE) ||
+        (tokens[token].GetTextStyle() == TS_CODE_FUNCTION);
+    pos = end;
+  }
+
+  // Tokenize the new text up to the first line start behind the edit that
+  // is a line start of the old text, too: From there on the old tokens are
+  // still valid.
+  std::size_t oldToken = token;
+  std::size_t oldPos = pos;
+  std::size_t resync = tokens.size();
+  auto stopAt = [&](std::size_t newPos) {
+    if (newPos < newEditEnd)
+      return false;
+    const std::size_t target = newPos - newEditEnd + oldEditEnd;
+    while ((oldToken < tokens.size()) && (oldPos < target)) {
+      oldPos += tokens[oldToken].GetText().Length();
+      ++oldToken;
+    }
+    if ((oldPos != target) || (oldToken == 0) || !IsLinebreak(tokens[oldToken - 1]))
+      return false;
+    resync = oldToken;
     return true;
+  };
+  TokenList newTokens = MaximaTokenizer(newText, configuration, start, stopAt).PopTokens();
+
+  change.removed = resync - change.first;
+  change.inserted = newTokens.size();
+  tokens.erase(tokens.begin() + change.first, tokens.begin() + resync);
+  tokens.insert(tokens.begin() + change.first, std::make_move_iterator(newTokens.begin()),
+                std::make_move_iterator(newTokens.end()));
+  return change;
+}
 
-  if (m_not_alphas.Find(ch) != wxNOT_FOUND)
-    return false;
+bool MaximaTokenizer::IsLinebreak(const Token &token) {
+  return (token.GetText().Length() == 1) && m_linebreaks.Contains(token.GetText());
+}
 
-  if (IsSpace(ch))
-    return false;
+bool MaximaTokenizer::IsAlpha(wxUniChar ch) { return Classes(ch) & alphaChar; }
+
+bool MaximaTokenizer::IsSpace(wxUniChar ch) { return Classes(ch) & spaceChar; }
+
+bool MaximaTokenizer::IsNum(wxUniChar ch) { return ch >= '0' && ch <= '9'; }
+
+bool MaximaTokenizer::IsAlphaNum(wxUniChar ch) { return Classes(ch) & (alphaChar | digitChar); }
+
+std::uint8_t MaximaTokenizer::Classify(wxUniChar ch) {
+  std::uint8_t classes = 0;
+  if (m_linebreaks.Find(ch) != wxNOT_FOUND)
+    classes |= linebreakChar;
+  if (Operators().Find(ch) != wxNOT_FOUND)
+    classes |= operatorChar;
+  if (UnicodeNumbers().Find(ch) != wxNOT_FOUND)
+    classes |= numberChar;
+  if ((ch >= '0') && (ch <= '9'))
+    classes |= digitChar;
+  if (m_plusSigns.Find(ch) != wxNOT_FOUND)
+    classes |= plusChar;
+  if (m_minusSigns.Find(ch) != wxNOT_FOUND)
+    classes |= minusChar;
+  if (m_spaces.Find(ch) != wxNOT_FOUND)
+    classes |= spaceChar;
 
   // If it cannot be converted to ASCII and we didn't detect it as a char we know
   // how to deal with it (in Maxima's view) is an ordinary letter.
-  if (ch > 127)
-    return true;
+  if (wxIsalpha(ch) ||
+      ((m_not_alphas.Find(ch) == wxNOT_FOUND) && !(classes & spaceChar) &&
+       ((ch > 127) || (m_additional_alphas.Find(ch) != wxNOT_FOUND))))
+    classes |= alphaChar;
+  return classes;
+}
 
-  return (m_additional_alphas.Find(ch) != wxNOT_FOUND);
+const std::array<std::uint8_t, MaximaTokenizer::ClassTableSize> &MaximaTokenizer::ClassTable() {
+  static const std::array<std::uint8_t, ClassTableSize> table = [] {
+    std::array<std::uint8_t, ClassTableSize> classes;
+    for (std::size_t i = 0; i < classes.size(); i++)
+      classes[i] = Classify(wxUniChar(static_cast<wxUint32>(i)));
+    return classes;
+  }();
+  return table;
 }
 
-bool MaximaTokenizer::IsSpace(wxUniChar ch) {
-  return m_spaces.Find(ch) != wxNOT_FOUND;
+bool MaximaTokenizer::IsHardcodedFunction(const wxString &word) {
+  if ((word.Length() < 2) || (word.Length() > 6))
+    return false;
+  // A perfect hash of the words: Each of them has a slot of its own.
+  static const wxChar *const words[32] = {
+    NULL, NULL, wxS("step"), NULL, wxS("or"), NULL, NULL, NULL,
+    wxS("for"), wxS("false"), NULL, wxS("true"), wxS("elseif"), NULL, NULL, wxS("unless"),
+    wxS("and"), NULL, wxS("then"), NULL, wxS("in"), NULL, wxS("not"), wxS("while"),
+    wxS("next"), wxS("else"), NULL, wxS("thru"), wxS("if"), wxS("do"), NULL, wxS("from")
+  };
+  const wxUniChar first = word[0];
+  const wxUniChar last = word.Last();
+  const std::size_t slot = (2 * word.Length() + 14 * static_cast<std::size_t>(first.GetValue()) +
+                            15 * static_cast<std::size_t>(last.GetValue())) & 31;
+  return (words[slot] != NULL) && (word == words[slot]);
 }
 
-bool MaximaTokenizer::IsNum(wxUniChar ch) { return ch >= '0' && ch <= '9'; }
+bool MaximaTokenizer::IsLispCommand(const wxString &commands, wxString::const_iterator it) {
+  // Does the text at it begin with this text, ignoring case?
+  auto matches = [&commands, &it](const wxChar *text) {
+    for (; *text != 0; ++text, ++it)
+      if ((it >= commands.end()) || (static_cast<wxChar>(wxTolower(*it)) != *text))
+        return false;
+    return true;
+  };
+  if (!matches(wxS(":lisp")))
+    return false;
+  if ((it < commands.end()) && (*it == '-') && !matches(wxS("-quiet")))
+    return false;
+  return (it < commands.end()) && ((*it == ' ') || (*it == '\t'));
+}
 
-bool MaximaTokenizer::IsAlphaNum(wxUniChar ch) { return IsAlpha(ch) || IsNum(ch); }
+wxString::const_iterator MaximaTokenizer::LispEnd(const wxString &commands,
+                                                  wxString::const_iterator it) {
+  const std::size_t start = static_cast<std::size_t>(it - commands.begin());
+  std::size_t end = wxString::npos;
+  for (const wxChar *marker : {wxS("(to-maxima)"), wxS("(to\u2212maxima)")}) {
+    std::size_t pos = commands.find(marker, start);
+    if (pos != wxString::npos)
+      end = std::min(end, pos + wxStrlen(marker));
+  }
+  if (end == wxString::npos)
+    return commands.end();
+  return commands.begin() + static_cast<std::ptrdiff_t>(end);
+}
 
 const wxString MaximaTokenizer::m_additional_alphas = wxS("\\_%µ");
 const wxString MaximaTokenizer::m_not_alphas =
@@ -415,5 +527,3 @@ const wxString MaximaTokenizer::m_plusSigns =
 const wxString MaximaTokenizer::m_minusSigns =
   "-" wxS("\u2796") wxS("\uFE63") wxS("\uFF0D");
 
-
-MaximaTokenizer::StringHash MaximaTokenizer::m_hardcodedFunctions;
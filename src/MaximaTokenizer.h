@@ -23,6 +23,9 @@
 #ifndef MAXIMATOKENIZER_H
 #define MAXIMATOKENIZER_H
 
+#include <array>
+#include <cstdint>
+#include <functional>
 #include <utility>
 #include <vector>
 #include <memory>
@@ -32,7 +35,6 @@
 #include "precomp.h"
 #include "cells/TextStyle.h"
 #include "Configuration.h"
-#include <unordered_map>
 
 /*!\file
 
@@ -53,7 +55,8 @@ public:
   /*! The constructor
 
     \param commands The maxima commands to tokenize
-    \param configuration A pointer to the configuration object
+    \param configuration A pointer to the configuration object. NULL means:
+    Not in lisp mode, don't replace asterisks and know only the built-in operators.
   */
   MaximaTokenizer(const wxString &commands, const Configuration * const configuration);
 
@@ -81,6 +84,8 @@ public:
   static bool IsNum(wxUniChar ch);
   static bool IsAlphaNum(wxUniChar ch);
   static bool IsSpace(wxUniChar ch);
+  //! Is this token a line break?
+  static bool IsLinebreak(const Token &token);
   static const wxString UnicodeNumbers() {
     return wxS("\u00BD\u00B2\u00B3\u221E"); // VULGAR FRACTION ONE HALF, SUPERSCRIPT TWO, SUPERSCRIPT THREE, INFINITY
   }
@@ -92,11 +97,49 @@ public:
   using TokenList = std::vector<Token>;
   TokenList PopTokens() && { return std::move(m_tokens); }
 
+  //! Which tokens Retokenize() has replaced
+  struct Change
+  {
+    //! The index of the first token that has been replaced
+    std::size_t first = 0;
+    //! How many of the old tokens have been removed
+    std::size_t removed = 0;
+    //! How many new tokens have been inserted instead
+    std::size_t inserted = 0;
+  };
+  /*! Updates the tokens of a text that has been edited
+
+    The tokenizer doesn't carry any state from one line to the next - with the
+    exception of comments, strings and lisp code, which are a single token each,
+    and of words that become function names if a "(" follows them. Retokenize()
+    therefore starts at the last line start before the edit that isn't preceded
+    by such a word and stops at the first line start after the edit where the
+    new tokens meet a line start of the old ones.
+
+    \param tokens The tokens of oldText. Will contain the tokens of newText.
+    \param oldText The text the tokens have been generated from
+    \param newText The edited text
+    \param configuration The configuration the tokens have been generated with.
+    In lisp mode all of newText is tokenized again.
+  */
+  static Change Retokenize(TokenList &tokens, const wxString &oldText,
+                           const wxString &newText,
+                           const Configuration * const configuration);
+
   //! A constructor that adds additional words to the token list
   MaximaTokenizer(const wxString &commands, const Configuration * const configuration,
                   const TokenList &initialTokens);
 
 protected:
+  /*! Tokenizes only a part of the commands
+
+    \param start The position to start at. Must be 0 or a line start.
+    \param stopAt Is asked at every line start the tokenizer reaches.
+    If it returns true, the tokenizer stops there.
+  */
+  MaximaTokenizer(const wxString &commands, const Configuration * const configuration,
+                  std::size_t start, const std::function<bool (std::size_t)> &stopAt);
+
   //! The tokens the string is divided into
   TokenList m_tokens;
   //! ASCII symbols that wxIsalnum() doesn't see as chars, but maxima does.
@@ -114,15 +157,42 @@ protected:
 
   const Configuration * const m_configuration = NULL;
 
-  typedef std::unordered_map <wxString, int, wxStringHash> StringHash;
-  /*! Names of functions that don't require parenthesis
+  //! The classes a character can belong to. A character can belong to several of them.
+  enum CharClass : std::uint8_t
+  {
+    alphaChar = 1,      //!< Can be part of a name
+    digitChar = 2,      //!< An ASCII digit
+    spaceChar = 4,      //!< A space
+    linebreakChar = 8,  //!< A line break
+    operatorChar = 16,  //!< One of Operators()
+    numberChar = 32,    //!< One of UnicodeNumbers()
+    plusChar = 64,      //!< A plus sign
+    minusChar = 128     //!< A minus sign
+  };
+  //! Characters below this code point are classified by a table
+  static constexpr std::size_t ClassTableSize = 0x3000;
+  //! The classes of a character
+  static std::uint8_t Classes(wxUniChar ch) {
+    const wxUint32 value = ch.GetValue();
+    return (value < ClassTableSize) ? ClassTable()[value] : Classify(ch);
+  }
+  //! Determines the classes of a character without the help of the table
+  static std::uint8_t Classify(wxUniChar ch);
+  //! The classes of all characters below ClassTableSize
+  static const std::array<std::uint8_t, ClassTableSize> &ClassTable();
+  /*! Is this word the name of a function that doesn't require parenthesis?
 
     The maxima parser automatically parses everything that is followed by
     an opening parenthesis as a function. But a few things like "then"
     are very similar to functions except that they don't require an
-    argument. These fake functions are kept in this hash.
+    argument.
   */
-  static StringHash m_hardcodedFunctions;
+  static bool IsHardcodedFunction(const wxString &word);
+  //! Does a :lisp or :lisp-quiet command start at this position?
+  static bool IsLispCommand(const wxString &commands, wxString::const_iterator it);
+  //! Where the lisp code that starts at this position ends
+  static wxString::const_iterator LispEnd(const wxString &commands,
+                                          wxString::const_iterator it);
 
 };
 
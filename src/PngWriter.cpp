@@ -0,0 +1,145 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  Defines PngWriter, which writes .png files line by line.
+*/
+
+#include "PngWriter.h"
+#include "Crc32.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+  void PutUInt32(unsigned char *out, uint32_t value) {
+    out[0] = static_cast<unsigned char>(value >> 24);
+    out[1] = static_cast<unsigned char>(value >> 16);
+    out[2] = static_cast<unsigned char>(value >> 8);
+    out[3] = static_cast<unsigned char>(value);
+  }
+}
+
+//! Collects what zlib writes and writes it as IDAT chunks
+class PngWriter::ChunkStream final : public wxOutputStream
+{
+public:
+  explicit ChunkStream(PngWriter &png) : m_png(png) {}
+  //! Writes the data that has been collected, if there is any
+  void WriteChunk() {
+    if (!m_data.empty())
+      m_png.WriteChunk("IDAT", m_data.data(), m_data.size());
+    m_data.clear();
+  }
+
+protected:
+  size_t OnSysWrite(const void *buffer, size_t size) override {
+    const unsigned char *bytes = static_cast<const unsigned char *>(buffer);
+    m_data.insert(m_data.end(), bytes, bytes + size);
+    if (m_data.size() >= ChunkSize)
+      WriteChunk();
+    return size;
+  }
+
+private:
+  PngWriter &m_png;
+  std::vector<unsigned char> m_data;
+};
+
+PngWriter::PngWriter(wxOutputStream &stream, int width, int height, double dpi):
+  m_stream(stream),
+  m_width(width),
+  m_height(height),
+  m_line(1 + 3 * static_cast<std::size_t>(width))
+{
+  static const unsigned char signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+  m_stream.Write(signature, sizeof(signature));
+
+  unsigned char header[13];
+  PutUInt32(header, static_cast<uint32_t>(width));
+  PutUInt32(header + 4, static_cast<uint32_t>(height));
+  header[8] = 8;  // bits per color channel
+  header[9] = 2;  // RGB
+  header[10] = 0; // deflate
+  header[11] = 0; // a filter type per line
+  header[12] = 0; // not interlaced
+  WriteChunk("IHDR", header, sizeof(header));
+
+  if (dpi > 0) {
+    unsigned char physical[9];
+    uint32_t perMetre = static_cast<uint32_t>(std::lround(dpi / 0.0254));
+    PutUInt32(physical, perMetre);
+    PutUInt32(physical + 4, perMetre);
+    physical[8] = 1; // the unit is the metre
+    WriteChunk("pHYs", physical, sizeof(physical));
+  }
+
+  m_chunks = std::make_unique<ChunkStream>(*this);
+  m_zlib = std::make_unique<wxZlibOutputStream>(*m_chunks, -1, wxZLIB_ZLIB);
+}
+
+PngWriter::~PngWriter() {
+  Finish();
+}
+
+void PngWriter::AddLines(const unsigned char *rgb, int lines) {
+  if (m_finished)
+    return;
+  const std::size_t bytes = m_line.size() - 1;
+  for (int i = 0; (i < lines) && (m_lines < m_height); i++, m_lines++) {
+    const unsigned char *in = rgb + i * bytes;
+    // The "sub" filter stores the difference of each byte to the same color
+    // of the pixel left of it: Areas of a single color compress much better.
+    m_line[0] = 1;
+    for (std::size_t j = 0; (j < 3) && (j < bytes); j++)
+      m_line[1 + j] = in[j];
+    for (std::size_t j = 3; j < bytes; j++)
+      m_line[1 + j] = static_cast<unsigned char>(in[j] - in[j - 3]);
+    m_zlib->Write(m_line.data(), m_line.size());
+  }
+}
+
+bool PngWriter::Finish() {
+  if (m_finished)
+    return m_ok;
+  m_finished = true;
+  bool zlibOk = m_zlib->Close();
+  m_chunks->WriteChunk();
+  WriteChunk("IEND", NULL, 0);
+  m_ok = zlibOk && (m_lines == m_height) && m_stream.IsOk();
+  return m_ok;
+}
+
+void PngWriter::WriteChunk(const char *type, const unsigned char *data, std::size_t length) {
+  unsigned char header[8];
+  PutUInt32(header, static_cast<uint32_t>(length));
+  std::memcpy(header + 4, type, 4);
+  m_stream.Write(header, sizeof(header));
+  if (length > 0)
+    m_stream.Write(data, length);
+  // The checksum covers the chunk's type and data
+  uint32_t crc = Crc32::Compute(header + 4, 4);
+  if (length > 0)
+    crc = Crc32::Update(crc, data, length);
+  unsigned char trailer[4];
+  PutUInt32(trailer, crc);
+  m_stream.Write(trailer, sizeof(trailer));
+}
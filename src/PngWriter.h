@@ -0,0 +1,91 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  Declares PngWriter, which writes .png files line by line.
+*/
+
+#ifndef PNGWRITER_H
+#define PNGWRITER_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <wx/stream.h>
+#include <wx/zstream.h>
+
+/*! Writes a RGB .png file whose lines arrive in parts
+
+  wxImage can only save an image that is completely in memory. PngWriter
+  compresses each part of the image as soon as it arrives, so an image can
+  be written without ever holding all of it in memory.
+*/
+class PngWriter
+{
+public:
+  /*! Starts the image by writing its header
+
+    \param stream The stream the .png file is written to
+    \param width The width of the image in pixels
+    \param height The height of the image in pixels
+    \param dpi The resolution the file tells. 0 = the file tells no resolution.
+  */
+  PngWriter(wxOutputStream &stream, int width, int height, double dpi = 0);
+  //! Calls Finish() if that hasn't been done
+  ~PngWriter();
+
+  /*! Adds the next lines of the image
+
+    \param rgb The pixels of the lines, 3 bytes per pixel (red, green, blue)
+    \param lines The number of lines. Lines past the image's height are ignored.
+  */
+  void AddLines(const unsigned char *rgb, int lines);
+  //! The number of lines that still are missing
+  int GetMissingLines() const { return m_height - m_lines; }
+  /*! Ends the image
+
+    \return false, if lines are missing or the stream has failed.
+  */
+  bool Finish();
+
+  //! How many bytes of compressed data a IDAT chunk holds at most
+  static constexpr std::size_t ChunkSize = 1 << 16;
+
+private:
+  class ChunkStream;
+  //! Writes a chunk of the .png file
+  void WriteChunk(const char *type, const unsigned char *data, std::size_t length);
+
+  wxOutputStream &m_stream;
+  const int m_width;
+  const int m_height;
+  //! The number of lines that have been added
+  int m_lines = 0;
+  //! A line in the form it is compressed in
+  std::vector<unsigned char> m_line;
+  //! Packs the compressed data into IDAT chunks
+  std::unique_ptr<ChunkStream> m_chunks;
+  std::unique_ptr<wxZlibOutputStream> m_zlib;
+  bool m_finished = false;
+  bool m_ok = false;
+};
+
+#endif // PNGWRITER_H
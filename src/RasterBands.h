@@ -0,0 +1,93 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  Splits rasterizing an image into horizontal bands that are rendered in parallel.
+
+  This file intentionally doesn't depend on wxWidgets, so nanoSVGTest.cpp can
+  benchmark it. The bands are run by the ThreadPool, which doesn't depend on
+  wxWidgets, either.
+*/
+
+#ifndef RASTERBANDS_H
+#define RASTERBANDS_H
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include "ThreadPool.h"
+
+namespace RasterBands {
+  //! Images with less pixels than this aren't worth splitting into bands
+  constexpr long MinParallelPixels = 512L * 512L;
+  //! The minimum number of lines a band consists of
+  constexpr int MinBandHeight = 64;
+
+  //! How many bands we want to split an image of this size into
+  inline int NumberOfBands(int width, int height)
+  {
+    if (static_cast<long>(width) * height < MinParallelPixels)
+      return 1;
+    int bands = static_cast<int>(std::thread::hardware_concurrency());
+    if (bands < 1)
+      bands = 1;
+    return std::max(1, std::min(bands, height / MinBandHeight));
+  }
+
+  /*! Renders an image of height "height" in "bands" horizontal bands
+
+    \param rasterize is called as rasterize(band, firstLine, lines) once per band.
+    The calling thread renders band 0 itself, the other bands are tasks of the
+    ThreadPool. Each band must use its own rasterizer state. nanoSVG's
+    rasterizer renders a band if it is given a ty of -firstLine and a
+    destination pointer that points to firstLine.
+
+    The calling thread waits for the bands, so they are queued with the highest
+    priority. If no worker is free the waiting thread renders them itself: This
+    function can be called from a task of the ThreadPool, too.
+  */
+  template <class BandRenderer>
+  void Rasterize(int height, int bands, BandRenderer rasterize)
+  {
+    if (bands < 2) {
+      rasterize(0, 0, height);
+      return;
+    }
+    int bandHeight = (height + bands - 1) / bands;
+    std::vector<ThreadPool::Task> tasks;
+    tasks.reserve(bands - 1);
+    for (int band = 1; band < bands; band++) {
+      int firstLine = band * bandHeight;
+      int lines = std::min(bandHeight, height - firstLine);
+      if (lines <= 0)
+        break;
+      tasks.push_back(ThreadPool::Get().Submit(ThreadPool::visible,
+                                               [&rasterize, band, firstLine, lines]() {
+                                                 rasterize(band, firstLine, lines);
+                                               }));
+    }
+    rasterize(0, 0, std::min(bandHeight, height));
+    for (auto &task : tasks)
+      task.Wait();
+  }
+}
+
+#endif // RASTERBANDS_H
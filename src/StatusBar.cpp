@@ -28,6 +28,7 @@
 */
 #include "StatusBar.h"
 #include "Image.h"
+#include "ImageCacheBudget.h"
 #include "ArtProvider.h"
 #include "SvgBitmap.h"
 #include "art/statusbar/network-idle.h"
@@ -89,6 +90,10 @@ StatusBar::StatusBar(wxWindow *parent, int id)
   m_statusText->Connect(
                         wxEVT_LEFT_DCLICK, wxCommandEventHandler(StatusBar::StatusMsgDClick), NULL,
                         this);
+  m_statusText->Connect(wxEVT_ENTER_WINDOW,
+                        wxMouseEventHandler(StatusBar::OnStatusTextEnter), NULL, this);
+  m_statusTextPanel->Connect(wxEVT_ENTER_WINDOW,
+                             wxMouseEventHandler(StatusBar::OnStatusTextEnter), NULL, this);
 
   m_maximaStatus = new wxStaticBitmap(this, wxID_ANY, m_network_offline);
   m_networkStatus = new wxStaticBitmap(this, wxID_ANY, m_network_offline);
@@ -109,6 +114,18 @@ void StatusBar::StatusMsgDClick(wxCommandEvent &ev)
   ev.Skip();
 }
 
+void StatusBar::OnStatusTextEnter(wxMouseEvent &event)
+{
+  const double megabyte = 1024.0 * 1024.0;
+  wxString toolTip = wxString::Format(_("Cached images: %li images use %.1f of %.1f MB"),
+                                      static_cast<long>(ImageCacheBudget::GetNumberOfImages()),
+                                      ImageCacheBudget::GetUsage() / megabyte,
+                                      ImageCacheBudget::GetBudget() / megabyte);
+  m_statusText->SetToolTip(toolTip);
+  m_statusTextPanel->SetToolTip(toolTip);
+  event.Skip();
+}
+
 void StatusBar::UpdateBitmaps() {
   wxSize ppi(-1, -1);
 #if wxCHECK_VERSION(3, 1, 1)
@@ -101,6 +101,8 @@ protected:
   void StatusMsgDClick(wxCommandEvent &ev);
   void OnSize(wxSizeEvent &event);
   void OnTimerEvent(wxTimerEvent &event);
+  //! Shows how much memory the images cache as the tooltip of the status text
+  void OnStatusTextEnter(wxMouseEvent &event);
 
   void HandleTimerEvent();
 
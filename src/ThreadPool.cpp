@@ -0,0 +1,304 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  Defines ThreadPool, the pool of threads all background tasks are run in.
+*/
+
+#include "ThreadPool.h"
+
+//! Everything a task's handle, the pool and its workers share
+class ThreadPool::TaskState
+{
+public:
+  enum State {queued, running, done};
+  TaskState(ThreadPool *pool, Priority priority, std::function<void()> work,
+            CancellationToken token) :
+    m_pool(pool), m_priority(priority), m_work(std::move(work)),
+    m_token(std::move(token)) {}
+  ThreadPool *m_pool;
+  /*! The priority the task is queued with
+
+    Reprioritize() leaves the task's old entry in the queue, which is skipped if
+    its priority doesn't match this one.
+  */
+  std::atomic<int> m_priority;
+  std::function<void()> m_work;
+  CancellationToken m_token;
+  //! Whoever changes this from queued to running runs the task
+  std::atomic<int> m_state{queued};
+  /*! Guards the end of the task and its leaving the queued state
+
+    Reprioritize() holds it, too, so it never moves a task to another priority
+    that is just being started or cancelled.
+  */
+  std::mutex m_mutex;
+  std::condition_variable m_done;
+};
+
+namespace {
+  //! The pool the current thread is a worker of, if any
+  thread_local ThreadPool *currentPool = NULL;
+  //! The index of the worker the current thread is
+  thread_local std::size_t currentWorker = 0;
+}
+
+ThreadPool &ThreadPool::Get() {
+  // Never destroyed: Tasks might still be submitted while the static objects
+  // are being destroyed.
+  static ThreadPool *pool = new ThreadPool();
+  return *pool;
+}
+
+ThreadPool::ThreadPool(std::size_t workers) {
+  if (workers == 0) {
+    workers = std::thread::hardware_concurrency();
+    if (workers < 4)
+      workers = 4;
+  }
+  for (std::size_t i = 0; i < workers; i++)
+    m_workers.emplace_back(new Worker);
+  for (std::size_t i = 0; i < workers; i++)
+    m_workers[i]->thread = std::thread(&ThreadPool::WorkerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+  for (auto &worker : m_workers) {
+    const std::lock_guard<std::mutex> lock(worker->mutex);
+    for (auto &queue : worker->queues)
+      for (auto &task : queue)
+        task->m_token.Cancel();
+  }
+  {
+    const std::lock_guard<std::mutex> lock(m_sleepMutex);
+    m_stop = true;
+  }
+  m_wakeUp.notify_all();
+  for (auto &worker : m_workers)
+    worker->thread.join();
+}
+
+ThreadPool::Task ThreadPool::Submit(Priority priority, std::function<void()> work,
+                                    CancellationToken token) {
+  auto task = std::make_shared<TaskState>(this, priority, std::move(work),
+                                          std::move(token));
+  // Tasks a worker creates are queued for itself: Other workers will steal
+  // them if it is busy.
+  std::size_t index;
+  if (currentPool == this)
+    index = currentWorker;
+  else
+    index = m_nextWorker++ % m_workers.size();
+  m_queuedByPriority[priority]++;
+  Enqueue(index, priority, task);
+  return Task(task);
+}
+
+void ThreadPool::Enqueue(std::size_t index, Priority priority,
+                         std::shared_ptr<TaskState> task) {
+  {
+    const std::lock_guard<std::mutex> lock(m_workers[index]->mutex);
+    m_workers[index]->queues[priority].push_back(std::move(task));
+  }
+  {
+    const std::lock_guard<std::mutex> lock(m_sleepMutex);
+    m_queued++;
+  }
+  m_wakeUp.notify_one();
+}
+
+void ThreadPool::Reprioritize(const std::shared_ptr<TaskState> &task,
+                              Priority priority) {
+  {
+    const std::lock_guard<std::mutex> lock(task->m_mutex);
+    if (task->m_state != TaskState::queued)
+      return;
+    int oldPriority = task->m_priority.exchange(priority);
+    if (oldPriority == priority)
+      return;
+    m_queuedByPriority[oldPriority]--;
+    m_queuedByPriority[priority]++;
+  }
+  m_reprioritized++;
+  // The entry in the old queue stays where it is and is skipped once a
+  // worker finds it.
+  std::size_t index;
+  if (currentPool == this)
+    index = currentWorker;
+  else
+    index = m_nextWorker++ % m_workers.size();
+  Enqueue(index, priority, task);
+}
+
+bool ThreadPool::Cancel(const std::shared_ptr<TaskState> &task) {
+  task->m_token.Cancel();
+  {
+    const std::lock_guard<std::mutex> lock(task->m_mutex);
+    int expected = TaskState::queued;
+    if (!task->m_state.compare_exchange_strong(expected, TaskState::running))
+      return false;
+    m_queuedByPriority[task->m_priority]--;
+  }
+  m_cancelled++;
+  task->m_work = nullptr;
+  {
+    const std::lock_guard<std::mutex> lock(task->m_mutex);
+    task->m_state = TaskState::done;
+  }
+  task->m_done.notify_all();
+  return true;
+}
+
+void ThreadPool::WorkerLoop(std::size_t index) {
+  currentPool = this;
+  currentWorker = index;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(m_sleepMutex);
+      m_wakeUp.wait(lock, [this] { return m_stop || (m_queued > 0); });
+      if (m_stop && (m_queued == 0))
+        return;
+    }
+    auto task = FindTask(index);
+    if (task)
+      Run(task, false);
+  }
+}
+
+std::shared_ptr<ThreadPool::TaskState> ThreadPool::FindTask(std::size_t index) {
+  std::shared_ptr<TaskState> task;
+  for (int priority = 0; (priority < NumberOfPriorities) && (!task); priority++) {
+    // Our own queue first, in the order the tasks were submitted. Then steal
+    // from the end of the other workers' queues.
+    for (std::size_t i = 0; (i < m_workers.size()) && (!task); i++) {
+      Worker &worker = *m_workers[(index + i) % m_workers.size()];
+      const std::lock_guard<std::mutex> lock(worker.mutex);
+      auto &queue = worker.queues[priority];
+      while ((!queue.empty()) && (!task)) {
+        if (i == 0) {
+          task = std::move(queue.front());
+          queue.pop_front();
+        } else {
+          task = std::move(queue.back());
+          queue.pop_back();
+        }
+        {
+          const std::lock_guard<std::mutex> sleepLock(m_sleepMutex);
+          m_queued--;
+        }
+        // Skip entries the task has left behind when it was reprioritized
+        // and tasks that have run or have been cancelled already.
+        if ((task->m_priority != priority) || (task->m_state != TaskState::queued))
+          task.reset();
+        else if (i != 0)
+          m_stolen++;
+      }
+    }
+  }
+  return task;
+}
+
+void ThreadPool::Run(const std::shared_ptr<TaskState> &task, bool inWaitingThread) {
+  {
+    const std::lock_guard<std::mutex> lock(task->m_mutex);
+    int expected = TaskState::queued;
+    // Task::Wait() might have run the task already
+    if (!task->m_state.compare_exchange_strong(expected, TaskState::running))
+      return;
+    m_queuedByPriority[task->m_priority]--;
+  }
+  if (task->m_token.IsCancelled())
+    m_cancelled++;
+  else {
+    m_running++;
+    if (inWaitingThread)
+      m_ranInline++;
+    task->m_work();
+    m_running--;
+    m_completed++;
+  }
+  // Free everything the task has captured before anybody is told it is done
+  task->m_work = nullptr;
+  {
+    const std::lock_guard<std::mutex> lock(task->m_mutex);
+    task->m_state = TaskState::done;
+  }
+  task->m_done.notify_all();
+}
+
+ThreadPool::Statistics ThreadPool::GetStatistics() const {
+  Statistics statistics;
+  for (int priority = 0; priority < NumberOfPriorities; priority++)
+    statistics.queued[priority] = m_queuedByPriority[priority];
+  statistics.running = m_running;
+  statistics.completed = m_completed;
+  statistics.cancelled = m_cancelled;
+  statistics.stolen = m_stolen;
+  statistics.ranInline = m_ranInline;
+  statistics.reprioritized = m_reprioritized;
+  statistics.workers = m_workers.size();
+  return statistics;
+}
+
+bool ThreadPool::Task::Done() const {
+  return (!m_state) || (m_state->m_state == TaskState::done);
+}
+
+void ThreadPool::Task::Wait() {
+  if (!m_state)
+    return;
+  m_state->m_pool->Run(m_state, true);
+  {
+    std::unique_lock<std::mutex> lock(m_state->m_mutex);
+    m_state->m_done.wait(lock, [this] { return m_state->m_state == TaskState::done; });
+  }
+  m_state.reset();
+}
+
+void ThreadPool::Task::CancelAndWait() {
+  if (!m_state)
+    return;
+  m_state->m_token.Cancel();
+  Wait();
+}
+
+bool ThreadPool::Task::Cancel() {
+  if (!m_state)
+    return false;
+  return m_state->m_pool->Cancel(m_state);
+}
+
+void ThreadPool::Task::SetPriority(Priority priority) {
+  if (m_state)
+    m_state->m_pool->Reprioritize(m_state, priority);
+}
+
+ThreadPool::Priority ThreadPool::Task::GetPriority() const {
+  if (!m_state)
+    return indexing;
+  return static_cast<Priority>(m_state->m_priority.load());
+}
+
+ThreadPool::CancellationToken ThreadPool::Task::GetCancellationToken() const {
+  if (m_state)
+    return m_state->m_token;
+  return CancellationToken();
+}
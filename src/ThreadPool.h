@@ -0,0 +1,222 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  Declares ThreadPool, the pool of threads all background tasks are run in.
+
+  Doesn't depend on wxWidgets, so it can be tested on its own.
+*/
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*! A work-stealing pool of threads that runs background tasks by priority
+
+  Starting a thread for each background task and limiting the number of threads
+  that actually run means that opening a document with hundreds of images
+  creates hundreds of threads that wait for each other. Instead all tasks are
+  queued here and run by a fixed number of worker threads:
+
+  - Each worker has its own queues, one per priority. A worker that has run out
+    of work steals tasks from the other workers, so no queue is a bottleneck.
+  - Before a worker runs a task of a lower priority it makes sure that neither
+    its own queue nor the queue of any other worker contains a task of a higher
+    priority.
+  - Every task can be cancelled before it starts. Long-running tasks can ask
+    their CancellationToken if they should end early.
+  - A task that hasn't started can be moved to another priority, for example
+    if the image it decodes has been scrolled into view.
+  - Waiting for a task that hasn't started, yet, runs it in the waiting thread,
+    so waiting for a task never means waiting for the queue.
+*/
+class ThreadPool
+{
+public:
+  //! How urgent a task is
+  enum Priority
+  {
+    visible = 0,  //!< Needed to draw what is on the screen right now
+    prefetch,     //!< Will probably be needed soon
+    indexing,     //!< Nobody waits for the result
+    NumberOfPriorities
+  };
+
+  /*! Tells a task if it should stop early
+
+    Copies share their state.
+  */
+  class CancellationToken
+  {
+  public:
+    CancellationToken() : m_cancelled(std::make_shared<std::atomic<bool>>(false)) {}
+    //! Asks the task to end as soon as possible. Tasks that haven't started won't start.
+    void Cancel() { *m_cancelled = true; }
+    //! Has Cancel() been called?
+    bool IsCancelled() const { return *m_cancelled; }
+
+  private:
+    std::shared_ptr<std::atomic<bool>> m_cancelled;
+  };
+
+  class TaskState;
+
+  /*! The handle of a task that has been submitted to the pool
+
+    A default-constructed Task does nothing and isn't pending.
+  */
+  class Task
+  {
+  public:
+    Task() = default;
+    //! Has the task been submitted, but Wait() not been called, yet?
+    bool Pending() const { return m_state != nullptr; }
+    //! Has the task ended (or never been started)?
+    bool Done() const;
+    /*! Waits until the task has ended
+
+      If no worker has started the task, yet, it is run in the calling thread
+      instead, unless it has been cancelled. Does nothing if the task isn't
+      pending.
+    */
+    void Wait();
+    //! Cancels the task and waits for it to end
+    void CancelAndWait();
+    /*! Cancels the task
+
+      \return true, if the task hadn't started and now never will. In this case
+      the task is done.
+    */
+    bool Cancel();
+    /*! Moves a task that hasn't started, yet, to the queue for another priority
+
+      The task is queued behind the tasks that already wait with that priority.
+    */
+    void SetPriority(Priority priority);
+    //! The priority the task is queued with
+    Priority GetPriority() const;
+    //! The token the task can ask if it should stop early
+    CancellationToken GetCancellationToken() const;
+
+  private:
+    friend class ThreadPool;
+    explicit Task(std::shared_ptr<TaskState> state) : m_state(std::move(state)) {}
+    std::shared_ptr<TaskState> m_state;
+  };
+
+  //! What the pool is doing
+  struct Statistics
+  {
+    //! The number of tasks of each priority that wait for a worker
+    std::array<std::size_t, NumberOfPriorities> queued = {};
+    //! The number of tasks that are being run right now
+    std::size_t running = 0;
+    //! The number of tasks that have ended
+    std::size_t completed = 0;
+    //! The number of tasks that were cancelled before they started
+    std::size_t cancelled = 0;
+    //! The number of tasks a worker took from another worker's queue
+    std::size_t stolen = 0;
+    //! The number of tasks that were run by Task::Wait() instead of by a worker
+    std::size_t ranInline = 0;
+    //! The number of times a queued task was given a different priority
+    std::size_t reprioritized = 0;
+    //! The number of worker threads
+    std::size_t workers = 0;
+  };
+
+  //! The pool all of wxMaxima's background tasks run in
+  static ThreadPool &Get();
+
+  /*! Creates a pool with the given number of workers
+
+    0 means: one worker per processor, but at least 4.
+  */
+  explicit ThreadPool(std::size_t workers = 0);
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+  //! Cancels all tasks that haven't started and waits for the others
+  ~ThreadPool();
+
+  /*! Queues a task
+
+    \param priority How urgent the task is
+    \param work The task. If it runs for a long time it should ask token if
+    it should end early.
+    \param token The token that allows to cancel the task
+  */
+  Task Submit(Priority priority, std::function<void()> work,
+              CancellationToken token = CancellationToken());
+
+  //! A snapshot of what the pool is doing
+  Statistics GetStatistics() const;
+
+private:
+  struct Worker
+  {
+    std::mutex mutex;
+    std::array<std::deque<std::shared_ptr<TaskState>>, NumberOfPriorities> queues;
+    std::thread thread;
+  };
+  //! The main loop of each worker thread
+  void WorkerLoop(std::size_t index);
+  //! Finds the most urgent task, preferring the queue of the worker index
+  std::shared_ptr<TaskState> FindTask(std::size_t index);
+  //! Runs a task unless somebody else has started it or it has been cancelled
+  void Run(const std::shared_ptr<TaskState> &task, bool inWaitingThread);
+  //! Marks a task as done without running it, if it hasn't started, yet
+  bool Cancel(const std::shared_ptr<TaskState> &task);
+  //! Queues the task again with a different priority
+  void Reprioritize(const std::shared_ptr<TaskState> &task, Priority priority);
+  //! Queues an entry for the task in the queue for "priority" of worker index
+  void Enqueue(std::size_t index, Priority priority, std::shared_ptr<TaskState> task);
+
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  //! Locked while checking if the workers should sleep
+  std::mutex m_sleepMutex;
+  //! Wakes up the workers if there is work or the pool is to be destroyed
+  std::condition_variable m_wakeUp;
+  //! The number of entries of all queues together
+  std::size_t m_queued = 0;
+  bool m_stop = false;
+  //! The worker Submit() queues the next task for, if not called from a worker
+  std::atomic<std::size_t> m_nextWorker{0};
+
+  std::array<std::atomic<std::size_t>, NumberOfPriorities> m_queuedByPriority = {};
+  std::atomic<std::size_t> m_running{0};
+  std::atomic<std::size_t> m_completed{0};
+  std::atomic<std::size_t> m_cancelled{0};
+  std::atomic<std::size_t> m_stolen{0};
+  std::atomic<std::size_t> m_ranInline{0};
+  std::atomic<std::size_t> m_reprioritized{0};
+};
+
+#endif // THREADPOOL_H
@@ -30,273 +30,395 @@
 #include <memory>
 #include <cstdlib>
 #include <vector>
+#include <unordered_map>
 #include "WXMXformat.h"
 #include "CellPointers.h"
 #include "cells/CellList.h"
 #include "cells/ImgCell.h"
+#include "XmlStreamChecker.h"
+#include "Crc32.h"
+#include "WxmxArchive.h"
 #include <wx/debug.h>
 #include <wx/textbuf.h>
 #include <wx/txtstrm.h>
 #include <wx/tokenzr.h>
-#include <wx/xml/xml.h>
 #include <wx/mstream.h>
 #include <wx/zipstrm.h>
+#include <wx/wfstream.h>
+#include <wx/ffile.h>
+#include <wx/filename.h>
 #include <wx/clipbrd.h>
+namespace {
+  //! The name, size and checksum of a file we have written to a .wxmx archive
+  struct WrittenEntry
+  {
+    wxString name;
+    wxFileOffset size;
+    uint32_t crc;
+  };
+
+  /*! Does the central directory of a .zip archive list the files we have written?
+
+    Only the central directory is read, not the files themselves.
+  */
+  bool CheckCentralDirectory(const wxString &file, const std::vector<WrittenEntry> &written,
+                             wxString &error) {
+    wxFFileInputStream input(file);
+    std::unordered_map<wxString, std::unique_ptr<wxZipEntry>, wxStringHash> entries;
+    if (input.IsOk()) {
+      wxZipInputStream zip(input);
+      wxZipEntry *entry;
+      while ((entry = zip.GetNextEntry()) != NULL)
+        entries[entry->GetName()].reset(entry);
+    }
+    for (const auto &expected : written) {
+      auto found = entries.find(expected.name);
+      if ((found == entries.end()) || (found->second->GetSize() != expected.size) ||
+          (found->second->GetCrc() != expected.crc)) {
+        wxLogMessage(_("%s is missing or damaged in the .zip archive we have written"),
+                     expected.name);
+        error = _(wxS("Saving succeeded, but the file could not be read "
+                      "again \u21D2 Not replacing the old saved file."));
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
 namespace Format {
 
-  /*
-  Save the data as wxmx file
+  WXMXSnapshot::~WXMXSnapshot() {
+    if ((!contentFile.IsEmpty()) && wxFileExists(contentFile))
+      wxRemoveFile(contentFile);
+  }
 
-  First saves the data to a backup file ending in .wxmx~ so if anything goes
-  horribly wrong in this step all that is lost is the data that was input
-  since the last save. Then the original .wxmx file is replaced in a
-  (hopefully) atomic operation.
-*/
-  bool ExportToWXMX(GroupCell *cells, const wxString &file,
-                    Configuration *configuration, CellPointers *cellPointers,
-                    const std::vector<wxString> &variables, const GroupCell * const cursorCell) {
-  // Show a busy cursor as long as we export a file.
-  wxBusyCursor crs;
-  // Clear the list of files we need to embed
-  configuration->ClearFilesToSave();
-  // Don't update the worksheet whilst exporting
-  //  wxWindowUpdateLocker noUpdates(this);
+  std::unique_ptr<WXMXSnapshot> CreateWXMXSnapshot(GroupCell *cells,
+                                                   Configuration *configuration,
+                                                   CellPointers *cellPointers,
+                                                   const std::vector<wxString> &variables,
+                                                   const GroupCell * const cursorCell) {
+    std::unique_ptr<WXMXSnapshot> snapshot(new WXMXSnapshot);
+    // Clear the list of files we need to embed
+    configuration->ClearFilesToSave();
+
+    snapshot->contentFile = wxFileName::CreateTempFileName(wxS("wxmx_content_"));
+    wxFFileOutputStream content(snapshot->contentFile);
+    wxFileOffset contentSize = 0;
+    auto write = [&content, &contentSize](const wxString &xml) {
+      const wxScopedCharBuffer utf8 = xml.utf8_str();
+      content.Write(utf8.data(), utf8.length());
+      contentSize += utf8.length();
+    };
+    snapshot->contentParts.push_back(0);
+
+    wxString xmlText;
+
+    xmlText << wxS("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    xmlText << wxS("\n<!--   Created using wxMaxima ") << wxS(WXMAXIMA_VERSION)
+            << wxS("   -->");
+    xmlText << wxS(
+                   "\n<!--https://wxMaxima-developers.github.io/wxmaxima/-->\n");
+
+    // write document
+    xmlText << wxS("\n<wxMaximaDocument version=\"");
+    xmlText << DOCUMENT_VERSION_MAJOR << wxS(".");
+    xmlText << DOCUMENT_VERSION_MINOR << wxS("\" zoom=\"");
+    xmlText << int(100.0 * configuration->GetZoomFactor()) << wxS("\"");
+
+    std::size_t ActiveCellNumber = 0;
+
+    // We want to save the information that the cursor is in the nth cell.
+    // Count the cells until then.
+    bool found = false;
+    if (cells)
+      for (const GroupCell &tmp : OnList(cells)) {
+        if (&tmp == cursorCell) {
+          found = true;
+          break;
+        }
+        ActiveCellNumber++;
+      }
+
+    // Paranoia: Test if we did find the cursor
+    if (cells && found)
+      // If we know where the cursor was we save this piece of information.
+      // If not we omit it.
+      xmlText << wxString::Format(wxS(" activecell=\"%li\""),
+                                  static_cast<long>(ActiveCellNumber));
+
+    // Save the variables list for the "variables" sidepane.
+    if (variables.size() > 1) {
+      std::size_t varcount = variables.size() - 1;
+      xmlText += wxString::Format(" variables_num=\"%li\"", static_cast<long>(varcount));
+      for (std::size_t i = 0; i < variables.size(); i++)
+        xmlText +=
+          wxString::Format(" variables_%li=\"%s\"", static_cast<long>(i),
+                           Cell::XMLescape(variables.at(i)).utf8_str());
+    }
+
+    xmlText << ">\n";
+    write(xmlText);
+
+    // Reset image counter
+    cellPointers->WXMXResetCounter();
+
+    // Written one cell at a time, so the XML of the whole document never has
+    // to be held in memory.
+    if (cells)
+      cells->ListToXML([&write, &snapshot, &contentSize](const wxString &xml) {
+        snapshot->contentParts.push_back(contentSize);
+        write(xml);
+      });
+    snapshot->contentParts.push_back(contentSize);
+    write(wxS("\n</wxMaximaDocument>"));
+    snapshot->contentParts.push_back(contentSize);
+    snapshot->contentOk = (!snapshot->contentFile.IsEmpty()) && content.IsOk() && content.Close();
+    if (!snapshot->contentOk)
+      wxLogMessage(_("Cannot write the XML representation of the document to %s"),
+                   snapshot->contentFile.utf8_str());
+    // ToXML() has told the configuration which files to embed.
+    snapshot->files = configuration->TakeFilesToSave();
+    wxLogMessage(_("Generated the XML representation of the document"));
+    return snapshot;
+  }
+
+  bool WriteWXMX(const WXMXSnapshot &snapshot, const wxString &file,
+                 wxString &error, std::string &invalidXml) {
   wxLogMessage(_("Starting to save the worksheet as .wxmx. Filename: %s"), file);
   // delete temp file if it already exists
   wxString backupfile = file + wxS("~");
   if (wxFileExists(backupfile)) {
-    if (!wxRemoveFile(backupfile))
+    if (!wxRemoveFile(backupfile)) {
+      error = _("Could not remove the old backup file during saving => aborting.");
       return false;
+    }
   }
+  std::vector<WrittenEntry> written;
   {
     wxFFileOutputStream out(backupfile);
-    if (!out.IsOk())
+    if (!out.IsOk()) {
+      error = _("Could not create the backup file during saving => aborting.");
       return false;
+    }
     {
       wxZipOutputStream zip(out);
-      if (!zip.IsOk())
+      if (!zip.IsOk()) {
+        error = _("Could not create the backup file during saving => aborting.");
         return false;
-      {
-        wxLogMessage(_("Created a .zip archive (the .wxmx file technically is a .zip file)"));
-        wxTextOutputStream output(zip);
-
-        /* The first zip entry is a file named "mimetype": This makes sure that
-           the mimetype is always stored at the same position in the file. This
-           is common practice. One example from an ePub file:
-
-           00000000  50 4b 03 04 14 00 00 08  00 00 cd bd 0a 43 6f 61
-           |PK...........Coa| 00000010  ab 2c 14 00 00 00 14 00  00 00 08 00 00
-           00 6d 69  |.,............mi| 00000020  6d 65 74 79 70 65 61 70  70 6c
-           69 63 61 74 69 6f  |metypeapplicatio| 00000030  6e 2f 65 70 75 62 2b
-           7a  69 70 50 4b 03 04 14 00  |n/epub+zipPK....|
-
-        */
-
-        // Make sure that the mime type is stored as plain text.
-        //
-        // We will keep that setting for the rest of the file for the following
-        // reasons:
-        //  - Compression of the .zip file won't improve compression of the
-        //  embedded .png images
-        //  - The text part of the file is too small to justify compression
-        //  - not compressing the text part of the file allows version control
-        //  systems to
-        //    determine which lines have changed and to track differences
-        //    between file versions efficiently (in a compressed text virtually
-        //    every byte might change when one byte at the start of the
-        //    uncompressed original is)
-        //  - and if anything crashes in a bad way chances are high that the
-        //  uncompressed
-        //    contents of the .wxmx file can be rescued using a text editor.
-        //  Who would - under these circumstances - care about a kilobyte?
-        zip.SetLevel(0);
-        zip.PutNextEntry(wxS("mimetype"));
-        output << wxS("text/x-wxmathml");
-        zip.CloseEntry();
-        wxLogMessage(_("Wrote the mimetype info"));
-        zip.PutNextEntry(wxS("format.txt"));
-        output << wxS(
-                      "\n\nThis file contains a wxMaxima session in the .wxmx format.\n"
-                      ".wxmx files are .xml-based files contained in a .zip container "
-                      "like .odt\n"
-                      "or .docx files. After changing their name to end in .zip the .xml "
-                      "and\n"
-                      "eventual bitmap files inside them can be extracted using any .zip "
-                      "file\n"
-                      "viewer.\n"
-                      "The reason why part of a .wxmx file still might still seem to "
-                      "make sense in a\n"
-                      "ordinary text viewer is that the text portion of .wxmx by "
-                      "default\n"
-                      "isn't compressed: The text is typically small and compressing it "
-                      "would\n"
-                      "mean that changing a single character would (with a high "
-                      "probability) change\n"
-                      "big parts of the  whole contents of the compressed .zip archive.\n"
-                      "Even if version control tools like git and svn that remember all "
-                      "changes\n"
-                      "that were ever made to a file can handle binary files compression "
-                      "would\n"
-                      "make the changed part of the file bigger and therefore seriously "
-                      "reduce\n"
-                      "the efficiency of version control\n\n"
-                      "wxMaxima can be downloaded from "
-                      "https://github.com/wxMaxima-developers/wxmaxima.\n"
-                      "It also is part of the windows installer for maxima\n"
-                      "(https://wxmaxima-developers.github.io/wxmaxima/).\n\n"
-                      "If a .wxmx file is broken but the content.xml portion of the file "
-                      "can still be\n"
-                      "viewed using a text editor just save the xml's text as "
-                      "\"content.xml\"\n"
-                      "and try to open it using a recent version of wxMaxima.\n"
-                      "If it is valid XML (the XML header is intact, all opened tags are "
-                      "closed again,\n"
-                      "the text is saved with the text encoding \"UTF8 without BOM\" and "
-                      "the few\n"
-                      "special characters XML requires this for are properly escaped)\n"
-                      "chances are high that wxMaxima will be able to recover all code "
-                      "and text\n"
-                      "from the XML file.\n\n");
+      }
+      wxLogMessage(_("Created a .zip archive (the .wxmx file technically is a .zip file)"));
+      auto writeEntry = [&zip, &written](const wxString &name, const void *data,
+                                         std::size_t length) {
+        zip.PutNextEntry(name);
+        zip.Write(data, length);
         zip.CloseEntry();
+        written.push_back({name, static_cast<wxFileOffset>(length),
+                           Crc32::Compute(data, length)});
+      };
 
-        // next zip entry is "content.xml", xml of cells
-
-        zip.PutNextEntry(wxS("content.xml"));
-        wxString xmlText;
+      /* The first zip entry is a file named "mimetype": This makes sure that
+         the mimetype is always stored at the same position in the file. This
+         is common practice. One example from an ePub file:
 
-        xmlText << wxS("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
-        xmlText << wxS("\n<!--   Created using wxMaxima ") << wxS(WXMAXIMA_VERSION)
-                << wxS("   -->");
-        xmlText << wxS(
-                       "\n<!--https://wxMaxima-developers.github.io/wxmaxima/-->\n");
+         00000000  50 4b 03 04 14 00 00 08  00 00 cd bd 0a 43 6f 61
+         |PK...........Coa| 00000010  ab 2c 14 00 00 00 14 00  00 00 08 00 00
+         00 6d 69  |.,............mi| 00000020  6d 65 74 79 70 65 61 70  70 6c
+         69 63 61 74 69 6f  |metypeapplicatio| 00000030  6e 2f 65 70 75 62 2b
+         7a  69 70 50 4b 03 04 14 00  |n/epub+zipPK....|
 
-        // write document
-        xmlText << wxS("\n<wxMaximaDocument version=\"");
-        xmlText << DOCUMENT_VERSION_MAJOR << wxS(".");
-        xmlText << DOCUMENT_VERSION_MINOR << wxS("\" zoom=\"");
-        xmlText << int(100.0 * configuration->GetZoomFactor()) << wxS("\"");
+      */
 
-        std::size_t ActiveCellNumber = 0;
+      // Make sure that the mime type is stored as plain text.
+      //
+      // We will keep that setting for the rest of the file for the following
+      // reasons:
+      //  - Compression of the .zip file won't improve compression of the
+      //  embedded .png images
+      //  - The text part of the file is too small to justify compression
+      //  - not compressing the text part of the file allows version control
+      //  systems to
+      //    determine which lines have changed and to track differences
+      //    between file versions efficiently (in a compressed text virtually
+      //    every byte might change when one byte at the start of the
+      //    uncompressed original is)
+      //  - and if anything crashes in a bad way chances are high that the
+      //  uncompressed
+      //    contents of the .wxmx file can be rescued using a text editor.
+      //  Who would - under these circumstances - care about a kilobyte?
+      zip.SetLevel(0);
+      static const char mimetype[] = "text/x-wxmathml";
+      writeEntry(wxS("mimetype"), mimetype, sizeof(mimetype) - 1);
+      wxLogMessage(_("Wrote the mimetype info"));
+      static const char formatInfo[] =
+        "\n\nThis file contains a wxMaxima session in the .wxmx format.\n"
+        ".wxmx files are .xml-based files contained in a .zip container "
+        "like .odt\n"
+        "or .docx files. After changing their name to end in .zip the .xml "
+        "and\n"
+        "eventual bitmap files inside them can be extracted using any .zip "
+        "file\n"
+        "viewer.\n"
+        "The reason why part of a .wxmx file still might still seem to "
+        "make sense in a\n"
+        "ordinary text viewer is that the text portion of .wxmx by "
+        "default\n"
+        "isn't compressed: The text is typically small and compressing it "
+        "would\n"
+        "mean that changing a single character would (with a high "
+        "probability) change\n"
+        "big parts of the  whole contents of the compressed .zip archive.\n"
+        "Even if version control tools like git and svn that remember all "
+        "changes\n"
+        "that were ever made to a file can handle binary files compression "
+        "would\n"
+        "make the changed part of the file bigger and therefore seriously "
+        "reduce\n"
+        "the efficiency of version control\n\n"
+        "wxMaxima can be downloaded from "
+        "https://github.com/wxMaxima-developers/wxmaxima.\n"
+        "It also is part of the windows installer for maxima\n"
+        "(https://wxmaxima-developers.github.io/wxmaxima/).\n\n"
+        "If a .wxmx file is broken but the content.xml portion of the file "
+        "can still be\n"
+        "viewed using a text editor just save the xml's text as "
+        "\"content.xml\"\n"
+        "and try to open it using a recent version of wxMaxima.\n"
+        "If it is valid XML (the XML header is intact, all opened tags are "
+        "closed again,\n"
+        "the text is saved with the text encoding \"UTF8 without BOM\" and "
+        "the few\n"
+        "special characters XML requires this for are properly escaped)\n"
+        "chances are high that wxMaxima will be able to recover all code "
+        "and text\n"
+        "from the XML file.\n\n";
+      writeEntry(wxS("format.txt"), formatInfo, sizeof(formatInfo) - 1);
 
-        // We want to save the information that the cursor is in the nth cell.
-        // Count the cells until then.
-        bool found = false;
-        if (cells)
-          for (const GroupCell &tmp : OnList(cells)) {
-            if (&tmp == cursorCell) {
-              found = true;
-              break;
-            }
-            ActiveCellNumber++;
-          }
+      // next zip entry is "content.xml", xml of cells
+      wxFFileInputStream content(snapshot.contentFile);
+      if ((!snapshot.contentOk) || (!content.IsOk())) {
+        error = _("Could not write the XML representation of the document => aborting.");
+        return false;
+      }
+      zip.PutNextEntry(wxS("content.xml"));
+      // Each chunk is checked before it is written, so we never save a
+      // document the XML parser cannot read again.
+      XmlStreamChecker checker;
+      uint32_t contentCrc = 0;
+      wxFileOffset contentSize = 0;
+      std::vector<char> buf(65536);
+      while (content.CanRead()) {
+        content.Read(buf.data(), buf.size());
+        std::size_t length = content.LastRead();
+        if (length == 0)
+          break;
+        if (!checker.Feed(buf.data(), length))
+          break;
+        zip.Write(buf.data(), length);
+        contentCrc = Crc32::Update(contentCrc, buf.data(), length);
+        contentSize += length;
+      }
+      if (content.GetLastError() == wxSTREAM_READ_ERROR) {
+        error = _("Could not write the XML representation of the document => aborting.");
+        return false;
+      }
+      if (checker.IsOk())
+        checker.Finish();
 
-        // Paranoia: Test if we did find the cursor
-        if (cells && found)
-          // If we know where the cursor was we save this piece of information.
-          // If not we omit it.
-          xmlText << wxString::Format(wxS(" activecell=\"%li\""),
-                                      static_cast<long>(ActiveCellNumber));
-
-        // Save the variables list for the "variables" sidepane.
-        if (variables.size() > 1) {
-          std::size_t varcount = variables.size() - 1;
-          xmlText += wxString::Format(" variables_num=\"%li\"", static_cast<long>(varcount));
-          for (std::size_t i = 0; i < variables.size(); i++)
-            xmlText +=
-              wxString::Format(" variables_%li=\"%s\"", static_cast<long>(i),
-                               Cell::XMLescape(variables.at(i)).utf8_str());
+      // If the document cannot be read again we abort the save process as
+      // it would only destroy data.
+      if (!checker.IsOk()) {
+        wxLogMessage(_("Invalid XML at byte %li: %s"),
+                     static_cast<long>(checker.GetErrorOffset()),
+                     wxString::FromUTF8(checker.GetError().c_str()));
+        // Hand out the whole part the error was found in: A part always
+        // consists of complete UTF-8 characters.
+        const std::vector<wxFileOffset> &parts = snapshot.contentParts;
+        auto end = std::upper_bound(parts.begin(), parts.end(),
+                                    static_cast<wxFileOffset>(checker.GetErrorOffset()));
+        if (end == parts.end() && !parts.empty())
+          end--;
+        if (end != parts.begin() && end != parts.end()) {
+          wxFFile contentFile(snapshot.contentFile, wxS("rb"));
+          invalidXml.resize(*end - *(end - 1));
+          if (!contentFile.IsOpened() || !contentFile.Seek(*(end - 1)) ||
+              contentFile.Read(&invalidXml[0], invalidXml.size()) != invalidXml.size())
+            invalidXml.clear();
         }
+        error = _("Produced invalid XML. The erroneous XML data has "
+                  "therefore not been saved.");
+        return false;
+      }
+      wxLogMessage(_("Validated that the XML representation of the document actually is valid XML"));
+      zip.CloseEntry();
+      written.push_back({wxS("content.xml"), contentSize, contentCrc});
+      wxLogMessage(_("Wrote the XML representation of the document to the zip archive"));
 
-        xmlText << ">\n";
-
-        // Reset image counter
-        cellPointers->WXMXResetCounter();
-
-        if (cells)
-          xmlText += cells->ListToXML();
-
-        // Delete all but one control character from the string: there should be
-        // no way for them to enter this string, anyway. But sometimes they
-        // still do...
-        for (wxString::const_iterator it = xmlText.begin(); it != xmlText.end();
-             ++it) {
-          wxChar c = *it;
-          if ((c < wxS('\t')) || ((c > wxS('\n')) && (c < wxS(' '))) ||
-              (c == wxChar(static_cast<char>(0x7F)))) {
-            // *it = wxS(' ');
+      // Files whose contents haven't changed since the file we are about to
+      // replace was saved are copied from there as they are: wxWidgets then
+      // neither needs to compress nor to checksum them again. The names of
+      // the files change between saves, so we identify them by their size
+      // and their checksum. Only the central directory is read here.
+      std::unique_ptr<wxFFileInputStream> previousFile;
+      std::unique_ptr<wxZipInputStream> previous;
+      std::vector<std::unique_ptr<wxZipEntry>> previousEntries;
+      std::unordered_multimap<wxFileOffset, wxZipEntry *> previousEntriesBySize;
+      if (wxFileExists(file)) {
+        previousFile.reset(new wxFFileInputStream(file));
+        if (previousFile->IsOk()) {
+          previous.reset(new wxZipInputStream(*previousFile));
+          wxZipEntry *entry;
+          while ((entry = previous->GetNextEntry()) != NULL) {
+            previousEntries.emplace_back(entry);
+            if (!entry->IsDir())
+              previousEntriesBySize.emplace(entry->GetSize(), entry);
           }
         }
+      }
 
-        xmlText += wxS("\n</wxMaximaDocument>");
-        wxLogMessage(_("Generated the XML representation of the document"));
-
+      // Move all files we have stored in memory during saving to zip file
+      zip.SetLevel(0);
+      long copied = 0;
+      for (const auto &fil: snapshot.files)
         {
-          // Let wxWidgets test if the document can be read again by the XML
-          // parser before the user finds out the hard way.
-          {
-            wxXmlDocument doc;
-            {
-              wxMemoryOutputStream ostream;
-              wxTextOutputStream txtstrm(ostream);
-              txtstrm.WriteString(xmlText);
-              wxMemoryInputStream istream(ostream);
-              wxLogNull suppressErrorMessages;
-              doc.Load(istream);
+          const wxMemoryBuffer &data = fil.Data();
+          auto candidates = previousEntriesBySize.equal_range(
+            static_cast<wxFileOffset>(data.GetDataLen()));
+          // The checksum is needed for checking the archive, anyway.
+          uint32_t crc = Crc32::Compute(data.GetData(), data.GetDataLen());
+          wxZipEntry *unchanged = NULL;
+          for (auto i = candidates.first; i != candidates.second; ++i)
+            if (i->second->GetCrc() == crc) {
+              unchanged = i->second;
+              break;
             }
-
-            // If we fail to load the document we abort the safe process as it
-            // will only destroy data. But we can still put the erroneous data
-            // into the clipboard for debugging purposes.
-            if (!doc.IsOk()) {
-              if (wxTheClipboard->Open()) {
-                wxDataObjectComposite *data = new wxDataObjectComposite;
-                data->Add(new wxTextDataObject(xmlText));
-                wxTheClipboard->SetData(data);
-                LoggingMessageDialog dialog(NULL, _("Produced invalid XML. The erroneous XML data has "
-                                                    "therefore not been saved but has been put on the "
-                                                    "clipboard in order to allow to debug it."),
-                                            _("Error"), wxCENTER | wxOK);
-                dialog.ShowModal();
-                wxTheClipboard->Close();
-              }
-
+          if (unchanged) {
+            wxZipEntry *copy = new wxZipEntry(*unchanged);
+            copy->SetName(fil.FileName());
+            if (!zip.CopyEntry(copy, *previous)) {
+              error = _("Could not write the file's contents during saving => aborting.");
               return false;
             }
+            copied++;
+          } else {
+            zip.PutNextEntry(fil.FileName());
+            zip.Write(data.GetData(), data.GetDataLen());
+            zip.CloseEntry();
           }
-          wxLogMessage(_("Validated that the XML representation of the document actually is valid XML"));
-
-          // wxWidgets could pretty-print the XML document now. But as no-one
-          // will look at it, anyway, there might be no good reason to do so.
-          output << xmlText;
-          zip.CloseEntry();
-          wxLogMessage(_("Wrote the XML representation of the document to the zip archive"));
-
-          // Move all files we have stored in memory during saving to zip file
-          zip.SetLevel(0);
-          for (const auto &fil: configuration->GetFilesToSave())
-            {
-              zip.PutNextEntry(fil.FileName());
-              zip.Write(fil.Data().GetData(), fil.Data().GetDataLen());
-              zip.CloseEntry();
-            }
-          wxLogMessage(_("Wrote all image and gnuplot files to the zip archive"));
+          written.push_back({fil.FileName(), static_cast<wxFileOffset>(data.GetDataLen()), crc});
         }
-      }
-      if (!zip.Close())
-        {
-          LoggingMessageDialog dialog(NULL, _("Could not write the file's contents during saving => aborting."),
-                                      _("Error"), wxCENTER | wxOK);
-          dialog.ShowModal();
-          return false;
-        }
-    }
-    if (!out.Close())
-      {
-        LoggingMessageDialog dialog(NULL, _("Could not create the backup file during saving => aborting."),
-                                    _("Error"), wxCENTER | wxOK);
-        dialog.ShowModal();
+      wxLogMessage(_("Wrote all image and gnuplot files to the zip archive, "
+                     "%li of them unchanged from the previous version of the file"),
+                   copied);
+      if (!zip.Close()) {
+        error = _("Could not write the file's contents during saving => aborting.");
         return false;
       }
+    }
+    if (!out.Close()) {
+      error = _("Could not create the backup file during saving => aborting.");
+      return false;
+    }
   }
   wxLogMessage(_("Closed the zip archive"));
   // If all data is saved now we can overwrite the actual save file.
@@ -305,36 +427,19 @@ namespace Format {
 
   // The following line is paranoia as closing (and thus writing) the file has
   // succeeded.
-  if (!wxFileExists(backupfile))
-    {
-      LoggingMessageDialog dialog(NULL, _("Saving succeeded, but the resulting files has disappeared ?!?."),
-                                  _("Error"), wxCENTER | wxOK);
-      dialog.ShowModal();
-      return false;
-    }
-
-  // Now we try to open the file in order to see if saving hasn't failed
-  // without returning an error - which can apparently happen on MSW.
-  {
-    wxFileInputStream wxmxFile(file + "~");
-    wxZipInputStream wxmxContents(wxmxFile);
-    wxZipEntry *contentsEntry = NULL;
-    while(!wxmxContents.Eof())
-      {
-        contentsEntry = wxmxContents.GetNextEntry();
-        if((!contentsEntry) || (contentsEntry->GetName() == wxS("content.xml")))
-          break;
-      }
-    // Did we succeed in opening the file?
-    if (!contentsEntry) {
-      LoggingMessageDialog dialog(NULL, _(wxS("Saving succeeded, but the file could not be read "
-                                              "again \u21D2 Not replacing the old saved file.")),
-                                  _("Error"), wxCENTER | wxOK);
-      dialog.ShowModal();
-      return false;
-    }
+  if (!wxFileExists(backupfile)) {
+    error = _("Saving succeeded, but the resulting files has disappeared ?!?.");
+    return false;
   }
-  wxLogMessage(_("Verified that we are able to read the whole .zip archive we produced."));
+
+  // Now we check if saving hasn't failed without returning an error - which
+  // can apparently happen on MSW. Reading everything again would double the
+  // time saving takes, so we only compare the sizes and checksums the
+  // archive's directory lists with the ones of the data we have written.
+  // VerifyWXMX() can check the data itself later.
+  if (!CheckCentralDirectory(backupfile, written, error))
+    return false;
+  wxLogMessage(_("Verified that the .zip archive we produced lists all files we have written."));
 
   {
     bool done = wxRenameFile(backupfile, file, true);
@@ -356,18 +461,99 @@ namespace Format {
     }
     if (!done) {
       wxSleep(1);
-      if (!wxRenameFile(backupfile, file, true))
-        {
-          LoggingMessageDialog dialog(NULL, _(wxS("Creating a backup file succeeded, but could not move the .wxmx file to the intended location.")),
-                                      _("Error"), wxCENTER | wxOK);
-          dialog.ShowModal();
-          return false;
-        }
+      if (!wxRenameFile(backupfile, file, true)) {
+        error = _(wxS("Creating a backup file succeeded, but could not move the .wxmx file to the intended location."));
+        return false;
+      }
     }
+    // Images that are loaded later mustn't use the old file's index
+    WxmxArchive::Forget(file);
     wxLogMessage(_("wxmx file saved"));
   }
   return true;
 }
 
+  // Unpacks every file of the archive and compares its CRC32 with the one the
+  // archive lists for it.
+  bool VerifyWXMX(const wxString &file, wxString &error,
+                  const ThreadPool::CancellationToken &token) {
+    long checked = 0;
+    {
+      // wxZipInputStream complains about wrong checksums itself. We want to
+      // tell the user what that means instead.
+      wxLogNull suppressor;
+      wxFFileInputStream input(file);
+      if (!input.IsOk()) {
+        error = wxString::Format(_("Cannot open %s."), file);
+        return false;
+      }
+      wxZipInputStream zip(input);
+      std::vector<char> buf(65536);
+      wxZipEntry *next;
+      while ((next = zip.GetNextEntry()) != NULL) {
+        std::unique_ptr<wxZipEntry> entry(next);
+        uint32_t crc = 0;
+        while (zip.CanRead()) {
+          if (token.IsCancelled()) {
+            error = wxString::Format(_("The check of %s has been cancelled."), file);
+            return false;
+          }
+          zip.Read(buf.data(), buf.size());
+          crc = Crc32::Update(crc, buf.data(), zip.LastRead());
+        }
+        if (crc != entry->GetCrc()) {
+          error = wxString::Format(_("%s in %s is damaged."), entry->GetName(), file);
+          return false;
+        }
+        checked++;
+      }
+      if (checked == 0) {
+        error = wxString::Format(_("%s isn't a .zip archive we can read."), file);
+        return false;
+      }
+    }
+    wxLogMessage(_("Verified the checksums of the %li files in %s"), checked, file);
+    return true;
+  }
+
+  /*
+  Save the data as wxmx file
+
+  First saves the data to a backup file ending in .wxmx~ so if anything goes
+  horribly wrong in this step all that is lost is the data that was input
+  since the last save. Then the original .wxmx file is replaced in a
+  (hopefully) atomic operation.
+*/
+  bool ExportToWXMX(GroupCell *cells, const wxString &file,
+                    Configuration *configuration, CellPointers *cellPointers,
+                    const std::vector<wxString> &variables, const GroupCell * const cursorCell) {
+  // Show a busy cursor as long as we export a file.
+  wxBusyCursor crs;
+  std::unique_ptr<WXMXSnapshot> snapshot =
+    CreateWXMXSnapshot(cells, configuration, cellPointers, variables, cursorCell);
+  wxString error;
+  std::string invalidXml;
+  if (WriteWXMX(*snapshot, file, error, invalidXml))
+    return true;
+
+  // We can still put the erroneous data into the clipboard for debugging
+  // purposes.
+  if ((!invalidXml.empty()) && wxTheClipboard->Open()) {
+    wxDataObjectComposite *data = new wxDataObjectComposite;
+    data->Add(new wxTextDataObject(wxString::FromUTF8(invalidXml.data(), invalidXml.size())));
+    wxTheClipboard->SetData(data);
+    LoggingMessageDialog dialog(NULL, _("Produced invalid XML. The erroneous XML data has "
+                                        "therefore not been saved but has been put on the "
+                                        "clipboard in order to allow to debug it."),
+                                _("Error"), wxCENTER | wxOK);
+    dialog.ShowModal();
+    wxTheClipboard->Close();
+    return false;
+  }
+  LoggingMessageDialog dialog(NULL, error, _("Error"), wxCENTER | wxOK);
+  dialog.ShowModal();
+  return false;
+}
+
 
 } // namespace Format
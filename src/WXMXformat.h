@@ -26,9 +26,12 @@
 #ifndef WXMXFORMAT_H
 #define WXMXFORMAT_H
 
+#include <list>
 #include <memory>
+#include <string>
 #include "cells/GroupCell.h"
 #include "Configuration.h"
+#include "ThreadPool.h"
 #include <vector>
 
 #define DOCUMENT_VERSION_MAJOR 1
@@ -51,6 +54,74 @@
 
 namespace Format
 {
+  /*! Everything a .wxmx file contains
+
+    Created in the GUI thread by CreateWXMXSnapshot(). Nothing in it is changed
+    afterwards, so WriteWXMX() can write it in a background thread while the
+    user continues editing. The embedded files share their buffers with the
+    images of the worksheet and wxMemoryBuffer's reference counting isn't
+    thread-safe: A snapshot must be destroyed in the GUI thread.
+  */
+  struct WXMXSnapshot
+  {
+    WXMXSnapshot() = default;
+    WXMXSnapshot(const WXMXSnapshot &) = delete;
+    WXMXSnapshot &operator=(const WXMXSnapshot &) = delete;
+    //! Removes contentFile
+    ~WXMXSnapshot();
+    /*! The temp file content.xml has been written to, in UTF-8
+
+      Written cell by cell, so the XML of the whole document never has to be
+      held in memory.
+    */
+    wxString contentFile;
+    //! Could content.xml be written to contentFile?
+    bool contentOk = false;
+    /*! Where the parts of contentFile start and end, in bytes
+
+      The parts are the header, the XML of each cell (see Cell::ListToXML())
+      and the document's end tag: The first entry is 0 and the last one the
+      size of contentFile.
+      Allows to show the user the cell an XML error was found in.
+    */
+    std::vector<wxFileOffset> contentParts;
+    //! The images and gnuplot files to embed
+    std::list<Configuration::FileToSave> files;
+  };
+
+  //! Records what a .wxmx file of the worksheet would contain
+  std::unique_ptr<WXMXSnapshot> CreateWXMXSnapshot(GroupCell *cells,
+                                                   Configuration *configuration,
+                                                   CellPointers *cellPointers,
+                                                   const std::vector<wxString> &variables,
+                                                   const GroupCell * const cursorCell = NULL);
+
+  /*! Writes a snapshot to a .wxmx file
+
+    Writes a backup file first and replaces the file by it only if it can be
+    read again. Doesn't show any dialogs and may be called from any thread.
+
+    \param error Receives the description of the problem, if saving fails
+    \param invalidXml Receives the part of content.xml (see
+    WXMXSnapshot::contentParts) the XML error was found in, if any
+  */
+  bool WriteWXMX(const WXMXSnapshot &snapshot, const wxString &file,
+                 wxString &error, std::string &invalidXml);
+
+  /*! Reads all files a .wxmx file contains and compares them with their checksums
+
+    WriteWXMX() only checks the archive's directory. This also finds damaged
+    data, but needs to read the whole file: Meant to be run in the background
+    after saving. Doesn't show any dialogs.
+
+    \param error Receives the description of the problem, if there is one
+    \param token Ends the check early, if cancelled. The file then counts as
+    not verified: false is returned.
+  */
+  bool VerifyWXMX(const wxString &file, wxString &error,
+                  const ThreadPool::CancellationToken &token = ThreadPool::CancellationToken());
+
+  //! Saves the worksheet as .wxmx file in the GUI thread
   bool ExportToWXMX(GroupCell *cells, const wxString &file,
                     Configuration *configuration, CellPointers *cellPointers,
                     const std::vector<wxString> &variables, const GroupCell * const cursorCell = NULL);
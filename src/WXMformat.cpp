@@ -29,12 +29,12 @@
 #include <algorithm>
 #include <memory>
 #include <cstdlib>
+#include <functional>
 #include <vector>
 #include "WXMformat.h"
 #include "cells/CellList.h"
 #include "cells/ImgCell.h"
 #include <wx/debug.h>
-#include <wx/textbuf.h>
 #include <wx/tokenzr.h>
 
 namespace Format {
@@ -225,50 +225,83 @@ namespace Format {
     return retval;
   }
 
-  std::unique_ptr<GroupCell> TreeFromWXM(const std::vector<wxString> &wxmLines,
-                                         Configuration *config) {
-    auto wxmLine = wxmLines.begin();
-    auto const end = wxmLines.end();
+  //! Does this header start a new cell?
+  static bool StartsCell(WXMHeaderId headerId) {
+    switch (headerId) {
+    case WXM_IMAGE:
+    case WXM_ANSWER:
+    case WXM_QUESTION:
+    case WXM_AUTOANSWER:
+    case WXM_FOLD:
+    case WXM_FOLD_END:
+    case WXM_INVALID:
+    case WXM_MAX:
+      return false;
+    default:
+      return true;
+    }
+  }
 
+  /*! Converts the lines of a .wxm file into cells
+
+    \param nextLine Gets the next line. Returns false at the end of the file.
+    \param full Is called before a new cell starts. If it returns true we stop
+    reading: The answers, images and folded cells that belong to the cells
+    we have read have been read, as well, at this point.
+  */
+  static std::unique_ptr<GroupCell> ReadWXMCells(const std::function<bool(wxString &)> &nextLine,
+                                                 const std::function<bool()> &full,
+                                                 WXMParserState &state,
+                                                 Configuration *config) {
     //! Consumes and concatenates lines until a closing tag is reached,
     //! consumes the tag and returns the line.
-    const auto getLinesUntil = [&wxmLine, end](const wxString &tag) -> wxString {
+    const auto getLinesUntil = [&nextLine](const wxString &tag) -> wxString {
       wxString line;
-      while (wxmLine != end) {
-        auto const thisLn = wxmLine++;
-        if (*thisLn == tag)
+      wxString thisLn;
+      while (nextLine(thisLn)) {
+        if (thisLn == tag)
           break;
         if (!line.empty())
           line << '\n';
-        line << *thisLn;
+        line << thisLn;
       }
       return line;
     };
 
-    bool hide = false;
     //! Hides the cell if a hide flag was set
-    const auto hideCell = [&hide](GroupCell *cell) {
-      if (hide && cell) {
+    const auto hideCell = [&state](GroupCell *cell) {
+      if (state.hide && cell) {
         cell->Hide(true);
-        hide = false;
+        state.hide = false;
       }
     };
 
     // Show a busy cursor while we read
     wxBusyCursor crs;
     CellListBuilder<GroupCell> tree;
-    wxString question;
+    wxString header;
+
+    while (true) {
+      if (!state.nextHeader.IsEmpty()) {
+        header = state.nextHeader;
+        state.nextHeader.Clear();
+      } else if (!nextLine(header))
+        break;
+
+      WXMHeaderId headerId = Headers.LookupStart(header);
+      if (tree && StartsCell(headerId) && full()) {
+        state.nextHeader = header;
+        break;
+      }
 
-    while (wxmLine != end) {
       GroupCell *const last = tree.GetTail();
       std::unique_ptr<GroupCell> cell;
-      WXMHeaderId headerId = Headers.LookupStart(*wxmLine++);
       wxString line;
 
       switch (headerId) {
         // Read hide tag
       case WXM_HIDE:
-        hide = true;
+        state.hide = true;
         break;
 
         // Read title, section, subsection, subsubsection, heading5, heading6,
@@ -294,7 +327,7 @@ namespace Format {
       case WXM_HIDDEN_COMMENT:
       case WXM_HIDDEN_INPUT:
       case WXM_HIDDEN_CAPTION:
-        hide = true;
+        state.hide = true;
         line = getLinesUntil(Headers.GetEnd(headerId));
         cell = std::make_unique<GroupCell>(config, GroupType(headerId - 128), line);
         hideCell(cell.get());
@@ -309,27 +342,27 @@ namespace Format {
         break;
 
         // Read an image bitmap
-      case WXM_IMAGE:
-        if (wxmLine != end) { // Read the image type
-          wxString const imgtype = *wxmLine++;
+      case WXM_IMAGE: {
+        wxString imgtype;
+        if (nextLine(imgtype)) { // Read the image type
           auto ln = getLinesUntil(Headers.GetEnd(headerId));
           if (last && last->GetGroupType() == GC_TYPE_IMAGE)
             last->SetOutput(std::make_unique<ImgCell>(
                                                       last, config, wxBase64Decode(ln), imgtype));
         }
-        break;
+      } break;
 
         // Read an answer
       case WXM_ANSWER:
         line = getLinesUntil(Headers.GetEnd(headerId));
-        if (last && !question.empty())
-          last->SetAnswer(question, line);
+        if (last && !state.question.empty())
+          last->SetAnswer(state.question, line);
         break;
 
         // Read a question
       case WXM_QUESTION:
         line = getLinesUntil(Headers.GetEnd(headerId));
-        question = line;
+        state.question = line;
         break;
 
         // Read autoanswer tag
@@ -347,10 +380,12 @@ namespace Format {
       case WXM_FOLD: {
         std::vector<wxString> hiddenTree;
         auto const &endHeader = Headers.GetEnd(headerId);
-        while (wxmLine != end && *wxmLine != endHeader)
-          hiddenTree.push_back(*wxmLine++);
+        wxString foldLine;
+        while (nextLine(foldLine) && foldLine != endHeader)
+          hiddenTree.push_back(foldLine);
 
-        last->HideTree(TreeFromWXM(hiddenTree, config));
+        if (last)
+          last->HideTree(TreeFromWXM(hiddenTree, config));
       } break;
 
       case WXM_INVALID:
@@ -373,23 +408,49 @@ namespace Format {
 #endif
   }
 
-  std::unique_ptr<GroupCell> ParseWXMFile(wxTextBuffer &text,
-                                          Configuration *config) {
-    std::vector<wxString> wxmLines;
-    for (auto line = text.GetFirstLine();; line = text.GetNextLine()) {
-      wxmLines.push_back(line);
-      if (text.Eof())
-        break;
-    }
+  std::unique_ptr<GroupCell> TreeFromWXM(const std::vector<wxString> &wxmLines,
+                                         Configuration *config) {
+    auto wxmLine = wxmLines.begin();
+    auto const end = wxmLines.end();
+    WXMParserState state;
+    return ReadWXMCells([&wxmLine, end](wxString &line) {
+      if (wxmLine == end)
+        return false;
+      line = *wxmLine++;
+      return true;
+    }, [] { return false; }, state, config);
+  }
 
-    return Format::TreeFromWXM(wxmLines, config);
+  //! Interprets a block of wxMaxima comments from a .mac file
+  static void AppendWXMLines(CellListBuilder<GroupCell> &tree, wxString &wxmLines,
+                             Configuration *config) {
+    // Convert the comment block to an array of lines
+    wxStringTokenizer tokenizer(wxmLines, "\n");
+    std::vector<wxString> commentLines;
+    while (tokenizer.HasMoreTokens())
+      commentLines.push_back(tokenizer.GetNextToken());
+
+    // Interpret the comment block
+    if (!tree.Append(TreeFromWXM(commentLines, config)))
+      tree.Append(std::make_unique<GroupCell>(config, GC_TYPE_TEXT, wxmLines));
+    wxmLines.Clear();
   }
 
-  std::unique_ptr<GroupCell> ParseMACContents(const wxString &macContents,
-                                              Configuration *config) {
-    wxString wxmLines;
-    CellListBuilder<GroupCell> tree;
-    auto const end = macContents.end();
+  /*! Converts the contents of a .mac file, or a part of them, into cells
+
+    \param final
+    - true: text is the rest of the file.
+    - false: More text will follow. Parsing then stops after the last cell
+    that is complete.
+    \return How many chars of text have been parsed. The rest has to be
+    parsed again once more text is known.
+  */
+  static std::size_t ParseMACText(const wxString &text, bool final,
+                                  MACParserState &state,
+                                  CellListBuilder<GroupCell> &tree,
+                                  Configuration *config) {
+    wxString &wxmLines = state.wxmLines;
+    auto const end = text.end();
 
     struct State {
       wxChar lastChar;
@@ -406,8 +467,9 @@ namespace Format {
     };
 
     wxString line;
-    wxString wxmBlock;
-    for (State s{' ', macContents.begin()}; s.ch != macContents.end();) {
+    // The point up to which all cells are complete
+    State parsed{state.lastChar, text.begin()};
+    for (State s{state.lastChar, text.begin()}; s.ch != end;) {
       wxChar c = *s.ch;
       // Handle comments
       if (s.lastChar == '/' && c == '*') {
@@ -421,7 +483,7 @@ namespace Format {
         }
 
         // Skip to the end of the comment
-        while (s.ch != macContents.end()) {
+        while (s.ch != end) {
           wxChar ch = *s.ch++;
           bool finished = (s.lastChar == wxS('*') && ch == wxS('/'));
           line += s.lastChar = ch;
@@ -434,9 +496,11 @@ namespace Format {
           line.Trim(false);
 
           // Is this a comment from wxMaxima?
-          if (line.StartsWith(wxS("/* [wxMaxima: "))) {
+          bool wxMaximaComment = line.StartsWith(wxS("/* [wxMaxima: "));
+          if (wxMaximaComment) {
             // Add the rest of this comment block to the "line".
-            while (!line.EndsWith(" end   ] */") &&
+            while (s.ch != end &&
+                   !line.EndsWith(" end   ] */") &&
                    !line.EndsWith(" end   ] */\n")) {
               s = readUntil(line, s, '\n');
             }
@@ -444,33 +508,29 @@ namespace Format {
             // If the last block was a caption block we need to read in the image
             // the caption was for, as well.
             if (line.StartsWith(Headers.GetStart(WXM_CAPTION))) {
-              if (s.ch != macContents.end())
+              if (s.ch != end)
                 line += s.lastChar = *s.ch++;
 
               s = readUntil(line, s, '\n');
 
-              while (!line.EndsWith(" end   ] */") &&
+              while (s.ch != end &&
+                     !line.EndsWith(" end   ] */") &&
                      !line.EndsWith(" end   ] */\n")) {
                 s = readUntil(line, s, '\n');
               }
             }
+          }
+
+          // The comment might continue in the text we haven't got, yet.
+          if (!final && s.ch == end)
+            break;
 
+          if (wxMaximaComment) {
             // Add this array of lines to the block of wxm code we will interpret.
             wxmLines += line;
           } else {
-            if (!wxmLines.IsEmpty()) {
-              // Convert the comment block to an array of lines
-              wxStringTokenizer tokenizer(wxmLines, "\n");
-              std::vector<wxString> commentLines;
-              while (tokenizer.HasMoreTokens())
-                commentLines.push_back(tokenizer.GetNextToken());
-
-              // Interpret the comment block
-              if (!tree.Append(TreeFromWXM(commentLines, config)))
-                tree.Append(
-                            std::make_unique<GroupCell>(config, GC_TYPE_TEXT, wxmLines));
-              wxmLines.Clear();
-            }
+            if (!wxmLines.IsEmpty())
+              AppendWXMLines(tree, wxmLines, config);
             if ((line.EndsWith(" */")) || (line.EndsWith("\n*/")))
               line.Truncate(line.length() - 3);
             else
@@ -512,25 +572,31 @@ namespace Format {
         s.lastChar = c;
         ++s.ch;
       }
+      if (line.empty())
+        parsed = s;
     }
-    if (!wxmLines.IsEmpty()) {
-      // Convert the comment block to an array of lines
-      wxStringTokenizer tokenizer(wxmLines, "\n");
-      std::vector<wxString> commentLines;
-      while (tokenizer.HasMoreTokens())
-        commentLines.push_back(tokenizer.GetNextToken());
-
-      // Interpret the comment block
-      if (!tree.Append(TreeFromWXM(commentLines, config)))
-        tree.Append(std::make_unique<GroupCell>(config, GC_TYPE_TEXT, wxmLines));
-      wxmLines.Clear();
+
+    if (!final) {
+      state.lastChar = parsed.lastChar;
+      return static_cast<std::size_t>(parsed.ch - text.begin());
     }
 
+    if (!wxmLines.IsEmpty())
+      AppendWXMLines(tree, wxmLines, config);
+
     line.Trim(true);
     line.Trim(false);
     if (!line.empty())
       tree.Append(std::make_unique<GroupCell>(config, GC_TYPE_CODE, line));
+    state.lastChar = ' ';
+    return text.length();
+  }
 
+  std::unique_ptr<GroupCell> ParseMACContents(const wxString &macContents,
+                                              Configuration *config) {
+    CellListBuilder<GroupCell> tree;
+    MACParserState state;
+    ParseMACText(macContents, true, state, tree, config);
   /* The warning from gcc is correct. But an old MacOs compiler errors out
      on correct code, here. */
 #ifdef __GNUC__
@@ -543,34 +609,91 @@ namespace Format {
 #endif
   }
 
-  std::unique_ptr<GroupCell> ParseMACFile(wxTextBuffer &text, bool xMaximaFile,
-                                          Configuration *config) {
-    bool input = true;
-    wxString macContents;
-
-    for (auto line = text.GetFirstLine();; line = text.GetNextLine()) {
-      if (xMaximaFile) {
-        // Detect output cells.
-        if (line.StartsWith(wxS("(%o")))
-          input = false;
-
-        if (line.StartsWith(wxS("(%i"))) {
-          int end = line.Find(wxS(")"));
-          if (end > 0) {
-            line = line.Right(line.Length() - end - 2);
-            input = true;
+  DocumentReader::DocumentReader(std::unique_ptr<wxInputStream> &&file, FileType type,
+                                 Configuration *config) :
+    m_file(std::move(file)),
+    m_bufferedFile(*m_file),
+    m_textFile(m_bufferedFile),
+    m_type(type),
+    m_configuration(config),
+    m_length(m_file->GetLength()) {
+    m_ok = m_file->IsOk();
+    if (m_ok && (m_type == wxm)) {
+      wxString firstLine;
+      m_ok = ReadLine(firstLine) && (firstLine == WXMFirstLine);
+    }
+  }
+
+  bool DocumentReader::ReadLine(wxString &line) {
+    if (m_eof)
+      return false;
+    line = m_textFile.ReadLine();
+    if (line.IsEmpty() && m_bufferedFile.Eof()) {
+      m_eof = true;
+      return false;
+    }
+    return true;
+  }
+
+  int DocumentReader::GetProgress() const {
+    if ((m_length == wxInvalidOffset) || (m_length == 0))
+      return 0;
+    wxFileOffset position = m_file->TellI();
+    if (position == wxInvalidOffset)
+      return 0;
+    return static_cast<int>(100 * position / m_length);
+  }
+
+  std::unique_ptr<GroupCell> DocumentReader::Read(std::size_t chars) {
+    if (m_type == wxm) {
+      std::size_t read = 0;
+      return ReadWXMCells([this, &read](wxString &line) {
+        if (!ReadLine(line))
+          return false;
+        read += line.length() + 1;
+        return true;
+      }, [&read, chars] { return read >= chars; }, m_wxmState, m_configuration);
+    }
+
+    CellListBuilder<GroupCell> tree;
+    while (!tree && !Eof()) {
+      std::size_t wanted = m_macText.length() + chars;
+      wxString line;
+      while ((m_macText.length() < wanted) && ReadLine(line)) {
+        if (m_type == xMaxima) {
+          // Detect output cells.
+          if (line.StartsWith(wxS("(%o")))
+            m_xMaximaInput = false;
+
+          if (line.StartsWith(wxS("(%i"))) {
+            int end = line.Find(wxS(")"));
+            if (end > 0) {
+              line = line.Right(line.Length() - end - 2);
+              m_xMaximaInput = true;
+            }
           }
         }
+        if (m_xMaximaInput)
+          m_macText << line << wxS('\n');
       }
 
-      if (input)
-        macContents << line << wxS('\n');
-
-      if (text.Eof())
-        break;
+      std::size_t parsed = ParseMACText(m_macText, m_eof, m_macState, tree, m_configuration);
+      m_macText.erase(0, parsed);
+      // If no cell has ended in the text we have read we read twice as much
+      // next time. This way a huge cell isn't parsed again and again.
+      if (parsed == 0)
+        chars *= 2;
     }
-
-    return Format::ParseMACContents(macContents, config);
+  /* The warning from gcc is correct. But an old MacOs compiler errors out
+     on correct code, here. */
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wredundant-move"
+#endif
+    return std::move(tree);
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
   }
 
 } // namespace Format
@@ -29,8 +29,9 @@
 #include <memory>
 #include "cells/GroupCell.h"
 #include <vector>
-
-class wxTextBuffer;
+#include <wx/buffstrm.h>
+#include <wx/stream.h>
+#include <wx/txtstrm.h>
 
 //! An identifier for each of the headers in a WXM file
 // This enum's elements must be synchronized with (GroupCell.h) GroupType
@@ -80,13 +81,6 @@ namespace Format
 //! Converts a wxm description into individual cells
   std::unique_ptr<GroupCell> TreeFromWXM(const std::vector<wxString> &wxmLines, Configuration *config);
 
-/*! Parses the contents of a .wxm file into individual cells.
- * Invokes TreeFromWXM on pre-processed data,
- * concatenates the results.
- * \returns the tree, or nullptr on failure.
- */
-  std::unique_ptr<GroupCell> ParseWXMFile(wxTextBuffer &text, Configuration *config);
-
 /*! Parses the contents of a preloaded .mac file into individual cells.
  *
  * Invokes TreeFromWXM on pre-processed data.
@@ -94,11 +88,91 @@ namespace Format
  */
   std::unique_ptr<GroupCell> ParseMACContents(const wxString &macContents, Configuration *config);
 
-/*! Parses the contents of a .mac or a .out file into individual cells.
- * Invokes ParseMACContents on pre-processed data.
- * \returns the cell tree, or nullptr on failure.
- */
-  std::unique_ptr<GroupCell> ParseMACFile(wxTextBuffer &text, bool xMaximaFile, Configuration *config);
+//! What the .wxm parser needs to remember between two parts of a file
+  struct WXMParserState
+  {
+    //! Does the next cell need to be hidden?
+    bool hide = false;
+    //! The question the next answer is for
+    wxString question;
+    //! The header of the next cell, if reading stopped after it was read
+    wxString nextHeader;
+  };
+
+//! What the .mac parser needs to remember between two parts of a file
+  struct MACParserState
+  {
+    //! The last char that has been parsed
+    wxChar lastChar = ' ';
+    //! The wxMaxima comments that haven't been converted to cells, yet
+    wxString wxmLines;
+  };
+
+/*! Reads a .wxm, .mac or .out file a part at a time
+
+  Reading the whole file into a wxTextBuffer and then parsing a copy of it
+  needed several times the memory the file occupies on the disk, and no
+  cell could be shown before the last one had been parsed. A DocumentReader
+  reads the file in chunks and returns the cells the chunk contains, so the
+  start of a huge document can be shown while the rest is still being read.
+
+  Every cell Read() returns is complete: The answers, images and folded
+  cells that belong to a cell are returned together with it.
+*/
+  class DocumentReader
+  {
+  public:
+    //! The file formats DocumentReader understands
+    enum FileType
+    {
+      wxm,    //!< A .wxm file
+      mac,    //!< A .mac file
+      xMaxima //!< A .out file xMaxima has written
+    };
+
+    DocumentReader(std::unique_ptr<wxInputStream> &&file, FileType type, Configuration *config);
+    /*! Can the file be read?
+
+      For .wxm files this also means that the file starts with WXMFirstLine.
+    */
+    bool IsOk() const {return m_ok;}
+    /*! Reads the next part of the file
+
+      \param chars About how many chars to read. If they don't contain a
+      complete cell, more chars are read.
+      \return The cells, or nullptr, if the file has ended.
+    */
+    std::unique_ptr<GroupCell> Read(std::size_t chars = ChunkSize);
+    //! Has the whole file been read and parsed?
+    bool Eof() const {return m_eof && m_macText.IsEmpty() && m_wxmState.nextHeader.IsEmpty();}
+    //! How much of the file has been read, in percent
+    int GetProgress() const;
+
+    //! How many chars Read() reads by default
+    static constexpr std::size_t ChunkSize = 1 << 16;
+
+  private:
+    //! Reads a line from the file. Returns false at the end of the file.
+    bool ReadLine(wxString &line);
+
+    std::unique_ptr<wxInputStream> m_file;
+    //! Reading the file one byte after the other needs a buffer in front of it
+    wxBufferedInputStream m_bufferedFile;
+    wxTextInputStream m_textFile;
+    FileType m_type;
+    Configuration *m_configuration;
+    bool m_ok = false;
+    //! Has the end of the file been reached?
+    bool m_eof = false;
+    //! The length of the file, or wxInvalidOffset, if it is unknown
+    wxFileOffset m_length;
+    //! In .out files: Are we in an input or in an output?
+    bool m_xMaximaInput = true;
+    WXMParserState m_wxmState;
+    MACParserState m_macState;
+    //! The part of a .mac file that has been read, but not parsed, yet
+    wxString m_macText;
+  };
 
 //! First line of the WXM files - used by both loading and saving code.
   extern const wxString WXMFirstLine;
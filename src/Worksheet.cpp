@@ -36,11 +36,17 @@
 #include "cells/CellList.h"
 #include "CompositeDataObject.h"
 #include "graphical_io/EMFout.h"
+#include "ExportCache.h"
+#include "ImageCacheBudget.h"
+#include "Image.h"
+#include "LayoutCache.h"
+#include "Dirstructure.h"
 #include "cells/ImgCell.h"
 #include "MarkDown.h"
 #include "dialogs/MaxSizeChooser.h"
 #include "dialogs/ResolutionChooser.h"
 #include "graphical_io/SVGout.h"
+#include "ThreadPool.h"
 #include "Version.h"
 #include "WXMformat.h"
 #include "levenshtein/levenshtein.h"
@@ -48,6 +54,9 @@
 #include "wxMaximaFrame.h"
 #include "ArtProvider.h"
 #include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
 #include <memory>
 #include <vector>
 #include <utility>
@@ -58,12 +67,14 @@
 #include <wx/dcbuffer.h>
 #include <wx/dcgraph.h>
 #include <wx/event.h>
+#include <wx/file.h>
 #include <wx/fileconf.h>
 #include <wx/filefn.h>
 #include <wx/filename.h>
 #include <wx/filesys.h>
 #include <wx/fs_mem.h>
 #include <wx/mstream.h>
+#include <wx/progdlg.h>
 #include <wx/region.h>
 #include <wx/richtext/richtextbuffer.h>
 #include <wx/settings.h>
@@ -165,6 +176,10 @@ Worksheet::Worksheet(wxWindow *parent, int id,
 #endif
   Connect(SIDEBARKEYEVENT, wxCommandEventHandler(Worksheet::OnSidebarKey), NULL,
           this);
+  Connect(IMAGE_RESCALED_EVENT, wxCommandEventHandler(Worksheet::OnImageRescaled),
+          NULL, this);
+  Connect(IMAGE_LOADED_EVENT, wxCommandEventHandler(Worksheet::OnImageLoaded),
+          NULL, this);
   Connect(wxEVT_ERASE_BACKGROUND,
           wxEraseEventHandler(Worksheet::EraseBackground));
   Connect(EventIDs::popid_autocomplete_keyword1, EventIDs::popid_autocomplete_keyword1 + EventIDs::NumberOfAutocompleteKeywords - 1,
@@ -210,6 +225,22 @@ Worksheet::Worksheet(wxWindow *parent, int id,
   CallAfter([this] {m_configuration->SetCanvasSize(GetClientSize());});
 }
 
+void Worksheet::OnImageRescaled(wxCommandEvent &WXUNUSED(event)) {
+  // An image has finished scaling in the background and now can replace its preview
+  RequestRedraw();
+}
+
+void Worksheet::OnImageLoaded(wxCommandEvent &WXUNUSED(event)) {
+  // The groups have been laid out for placeholders of images that were still
+  // being loaded. Groups whose images still aren't loaded will ask again.
+  std::vector<CellPtr<GroupCell>> groups;
+  groups.swap(m_cellPointers.m_groupsWaitingForImages);
+  for (const auto &group : groups)
+    if (group)
+      Recalculate(group);
+  RequestRedraw();
+}
+
 void Worksheet::OnSidebarKey(wxCommandEvent &event) {
   if (m_configuration->LastActiveTextCtrl() == NULL) {
     SetFocus();
@@ -462,8 +493,9 @@ void Worksheet::OnPaint(wxPaintEvent &WXUNUSED(event)) {
     return;
 
   // It is possible that the redraw starts before the idle task attempts
-  // to recalculate the worksheet.
-  RecalculateIfNeeded();
+  // to recalculate the worksheet. Only the cells up to the bottom of the
+  // screen are needed for drawing, the idle task recalculates the rest.
+  RecalculateIfNeeded(true);
 
   // Create a graphics context that supports antialiasing, but on MSW
   // only supports fonts that come in the Right Format.
@@ -538,19 +570,25 @@ void Worksheet::OnPaint(wxPaintEvent &WXUNUSED(event)) {
         }
         atStart = false;
 
-        wxRect cellRect = cell.GetRect();
-
-        // Clear the image cache of all cells above or below the viewport.
-        if (cellRect.GetTop() >= bottom || cellRect.GetBottom() <= top) {
-          // Only actually clear the image cache if there is a screen's height
-          // between us and the image's position: Else the chance is too high
-          // that we will very soon have to generated a scaled image again.
-          if ((cellRect.GetBottom() <= m_lastBottom - 2 * height) ||
-              (cellRect.GetTop() >= m_lastTop + 2 * height)) {
-            if (cell.GetOutput())
-              cell.GetOutput()->ClearCacheList();
-          }
+        // Images that are on the screen must stay in the image cache, even
+        // if they aren't part of the region we redraw. Images near the screen
+        // are scaled before they are scrolled into view.
+        if (cell.GetOutput()) {
+          wxRect cellRect = cell.GetRect();
+          double distance = 0;
+          if (cellRect.GetBottom() < visibleRegion.GetTop())
+            distance = visibleRegion.GetTop() - cellRect.GetBottom();
+          if (cellRect.GetTop() > visibleRegion.GetBottom())
+            distance = cellRect.GetTop() - visibleRegion.GetBottom();
+          distance /= std::max(height, 1);
+          if (distance == 0)
+            cell.GetOutput()->TouchCacheList();
+          // Only images whose scaling might have been started need to know
+          // that they are far away.
+          if (distance <= 2 * Image::CancelDistance)
+            cell.GetOutput()->SetViewportDistanceList(distance);
         }
+
         //      m_drawThreads.push_back(std::thread(&Worksheet::DrawGroupCell_UsingBitmap,
         //                                  this,
         //                                  &dc, &cell, unscrolledRect));
@@ -604,8 +642,6 @@ void Worksheet::OnPaint(wxPaintEvent &WXUNUSED(event)) {
       }
     }
 
-    m_lastTop = top;
-    m_lastBottom = bottom;
     // for(auto &i:m_drawThreads)
     //   if(i.joinable())
     //     i.join();
@@ -613,6 +649,9 @@ void Worksheet::OnPaint(wxPaintEvent &WXUNUSED(event)) {
   }
 
   m_configuration->ReportMultipleRedraws();
+  // Now that we know which images are on the screen we can evict the others
+  // from the image cache if it has grown too big.
+  ImageCacheBudget::Enforce();
 }
 
 void Worksheet::PrepareDrawGC(wxDC &dc) const
@@ -928,16 +967,18 @@ bool Worksheet::RecalculateIfNeeded(bool timeout) {
 
   if(timeout)
     {
+      // Everything up to the bottom of the screen is recalculated at once,
+      // the rest in slices of 50ms. The cells below the screen don't need
+      // their size for being drawn.
       wxStopWatch stopwatch;
-      bool recalculated = false;
       bool stopwatchStarted = false;
       for (auto &cell : OnList(m_recalculateStart.get())) {
-        recalculated |= cell.Recalculate();
-        if((cell.GetRect().GetTop() > m_configuration->GetVisibleRegion().GetBottom()) &&
-           recalculated)
+        m_adjustWorksheetSizeNeeded |= cell.Recalculate();
+        if((!stopwatchStarted) &&
+           (cell.GetRect().GetTop() > m_configuration->GetVisibleRegion().GetBottom()))
           {
-            if(!stopwatchStarted)
-              stopwatch.Start();
+            stopwatch.Start();
+            stopwatchStarted = true;
           }
         if(cell.GetNext() != NULL)
           m_recalculateStart = cell.GetNext();
@@ -946,8 +987,9 @@ bool Worksheet::RecalculateIfNeeded(bool timeout) {
             wxLogMessage(_("Recalculation hit the end of the worksheet => Updating its size"));
             m_recalculateStart = {};
             AdjustSize();
+            StoreLayout();
           }
-        if(stopwatch.Time() > 50)
+        if(stopwatchStarted && (stopwatch.Time() > 50))
           break;
       }
     }
@@ -960,14 +1002,108 @@ bool Worksheet::RecalculateIfNeeded(bool timeout) {
             wxLogMessage(_("Recalculated the whole worksheet at once => Updating its size"));
           }
       }
+      m_recalculateStart = {};
+      StoreLayout();
     }
   if (m_adjustWorksheetSizeNeeded)
     AdjustSize();
 
-  m_recalculateStart = {};
   return true;
 }
 
+namespace {
+  //! The heights of the cells of the documents that have been opened last
+  LayoutCache &RecentLayouts() {
+    static LayoutCache cache;
+    static bool alreadyRead = false;
+    if (!alreadyRead) {
+      alreadyRead = true;
+      wxString fileName = Dirstructure::LayoutCacheFile();
+      if (wxFileExists(fileName)) {
+        wxFileInputStream file(fileName);
+        if (file.IsOk() && !cache.Read(file))
+          wxLogMessage(_("Ignoring the damaged layout cache %s"), fileName.mb_str());
+      }
+    }
+    return cache;
+  }
+
+  //! Writes the layout cache to disk. Only one write is pending at any time.
+  ThreadPool::Task &LayoutCacheWriteTask() {
+    static ThreadPool::Task task;
+    return task;
+  }
+}
+
+uint64_t Worksheet::LayoutKey() const {
+  wxString settings = wxString::Format(wxS("%s %li %f"), wxS(WXMAXIMA_VERSION),
+                                       m_configuration->GetLineWidth(),
+                                       m_configuration->GetZoomFactor());
+  for (int style = 0; style < NUMBEROFSTYLES; style++) {
+    const Style *fontStyle = m_configuration->GetStyle(static_cast<TextStyle>(style));
+    settings += wxString::Format(wxS(" %s %f %i %i"), fontStyle->GetFontName(),
+                                 fontStyle->GetFontSize().Get(),
+                                 fontStyle->IsBold(), fontStyle->IsItalic());
+  }
+  wxScopedCharBuffer settingsUtf8 = settings.utf8_str();
+  return LayoutCache::Hash(settingsUtf8.data(), settingsUtf8.length(),
+                           LayoutCache::Hash(&m_documentHash, sizeof(m_documentHash)));
+}
+
+void Worksheet::SetDocumentHash(uint64_t contentHash) {
+  m_documentHash = contentHash;
+  if ((m_documentHash == 0) || !GetTree())
+    return;
+  const LayoutCache::Layout *layout = RecentLayouts().Find(LayoutKey());
+  if (!layout)
+    return;
+  std::size_t cells = 0;
+  for (const auto &cell : OnList(GetTree())) {
+    (void) cell;
+    cells++;
+  }
+  if (cells != layout->size())
+    return;
+  wxLogMessage(_("Using the cell heights from the last time this document was opened"));
+  auto height = layout->begin();
+  for (auto &cell : OnList(GetTree()))
+    cell.SetHeightHint(*height++);
+  AdjustSize();
+}
+
+void Worksheet::StoreLayout() {
+  // The layout only fits the file as long as the document hasn't been changed
+  if ((m_documentHash == 0) || !IsSaved() || !GetTree())
+    return;
+  LayoutCache::Layout layout;
+  for (const auto &cell : OnList(GetTree()))
+    layout.push_back(cell.GetHeightList());
+  RecentLayouts().Store(LayoutKey(), std::move(layout));
+  // Each document is stored only once
+  m_documentHash = 0;
+
+  // Writing the file is left to the thread pool: The GUI thread only
+  // copies the cache. A write that hasn't started, yet, is superseded by
+  // this one, which contains the newer data.
+  ThreadPool::Task &task = LayoutCacheWriteTask();
+  task.CancelAndWait();
+  wxString fileName = Dirstructure::LayoutCacheFile();
+  LayoutCache cache = RecentLayouts();
+  std::function<void()> write = [fileName, cache]() {
+    // Write to a temp file that replaces the old cache only after everything is written
+    wxTempFileOutputStream file(fileName);
+    if (!file.IsOk())
+      return;
+    cache.Write(file);
+    if (!(file.IsOk() && file.Commit()))
+      wxLogMessage(_("Cannot write the layout cache %s"), fileName.mb_str());
+  };
+  if (m_configuration->UseThreads())
+    task = ThreadPool::Get().Submit(ThreadPool::indexing, std::move(write));
+  else
+    write();
+}
+
 void Worksheet::Recalculate(Cell *start) {
   if (!GetTree())
     return;
@@ -2645,8 +2781,11 @@ bool Worksheet::Copy(bool astext) const {
       BitmapOut output(&m_configuration, std::move(cell),
                        m_configuration->BitmapScale(),
                        1000000 * m_configuration->MaxClipbrdBitmapMegabytes());
+      std::unique_ptr<wxBitmapDataObject> bitmap;
       if (output.IsOk())
-        data->Add(output.GetDataObject().release());
+        bitmap = output.GetDataObject();
+      if (bitmap)
+        data->Add(bitmap.release());
     }
     wxTheClipboard->SetData(data);
     wxTheClipboard->Close();
@@ -2868,8 +3007,11 @@ bool Worksheet::CopyCells() const {
       std::unique_ptr<BitmapOut> output(new BitmapOut(&m_configuration, CopySelection(),
                                                       m_configuration->BitmapScale(),
                                                       1000000 * m_configuration->MaxClipbrdBitmapMegabytes()));
+      std::unique_ptr<wxBitmapDataObject> bitmap;
       if (output->IsOk())
-        data->Add(output->GetDataObject().release());
+        bitmap = output->GetDataObject();
+      if (bitmap)
+        data->Add(bitmap.release());
     }
 
 #if wxUSE_ENH_METAFILE
@@ -4174,8 +4316,13 @@ void Worksheet::GetMaxPoint(int *width, int *height) {
   int currentHeight = m_configuration->GetIndent();
   *width = m_configuration->GetBaseIndent();
 
-  for (Cell const &tmp : OnList(GetTree())) {
-    currentHeight += tmp.GetHeightList();
+  for (GroupCell const &tmp : OnList(GetTree())) {
+    // Cells that haven't been recalculated since the document has been
+    // opened might know the height they will have.
+    if (tmp.GetHeightHint() >= 0)
+      currentHeight += tmp.GetHeightHint();
+    else
+      currentHeight += tmp.GetHeightList();
     currentHeight += m_configuration->GetGroupSkip();
     int currentWidth =
       m_configuration->Scale_Px(m_configuration->GetIndent() +
@@ -5218,7 +5365,108 @@ bool Worksheet::ExportToHTML(const wxString &file) {
   // Write the actual contents
   //////////////////////////////////////////////
 
+  // The HTML code, in document order. The parts background tasks produce are
+  // filled in by them. A std::deque, since its elements don't move if more
+  // parts are appended.
+  std::deque<wxString> parts;
+  // Reserves a part for a background task. Everything that has been written
+  // to output so far becomes the part before it.
+  auto backgroundPart = [&parts, &output]() -> wxString & {
+    parts.push_back(output);
+    output.clear();
+    parts.emplace_back();
+    return parts.back();
+  };
+  // The copies of the cells the background tasks read. Cells may only be
+  // created and deleted in the GUI thread, so they are kept here until all
+  // tasks have ended.
+  std::vector<std::unique_ptr<Cell>> taskCells;
+  std::vector<ThreadPool::Task> tasks;
+  ThreadPool::CancellationToken cancel;
+  std::atomic<bool> filesOK(true);
+  auto runTask = [this, &tasks, &cancel](std::function<void()> &&work) {
+    if (m_configuration->UseThreads())
+      tasks.push_back(ThreadPool::Get().Submit(ThreadPool::visible, std::move(work), cancel));
+    else
+      work();
+  };
+  // Files whose contents haven't changed since the last export are reused.
+  // The images of equations also depend on the style settings.
+  ExportCache cache(imgDir);
+  wxString settings = wxString::Format(wxS("%s %i %i %li"), wxS(WXMAXIMA_VERSION),
+                                       static_cast<int>(m_configuration->HTMLequationFormat()),
+                                       m_configuration->BitmapScale(),
+                                       m_configuration->GetLineWidth());
+  for (int style = 0; style < NUMBEROFSTYLES; style++) {
+    const Style *fontStyle = m_configuration->GetStyle(static_cast<TextStyle>(style));
+    settings += wxString::Format(wxS(" %s %f %i %i %lx"), fontStyle->GetFontName(),
+                                 fontStyle->GetFontSize().Get(),
+                                 fontStyle->IsBold(), fontStyle->IsItalic(),
+                                 static_cast<unsigned long>(fontStyle->GetRGBColor()));
+  }
+  uint64_t settingsKey = ExportCache::Key(settings);
+
+  // Writes an image to a file in the format it is stored in
+  auto exportImage = [&imgDir, &runTask, &filesOK, &cache](ImgCellBase *image,
+                                                            const wxString &name) {
+    ImgCell *imgCell = dynamic_cast<ImgCell *>(image);
+    if (!imgCell)
+      return image->ToImageFile(imgDir + wxS("/") + name);
+    wxSize size(imgCell->GetOriginalWidth(), imgCell->GetOriginalHeight());
+    wxMemoryBuffer compressed = imgCell->GetCompressedImage();
+    uint64_t key = ExportCache::Key(compressed);
+    if (cache.Reuse(name, key))
+      return size;
+    cache.Stored(name, key);
+    // Writing the file is all there is to do => it is done in the
+    // background. The task gets a copy of the data, since wxMemoryBuffer's
+    // reference counting isn't thread-safe.
+    auto data = std::make_shared<std::string>(
+      static_cast<const char *>(compressed.GetData()), compressed.GetDataLen());
+    wxString imgFile = imgDir + wxS("/") + name;
+    runTask([data, imgFile, &filesOK] {
+      wxFile file(imgFile, wxFile::write);
+      if ((!file.IsOpened()) ||
+          (file.Write(data->data(), data->size()) != data->size()) ||
+          (!file.Close()))
+        filesOK = false;
+    });
+    return size;
+  };
+  // Writes an animation to a .gif file
+  auto exportGif = [&imgDir, &filesOK, &cache](AnimationCell *animation,
+                                                const wxString &name) {
+    uint64_t key = animation->GetFrameRate();
+    key = ExportCache::Key(&key, sizeof(key));
+    for (int frame = 0; frame < animation->Length(); frame++)
+      key = ExportCache::Key(animation->GetCompressedFrame(frame), key);
+    if (cache.Reuse(name, key))
+      return;
+    // A .gif that hasn't been written completely must never be reused.
+    if (animation->ToGif(imgDir + wxS("/") + name).x < 0)
+      filesOK = false;
+    else
+      cache.Stored(name, key);
+  };
+
+  std::size_t cells = 0;
+  for (const auto &cell : OnList(GetTree())) {
+    (void) cell;
+    cells++;
+  }
+  wxProgressDialog progress(_("HTML export"), _("Exporting the cells..."),
+                            static_cast<int>(2 * cells + 1), this,
+                            wxPD_APP_MODAL | wxPD_AUTO_HIDE | wxPD_CAN_ABORT |
+                            wxPD_ELAPSED_TIME | wxPD_REMAINING_TIME);
+  bool cancelled = false;
+  std::size_t cellsDone = 0;
+
   for (auto &tmp : OnList(GetTree())) {
+    if (!progress.Update(static_cast<int>(++cellsDone))) {
+      cancelled = true;
+      break;
+    }
+
     // Handle a code cell
     if (tmp.GetGroupType() == GC_TYPE_CODE) {
       // Handle the label
@@ -5275,9 +5523,8 @@ bool Worksheet::ExportToHTML(const wxString &file) {
           // Export the chunk.
 
           if (dynamic_cast<AnimationCell *>(&(*chunk)) != NULL) {
-            dynamic_cast<AnimationCell *>(&(*chunk))->ToGif(
-                                                            imgDir + wxS("/") + filename +
-                                                            wxString::Format(wxS("_%d.gif"), count));
+            exportGif(dynamic_cast<AnimationCell *>(&(*chunk)),
+                      filename + wxString::Format(wxS("_%d.gif"), count));
             output
               << wxS("  <img src=\"") + filename_encoded + wxS("_htmlimg/") +
               filename_encoded +
@@ -5288,33 +5535,48 @@ bool Worksheet::ExportToHTML(const wxString &file) {
           } else if (dynamic_cast<ImgCellBase *>(&(*chunk)) == NULL) {
             switch (m_configuration->HTMLequationFormat()) {
             case Configuration::mathJaX_TeX: {
-              wxString line = chunk->ListToTeX();
-
-              line.Replace(wxS("<"), wxS("&lt;"));
-              line.Replace(wxS("&"), wxS("&amp;"));
-              line.Replace(wxS(">"), wxS("&gt;"));
-              // Work around a known limitation in MathJaX: According to
-              // https://github.com/mathjax/MathJax/issues/569 Non-Math Text
-              // will still be interpreted as Text, not as TeX for a long while.
-              //
-              // So instead of  "\%o1" print "%o1" - that works fine now.
-              // Since we are using a *fixed* Mathjax version for an export,
-              // nothing will happen, if Mathjax changes that behaviour and
-              // would interpret the % as TeX comment. When we would upgrade to
-              // the new MathJax version we would need to escape the % with \%,
-              // but now that is not necessary.
-              line.Replace(wxS("\\tag{\\% "), wxS("\\tag{%"));
-
-              output << wxS("<p>\n\\[") << line << wxS("\\]\n</p>\n");
+              // Converting the maths to TeX only reads the copy of the cells
+              // => it can be done in the background.
+              const Cell *math = chunk.get();
+              wxString *part = &backgroundPart();
+              runTask([math, part] {
+                wxString line = math->ListToTeX();
+
+                line.Replace(wxS("<"), wxS("&lt;"));
+                line.Replace(wxS("&"), wxS("&amp;"));
+                line.Replace(wxS(">"), wxS("&gt;"));
+                // Work around a known limitation in MathJaX: According to
+                // https://github.com/mathjax/MathJax/issues/569 Non-Math Text
+                // will still be interpreted as Text, not as TeX for a long while.
+                //
+                // So instead of  "\%o1" print "%o1" - that works fine now.
+                // Since we are using a *fixed* Mathjax version for an export,
+                // nothing will happen, if Mathjax changes that behaviour and
+                // would interpret the % as TeX comment. When we would upgrade to
+                // the new MathJax version we would need to escape the % with \%,
+                // but now that is not necessary.
+                line.Replace(wxS("\\tag{\\% "), wxS("\\tag{%"));
+
+                *part << wxS("<p>\n\\[") << line << wxS("\\]\n</p>\n");
+              });
+              taskCells.push_back(std::move(chunk));
               break;
             }
 
             case Configuration::svg: {
               auto const alttext =
                 EditorCell::EscapeHTMLChars(chunk->ListToString());
-              auto const filepath = wxString::Format(wxS("%s/%s_%d.svg"),
-                                                     imgDir, filename, count);
-              Svgout svgout(&m_configuration, std::move(chunk), filepath);
+              auto const name = wxString::Format(wxS("%s_%d.svg"), filename, count);
+              uint64_t key = ExportCache::Key(chunk->ListToXML(), settingsKey);
+              wxSize size;
+              if (!cache.Reuse(name, key, &size)) {
+                Svgout svgout(&m_configuration, std::move(chunk), imgDir + wxS("/") + name);
+                size = svgout.GetSize();
+                if (svgout.IsOk())
+                  cache.Stored(name, key, size);
+                else
+                  filesOK = false;
+              }
 
               wxString line =
                 wxS("  <img src=\"") + filename_encoded + wxS("_htmlimg/") +
@@ -5322,7 +5584,7 @@ bool Worksheet::ExportToHTML(const wxString &file) {
                 wxString::Format(
                                  wxS("_%d.svg\" width=\"%li\" style=\"max-width:90%%;\" "
                                      "loading=\"lazy\" alt=\""),
-                                 count, static_cast<long>(svgout.GetSize().x)) +
+                                 count, static_cast<long>(size.x)) +
                 alttext + wxS("\"><br>\n");
 
               output << line + "\n";
@@ -5330,23 +5592,36 @@ bool Worksheet::ExportToHTML(const wxString &file) {
             }
 
             case Configuration::bitmap: {
-              wxSize size;
-              size = CopyToFile(imgDir + wxS("/") + filename +
-                                wxString::Format(wxS("_%d.png"), count),
-                                &(*chunk), NULL, true,
-                                m_configuration->BitmapScale());
-              int borderwidth = 0;
               wxString alttext =
                 EditorCell::EscapeHTMLChars(chunk->ListToString());
-              borderwidth = chunk->GetImageBorderWidth();
+              int borderwidth = chunk->GetImageBorderWidth();
+              wxString name = filename + wxString::Format(wxS("_%d.png"), count);
+              uint64_t key = ExportCache::Key(chunk->ListToXML(), settingsKey);
+              wxSize size;
+              if (!cache.Reuse(name, key, &size)) {
+                // Bitmaps can only be drawn in the GUI thread. Compressing them
+                // into a .png file is the slow part, though, and is done in the
+                // background. wxImage's reference counting isn't thread-safe:
+                // Only the task may access the image.
+                BitmapOut bitmap(&m_configuration, std::move(chunk),
+                                 m_configuration->BitmapScale());
+                size = bitmap.GetScaledSize();
+                cache.Stored(name, key, size);
+                auto image = std::make_shared<wxImage>(bitmap.ToImage());
+                wxString pngFile = imgDir + wxS("/") + name;
+                runTask([image, pngFile, &filesOK] {
+                  if (!image->SaveFile(pngFile, wxBITMAP_TYPE_PNG))
+                    filesOK = false;
+                });
+              }
 
               wxString line =
                 wxS("  <img src=\"") + filename_encoded + wxS("_htmlimg/") +
                 filename_encoded +
                 wxString::Format(
-                                 wxS("_%d%s\" width=\"%li\" style=\"max-width:90%%;\" "
+                                 wxS("_%d.png\" width=\"%li\" style=\"max-width:90%%;\" "
                                      "loading=\"lazy\" alt=\" "),
-                                 count, ext.utf8_str(),
+                                 count,
                                  static_cast<long>(size.x) / m_configuration->BitmapScale() -
                                  2 * borderwidth) +
                 alttext + wxS("\"><br>\n");
@@ -5356,20 +5631,24 @@ bool Worksheet::ExportToHTML(const wxString &file) {
             }
 
             default: {
-              wxString line = chunk->ListToMathML();
-              output
-                << wxS("<math xmlns=\"http://www.w3.org/1998/Math/MathML\" "
-                       "display=\"block\">")
-                << line << wxS("</math>\n");
+              // Converting the maths to MathML only reads the copy of the
+              // cells => it can be done in the background.
+              const Cell *math = chunk.get();
+              wxString *part = &backgroundPart();
+              runTask([math, part] {
+                *part << wxS("<math xmlns=\"http://www.w3.org/1998/Math/MathML\" "
+                             "display=\"block\">")
+                      << math->ListToMathML() << wxS("</math>\n");
+              });
+              taskCells.push_back(std::move(chunk));
             }
             }
           } else {
             wxSize size;
             ext = wxS(".") +
               dynamic_cast<ImgCellBase *>(&(*chunk))->GetExtension();
-            size = dynamic_cast<ImgCellBase *>(&(*chunk))->ToImageFile(
-                                                                       imgDir + wxS("/") + filename +
-                                                                       wxString::Format(wxS("_%d"), count) + ext);
+            size = exportImage(dynamic_cast<ImgCellBase *>(&(*chunk)),
+                               filename + wxString::Format(wxS("_%d"), count) + ext);
             int borderwidth = 0;
             wxString alttext =
               EditorCell::EscapeHTMLChars(chunk->ListToString());
@@ -5482,9 +5761,8 @@ bool Worksheet::ExportToHTML(const wxString &file) {
                      << wxS("\n");
               output << wxS("<br>\n");
               if (dynamic_cast<AnimationCell *>(tmp.GetOutput()) != NULL) {
-                dynamic_cast<AnimationCell *>(tmp.GetOutput())
-                  ->ToGif(imgDir + wxS("/") + filename +
-                          wxString::Format(wxS("_%d.gif"), count));
+                exportGif(dynamic_cast<AnimationCell *>(tmp.GetOutput()),
+                          filename + wxString::Format(wxS("_%d.gif"), count));
                 output << wxS("  <img src=\"") + filename_encoded + wxS("_htmlimg/") +
                   filename_encoded +
                   wxString::Format(
@@ -5497,9 +5775,8 @@ bool Worksheet::ExportToHTML(const wxString &file) {
                 wxASSERT(imgCell);
                 if(imgCell)
                   {
-                    imgCell->ToImageFile(imgDir + wxS("/") + filename +
-                                         wxString::Format(wxS("_%d."), count) +
-                                         imgCell->GetExtension());
+                    exportImage(imgCell, filename + wxString::Format(wxS("_%d."), count) +
+                                imgCell->GetExtension());
                     output
                       << wxS("  <img src=\"") + filename_encoded + wxS("_htmlimg/") +
                       filename_encoded +
@@ -5522,6 +5799,29 @@ bool Worksheet::ExportToHTML(const wxString &file) {
       }
   }
 
+  // The parts the background tasks produce are collected in document order as
+  // soon as they are ready.
+  for (std::size_t i = 0; (i < tasks.size()) && (!cancelled); i++) {
+    tasks[i].Wait();
+    cancelled = !progress.Update(static_cast<int>(cells + (i + 1) * cells / tasks.size()));
+  }
+  if (cancelled) {
+    cancel.Cancel();
+    for (auto &task : tasks)
+      task.Wait();
+    m_configuration->ClipToDrawRegion(true);
+    return false;
+  }
+  taskCells.clear();
+  if (filesOK)
+    cache.Commit();
+  wxLogMessage(_("HTML export: %li of the images were reused from the last export."),
+               static_cast<long>(cache.GetReused()));
+  parts.push_back(output);
+  output.clear();
+  for (const auto &part : parts)
+    output << part;
+
   //////////////////////////////////////////////
   // Footer
   //////////////////////////////////////////////
@@ -5599,7 +5899,9 @@ bool Worksheet::ExportToHTML(const wxString &file) {
 
   m_configuration->ClipToDrawRegion(true);
   Recalculate();
-  return outfileOK && cssOK;
+  if (!filesOK)
+    wxLogMessage(_("Could not write all images of the HTML export to %s"), imgDir);
+  return outfileOK && cssOK && filesOK;
 }
 
 void Worksheet::CodeCellVisibilityChanged() {
@@ -5715,10 +6017,14 @@ bool Worksheet::ExportToTeX(const wxString &file) {
   //
   // Write contents
   //
+  // Images that haven't changed since the last export are reused
+  ExportCache cache(imgDir);
   for (auto &tmp : OnList(GetTree())) {
-    wxString s = tmp.ToTeX(imgDir, filename, &imgCounter);
+    wxString s = tmp.ToTeX(imgDir, filename, &imgCounter, &cache);
     output << s << wxS("\n");
   }
+  if (wxDirExists(imgDir))
+    cache.Commit();
 
   //
   // Close document
@@ -210,10 +210,6 @@ private:
 
 //! true, if we have the current focus.
   bool m_hasFocus = true;
-  //! The last beginning for the area being drawn
-  long m_lastTop = 0;
-  //! The last ending for the area being drawn
-  long m_lastBottom = 0;
   /*! \defgroup UndoBufferFill Undo methods for cell additions/deletions:
 
     Each EditorCell has its own private undo buffer Additionally wxMaxima
@@ -488,6 +484,11 @@ private:
 
   void OnSidebarKey(wxCommandEvent &event);
 
+  //! Called when an Image has scaled a bitmap in the background
+  void OnImageRescaled(wxCommandEvent &event);
+  //! Called when an image has been loaded in the background
+  void OnImageLoaded(wxCommandEvent &event);
+
   void OnMouseLeftUp(wxMouseEvent &event);
 
   //! Is called if we loose the mouse connection whilst selecting text/cells
@@ -888,6 +889,17 @@ public:
    */
   bool RecalculateIfNeeded(bool timeout = false);
 
+  /*! Tells the worksheet which file its contents have just been read from
+
+    If the document has been laid out with the same settings before, the
+    heights its cells had then are used for the size of the worksheet
+    until the cells have been recalculated. Once the whole document has
+    been laid out its cells' heights are remembered for the next time.
+
+    \param contentHash A hash of the file's contents
+  */
+  void SetDocumentHash(uint64_t contentHash);
+
   //! Schedule a recalculation of the worksheet starting with the cell start.
   void Recalculate(Cell *start);
 
@@ -1600,6 +1612,12 @@ protected:
   void UpdateConfigurationClientSize();
   //! Where to start recalculation. NULL = No recalculation needed.
   CellPtr<GroupCell> m_recalculateStart;
+  //! The hash of the file the document was read from, or 0 if the layout cache isn't used
+  uint64_t m_documentHash = 0;
+  //! The key for the layout cache: The document's hash plus the settings that affect the layout
+  uint64_t LayoutKey() const;
+  //! Remembers the heights of the cells, if the document still is the one that has been read
+  void StoreLayout();
   //! The x position of the mouse pointer
   int m_pointer_x = -1;
   //! The y position of the mouse pointer
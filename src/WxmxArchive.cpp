@@ -0,0 +1,120 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  This file defines the class WxmxArchive
+
+  WxmxArchive gives random access to the files a .wxmx file contains.
+*/
+
+#include "WxmxArchive.h"
+#include <list>
+#include <mutex>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/intl.h>
+#include <wx/log.h>
+#include <wx/wfstream.h>
+
+namespace {
+  //! Guards the cache: Images are loaded from several threads at once
+  std::mutex cacheMutex;
+  //! The indexes that have been used last, the newest one first
+  std::list<std::shared_ptr<const WxmxArchive>> cache;
+}
+
+WxmxArchive::WxmxArchive(const wxString &file) :
+  m_file(file),
+  m_size(wxFileName::GetSize(file)),
+  m_modified(wxFileModificationTime(file)) {
+  wxFFileInputStream input(file);
+  if (!input.IsOk())
+    return;
+  // As the file is seekable wxZipInputStream only reads the central directory
+  // here, not the files themselves.
+  wxZipInputStream zip(input, wxConvLocal);
+  wxZipEntry *entry;
+  while ((entry = zip.GetNextEntry()) != NULL)
+    m_entries[entry->GetName()].reset(entry);
+  m_ok = (zip.GetLastError() == wxSTREAM_EOF) || (zip.GetLastError() == wxSTREAM_NO_ERROR);
+  wxLogMessage(_("Indexed the %li files in %s"), static_cast<long>(m_entries.size()), file);
+}
+
+std::shared_ptr<const WxmxArchive> WxmxArchive::Open(const wxString &file) {
+  wxULongLong size = wxFileName::GetSize(file);
+  time_t modified = wxFileModificationTime(file);
+  {
+    const std::lock_guard<std::mutex> lock(cacheMutex);
+    for (auto i = cache.begin(); i != cache.end(); ++i)
+      if ((*i)->m_file == file) {
+        std::shared_ptr<const WxmxArchive> archive = *i;
+        cache.erase(i);
+        if ((archive->m_size != size) || (archive->m_modified != modified))
+          break;
+        cache.push_front(archive);
+        return archive;
+      }
+  }
+
+  // Indexing the file may take a while, so it is done without holding the
+  // lock. If two threads index the same file at once the cache keeps the
+  // index that was done last.
+  std::shared_ptr<const WxmxArchive> archive(new WxmxArchive(file));
+  if (!archive->m_ok)
+    return nullptr;
+  const std::lock_guard<std::mutex> lock(cacheMutex);
+  cache.remove_if([&file](const std::shared_ptr<const WxmxArchive> &cached) {
+    return cached->m_file == file;});
+  cache.push_front(archive);
+  if (cache.size() > CacheSize)
+    cache.pop_back();
+  return archive;
+}
+
+void WxmxArchive::Forget(const wxString &file) {
+  const std::lock_guard<std::mutex> lock(cacheMutex);
+  cache.remove_if([&file](const std::shared_ptr<const WxmxArchive> &cached) {
+    return cached->m_file == file;});
+}
+
+std::unique_ptr<wxInputStream> WxmxArchive::OpenEntry(const wxString &name) const {
+  auto entry = m_entries.find(name);
+  if (entry == m_entries.end())
+    return nullptr;
+  std::unique_ptr<wxFFileInputStream> input(new wxFFileInputStream(m_file));
+  if (!input->IsOk())
+    return nullptr;
+  // The zip stream takes the ownership of the file stream. As the file is
+  // seekable it directly seeks to the entry we open.
+  std::unique_ptr<wxZipInputStream> zip(new wxZipInputStream(input.release(), wxConvLocal));
+  wxZipEntry zipEntry;
+  {
+    const std::lock_guard<std::mutex> lock(m_entriesMutex);
+    zipEntry = *entry->second;
+    // The sizes the extra fields might contain have been read, already. The
+    // stream reads the local extra field from the file itself.
+    zipEntry.SetExtra(NULL, 0);
+    zipEntry.SetLocalExtra(NULL, 0);
+  }
+  if (!zip->OpenEntry(zipEntry))
+    return nullptr;
+  return std::unique_ptr<wxInputStream>(zip.release());
+}
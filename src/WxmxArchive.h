@@ -0,0 +1,101 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  This file declares the class WxmxArchive
+
+  WxmxArchive gives random access to the files a .wxmx file contains.
+*/
+
+#ifndef WXMXARCHIVE_H
+#define WXMXARCHIVE_H
+
+#include "precomp.h"
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <wx/string.h>
+#include <wx/stream.h>
+#include <wx/zipstrm.h>
+
+/*! An index of the files a .wxmx file contains
+
+  wxZipInputStream can only find a file in a .zip archive by walking through
+  the archive's central directory. A document with hundreds of images did
+  that once for every image. WxmxArchive reads the central directory only
+  once and then jumps directly to the files it is asked for.
+
+  An index never changes after it has been created, so files can be read
+  from it by several threads at once: Every file that is opened gets a
+  file handle of its own and a copy of the entry that shares no data with
+  the index.
+*/
+class WxmxArchive
+{
+public:
+  /*! Returns the index of a .wxmx file
+
+    The indexes of the files that have been opened last are cached until
+    the file's size or modification time changes.
+
+    \return The index, or nullptr if the file isn't a .zip archive we can read.
+  */
+  static std::shared_ptr<const WxmxArchive> Open(const wxString &file);
+  //! Drops the cached index of a file we have just overwritten
+  static void Forget(const wxString &file);
+
+  //! Does the archive contain a file of this name?
+  bool Has(const wxString &name) const {return m_entries.find(name) != m_entries.end();}
+  //! The central directory's info about a file, or nullptr if the archive doesn't contain it
+  const wxZipEntry *GetEntry(const wxString &name) const {
+    auto entry = m_entries.find(name);
+    return (entry == m_entries.end()) ? nullptr : entry->second.get();
+  }
+  /*! Opens a file the archive contains for reading
+
+    \return The stream to read it from, or nullptr if the archive doesn't
+    contain a file of this name.
+  */
+  std::unique_ptr<wxInputStream> OpenEntry(const wxString &name) const;
+
+private:
+  explicit WxmxArchive(const wxString &file);
+  //! The name of the .wxmx file
+  wxString m_file;
+  //! The size of the .wxmx file when it was indexed
+  wxULongLong m_size;
+  //! The modification time of the .wxmx file when it was indexed
+  time_t m_modified = 0;
+  //! The central directory's entries, by file name
+  std::unordered_map<wxString, std::unique_ptr<wxZipEntry>, wxStringHash> m_entries;
+  //! Could the central directory be read?
+  bool m_ok = false;
+  /*! Guards copying the entries
+
+    Copies of a wxZipEntry share its extra fields, whose reference count isn't
+    thread-safe.
+  */
+  mutable std::mutex m_entriesMutex;
+  //! How many indexes Open() keeps
+  static constexpr std::size_t CacheSize = 4;
+};
+
+#endif // WXMXARCHIVE_H
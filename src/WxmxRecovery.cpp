@@ -0,0 +1,489 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  Defines WxmxRecovery, which recovers what it can from a damaged content.xml.
+*/
+
+#include "WxmxRecovery.h"
+#include <algorithm>
+#include <utility>
+
+namespace {
+  bool StartsWith(const std::string &s, const char *prefix) {
+    return s.compare(0, std::char_traits<char>::length(prefix), prefix) == 0;
+  }
+  bool EndsWith(const std::string &s, const char *suffix) {
+    std::size_t length = std::char_traits<char>::length(suffix);
+    return (s.size() >= length) && (s.compare(s.size() - length, length, suffix) == 0);
+  }
+  //! Is s the start of prefix?
+  bool IsStartOf(const std::string &s, const char *prefix) {
+    return std::string(prefix).compare(0, s.size(), s) == 0;
+  }
+}
+
+void WxmxRecovery::Feed(const char *data, std::size_t length) {
+  for (std::size_t i = 0; i < length; i++) {
+    unsigned char byte = static_cast<unsigned char>(data[i]);
+    if (m_utf8Pending > 0) {
+      if ((byte & 0xC0) == 0x80) {
+        m_codePoint = (m_codePoint << 6) | (byte & 0x3F);
+        if (--m_utf8Pending > 0)
+          continue;
+        Char((m_codePoint < m_minCodePoint) ? 0xFFFD : m_codePoint);
+        continue;
+      }
+      // The sequence is incomplete. This byte starts a new character.
+      m_utf8Pending = 0;
+      Char(0xFFFD);
+    }
+    if (byte < 0x80)
+      Char(byte);
+    else if ((byte >= 0xC2) && (byte <= 0xDF)) {
+      m_utf8Pending = 1;
+      m_codePoint = byte & 0x1F;
+      m_minCodePoint = 0x80;
+    } else if ((byte >= 0xE0) && (byte <= 0xEF)) {
+      m_utf8Pending = 2;
+      m_codePoint = byte & 0x0F;
+      m_minCodePoint = 0x800;
+    } else if ((byte >= 0xF0) && (byte <= 0xF4)) {
+      m_utf8Pending = 3;
+      m_codePoint = byte & 0x07;
+      m_minCodePoint = 0x10000;
+    } else
+      Char(0xFFFD);
+  }
+}
+
+std::string WxmxRecovery::Finish() {
+  if (m_utf8Pending > 0) {
+    m_utf8Pending = 0;
+    Char(0xFFFD);
+  }
+  bool inRoot = m_rootSeen && !m_rootClosed;
+  if ((m_state == markup) && inRoot) {
+    // The file ends inside a tag
+    Lose(Loss::badMarkup, std::string(), CurrentCell());
+    Damage();
+  } else if ((m_state == reference) && inRoot)
+    m_out += "&amp;" + m_markup;
+  m_state = text;
+  m_markup.clear();
+
+  if (!m_rootSeen)
+    return std::string();
+  while (!m_openElements.empty())
+    CloseElement(false);
+  m_out += '\n';
+  return std::move(m_out);
+}
+
+std::size_t WxmxRecovery::CurrentCell() const {
+  if ((m_openElements.size() > 1) && (m_openElements[1].name == "cell"))
+    return m_cells;
+  return 0;
+}
+
+void WxmxRecovery::Lose(Loss::Kind kind, const std::string &element, std::size_t cell) {
+  if (!m_losses.empty()) {
+    Loss &last = m_losses.back();
+    if ((last.kind == kind) && (last.cell == cell) && (last.element == element)) {
+      last.count++;
+      return;
+    }
+  }
+  m_losses.push_back({kind, cell, element, 1});
+}
+
+void WxmxRecovery::Damage() {
+  for (auto i = m_openElements.rbegin(); i != m_openElements.rend(); ++i)
+    if (i->name == "output") {
+      i->damaged = true;
+      return;
+    }
+}
+
+void WxmxRecovery::AppendUtf8(std::string &out, char32_t c) {
+  if (c < 0x80)
+    out += static_cast<char>(c);
+  else if (c < 0x800) {
+    out += static_cast<char>(0xC0 | (c >> 6));
+    out += static_cast<char>(0x80 | (c & 0x3F));
+  } else if (c < 0x10000) {
+    out += static_cast<char>(0xE0 | (c >> 12));
+    out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (c & 0x3F));
+  } else {
+    out += static_cast<char>(0xF0 | (c >> 18));
+    out += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+    out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (c & 0x3F));
+  }
+}
+
+void WxmxRecovery::AppendText(char32_t c) {
+  if (c == '<')
+    m_out += "&lt;";
+  else if (c == '>')
+    m_out += "&gt;";
+  else if (c == '&')
+    m_out += "&amp;";
+  else
+    AppendUtf8(m_out, c);
+}
+
+bool WxmxRecovery::IsValidReference(const std::string &name) {
+  static const char *const entities[] = {"amp", "lt", "gt", "quot", "apos"};
+  if (name.empty())
+    return false;
+  if (name[0] != '#')
+    return std::find(std::begin(entities), std::end(entities), name) != std::end(entities);
+
+  char32_t c = 0;
+  std::size_t i = 1;
+  bool hex = (name.size() > 1) && (name[1] == 'x');
+  if (hex)
+    i++;
+  if (i >= name.size())
+    return false;
+  for (; i < name.size(); i++) {
+    char digit = name[i];
+    int value;
+    if ((digit >= '0') && (digit <= '9'))
+      value = digit - '0';
+    else if (hex && (digit >= 'a') && (digit <= 'f'))
+      value = digit - 'a' + 10;
+    else if (hex && (digit >= 'A') && (digit <= 'F'))
+      value = digit - 'A' + 10;
+    else
+      return false;
+    c = c * (hex ? 16 : 10) + value;
+    if (c > 0x10FFFF)
+      return false;
+  }
+  return !(((c < 0x20) && (!IsWhitespace(c))) || ((c >= 0xD800) && (c <= 0xDFFF)) ||
+           (c == 0xFFFE) || (c == 0xFFFF));
+}
+
+void WxmxRecovery::Char(char32_t c) {
+  bool inRoot = m_rootSeen && !m_rootClosed;
+  if (c == 0x1B)
+    c = 0x238B;
+  else if (((c < 0x20) && (!IsWhitespace(c))) || ((c >= 0xD800) && (c <= 0xDFFF)) ||
+           (c == 0xFFFE) || (c == 0xFFFF) || (c > 0x10FFFF)) {
+    if (inRoot)
+      Lose(Loss::badChar, std::string(), CurrentCell());
+    c = 0xFFFD;
+  }
+
+  switch (m_state) {
+  case text:
+    if (c == '<') {
+      m_markup = "<";
+      m_quote = 0;
+      m_state = markup;
+    } else if (inRoot) {
+      if (c == '&') {
+        m_markup.clear();
+        m_state = reference;
+      } else
+        AppendText(c);
+    }
+    return;
+
+  case reference:
+    if (c == ';') {
+      if (IsValidReference(m_markup))
+        m_out += "&" + m_markup + ";";
+      else {
+        Lose(Loss::badChar, std::string(), CurrentCell());
+        m_out += "&amp;" + m_markup + ";";
+      }
+      m_state = text;
+      return;
+    }
+    // No valid reference is that long
+    if ((m_markup.size() <= 10) && (IsNameChar(c) || ((c == '#') && m_markup.empty()))) {
+      AppendUtf8(m_markup, c);
+      return;
+    }
+    // The "&" wasn't meant to start a reference.
+    m_out += "&amp;" + m_markup;
+    m_state = text;
+    Char(c);
+    return;
+
+  case markup:
+    if (m_markup.size() > MaxMarkupLength) {
+      if (inRoot) {
+        Lose(Loss::badMarkup, std::string(), CurrentCell());
+        Damage();
+      }
+      m_state = text;
+      Char(c);
+      return;
+    }
+    if (m_markup.size() == 1) {
+      if ((c == '!') || (c == '?') || (c == '/') || IsNameStart(c)) {
+        AppendUtf8(m_markup, c);
+        return;
+      }
+      // A "<" that doesn't start markup is text that should have been escaped
+      m_state = text;
+      if (inRoot) {
+        Lose(Loss::badChar, std::string(), CurrentCell());
+        AppendText('<');
+      }
+      Char(c);
+      return;
+    }
+    AppendUtf8(m_markup, c);
+    if (m_markup[1] == '!') {
+      if (StartsWith(m_markup, "<!--")) {
+        if ((m_markup.size() >= 7) && EndsWith(m_markup, "-->"))
+          Markup();
+      } else if (StartsWith(m_markup, "<![CDATA[")) {
+        if ((m_markup.size() >= 12) && EndsWith(m_markup, "]]>"))
+          Markup();
+      } else if (!IsStartOf(m_markup, "<!--") && !IsStartOf(m_markup, "<![CDATA[") &&
+                 (c == '>'))
+        Markup();
+      return;
+    }
+    if (m_markup[1] == '?') {
+      if ((m_markup.size() >= 4) && EndsWith(m_markup, "?>"))
+        Markup();
+      return;
+    }
+    // A tag
+    if (c == '<') {
+      // The tag before has been cut off.
+      if (inRoot) {
+        Lose(Loss::badMarkup, std::string(), CurrentCell());
+        Damage();
+      }
+      m_markup = "<";
+      m_quote = 0;
+      return;
+    }
+    if (m_quote != 0) {
+      if (c == m_quote)
+        m_quote = 0;
+    } else if ((c == '"') || (c == '\''))
+      m_quote = c;
+    else if (c == '>')
+      Markup();
+    return;
+  }
+}
+
+void WxmxRecovery::Markup() {
+  m_state = text;
+  bool inRoot = m_rootSeen && !m_rootClosed;
+  if (StartsWith(m_markup, "<![CDATA[")) {
+    if (inRoot)
+      for (std::size_t i = 9; i < m_markup.size() - 3; i++) {
+        char c = m_markup[i];
+        if ((c == '<') || (c == '>') || (c == '&'))
+          AppendText(static_cast<char32_t>(c));
+        else
+          m_out += c;
+      }
+  } else if (m_markup[1] == '/')
+    EndTag();
+  else if ((m_markup[1] != '!') && (m_markup[1] != '?'))
+    StartTag();
+  // Comments, processing instructions and DTDs aren't part of the worksheet.
+}
+
+void WxmxRecovery::EndTag() {
+  std::size_t i = 2;
+  std::string name;
+  while ((i < m_markup.size()) && IsNameChar(static_cast<unsigned char>(m_markup[i])))
+    name += m_markup[i++];
+  while ((i < m_markup.size()) && IsWhitespace(static_cast<unsigned char>(m_markup[i])))
+    i++;
+  if (!m_rootSeen || m_rootClosed)
+    return;
+  if (name.empty() || (i != m_markup.size() - 1)) {
+    Lose(Loss::badMarkup, std::string(), CurrentCell());
+    Damage();
+    return;
+  }
+
+  std::size_t element = m_openElements.size();
+  while ((element > 0) && (m_openElements[element - 1].name != name))
+    element--;
+  if (element == 0) {
+    Lose(Loss::strayEndTag, name, CurrentCell());
+    Damage();
+    return;
+  }
+  while (m_openElements.size() > element)
+    CloseElement(false);
+  CloseElement(true);
+}
+
+void WxmxRecovery::StartTag() {
+  std::string name;
+  std::string cleaned;
+  bool empty;
+  bool inRoot = m_rootSeen && !m_rootClosed;
+  if (!CleanStartTag(m_markup, name, cleaned, empty)) {
+    if (inRoot) {
+      Lose(Loss::badMarkup, std::string(), CurrentCell());
+      Damage();
+    }
+    return;
+  }
+
+  if (!m_rootSeen) {
+    // Everything before the document is ignored
+    if (name != "wxMaximaDocument")
+      return;
+    m_rootSeen = true;
+    m_out = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+  } else if (m_rootClosed)
+    return;
+  else if (name == "wxMaximaDocument") {
+    Lose(Loss::badMarkup, std::string(), CurrentCell());
+    Damage();
+    return;
+  } else if (name == "cell") {
+    // Cells are only found in the document or in folds. If we are somewhere
+    // else the cell before has been cut off.
+    while ((m_openElements.size() > 1) && (m_openElements.back().name != "fold"))
+      CloseElement(false);
+    if (m_openElements.size() == 1)
+      m_cells++;
+  }
+
+  OpenElement element{name, m_out.size(), m_out.size() + cleaned.size(), m_losses.size(), false};
+  m_out += cleaned;
+  if (!empty)
+    m_openElements.push_back(std::move(element));
+  else if (m_openElements.empty())
+    m_rootClosed = true;
+}
+
+void WxmxRecovery::CloseElement(bool complete) {
+  std::size_t cell = CurrentCell();
+  OpenElement element = std::move(m_openElements.back());
+  m_openElements.pop_back();
+
+  if ((element.name == "output") && (element.damaged || !complete)) {
+    m_out.resize(element.start);
+    m_losses.resize(element.losses);
+    Lose(Loss::output, element.name, cell);
+    return;
+  }
+  if (!complete) {
+    if ((element.name == "cell") && (m_out.size() == element.contentStart)) {
+      m_out.resize(element.start);
+      m_losses.resize(element.losses);
+      Lose(Loss::emptyCell, element.name, cell);
+      return;
+    }
+    Lose(Loss::unclosed, element.name, cell);
+    Damage();
+  }
+  m_out += "</" + element.name + ">";
+  if (m_openElements.empty())
+    m_rootClosed = true;
+}
+
+bool WxmxRecovery::CleanStartTag(const std::string &tag, std::string &name,
+                                 std::string &cleaned, bool &empty) const {
+  const auto at = [&tag](std::size_t i) {return static_cast<unsigned char>(tag[i]);};
+  std::size_t i = 1;
+  std::size_t const n = tag.size();
+  if ((i >= n) || !IsNameStart(at(i)))
+    return false;
+  while ((i < n) && IsNameChar(at(i)))
+    name += tag[i++];
+  cleaned = "<" + name;
+
+  std::vector<std::string> attributes;
+  while (true) {
+    bool whitespace = false;
+    while ((i < n) && IsWhitespace(at(i))) {
+      i++;
+      whitespace = true;
+    }
+    if (i >= n)
+      return false;
+    if (tag[i] == '>') {
+      empty = false;
+      cleaned += ">";
+      return i == n - 1;
+    }
+    if (tag[i] == '/') {
+      empty = true;
+      cleaned += "/>";
+      return (i + 2 == n) && (tag[i + 1] == '>');
+    }
+    if (!whitespace || !IsNameStart(at(i)))
+      return false;
+
+    std::string attribute;
+    while ((i < n) && IsNameChar(at(i)))
+      attribute += tag[i++];
+    while ((i < n) && IsWhitespace(at(i)))
+      i++;
+    if ((i >= n) || (tag[i] != '='))
+      return false;
+    i++;
+    while ((i < n) && IsWhitespace(at(i)))
+      i++;
+    if ((i >= n) || ((tag[i] != '"') && (tag[i] != '\'')))
+      return false;
+    std::size_t end = tag.find(tag[i], i + 1);
+    if (end == std::string::npos)
+      return false;
+    std::string value = tag.substr(i + 1, end - i - 1);
+    i = end + 1;
+
+    // XML doesn't allow an attribute to be set twice
+    if (std::find(attributes.begin(), attributes.end(), attribute) != attributes.end())
+      continue;
+    attributes.push_back(attribute);
+
+    cleaned += " " + attribute + "=\"";
+    for (std::size_t j = 0; j < value.size(); j++) {
+      if (value[j] == '"')
+        cleaned += "&quot;";
+      else if (value[j] == '<')
+        cleaned += "&lt;";
+      else if (value[j] == '&') {
+        std::size_t semicolon = value.find(';', j);
+        if ((semicolon != std::string::npos) && (semicolon - j <= 12) &&
+            IsValidReference(value.substr(j + 1, semicolon - j - 1)))
+          cleaned += '&';
+        else
+          cleaned += "&amp;";
+      } else
+        cleaned += value[j];
+    }
+    cleaned += "\"";
+  }
+}
@@ -0,0 +1,172 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  Declares WxmxRecovery, which recovers what it can from a damaged content.xml.
+
+  Doesn't depend on wxWidgets, so it can be tested on its own.
+*/
+
+#ifndef WXMXRECOVERY_H
+#define WXMXRECOVERY_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*! Turns a damaged content.xml into a document the XML parser can read
+
+  The recovery is fed the bytes of the damaged file in chunks of any size and
+  reads them only once. It skips everything before the \<wxMaximaDocument\>
+  tag and after its end tag and writes a well-formed copy of the rest:
+
+  - Elements that aren't closed are closed. Inputs and text therefore are
+    kept as far as the file contains them.
+  - Outputs that aren't complete and well-formed are dropped as a whole.
+  - Markup that isn't well-formed and end tags that don't belong to any
+    open element are dropped.
+  - Invalid UTF-8 and characters XML doesn't allow are replaced. The escape
+    character old wxMaxima versions wrote into content.xml becomes U+238B.
+
+  Everything that had to be dropped or repaired is reported by GetLosses().
+*/
+class WxmxRecovery
+{
+public:
+  //! Something the recovery had to drop or to repair
+  struct Loss
+  {
+    enum Kind
+    {
+      output,      //!< An incomplete output has been dropped
+      emptyCell,   //!< A cell nothing could be recovered of has been dropped
+      unclosed,    //!< An element that wasn't closed has been closed
+      strayEndTag, //!< An end tag that didn't close any open element has been dropped
+      badMarkup,   //!< Markup that wasn't well-formed has been dropped
+      badChar      //!< Characters that XML doesn't allow have been replaced
+    };
+    Kind kind;
+    //! The number of the top-level cell this happened in, counting from 1. 0 = outside of any cell.
+    std::size_t cell;
+    //! The name of the element this happened to, if it concerns an element
+    std::string element;
+    //! How often this happened in a row
+    std::size_t count;
+  };
+
+  //! Reads the next part of the damaged document
+  void Feed(const char *data, std::size_t length);
+  void Feed(const std::string &data) { Feed(data.data(), data.size()); }
+  /*! Tells that the damaged document has ended
+
+    \return The recovered document, or an empty string if the damaged one
+    didn't contain a \<wxMaximaDocument\> tag.
+  */
+  std::string Finish();
+  //! What has been dropped or repaired, in the order it appeared in the file
+  const std::vector<Loss> &GetLosses() const { return m_losses; }
+
+  //! Markup that is longer than this is considered as garbage
+  static constexpr std::size_t MaxMarkupLength = 1 << 20;
+
+private:
+  enum State
+  {
+    text,      //!< Outside of any markup
+    markup,    //!< After a "<"
+    reference  //!< After a "&" in text
+  };
+  //! An element that is open in the recovered document
+  struct OpenElement
+  {
+    std::string name;
+    //! Where the element's start tag begins in m_out
+    std::size_t start;
+    //! Where the element's contents begin in m_out
+    std::size_t contentStart;
+    //! The number of losses that were known when the element started
+    std::size_t losses;
+    //! Has something inside the element been dropped or repaired?
+    bool damaged;
+  };
+
+  //! Processes the next character of the damaged document
+  void Char(char32_t c);
+  //! Processes a complete piece of markup that starts with "<"
+  void Markup();
+  //! Processes a start tag
+  void StartTag();
+  //! Processes an end tag
+  void EndTag();
+  //! Closes the innermost open element
+  void CloseElement(bool complete);
+  /*! Converts a start tag into a well-formed one
+
+    \return false, if the tag is too badly damaged for that.
+  */
+  bool CleanStartTag(const std::string &tag, std::string &name, std::string &cleaned,
+                     bool &empty) const;
+  //! Records a loss
+  void Lose(Loss::Kind kind, const std::string &element, std::size_t cell);
+  //! The number of the top-level cell we are in, or 0
+  std::size_t CurrentCell() const;
+  //! Marks the open output, if there is one, as damaged
+  void Damage();
+  //! Appends a character to text, escaping it if necessary
+  void AppendText(char32_t c);
+  //! Is this the text between "&" and ";" of a valid reference?
+  static bool IsValidReference(const std::string &name);
+  static void AppendUtf8(std::string &out, char32_t c);
+  static bool IsWhitespace(char32_t c)
+    { return (c == ' ') || (c == '\t') || (c == '\n') || (c == '\r'); }
+  static bool IsNameStart(char32_t c)
+    {
+      return ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) ||
+        (c == '_') || (c == ':') || (c >= 0x80);
+    }
+  static bool IsNameChar(char32_t c)
+    { return IsNameStart(c) || ((c >= '0') && (c <= '9')) || (c == '-') || (c == '.'); }
+
+  State m_state = text;
+  //! The markup or the reference we are reading
+  std::string m_markup;
+  //! The quote the attribute value we are in is enclosed in, or 0
+  char32_t m_quote = 0;
+  //! The recovered document
+  std::string m_out;
+  std::vector<OpenElement> m_openElements;
+  std::vector<Loss> m_losses;
+  //! Has the \<wxMaximaDocument\> tag been found?
+  bool m_rootSeen = false;
+  //! Has the \<wxMaximaDocument\> element ended?
+  bool m_rootClosed = false;
+  //! The number of top-level cells that have been started
+  std::size_t m_cells = 0;
+
+  //! The number of continuation bytes the current UTF-8 sequence still needs
+  int m_utf8Pending = 0;
+  //! The part of the current UTF-8 sequence we have decoded
+  char32_t m_codePoint = 0;
+  //! The smallest code point the current UTF-8 sequence may encode
+  char32_t m_minCodePoint = 0;
+};
+
+#endif // WXMXRECOVERY_H
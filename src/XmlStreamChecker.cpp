@@ -0,0 +1,371 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  Defines XmlStreamChecker, which tests if a stream of UTF-8 bytes is well-formed XML.
+*/
+
+#include "XmlStreamChecker.h"
+
+bool XmlStreamChecker::Error(const std::string &message) {
+  if (m_error.empty()) {
+    m_error = message;
+    m_errorOffset = m_offset;
+  }
+  return false;
+}
+
+bool XmlStreamChecker::Feed(const char *data, std::size_t length) {
+  if (!IsOk())
+    return false;
+  for (std::size_t i = 0; i < length; i++, m_offset++) {
+    unsigned char byte = static_cast<unsigned char>(data[i]);
+    if (m_utf8Pending > 0) {
+      if ((byte & 0xC0) != 0x80)
+        return Error("Incomplete UTF-8 sequence");
+      m_codePoint = (m_codePoint << 6) | (byte & 0x3F);
+      if (--m_utf8Pending > 0)
+        continue;
+      if (m_codePoint < m_minCodePoint)
+        return Error("Overlong UTF-8 sequence");
+      if (!Char(m_codePoint))
+        return false;
+      continue;
+    }
+    if (byte < 0x80) {
+      if (!Char(byte))
+        return false;
+      continue;
+    }
+    if ((byte >= 0xC2) && (byte <= 0xDF)) {
+      m_utf8Pending = 1;
+      m_codePoint = byte & 0x1F;
+      m_minCodePoint = 0x80;
+    } else if ((byte >= 0xE0) && (byte <= 0xEF)) {
+      m_utf8Pending = 2;
+      m_codePoint = byte & 0x0F;
+      m_minCodePoint = 0x800;
+    } else if ((byte >= 0xF0) && (byte <= 0xF4)) {
+      m_utf8Pending = 3;
+      m_codePoint = byte & 0x07;
+      m_minCodePoint = 0x10000;
+    } else
+      return Error("Invalid UTF-8 byte");
+  }
+  return true;
+}
+
+bool XmlStreamChecker::Finish() {
+  if (!IsOk())
+    return false;
+  if (m_utf8Pending > 0)
+    return Error("The document ends inside a UTF-8 sequence");
+  if (m_state != text)
+    return Error("The document ends inside markup");
+  if (!m_openElements.empty())
+    return Error("The document ends before all elements have been closed");
+  if (!m_rootSeen)
+    return Error("The document has no root element");
+  return true;
+}
+
+bool XmlStreamChecker::OpenElement() {
+  if (m_openElements.empty()) {
+    if (m_rootSeen)
+      return Error("More than one root element");
+    m_rootSeen = true;
+  }
+  m_openElements.push_back(m_name);
+  m_attributeNames.clear();
+  return true;
+}
+
+bool XmlStreamChecker::AttributeNameComplete() {
+  for (const auto &name : m_attributeNames)
+    if (name == m_attributeName)
+      return Error("Duplicate attribute in a tag");
+  m_attributeNames.push_back(m_attributeName);
+  return true;
+}
+
+bool XmlStreamChecker::CloseElement() {
+  if (m_openElements.empty() || (m_openElements.back() != m_name))
+    return Error("End tag doesn't match the start tag");
+  m_openElements.pop_back();
+  m_state = text;
+  return true;
+}
+
+bool XmlStreamChecker::Reference() {
+  static const std::u32string entities[] = {U"amp", U"lt", U"gt", U"quot", U"apos"};
+  if (m_name.empty())
+    return Error("Empty reference");
+  if (m_name[0] != '#') {
+    for (const auto &entity : entities)
+      if (m_name == entity)
+        return true;
+    return Error("Unknown entity");
+  }
+
+  char32_t c = 0;
+  std::size_t i = 1;
+  bool hex = (m_name.size() > 1) && (m_name[1] == 'x');
+  if (hex)
+    i++;
+  if (i >= m_name.size())
+    return Error("Empty character reference");
+  for (; i < m_name.size(); i++) {
+    char32_t digit = m_name[i];
+    int value;
+    if ((digit >= '0') && (digit <= '9'))
+      value = digit - '0';
+    else if (hex && (digit >= 'a') && (digit <= 'f'))
+      value = digit - 'a' + 10;
+    else if (hex && (digit >= 'A') && (digit <= 'F'))
+      value = digit - 'A' + 10;
+    else
+      return Error("Invalid character reference");
+    c = c * (hex ? 16 : 10) + value;
+    if (c > 0x10FFFF)
+      return Error("Character reference out of range");
+  }
+  if (((c < 0x20) && (!IsWhitespace(c))) || ((c >= 0xD800) && (c <= 0xDFFF)) ||
+      (c == 0xFFFE) || (c == 0xFFFF))
+    return Error("Character reference to a character XML doesn't allow");
+  return true;
+}
+
+bool XmlStreamChecker::Char(char32_t c) {
+  if (((c < 0x20) && (!IsWhitespace(c))) || ((c >= 0xD800) && (c <= 0xDFFF)) ||
+      (c == 0xFFFE) || (c == 0xFFFF) || (c > 0x10FFFF))
+    return Error("Character XML doesn't allow");
+
+  switch (m_state) {
+  case text:
+    if (c == '<') {
+      m_state = markup;
+      m_run = 0;
+      return true;
+    }
+    if (m_openElements.empty()) {
+      if (!IsWhitespace(c))
+        return Error("Text outside of the root element");
+      return true;
+    }
+    if (c == '&') {
+      m_name.clear();
+      m_referenceReturn = text;
+      m_state = reference;
+      return true;
+    }
+    // "]]>" is only allowed at the end of a CDATA section
+    if (c == ']')
+      m_run++;
+    else {
+      if ((c == '>') && (m_run >= 2))
+        return Error("\"]]>\" in text");
+      m_run = 0;
+    }
+    return true;
+
+  case markup:
+    m_name.clear();
+    if (c == '/')
+      m_state = endTagName;
+    else if (c == '!')
+      m_state = markupDeclaration;
+    else if (c == '?') {
+      m_previous = 0;
+      m_state = processingInstruction;
+    } else if (IsNameStart(c)) {
+      m_name += c;
+      m_state = startTagName;
+    } else
+      return Error("Invalid character after \"<\"");
+    return true;
+
+  case startTagName:
+    if (IsNameChar(c)) {
+      m_name += c;
+      return true;
+    }
+    if (!OpenElement())
+      return false;
+    if (IsWhitespace(c))
+      m_state = inTag;
+    else if (c == '>')
+      m_state = text;
+    else if (c == '/')
+      m_state = emptyElementEnd;
+    else
+      return Error("Invalid character in a tag name");
+    return true;
+
+  case emptyElementEnd:
+    if (c != '>')
+      return Error("Expected \">\" after \"/\"");
+    m_openElements.pop_back();
+    m_state = text;
+    return true;
+
+  case inTag:
+  case afterAttributeValue:
+    if (IsWhitespace(c))
+      m_state = inTag;
+    else if (c == '>')
+      m_state = text;
+    else if (c == '/')
+      m_state = emptyElementEnd;
+    else if (IsNameStart(c) && (m_state == inTag)) {
+      m_attributeName.assign(1, c);
+      m_state = attributeName;
+    } else
+      return Error("Invalid character in a tag");
+    return true;
+
+  case attributeName:
+    if (IsNameChar(c)) {
+      m_attributeName += c;
+      return true;
+    }
+    if (!AttributeNameComplete())
+      return false;
+    if (IsWhitespace(c))
+      m_state = afterAttributeName;
+    else if (c == '=')
+      m_state = beforeAttributeValue;
+    else
+      return Error("Invalid character in an attribute name");
+    return true;
+
+  case afterAttributeName:
+    if (c == '=')
+      m_state = beforeAttributeValue;
+    else if (!IsWhitespace(c))
+      return Error("Expected \"=\" after an attribute name");
+    return true;
+
+  case beforeAttributeValue:
+    if ((c == '"') || (c == '\'')) {
+      m_quote = c;
+      m_state = attributeValue;
+    } else if (!IsWhitespace(c))
+      return Error("Attribute value without quotes");
+    return true;
+
+  case attributeValue:
+    if (c == m_quote)
+      m_state = afterAttributeValue;
+    else if (c == '<')
+      return Error("\"<\" in an attribute value");
+    else if (c == '&') {
+      m_name.clear();
+      m_referenceReturn = attributeValue;
+      m_state = reference;
+    }
+    return true;
+
+  case endTagName:
+    if (IsNameStart(c) || ((!m_name.empty()) && IsNameChar(c))) {
+      m_name += c;
+      return true;
+    }
+    if (m_name.empty())
+      return Error("Invalid character in an end tag");
+    if (IsWhitespace(c)) {
+      m_state = afterEndTagName;
+      return true;
+    }
+    if (c == '>')
+      return CloseElement();
+    return Error("Invalid character in an end tag");
+
+  case afterEndTagName:
+    if (c == '>')
+      return CloseElement();
+    if (!IsWhitespace(c))
+      return Error("Invalid character in an end tag");
+    return true;
+
+  case reference:
+    if (c == ';') {
+      m_state = m_referenceReturn;
+      m_run = 0;
+      return Reference();
+    }
+    // No valid reference is that long
+    if ((m_name.size() > 10) || !(IsNameChar(c) || ((c == '#') && m_name.empty())))
+      return Error("Invalid reference");
+    m_name += c;
+    return true;
+
+  case markupDeclaration: {
+    static const std::u32string commentStart = U"--";
+    static const std::u32string cdataStart = U"[CDATA[";
+    m_name += c;
+    if (m_name == commentStart) {
+      m_run = 0;
+      m_state = comment;
+    } else if (m_name == cdataStart) {
+      if (m_openElements.empty())
+        return Error("CDATA section outside of the root element");
+      m_run = 0;
+      m_state = cdata;
+    } else if ((commentStart.compare(0, m_name.size(), m_name) != 0) &&
+               (cdataStart.compare(0, m_name.size(), m_name) != 0))
+      return Error("Unsupported markup declaration");
+    return true;
+  }
+
+  case comment:
+    if (c == '-') {
+      if (++m_run > 2)
+        return Error("\"--\" in a comment");
+    } else if (m_run == 2) {
+      if (c != '>')
+        return Error("\"--\" in a comment");
+      m_state = text;
+      m_run = 0;
+    } else
+      m_run = 0;
+    return true;
+
+  case cdata:
+    if (c == ']')
+      m_run++;
+    else {
+      if ((c == '>') && (m_run >= 2)) {
+        m_state = text;
+        m_run = 0;
+        return true;
+      }
+      m_run = 0;
+    }
+    return true;
+
+  case processingInstruction:
+    if ((c == '>') && (m_previous == '?'))
+      m_state = text;
+    m_previous = c;
+    return true;
+  }
+  return true;
+}
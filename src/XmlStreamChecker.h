@@ -0,0 +1,147 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  Declares XmlStreamChecker, which tests if a stream of UTF-8 bytes is well-formed XML.
+
+  Doesn't depend on wxWidgets, so it can be tested on its own.
+*/
+
+#ifndef XMLSTREAMCHECKER_H
+#define XMLSTREAMCHECKER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*! Tests if a document is well-formed XML while it is being written
+
+  Parsing the whole .wxmx document into a DOM before saving it needs several
+  times the memory of the document. This checker instead is fed the bytes of
+  the document in chunks of any size and only remembers the names of the
+  elements that are open. It checks:
+
+  - that the text is valid UTF-8 and contains no characters XML forbids,
+  - that all tags, attributes, comments, CDATA sections and processing
+    instructions are well-formed and that no tag contains an attribute twice,
+  - that all entity references are known and all character references are
+    valid characters,
+  - that every element is closed in the right order and that there is exactly
+    one root element.
+
+  DTDs aren't supported: wxMaxima never writes them.
+*/
+class XmlStreamChecker
+{
+public:
+  /*! Checks the next part of the document
+
+    \return false, if the document isn't well-formed. Once an error has been
+    found all further input is ignored.
+  */
+  bool Feed(const char *data, std::size_t length);
+  bool Feed(const std::string &data) { return Feed(data.data(), data.size()); }
+  //! Tells that the document is complete. Returns true if it was well-formed.
+  bool Finish();
+  //! Has no error been found, yet?
+  bool IsOk() const { return m_error.empty(); }
+  //! A description of the first error, or an empty string
+  const std::string &GetError() const { return m_error; }
+  //! The position [in bytes from the start of the document] of the first error
+  std::size_t GetErrorOffset() const { return m_errorOffset; }
+
+private:
+  enum State
+  {
+    text,                  //!< Outside of any markup
+    markup,                //!< After a "<"
+    startTagName,
+    emptyElementEnd,       //!< After the "/" of a "<tag/>"
+    inTag,                 //!< Between the attributes of a start tag
+    attributeName,
+    afterAttributeName,
+    beforeAttributeValue,  //!< After the "="
+    attributeValue,
+    afterAttributeValue,
+    endTagName,
+    afterEndTagName,
+    reference,             //!< After a "&"
+    markupDeclaration,     //!< After a "<!"
+    comment,
+    cdata,
+    processingInstruction
+  };
+  //! Checks the next character of the document
+  bool Char(char32_t c);
+  //! Checks the name of an entity or character reference
+  bool Reference();
+  //! Records an error
+  bool Error(const std::string &message);
+  //! Starts an element named m_name
+  bool OpenElement();
+  //! Ends the element named m_name
+  bool CloseElement();
+  //! Adds m_attributeName to the attributes of the current start tag
+  bool AttributeNameComplete();
+  static bool IsWhitespace(char32_t c)
+    { return (c == ' ') || (c == '\t') || (c == '\n') || (c == '\r'); }
+  static bool IsNameStart(char32_t c)
+    {
+      return ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) ||
+        (c == '_') || (c == ':') || (c >= 0x80);
+    }
+  static bool IsNameChar(char32_t c)
+    { return IsNameStart(c) || ((c >= '0') && (c <= '9')) || (c == '-') || (c == '.'); }
+
+  State m_state = text;
+  //! The state to return to after a reference
+  State m_referenceReturn = text;
+  //! The name of the tag or the reference we are reading, or the start of a markup declaration
+  std::u32string m_name;
+  //! The elements that are open, the innermost one last
+  std::vector<std::u32string> m_openElements;
+  //! The name of the attribute we are reading
+  std::u32string m_attributeName;
+  //! The names of the attributes of the current start tag
+  std::vector<std::u32string> m_attributeNames;
+  //! Has the root element been started?
+  bool m_rootSeen = false;
+  //! The quote the current attribute value is enclosed in
+  char32_t m_quote = 0;
+  //! Counts the "-" at the end of a comment or the "]" at the end of a CDATA section
+  int m_run = 0;
+  //! The char before the current one in a processing instruction
+  char32_t m_previous = 0;
+
+  //! The number of continuation bytes the current UTF-8 sequence still needs
+  int m_utf8Pending = 0;
+  //! The part of the current UTF-8 sequence we have decoded
+  char32_t m_codePoint = 0;
+  //! The smallest code point the current UTF-8 sequence may encode
+  char32_t m_minCodePoint = 0;
+
+  //! The number of bytes we have checked
+  std::size_t m_offset = 0;
+  std::string m_error;
+  std::size_t m_errorOffset = 0;
+};
+
+#endif // XMLSTREAMCHECKER_H
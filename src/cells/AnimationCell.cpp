@@ -35,7 +35,9 @@
 #include "CellPointers.h"
 #include "ImgCell.h"
 #include "StringUtils.h"
+#include "ThreadPool.h"
 
+#include <algorithm>
 #include <memory>
 #include <wx/anidecod.h>
 #include <wx/clipbrd.h>
@@ -45,6 +47,7 @@
 #include <wx/fs_mem.h>
 #include <wx/imaggif.h>
 #include <wx/mstream.h>
+#include <wx/progdlg.h>
 #include <wx/quantize.h>
 #include <wx/utils.h>
 #include <wx/wfstream.h>
@@ -226,6 +229,52 @@ void AnimationCell::SetDisplayedIndex(int ind) {
     m_displayed = Length() - 1;
   if (m_displayed < 0)
     m_displayed = 0;
+  PrefetchFrames();
+}
+
+int AnimationCell::LookAhead() const {
+  // Until we know better we assume that scaling a frame takes one frame period
+  int lookAhead = 2;
+  long scalingTime = m_images.at(m_displayed)->GetScalingTime();
+  if (scalingTime >= 0)
+    lookAhead = 1 + (scalingTime * GetFrameRate() + 999) / 1000;
+  if (lookAhead > MaxLookAhead)
+    lookAhead = MaxLookAhead;
+  if (lookAhead > Length() - 1)
+    lookAhead = Length() - 1;
+  return lookAhead;
+}
+
+void AnimationCell::PrefetchFrames() {
+  if ((!IsOk()) || m_configuration->GetPrinting() || m_configuration->IsTemporary())
+    return;
+  std::vector<int> frames;
+  frames.push_back(m_displayed);
+  int lookAhead = LookAhead();
+  for (int i = 1; i <= lookAhead; i++)
+    frames.push_back((m_displayed + i) % Length());
+
+  for (auto frame : m_residentFrames)
+    if ((frame < Length()) && m_images[frame] &&
+        (std::find(frames.begin(), frames.end(), frame) == frames.end())) {
+      m_images[frame]->CancelPrefetch();
+      m_images[frame]->ClearCache();
+    }
+  m_residentFrames = frames;
+
+  // The frames are queued in the order they will be displayed in.
+  for (auto frame = frames.begin() + 1; frame != frames.end(); ++frame)
+    if (m_images[*frame])
+      m_images[*frame]->Prefetch(ThreadPool::prefetch);
+}
+
+void AnimationCell::ReleasePrefetchedFrames() {
+  for (auto frame : m_residentFrames)
+    if ((frame != m_displayed) && (frame < Length()) && m_images[frame]) {
+      m_images[frame]->CancelPrefetch();
+      m_images[frame]->ClearCache();
+    }
+  m_residentFrames.clear();
 }
 
 wxCoord AnimationCell::GetMaxWidth() const {
@@ -265,6 +314,8 @@ void AnimationCell::Recalculate(AFontSize fontsize) {
                          PRINT_SIZE_MULTIPLIER);
         } else {
           i->Recalculate();
+          if (i->IsLoading())
+            m_cellPointers->WaitForImage(GetGroup());
         }
         if (m_width < i->m_width + 2 * m_imageBorderWidth)
           m_width = i->m_width + 2 * m_imageBorderWidth;
@@ -306,11 +357,24 @@ void AnimationCell::Draw(wxPoint point, wxDC *dc, wxDC *antialiassingDC) {
       dc->SetPen(*wxRED_PEN);
     dc->DrawRectangle(wxRect(point.x, point.y - m_center, m_width, m_height));
 
-    wxBitmap bitmap =
-      (m_configuration->GetPrinting()
-       ? m_images.at(m_displayed)->GetBitmap(
-                                             m_configuration->GetZoomFactor() * PRINT_SIZE_MULTIPLIER)
-       : m_images.at(m_displayed)->GetBitmap());
+    const auto &image = m_images.at(m_displayed);
+    wxBitmap bitmap;
+    if (m_configuration->GetPrinting())
+      bitmap = image->GetBitmap(m_configuration->GetZoomFactor() * PRINT_SIZE_MULTIPLIER);
+    else {
+      PrefetchFrames();
+      // If a frame isn't scaled in time showing the last frame a bit longer
+      // looks better than showing a blurry preview.
+      if (m_animationRunning && m_lastDrawnBitmap.IsOk() &&
+          (m_lastDrawnBitmap.GetSize() == wxSize(image->m_width, image->m_height)) &&
+          (!image->ScaledBitmapReady())) {
+        image->Prefetch(ThreadPool::visible);
+        image->TouchCache();
+        bitmap = m_lastDrawnBitmap;
+      }
+      else
+        bitmap = m_lastDrawnBitmap = image->GetBitmap();
+    }
     bitmapDC.SelectObject(bitmap);
 
     int imageBorderWidth = m_imageBorderWidth;
@@ -325,12 +389,7 @@ void AnimationCell::Draw(wxPoint point, wxDC *dc, wxDC *antialiassingDC) {
              m_width - 2 * imageBorderWidth, m_height - 2 * imageBorderWidth,
              &bitmapDC, imageBorderWidth - m_imageBorderWidth,
              imageBorderWidth - m_imageBorderWidth);
-  } else
-    {
-      // The cell isn't drawn => No need to keep it's image cache for now.
-      if(!GetRect().Intersects(m_configuration->GetVisibleRegion()))
-        ClearCache();
-    }
+  }
 
   // If we need a selection border on another redraw we will be informed by
   // OnPaint() again.
@@ -471,44 +530,112 @@ const wxString AnimationCell::GetToolTip(const wxPoint point) const {
   return GetLocalToolTip();
 }
 
-wxSize AnimationCell::ToGif(wxString file) {
-  if (!IsOk())
-    return wxSize(1, 1);
+//! Reduces a frame to the colors and the transparency a gif file supports
+static void QuantizeGifFrame(const wxImage &image, wxImage &frame) {
+  // Reduce the frame to at most 256 colors
+  wxQuantize::Quantize(image, frame);
+  // Gif supports only fully transparent or not transparent at all.
+  frame.ConvertAlphaToMask();
+}
 
+bool AnimationCell::SaveGif(wxOutputStream &stream) {
   // Show a busy cursor as long as we export a .gif file (which might be a
   // lengthy action).
   wxBusyCursor crs;
+  wxProgressDialog progress(_("Animated gif"), _("Converting the frames..."),
+                            2 * Length(), m_cellPointers->GetWorksheet(),
+                            wxPD_APP_MODAL | wxPD_AUTO_HIDE | wxPD_CAN_ABORT |
+                            wxPD_ELAPSED_TIME | wxPD_REMAINING_TIME);
+
+  // Bitmaps can only be created in the GUI thread: The frames are converted
+  // to images here and quantized in parallel.
+  std::vector<wxImage> frames(m_images.size());
+  std::vector<ThreadPool::Task> tasks;
+  ThreadPool::CancellationToken cancel;
+  bool cancelled = false;
+  for (std::size_t i = 0; (i < m_images.size()) && (!cancelled); i++) {
+    // wxImage's reference counting isn't thread-safe: Only the task may
+    // access the image.
+    auto image =
+      std::make_shared<wxImage>(m_images[i]->GetUnscaledBitmap().ConvertToImage());
+    wxImage *frame = &frames[i];
+    if (m_configuration->UseThreads())
+      tasks.push_back(ThreadPool::Get().Submit(ThreadPool::visible, [image, frame] {
+        QuantizeGifFrame(*image, *frame);
+      }, cancel));
+    else
+      QuantizeGifFrame(*image, *frame);
+    cancelled = !progress.Update(static_cast<int>(i + 1));
+  }
 
-  wxImageArray gifFrames;
+  // The frames are collected in order as soon as they are ready.
+  for (std::size_t i = 0; (i < tasks.size()) && (!cancelled); i++) {
+    tasks[i].Wait();
+    cancelled = !progress.Update(static_cast<int>(m_images.size() + i + 1));
+  }
+  if (cancelled) {
+    cancel.Cancel();
+    for (auto &task : tasks)
+      task.Wait();
+    return false;
+  }
 
-  for (const auto &i: m_images) {
-    wxImage frame;
-    // Reduce the frame to at most 256 colors
-    wxQuantize::Quantize(i->GetUnscaledBitmap().ConvertToImage(),
-                         frame);
-    // Gif supports only fully transparent or not transparent at all.
-    frame.ConvertAlphaToMask();
+  wxImageArray gifFrames;
+  for (const auto &frame : frames)
     gifFrames.Add(frame);
-  }
+  wxGIFHandler gif;
+  return gif.SaveAnimation(gifFrames, &stream, true, 1000 / GetFrameRate());
+}
 
-  wxFile fl(file, wxFile::write);
-  if (fl.IsOpened()) {
-    wxFileOutputStream outStream(fl);
-    if (outStream.IsOk()) {
-      wxGIFHandler gif;
+wxSize AnimationCell::ToGif(wxString file) {
+  if (!IsOk())
+    return wxSize(1, 1);
 
-      if (gif.SaveAnimation(gifFrames, &outStream, true, 1000 / GetFrameRate()))
-        return wxSize(m_images[1]->GetOriginalWidth(),
-                      m_images[1]->GetOriginalHeight());
+  // The gif is written to a temp file first, so a failed or cancelled
+  // export never leaves a truncated file behind under the real name.
+  wxString tempFile = file + wxS("~");
+  bool ok = false;
+  {
+    wxFile fl(tempFile, wxFile::write);
+    if (fl.IsOpened()) {
+      wxFileOutputStream outStream(fl);
+      ok = outStream.IsOk() && SaveGif(outStream) && outStream.Close();
     }
   }
-  return wxSize(-1, -1);
+  if (ok)
+    ok = wxRenameFile(tempFile, file, true);
+  if (!ok) {
+    if (wxFileExists(tempFile))
+      wxRemoveFile(tempFile);
+    return wxSize(-1, -1);
+  }
+  return wxSize(m_images[1]->GetOriginalWidth(),
+                m_images[1]->GetOriginalHeight());
 }
 
 void AnimationCell::ClearCache() {
   for (auto &i: m_images)
     if (i != NULL)
       i->ClearCache();
+  m_residentFrames.clear();
+  m_lastDrawnBitmap = wxBitmap();
+}
+
+void AnimationCell::TouchCache() {
+  if (IsOk())
+    m_images.at(m_displayed)->TouchCache();
+  for (auto frame : m_residentFrames)
+    if ((frame != m_displayed) && (frame < Length()) && m_images[frame])
+      m_images[frame]->TouchCache();
+}
+
+void AnimationCell::SetViewportDistance(double screens) {
+  if (!IsOk())
+    return;
+  m_images.at(m_displayed)->SetViewportDistance(screens);
+  // Animations that aren't about to be shown don't need their next frames.
+  if (screens > Image::PrefetchDistance)
+    ReleasePrefetchedFrames();
 }
 
 AnimationCell::GifDataObject::GifDataObject(const wxMemoryOutputStream &str)
@@ -547,28 +674,12 @@ bool AnimationCell::CopyAnimationToClipboard() {
   if (!IsOk())
     return false;
 
-  if (wxTheClipboard->Open()) {
-    // Show a busy cursor as long as we export a .gif file (which might be a
-    // lengthy action).
-    wxBusyCursor crs;
-
-    wxImageArray gifFrames;
-
-    for (auto &i: m_images) {
-      wxImage frame;
-      // Reduce the frame to at most 256 colors
-      wxQuantize::Quantize(i->GetUnscaledBitmap().ConvertToImage(),
-                           frame);
-      // Gif supports only fully transparent or not transparent at all.
-      frame.ConvertAlphaToMask();
-      gifFrames.Add(frame);
-    }
-
-    wxMemoryOutputStream stream;
-    wxGIFHandler gif;
-    if (!gif.SaveAnimation(gifFrames, &stream, true, 1000 / GetFrameRate()))
-      return false;
+  // The clipboard isn't kept open while the frames are converted.
+  wxMemoryOutputStream stream;
+  if (!SaveGif(stream))
+    return false;
 
+  if (wxTheClipboard->Open()) {
     GifDataObject *clpbrdObj = new GifDataObject(stream);
     bool res = wxTheClipboard->SetData(clpbrdObj);
     wxTheClipboard->Close();
@@ -79,6 +79,8 @@ public:
   const CellTypeInfo &GetInfo() override;
   virtual ~AnimationCell();
   int Length() const {return m_images.size();}
+  //! The compressed data of a frame, as it has been read from the file
+  wxMemoryBuffer GetCompressedFrame(int frame) const {return m_images.at(frame)->GetCompressedImage();}
   void LoadImages(wxMemoryBuffer imageData);
   void LoadImages(wxString imageFile);
   //! Set the animation's resolution
@@ -112,6 +114,12 @@ public:
   */
   void ClearCache() override;
 
+  //! Keeps the scaled images of the displayed and the next frames from being evicted
+  void TouchCache() override;
+
+  //! Only the frame that is displayed is scaled in advance
+  void SetViewportDistance(double screens) override;
+
   void LoadImages(wxArrayString images, bool deleteRead);
 
   int GetDisplayedIndex() const { return m_displayed; }
@@ -132,6 +140,14 @@ public:
   //! Put the animation on the clipboard.
   bool CopyAnimationToClipboard();
 
+  /*! Writes the whole animation as animated gif to a stream
+
+    The frames are quantized in parallel. Shows a progress dialog that allows
+    to cancel the conversion.
+    \return false, if the conversion has failed or has been cancelled.
+  */
+  bool SaveGif(wxOutputStream &stream);
+
   /*! Get the frame rate of this AnimationCell [in Hz].
 
     Returns either the frame rate set for this slide show cell individually or
@@ -194,6 +210,27 @@ private:
   int m_framerate = -1;
   int m_displayed = 0;
   int m_imageBorderWidth = 0;
+  //! The frames whose scaled images we keep: The displayed one and the next ones
+  std::vector<int> m_residentFrames;
+  //! The bitmap we have drawn last, drawn again if the next frame isn't scaled in time
+  wxBitmap m_lastDrawnBitmap;
+  //! The maximum number of frames that are scaled ahead of the displayed one
+  static constexpr int MaxLookAhead = 8;
+
+  /*! The number of frames that are to be scaled ahead of the displayed one
+
+    The frames are scaled in parallel. Scaling as many frames as are displayed
+    while one frame is scaled keeps up with the frame rate.
+  */
+  int LookAhead() const;
+  /*! Scales the next frames in the background and frees the scaled images of the others
+
+    Only the compressed images of the frames that are neither displayed nor
+    displayed next are kept in memory.
+  */
+  void PrefetchFrames();
+  //! Frees the scaled images of all frames but the displayed one
+  void ReleasePrefetchedFrames();
 
 //** Bitfield objects (1 bytes)
 //**
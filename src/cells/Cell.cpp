@@ -213,6 +213,16 @@ void Cell::ClearCacheList() {
     tmp.ClearCache();
 }
 
+void Cell::TouchCacheList() {
+  for (Cell &tmp : OnList(this))
+    tmp.TouchCache();
+}
+
+void Cell::SetViewportDistanceList(double screens) {
+  for (Cell &tmp : OnList(this))
+    tmp.SetViewportDistance(screens);
+}
+
 unsigned long Cell::CellsInListRecursive() const {
   //! The number of cells the current group contains (-1, if no GroupCell)
   unsigned cells = 0;
@@ -960,28 +970,33 @@ void Cell::SelectRectText(wxPoint WXUNUSED(one), wxPoint WXUNUSED(two)) {}
 void Cell::PasteFromClipboard(bool WXUNUSED(primary)) {}
 
 wxString Cell::ListToXML() const {
-  bool highlight = false;
   wxString retval;
+  ListToXML([&retval](const wxString &xml) { retval += xml; });
+  return retval;
+}
+
+void Cell::ListToXML(const std::function<void(const wxString &xml)> &write) const {
+  bool highlight = false;
 
   for (const Cell &tmp : OnList(this)) {
+    wxString xml;
     if ((tmp.GetHighlight()) && (!highlight)) {
-      retval += wxS("<hl boxname=\"highlight\">\n");
+      xml += wxS("<hl boxname=\"highlight\">\n");
       highlight = true;
     }
 
     if ((!tmp.GetHighlight()) && (highlight)) {
-      retval += wxS("</hl>\n");
+      xml += wxS("</hl>\n");
       highlight = false;
     }
 
-    retval += tmp.ToXML();
+    xml += tmp.ToXML();
+    write(xml);
   }
 
   if (highlight) {
-    retval += wxS("</hl>\n");
+    write(wxS("</hl>\n"));
   }
-
-  return retval;
 }
 
 wxString Cell::GetDiffPart() const {
@@ -41,6 +41,7 @@
 #include <wx/access.h>
 #endif // wxUSE_ACCESSIBILITY
 #include <algorithm>
+#include <functional>
 #include <map>
 #include <memory>
 #include <vector>
@@ -297,6 +298,29 @@ public:
     For details see ClearCache().
   */
   void ClearCacheList();
+
+  /*! Tells the image cache that the cached items of this cell are on the screen
+
+    Keeps ImageCacheBudget from clearing them in order to save memory.
+  */
+  virtual void TouchCache()
+    {}
+
+  /*! Calls TouchCache() for the whole list of cells starting with this one.
+   */
+  void TouchCacheList();
+
+  /*! Tells the cell how far it is away from the visible part of the worksheet
+
+    \param screens The distance in screen heights; 0 means: The cell is visible.
+    Allows images to be scaled before they are scrolled into view.
+  */
+  virtual void SetViewportDistance(double WXUNUSED(screens))
+    {}
+
+  /*! Calls SetViewportDistance() for the whole list of cells starting with this one.
+   */
+  void SetViewportDistanceList(double screens);
   //! Tell this cell list to use the configuration object config
   void SetConfigurationList(Configuration *config);
   //! Tell this cell to use the configuration object config
@@ -614,6 +638,14 @@ public:
   virtual wxString ListToTeX() const;
   //! Convert this list to a representation fit for saving in a .wxmx file
   virtual wxString ListToXML() const;
+  /*! Convert this list to a representation fit for saving in a .wxmx file, piece by piece
+
+    \param write is called with the XML of each cell, including the highlight
+    tags in front of it, and with the highlight tag that closes the list, if
+    there is one. This way the XML of a long list never has to be held in
+    memory as a whole.
+  */
+  void ListToXML(const std::function<void(const wxString &xml)> &write) const;
 
   //! Convert this list to a MathML representation
   virtual wxString ListToMathML(bool startofline = false) const;
@@ -37,6 +37,7 @@
 #include "wxMaxima.h"
 #include "wxMaximaFrame.h"
 #include <algorithm>
+#include <iterator>
 #include <wx/clipbrd.h>
 #include <wx/regex.h>
 #include <wx/tokenzr.h>
@@ -572,12 +573,18 @@ bool EditorCell::NeedsRecalculation(AFontSize fontSize) const {
 void EditorCell::Recalculate(AFontSize fontsize) {
   if(NeedsRecalculation(fontsize))
     {
+      // If only the text has changed the widths of the unchanged text snippets
+      // are still valid.
+      if (ConfigChanged() ||
+          !EqualToWithin(Scale_Px(fontsize), m_fontSize_Scaled, 0.1f))
+        FontsChanged();
+      else
+        // The width cache also holds every cursor prefix we have measured while
+        // editing: Don't let it grow as long as the cell exists.
+        m_widths.clear();
       // Needs to be before the StyleText() as it sets m_fontsize_scaled
       Cell::Recalculate(fontsize);
-      // Perhaps we should test if the fons have actually changed here.
-      FontsChanged();
       m_isDirty = false;
-      m_widths.clear();
       StyleText();
       SetFont(m_configuration->GetRecalcDC());
 
@@ -589,7 +596,7 @@ void EditorCell::Recalculate(AFontSize fontsize) {
       // We want a little bit of vertical space between two text lines (and between
       // two labels).
       m_charHeight += 2 * MC_TEXT_PADDING;
-      wxCoord width = 0, tokenwidth, tokenheight, linewidth = 0;
+      wxCoord width = 0, linewidth = 0;
 
       m_numberOfLines = 1;
 
@@ -599,10 +606,9 @@ void EditorCell::Recalculate(AFontSize fontsize) {
           m_numberOfLines++;
           linewidth = textSnippet.GetIndentPixels();
         } else {
-          m_configuration->GetRecalcDC()->GetTextExtent(textSnippet.GetText(),
-                                                        &tokenwidth, &tokenheight);
-          textSnippet.SetWidth(tokenwidth);
-          linewidth += tokenwidth;
+          if (!textSnippet.SizeKnown())
+            textSnippet.SetWidth(GetTextSize(textSnippet.GetText()).GetWidth());
+          linewidth += textSnippet.GetWidth();
           width = std::max(width, linewidth);
         }
 
@@ -908,12 +914,12 @@ void EditorCell::Draw(wxPoint point, wxDC *dc, wxDC *antialiassingDC) {
 }
 
 void EditorCell::SetType(CellType type) {
-  m_widths.clear();
+  FontsChanged();
   Cell::SetType(type);
 }
 
 void EditorCell::SetStyle(TextStyle style) {
-  m_widths.clear();
+  FontsChanged();
   Cell::SetStyle(style);
 }
 
@@ -2937,15 +2943,31 @@ void EditorCell::StyleTextCode() {
     }
   }
 
-  // Split the line into commands, numbers etc.
-  m_tokens = MaximaTokenizer(textToStyle, m_configuration).PopTokens();
+  // Split the line into commands, numbers etc. After an edit only the part of
+  // the text the edit has changed is split again and only the styled text of
+  // the tokens that have changed is replaced.
+  MaximaTokenizer::Change change;
+  if (!m_tokenizedText.IsEmpty() && suppressedLinesInfo.IsEmpty() &&
+      !m_configuration->GetAutoWrapCode() &&
+      (m_tokenStyledText.size() == m_tokens.size()))
+    change = MaximaTokenizer::Retokenize(m_tokens, m_tokenizedText, textToStyle,
+                                         m_configuration);
+  else {
+    m_tokens = MaximaTokenizer(textToStyle, m_configuration).PopTokens();
+    m_styledText.clear();
+    m_tokenStyledText.clear();
+    change.inserted = m_tokens.size();
+  }
 
-  // Now handle the text pieces one by one
-  wxString lastTokenWithText;
+  // Now handle the new text pieces one by one
+  std::vector<StyledText> styledText;
+  std::vector<std::size_t> tokenStyledText;
   size_t pos = 0;
   wxCoord lineWidth = 0;
 
-  for (auto const &token : m_tokens) {
+  for (size_t i = change.first; i < change.first + change.inserted; i++) {
+    auto const &token = m_tokens[i];
+    tokenStyledText.push_back(styledText.size());
     pos += token.GetText().Length();
     auto &tokenString = token.GetText();
     if (tokenString.IsEmpty())
@@ -2957,13 +2979,13 @@ void EditorCell::StyleTextCode() {
       // All spaces except the last one (that could cause a line break)
       // share the same token
       if (tokenString.Length() > 1)
-        m_styledText.push_back(StyledText(tokenString.Right(tokenString.Length() - 1), GetTextStyle()));
+        styledText.push_back(StyledText(tokenString.Right(tokenString.Length() - 1), GetTextStyle()));
 
       // Now we push the last space to the list of tokens and remember this
       // space as the space that potentially serves as the next point to
       // introduce a soft line break.
-      m_styledText.push_back(StyledText(wxS(" "), GetTextStyle()));
-      lastSpace = &m_styledText.back();
+      styledText.push_back(StyledText(wxS(" "), GetTextStyle()));
+      lastSpace = &styledText.back();
       lastSpacePos = pos + tokenString.Length() - 1;
       continue;
     }
@@ -2977,22 +2999,47 @@ void EditorCell::StyleTextCode() {
         line += wxString(*it2);
       else {
         if (line != wxEmptyString)
-          m_styledText.push_back(StyledText(token.GetTextStyle(), line));
-        m_styledText.push_back(StyledText(token.GetTextStyle(), "\n"));
+          styledText.push_back(StyledText(token.GetTextStyle(), line));
+        styledText.push_back(StyledText(token.GetTextStyle(), "\n"));
         line.Clear();
       }
     }
     if (line != wxEmptyString)
-      m_styledText.push_back(StyledText(token.GetTextStyle(), line));
+      styledText.push_back(StyledText(token.GetTextStyle(), line));
     HandleSoftLineBreaks_Code(lastSpace, lineWidth, token, pos, m_text,
                               lastSpacePos, indentationPixels);
+  }
+
+  // Replace the styled text of the tokens that have changed
+  const size_t oldStart = (change.first < m_tokenStyledText.size()) ?
+    m_tokenStyledText[change.first] : m_styledText.size();
+  const size_t oldEnd = (change.first + change.removed < m_tokenStyledText.size()) ?
+    m_tokenStyledText[change.first + change.removed] : m_styledText.size();
+  for (size_t i = change.first + change.removed; i < m_tokenStyledText.size(); i++)
+    m_tokenStyledText[i] = m_tokenStyledText[i] + styledText.size() - (oldEnd - oldStart);
+  for (auto &start : tokenStyledText)
+    start += oldStart;
+  m_tokenStyledText.erase(m_tokenStyledText.begin() + change.first,
+                          m_tokenStyledText.begin() + change.first + change.removed);
+  m_tokenStyledText.insert(m_tokenStyledText.begin() + change.first,
+                           tokenStyledText.begin(), tokenStyledText.end());
+  m_styledText.erase(m_styledText.begin() + oldStart, m_styledText.begin() + oldEnd);
+  m_styledText.insert(m_styledText.begin() + oldStart,
+                      std::make_move_iterator(styledText.begin()),
+                      std::make_move_iterator(styledText.end()));
+
+  for (auto const &token : m_tokens)
     if ((token.GetTextStyle() == TS_CODE_VARIABLE) ||
-        (token.GetTextStyle() == TS_CODE_FUNCTION)) {
+        (token.GetTextStyle() == TS_CODE_FUNCTION))
       m_wordList.push_back(token);
-      continue;
-    }
-  }
   std::sort(m_wordList.begin(), m_wordList.end());
+
+  // Soft line breaks, folding and lisp mode make the next styling start from scratch
+  if (suppressedLinesInfo.IsEmpty() && !m_configuration->GetAutoWrapCode() &&
+      !m_configuration->InLispMode())
+    m_tokenizedText = textToStyle;
+  else
+    m_tokenizedText.Clear();
   if(!suppressedLinesInfo.IsEmpty())
     m_styledText.push_back(StyledText(TS_CODE_COMMENT, suppressedLinesInfo));
 }
@@ -3274,10 +3321,14 @@ void EditorCell::StyleText() {
   SetFont(m_configuration->GetRecalcDC());
 
   m_wordList.clear();
-  m_styledText.clear();
 
-  if (m_text == wxEmptyString)
+  if (m_text == wxEmptyString) {
+    m_styledText.clear();
+    m_tokens.clear();
+    m_tokenStyledText.clear();
+    m_tokenizedText.Clear();
     return;
+  }
 
   // Remove all soft line breaks. They will be re-added in the right places
   // in the next step
@@ -3285,8 +3336,12 @@ void EditorCell::StyleText() {
   // Do we need to style code or text?
   if (m_type == MC_TYPE_INPUT)
     StyleTextCode();
-  else
+  else {
+    m_styledText.clear();
+    m_tokenStyledText.clear();
+    m_tokenizedText.Clear();
     StyleTextTexts();
+  }
   m_tokens_valid = true;
 }
 
@@ -585,6 +585,9 @@ private:
   void FontsChanged() override
     {
       m_widths.clear();
+      for (auto &textSnippet : m_styledText)
+        textSnippet.ResetSize();
+      m_tokenizedText.Clear();
     }
 
   /*! Adds soft line breaks to code cells, if needed.
@@ -642,6 +645,14 @@ private:
    */
   wxString m_text;
   std::vector<StyledText> m_styledText;
+  /*! The text m_tokens has been generated from
+
+    Empty, if StyleTextCode() cannot just re-tokenize the part of the text that
+    has changed since.
+  */
+  wxString m_tokenizedText;
+  //! The index of the first element of m_styledText each element of m_tokens has created
+  std::vector<std::size_t> m_tokenStyledText;
 
 //** 8/4 bytes
 //**
@@ -127,6 +127,8 @@ public:
   constexpr bool IsNull() const { return !IsValid(); }
   constexpr bool IsValid() const { return m_uSize > 0; }
   constexpr bool IsMinimal() const { return m_uSize == ToUSize(Minimum_Size); }
+  //! The size in the internal, quantised units. Suitable as a key for caches.
+  constexpr value_type GetUnits() const { return m_uSize; }
 
   struct Equals {
     bool operator()(AFontSize l, AFontSize r) const { return l == r; }
@@ -22,77 +22,113 @@
 #include "FontVariantCache.h"
 #include <wx/intl.h>
 #include <wx/log.h>
-#include <iostream>
+
 FontVariantCache::FontVariantCache(const wxString &fontName):
   m_fontName(fontName)
 {
 }
 
+FontVariantCache::~FontVariantCache()
+{
+  for (auto &i: m_fonts)
+    LRU().erase(i.second);
+}
 
-void FontVariantCache::ClearCache() const {
-  bool cleared = false;
-  for (auto &i: m_fontCaches)
+FontVariantCache::LRUList &FontVariantCache::LRU()
+{
+  static LRUList *lru = new LRUList;
+  return *lru;
+}
+
+void FontVariantCache::Trim()
+{
+  LRUList &lru = LRU();
+  while(lru.size() > MaxCachedFonts)
   {
-    if(!i.empty())
-    {
-      cleared = true;
-      i.clear();
-    }
+    const CachedFont &oldest = lru.back();
+    oldest.owner->m_fonts.erase(oldest.key);
+    lru.pop_back();
   }
-  if(cleared)
-    wxLogMessage(_("Cleared font cache for font %s"), m_fontName.mb_str());
 }
 
-std::shared_ptr<wxFont> FontVariantCache::GetFont (double size,
-                                                   bool isItalic,
-                                                   bool isBold,
-                                                   bool isUnderlined,
-                                                   bool isSlanted,
-                                                   bool isStrikeThrough
+void FontVariantCache::ClearCache() const {
+  if(m_fonts.empty())
+    return;
+  for (auto &i: m_fonts)
+    LRU().erase(i.second);
+  m_fonts.clear();
+  wxLogMessage(_("Cleared font cache for font %s"), m_fontName.mb_str());
+}
+
+bool FontVariantCache::IsCached(AFontSize size,
+                                bool isItalic,
+                                bool isBold,
+                                bool isUnderlined,
+                                bool isSlanted,
+                                bool isStrikeThrough) const
+{
+  uint32_t key = GetKey(size, GetIndex(isItalic,
+                                       isBold,
+                                       isUnderlined,
+                                       isSlanted,
+                                       isStrikeThrough));
+  return m_fonts.find(key) != m_fonts.end();
+}
+
+const wxFont &FontVariantCache::GetFont (AFontSize size,
+                                  bool isItalic,
+                                  bool isBold,
+                                  bool isUnderlined,
+                                  bool isSlanted,
+                                  bool isStrikeThrough
   )
 {
-  int index = GetIndex(isItalic,
-                       isBold,
-                       isUnderlined,
-                       isSlanted,
-                       isStrikeThrough);
-  auto cachedFont = m_fontCaches[index].find(size);
-  if(cachedFont == m_fontCaches[index].end())
+  uint32_t key = GetKey(size, GetIndex(isItalic,
+                                       isBold,
+                                       isUnderlined,
+                                       isSlanted,
+                                       isStrikeThrough));
+  LRUList &lru = LRU();
+  auto cachedFont = m_fonts.find(key);
+  if(cachedFont != m_fonts.end())
   {
-    wxFontStyle style;
-    style = wxFONTSTYLE_NORMAL;
-    if(isItalic)
-      style = wxFONTSTYLE_ITALIC;
-    if(isSlanted)
-      style = wxFONTSTYLE_SLANT;
-    wxFontWeight weight;
-    if(isBold)
-      weight = wxFONTWEIGHT_BOLD;
-    else
-      weight = wxFONTWEIGHT_NORMAL;
-    auto font = std::shared_ptr<wxFont>(
-      new
-      wxFont (
-        size,
-        wxFONTFAMILY_DEFAULT,
-        style,
-        weight, isUnderlined,
-        m_fontName));
-    if(!font->IsOk())
-    {
-      wxLogMessage(_("Cannot create a font based on %s. Falling back to a default font."), m_fontName.mb_str());
-      font = std::shared_ptr<wxFont>(new wxFont(*wxNORMAL_FONT));
-    }
-    if(isStrikeThrough)
-      font->MakeStrikethrough();
+    // Mark the font as the most recently used one. This only relinks the list node.
+    if(cachedFont->second != lru.begin())
+      lru.splice(lru.begin(), lru, cachedFont->second);
+    return cachedFont->second->font;
+  }
+
+  wxFontStyle style;
+  style = wxFONTSTYLE_NORMAL;
+  if(isItalic)
+    style = wxFONTSTYLE_ITALIC;
+  if(isSlanted)
+    style = wxFONTSTYLE_SLANT;
+  wxFontWeight weight;
+  if(isBold)
+    weight = wxFONTWEIGHT_BOLD;
+  else
+    weight = wxFONTWEIGHT_NORMAL;
+  wxFont font(size.GetForWX(),
+              wxFONTFAMILY_DEFAULT,
+              style,
+              weight, isUnderlined,
+              m_fontName);
+  if(!font.IsOk())
+  {
+    wxLogMessage(_("Cannot create a font based on %s. Falling back to a default font."), m_fontName.mb_str());
+    font = *wxNORMAL_FONT;
+  }
+  if(isStrikeThrough)
+    font.MakeStrikethrough();
 #if wxCHECK_VERSION(3, 1, 2)
-    font->SetFractionalPointSize(size);
+  font.SetFractionalPointSize(size.Get());
 #else
-    font->SetPointSize(size);
+  font.SetPointSize(size.GetAsLong());
 #endif
-    m_fontCaches[index][size] = font;
-    wxLogMessage(_("Caching font variant: %s"), font->GetNativeFontInfoDesc().mb_str());
-    return font;
-  }
-  return cachedFont->second;
+  lru.emplace_front(this, key, font);
+  m_fonts[key] = lru.begin();
+  wxLogMessage(_("Caching font variant: %s"), font.GetNativeFontInfoDesc().mb_str());
+  Trim();
+  return lru.front().font;
 }
@@ -23,11 +23,11 @@
 #define FONTVARIANTCACHE_H
 
 #include "precomp.h"
-#include <memory>
+#include "FontAttribs.h"
 #include <wx/font.h>
-#include <functional>
+#include <cstddef>
+#include <cstdint>
 #include <list>
-#include <utility>
 #include <unordered_map>
 
 /*! \file
@@ -36,8 +36,18 @@
  This system is necessary since creating a wxFont object costs loads of
  CPU cycles costs.
 
- Each font gets its own FontVariantCache that caches all sizes of each
- style of that font that we ever generated a wxFont object for.
+ Each font gets its own FontVariantCache that caches the sizes of each
+ style of that font that we recently generated a wxFont object for.
+
+ The sizes are keyed by the quantised size AFontSize works with, so zooming
+ back and forth re-uses the same font objects. All font variant caches share
+ one least-recently-used list that is bounded to MaxCachedFonts entries: If
+ the list grows beyond that the font that wasn't used for the longest time
+ is freed, no matter which face it belongs to.
+
+ Fonts are only ever requested by the GUI thread: The tasks of the thread
+ pool don't lay out or draw cells. The cache therefore isn't locked, and
+ GetFont() can return a reference into it.
 */
 class FontVariantCache final
 {
@@ -46,22 +56,61 @@ class FontVariantCache final
 public:
   //! Creates a font variant cache for the font named fontName.
   explicit FontVariantCache(const wxString &fontName);
-  ~FontVariantCache(){}
+  ~FontVariantCache();
   //! Clear this font variant cache
   void ClearCache() const;
   /*! Returns a font with the requested attributes
 
-    This font can be either cached or newly created.*/
-  std::shared_ptr<wxFont> GetFont (double size,
-                                   bool isItalic,
-                                   bool isBold,
-                                   bool isUnderlined,
-                                   bool isSlanted,
-                                   bool isStrikeThrough
+    This font can be either cached or newly created. The reference stays valid
+    until the cache is cleared or MaxCachedFonts other fonts have been requested.
+  */
+  const wxFont &GetFont (AFontSize size,
+                  bool isItalic,
+                  bool isBold,
+                  bool isUnderlined,
+                  bool isSlanted,
+                  bool isStrikeThrough
     );
+  //! Does the cache hold a font with these attributes?
+  bool IsCached(AFontSize size,
+                bool isItalic,
+                bool isBold,
+                bool isUnderlined,
+                bool isSlanted,
+                bool isStrikeThrough) const;
   //! Get the name of the fonts this font variant cache is responsible for
   const wxString& GetFaceName() const {return m_fontName;}
+  //! How many wxFont objects all font variant caches together currently hold
+  static std::size_t GetCachedFontCount() {return LRU().size();}
+  //! The maximum number of wxFont objects all font variant caches together hold
+  static constexpr std::size_t MaxCachedFonts = 256;
 private:
+  //! A font in the LRU list, together with the info which cache it belongs to
+  struct CachedFont
+  {
+    CachedFont(const FontVariantCache *owner_, uint32_t key_, const wxFont &font_) :
+      owner(owner_), key(key_), font(font_) {}
+    const FontVariantCache *owner;
+    uint32_t key;
+    wxFont font;
+  };
+  using LRUList = std::list<CachedFont>;
+  /*! The fonts of all font variant caches, the most recently used one first
+
+    Allocated on the heap and never freed, so the font variant caches that
+    are static objects of other translation units still can access it on
+    destruction.
+  */
+  static LRUList &LRU();
+  //! Frees the least recently used fonts until we are within MaxCachedFonts
+  static void Trim();
+  //! The key a font is cached under: The quantised size and the style bits
+  static uint32_t GetKey(AFontSize size, int index)
+    {
+      return (static_cast<uint32_t>(static_cast<uint16_t>(size.GetUnits())) << 5) |
+        static_cast<uint32_t>(index);
+    }
+
   //! Get the number of the internal cache hashmap
   static int GetIndex (
     bool isItalic,
@@ -85,8 +134,8 @@ private:
       return result;
     }
 
-  //! One hashmap for each value GetIndex() can return.
-  mutable std::unordered_map<double, std::shared_ptr<wxFont>> m_fontCaches[32];
+  //! Where in the LRU list to find the font for each key GetKey() returns
+  mutable std::unordered_map<uint32_t, LRUList::iterator> m_fonts;
   //! The name our font cache
   wxString m_fontName;
 };
@@ -39,6 +39,7 @@
 #include "CellImpl.h"
 #include "CellList.h"
 #include "CellPointers.h"
+#include "ExportCache.h"
 #include "ImgCell.h"
 #include "LabelCell.h"
 #include "MarkDown.h"
@@ -452,6 +453,7 @@ bool GroupCell::Recalculate() {
     }
     Cell::Recalculate(m_configuration->GetDefaultFontSize());
     m_cellsAppended = false;
+    m_heightHint = -1;
   }
   // Move all cells that follow the current one down by the amount this cell
   // has grown.
@@ -640,6 +642,8 @@ wxCoord GroupCell::GetInputIndent() {
 
 void GroupCell::UpdateOutputPositions() {
   UpdateYPosition();
+  if (m_inputLabel)
+    m_inputLabel->SetCurrentPoint(GetCurrentPoint());
   if (m_output && !IsHidden()) {
     wxPoint in = GetCurrentPoint();
     if (m_configuration->ShowCodeCells() || (m_groupType != GC_TYPE_CODE))
@@ -991,8 +995,22 @@ wxString GroupCell::ToRTF() const {
   return retval;
 }
 
+//! Writes an image of a TeX export, unless the last export has written it already
+static bool ToTeXImageFile(ImgCell *image, const wxString &imgDir, const wxString &name,
+                           ExportCache *cache) {
+  if (!cache)
+    return image->ToImageFile(imgDir + wxS("/") + name).x >= 0;
+  uint64_t key = ExportCache::Key(image->GetCompressedImage());
+  if (cache->Reuse(name, key))
+    return true;
+  if (image->ToImageFile(imgDir + wxS("/") + name).x < 0)
+    return false;
+  cache->Stored(name, key);
+  return true;
+}
+
 wxString GroupCell::ToTeX(const wxString &imgDir, const wxString &filename,
-                          std::size_t *imgCounter) const {
+                          std::size_t *imgCounter, ExportCache *cache) const {
   std::size_t myImgCounter = 0;
   if (imgCounter == NULL)
     imgCounter = &myImgCounter;
@@ -1009,15 +1027,14 @@ wxString GroupCell::ToTeX(const wxString &imgDir, const wxString &filename,
       auto *const imgCopy = dynamic_cast<ImgCell *>(copy.get());
       (*imgCounter)++;
       wxString image = filename + wxString::Format(wxS("_%zu"), *imgCounter);
-      wxString file;
 
       if (!wxDirExists(imgDir))
         wxMkdir(imgDir);
 
       if(imgCopy)
         {
-          file = imgDir + wxS("/") + image + wxS(".") + imgCopy->GetExtension();
-          if (imgCopy->ToImageFile(file).x >= 0) {
+          if (ToTeXImageFile(imgCopy, imgDir, image + wxS(".") + imgCopy->GetExtension(),
+                             cache)) {
             str << wxS("\\begin{figure}[htb]\n") << wxS("  \\centering\n")
             << wxS("    \\includeimage{") << filename << wxS("_img/") << image
             << wxS("}\n") << wxS("  \\caption{")
@@ -1030,7 +1047,7 @@ wxString GroupCell::ToTeX(const wxString &imgDir, const wxString &filename,
     break;
     
   case GC_TYPE_CODE:
-    str = ToTeXCodeCell(imgDir, filename, imgCounter);
+    str = ToTeXCodeCell(imgDir, filename, imgCounter, cache);
     str.Replace(wxS("\\[\\displaystyle \\]"), wxS(""));
     break;
 
@@ -1079,7 +1096,7 @@ wxString GroupCell::ToTeX(const wxString &imgDir, const wxString &filename,
 }
 
 wxString GroupCell::ToTeXCodeCell(const wxString &imgDir, const wxString &filename,
-                                  std::size_t *imgCounter) const {
+                                  std::size_t *imgCounter, ExportCache *cache) const {
   wxString str;
 
   // Input cells
@@ -1116,7 +1133,7 @@ wxString GroupCell::ToTeXCodeCell(const wxString &imgDir, const wxString &filena
 
     for (const Cell &tmp : OnDrawList(m_output.get())) {
       if (tmp.GetType() == MC_TYPE_IMAGE) {
-        str << ToTeXImage(&tmp, imgDir, filename, imgCounter);
+        str << ToTeXImage(&tmp, imgDir, filename, imgCounter, cache);
       } else if (tmp.GetType() == MC_TYPE_SLIDE) {
         str << "\\text{[animated graphics - not shown in TeX export]}";
       } else {
@@ -1163,7 +1180,7 @@ wxString GroupCell::ToTeXCodeCell(const wxString &imgDir, const wxString &filena
 }
 
 wxString GroupCell::ToTeXImage(const Cell *tmp, const wxString &imgDir, const wxString &filename,
-                               std::size_t *imgCounter) {
+                               std::size_t *imgCounter, ExportCache *cache) {
   wxASSERT_MSG((imgCounter != NULL), _("Bug: No image counter to write to!"));
   if(tmp == NULL) {
       wxLogMessage(_("No image to export"));
@@ -1186,9 +1203,7 @@ wxString GroupCell::ToTeXImage(const Cell *tmp, const wxString &imgDir, const wx
       if (!wxMkdir(imgDir))
         return wxEmptyString;
 
-    wxString file =
-      imgDir + wxS("/") + image + wxS(".") + imgCopy->GetExtension();
-    if (imgCopy->ToImageFile(file).x >= 0)
+    if (ToTeXImageFile(imgCopy, imgDir, image + wxS(".") + imgCopy->GetExtension(), cache))
       str += wxS("\\includegraphics[width=.95\\linewidth,height=."
                  "80\\textheight,keepaspectratio]{") +
         filename + wxS("_img/") + image + wxS("}");
@@ -52,6 +52,8 @@ enum GroupType : int8_t
   GC_TYPE_IMAGE,
   GC_TYPE_PAGEBREAK
 };
+class ExportCache;
+
 //! Allow Standard c++ streams to print out our enum values as text.
 std::ostream& operator<<(std::ostream& out, const GroupType grouptype);
 
@@ -95,6 +97,13 @@ public:
   bool AutoAnswer() const { return m_autoAnswer; }
   void SetAutoAnswer(bool autoAnswer);
   void MarkNeedsRecalculate(){m_cellsAppended = true;}
+  /*! Sets the height this cell probably will have once it has been recalculated
+
+    Used for the size of the worksheet until the cell actually is recalculated.
+  */
+  void SetHeightHint(wxCoord height){m_heightHint = height;}
+  //! The height this cell probably has, if it hasn't been recalculated, yet, else -1
+  wxCoord GetHeightHint() const {return m_heightHint;}
   //! Add a new answer to the cell
   void SetAnswer(const wxString &question, const wxString &answer);
 
@@ -161,14 +170,19 @@ public:
     image filenames we have already generated. NULL means: This TeX export
     doesn't contain other GroupCells that can export images and therefore
     need to enumerate them.
+    \param cache The images of the last export of the document that may be
+    reused, or NULL.
   */
-  wxString ToTeX(const wxString &imgDir, const wxString &filename, std::size_t *imgCounter) const;
+  wxString ToTeX(const wxString &imgDir, const wxString &filename, std::size_t *imgCounter,
+                 ExportCache *cache = NULL) const;
 
   wxString ToRTF() const override;
 
-  wxString ToTeXCodeCell(const wxString &imgDir, const wxString &filename, std::size_t *imgCounter) const;
+  wxString ToTeXCodeCell(const wxString &imgDir, const wxString &filename, std::size_t *imgCounter,
+                         ExportCache *cache = NULL) const;
 
-  static wxString ToTeXImage(const Cell *tmp, const wxString &imgDir, const wxString &filename, std::size_t *imgCounter);
+  static wxString ToTeXImage(const Cell *tmp, const wxString &imgDir, const wxString &filename,
+                             std::size_t *imgCounter, ExportCache *cache = NULL);
 
   wxString ToTeX() const override;
 
@@ -377,6 +391,7 @@ public:
   //! Recalculate the cell's y position using the position and height of the last one.
   void UpdateYPosition();
 
+  //! Tells the prompt and the output cells where Draw() would place them, without drawing them
   void UpdateOutputPositions();
 
   void UpdateYPositionList();
@@ -409,10 +424,12 @@ protected:
   std::unique_ptr<Cell> m_output;
   // The pointers above point to inner cells and must be kept contiguous.
 
-//** 4-byte objects (16 bytes)
+//** 4-byte objects (20 bytes)
 //**
   int m_labelWidth_cached = 0;
   int m_inputWidth, m_inputHeight;
+  //! The height the cell had the last time the document was opened, until it is recalculated
+  wxCoord m_heightHint = -1;
 protected:
 //** 2-byte objects (6 bytes)
 //**
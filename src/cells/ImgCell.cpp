@@ -150,8 +150,11 @@ void ImgCell::Recalculate(AFontSize fontsize) {
       m_image->Recalculate(m_configuration->GetZoomFactor() *
                            PRINT_SIZE_MULTIPLIER);
       m_imageBorderWidth = Scale_Px(1);
-    } else
+    } else {
       m_image->Recalculate();
+      if (m_image->IsLoading())
+        m_cellPointers->WaitForImage(GetGroup());
+    }
     m_width = m_image->m_width + 2 * m_imageBorderWidth;
     m_height = m_image->m_height + 2 * m_imageBorderWidth;
     m_center = m_height / 2;
@@ -200,12 +203,7 @@ void ImgCell::Draw(wxPoint point, wxDC *dc, wxDC *antialiassingDC) {
                       bitmap.GetWidth(), bitmap.GetHeight());
     } else
       dc->Blit(xDst, yDst, widthDst, heightDst, &bitmapDC, xSrc, ySrc);
-  } else
-    {
-      // The cell isn't drawn => No need to keep it's image cache for now.
-      if(!GetRect().Intersects(m_configuration->GetVisibleRegion()))
-        ClearCache();
-    }
+  }
 
   // The next time we need to draw a bounding box we will be informed again.
   m_drawBoundingBox = false;
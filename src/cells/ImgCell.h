@@ -94,6 +94,11 @@ public:
   */
   void ClearCache() override { if (m_image) m_image->ClearCache(); }
 
+  //! Keeps the scaled image from being evicted from the image cache
+  void TouchCache() override { if (m_image) m_image->TouchCache(); }
+  void SetViewportDistance(double screens) override
+    { if (m_image) m_image->SetViewportDistance(screens); }
+
   const wxString GetToolTip(wxPoint point) const override;
 
   //! Sets the bitmap that is shown
@@ -117,7 +122,7 @@ public:
     { m_origImageFile = file; }
 
   //! Returns the original compressed version of the image
-  wxMemoryBuffer GetCompressedImage() const { return m_image->m_compressedImage; }
+  wxMemoryBuffer GetCompressedImage() const { return m_image->GetCompressedImage(); }
 
   wxCoord GetMaxWidth() const override { return m_image ? m_image->GetMaxWidth() : -1; }
   wxCoord GetHeightList() const override { return m_image ? m_image->GetHeightList() : -1; }
@@ -347,8 +347,8 @@ void Style::Write(wxConfigBase *config, const wxString &where) const {
 }
 
 const wxFont &Style::GetFont(AFontSize fontSize) const {
-  return *(m.fontCache->GetFont(fontSize.Get(), IsItalic(), IsBold(), IsUnderlined(),
-                                IsSlant(), IsStrikethrough()));
+  return m.fontCache->GetFont(fontSize, IsItalic(), IsBold(), IsUnderlined(),
+                              IsSlant(), IsStrikethrough());
 }
 
 Style Style::FromStockFont(wxStockGDI::Item font) {
@@ -344,6 +344,12 @@ void ConfigDialogue::SetCheckboxValues() {
                                       "using draw() in order to be able to open plots interactively in "
                                       "gnuplot later. This setting defines the limit [in Megabytes per plot] "
                                       "for this feature."));
+  m_imageCacheMegabytes->SetToolTip(
+                                    _("wxMaxima keeps scaled versions of the plots and images that "
+                                      "have been on the screen in order to be able to quickly draw them "
+                                      "again. If they need more memory than this the images that have "
+                                      "been off-screen for the longest time are scaled anew when they "
+                                      "are needed again."));
   m_defaultPlotWidth->SetToolTip(
                                  _("The default width for embedded plots. Can be read out or overridden "
                                    "by the maxima variable wxplot_size"));
@@ -502,6 +508,7 @@ void ConfigDialogue::SetCheckboxValues() {
   m_numpadEnterEvaluates->SetValue(configuration->NumpadEnterEvaluates());
   m_saveImgFileName->SetValue(configuration->SaveImgFileName());
   m_saveUntitled->SetValue(configuration->SaveUntitled());
+  m_verifySavedFiles->SetValue(configuration->VerifySavedFiles());
   m_openHCaret->SetValue(configuration->GetOpenHCaret());
   m_insertAns->SetValue(configuration->GetInsertAns());
   m_autoIndent->SetValue(configuration->GetAutoIndent());
@@ -528,6 +535,7 @@ void ConfigDialogue::SetCheckboxValues() {
   m_restartOnReEvaluation->SetValue(configuration->RestartOnReEvaluation());
   m_defaultFramerate->SetValue(m_configuration->DefaultFramerate());
   m_maxGnuplotMegabytes->SetValue(configuration->MaxGnuplotMegabytes());
+  m_imageCacheMegabytes->SetValue(configuration->ImageCacheMegabytes());
   m_autosaveMinutes->SetValue(configuration->AutosaveMinutes());
   m_defaultPlotWidth->SetValue(configuration->DefaultPlotWidth());
   m_defaultPlotHeight->SetValue(configuration->DefaultPlotHeight());
@@ -1265,6 +1273,17 @@ wxWindow *ConfigDialogue::CreateOptionsPanel() {
                   wxUP | wxDOWN | wxALIGN_CENTER_VERTICAL,
                   5 * GetContentScaleFactor());
 
+  grid_sizer->Add(
+                  new wxStaticText(stdOpts_sizer->GetStaticBox(), wxID_ANY,
+                                   _("Memory for scaled images [MB]:")),
+                  0, wxUP | wxDOWN | wxALIGN_CENTER_VERTICAL, 5 * GetContentScaleFactor());
+  m_imageCacheMegabytes = new wxSpinCtrl(
+                                         stdOpts_sizer->GetStaticBox(), wxID_ANY, wxEmptyString, wxDefaultPosition,
+                                         wxSize(150 * GetContentScaleFactor(), -1), wxSP_ARROW_KEYS, 16, 16384);
+  grid_sizer->Add(m_imageCacheMegabytes, 0,
+                  wxUP | wxDOWN | wxALIGN_CENTER_VERTICAL,
+                  5 * GetContentScaleFactor());
+
   grid_sizer->Add(new wxStaticText(stdOpts_sizer->GetStaticBox(), wxID_ANY,
                                    _("Time [in Minutes] between autosaves")),
                   0, wxUP | wxDOWN | wxALIGN_CENTER_VERTICAL,
@@ -1299,6 +1318,12 @@ wxWindow *ConfigDialogue::CreateOptionsPanel() {
   stdOpts_sizer->Add(m_saveUntitled,
                      wxSizerFlags().Border(wxALL, 5 * GetContentScaleFactor()));
 
+  m_verifySavedFiles =
+    new wxCheckBox(stdOpts_sizer->GetStaticBox(), wxID_ANY,
+                   _("Read .wxmx files again after saving in order to verify them"));
+  stdOpts_sizer->Add(m_verifySavedFiles,
+                     wxSizerFlags().Border(wxALL, 5 * GetContentScaleFactor()));
+
   m_fixReorderedIndices =
     new wxCheckBox(
                    stdOpts_sizer->GetStaticBox(), wxID_ANY,
@@ -2139,6 +2164,7 @@ void ConfigDialogue::WriteSettings() {
   configuration->NumpadEnterEvaluates(m_numpadEnterEvaluates->GetValue());
   configuration->SaveImgFileName(m_saveImgFileName->GetValue());
   configuration->SaveUntitled(m_saveUntitled->GetValue());
+  configuration->VerifySavedFiles(m_verifySavedFiles->GetValue());
   configuration->SetOpenHCaret(m_openHCaret->GetValue());
   configuration->SetInsertAns(m_insertAns->GetValue());
   configuration->SetAutoIndent(m_autoIndent->GetValue());
@@ -2160,6 +2186,7 @@ void ConfigDialogue::WriteSettings() {
   configuration->UseSVG(m_usesvg->GetValue());
   configuration->DefaultFramerate(m_defaultFramerate->GetValue());
   configuration->MaxGnuplotMegabytes(m_maxGnuplotMegabytes->GetValue());
+  configuration->ImageCacheMegabytes(m_imageCacheMegabytes->GetValue());
   configuration->AutosaveMinutes(m_autosaveMinutes->GetValue());
   configuration->DefaultPlotWidth(m_defaultPlotWidth->GetValue());
   configuration->DefaultPlotHeight(m_defaultPlotHeight->GetValue());
@@ -2451,10 +2478,10 @@ void ConfigDialogue::UpdateExample() {
 
   if (st == TS_TEXT_BACKGROUND || st == TS_TEXT) {
     m_examplePanel->SetBackgroundColour(
-                                        m_configuration->m_styles[TS_TEXT_BACKGROUND].GetColor());
+                                        m_configuration->GetStyle(TS_TEXT_BACKGROUND)->GetColor());
   } else {
     m_examplePanel->SetBackgroundColour(
-                                        m_configuration->m_styles[TS_DOCUMENT_BACKGROUND].GetColor());
+                                        m_configuration->GetStyle(TS_DOCUMENT_BACKGROUND)->GetColor());
   }
   m_sampleWorksheet->Refresh();
 }
@@ -309,6 +309,7 @@ protected:
   wxCheckBox *m_numpadEnterEvaluates;
   wxCheckBox *m_saveImgFileName;
   wxCheckBox *m_saveUntitled;
+  wxCheckBox *m_verifySavedFiles;
   wxCheckBox *m_openHCaret;
   wxCheckBox *m_insertAns;
   wxCheckBox *m_autoIndent;
@@ -346,6 +347,7 @@ protected:
   wxSpinCtrl *m_defaultPort;
   ExamplePanel *m_examplePanel;
   wxSpinCtrl *m_maxGnuplotMegabytes;
+  wxSpinCtrl *m_imageCacheMegabytes;
   wxSpinCtrl *m_autosaveMinutes;
   wxTextCtrl *m_autoMathJaxURL;
   int m_maximaEmvRightClickRow = 0;
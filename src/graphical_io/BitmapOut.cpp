@@ -26,8 +26,12 @@
 */
 
 #include "BitmapOut.h"
+#include "PngWriter.h"
 #include "cells/Cell.h"
+#include <algorithm>
+#include <cmath>
 #include <wx/clipbrd.h>
+#include <wx/wfstream.h>
 
 #define BM_FULL_WIDTH 1000
 
@@ -55,6 +59,7 @@ BitmapOut::~BitmapOut() {}
 
 bool BitmapOut::Render(std::unique_ptr<Cell> &&tree, long int maxSize) {
   m_tree = std::move(tree);
+  m_bitmapDrawn = false;
   m_isOk = Layout(maxSize);
   return m_isOk;
 }
@@ -66,15 +71,26 @@ bool BitmapOut::Layout(long int maxSize) {
   if (!m_cmn.PrepareLayout(m_tree.get()))
     return false;
 
-  auto scale = m_cmn.GetScale();
   auto size = m_cmn.GetScaledSize();
-  auto rawSize = m_cmn.GetSize();
 
   // Bitmaps that are bigger than the available memory can lead to crashes within
   // MS Windows or the X server.
   if (maxSize >= 0 && (((long)size.x * size.y >= maxSize) ||
                        (size.x >= 20000) || (size.y >= 20000)))
-    goto failed;
+    return false;
+
+  // The bitmap is only drawn when it is needed: ToFile() doesn't need it.
+  return true;
+}
+
+bool BitmapOut::DrawBitmap() {
+  if (!m_isOk)
+    return false;
+  if (m_bitmapDrawn)
+    return true;
+
+  auto scale = m_cmn.GetScale();
+  auto rawSize = m_cmn.GetSize();
 
   // The depth 24 hinders wxWidgets from creating rgb0 bitmaps that some
   // windows applications will interpret as rgba if they appear on
@@ -91,10 +107,12 @@ bool BitmapOut::Layout(long int maxSize) {
   m_dc.SetUserScale(scale, scale);
   m_dc.SetPen(wxNullPen);
   Draw();
+  m_bitmapDrawn = true;
   return true;
 
  failed:
   m_bmp = wxNullBitmap;
+  m_isOk = false;
   return false;
 }
 
@@ -102,7 +120,7 @@ void BitmapOut::Draw() {
   auto config = m_cmn.GetConfiguration();
   config->ClipToDrawRegion(false);
 
-  auto bgColor = config->m_styles[TS_TEXT_BACKGROUND].GetColor();
+  auto bgColor = config->GetStyle(TS_TEXT_BACKGROUND)->GetColor();
   m_dc.SetBackground(*(wxTheBrushList->FindOrCreateBrush(bgColor,
                                                          wxBRUSHSTYLE_SOLID)));
   m_dc.Clear();
@@ -110,24 +128,83 @@ void BitmapOut::Draw() {
   m_cmn.Draw(m_tree.get());
 }
 
-wxSize BitmapOut::ToFile(const wxString &file) {
+double BitmapOut::GetResolution() const {
+  return m_cmn.GetScreenConfig().GetRecalcDC()->GetPPI().x * m_cmn.GetScale();
+}
+
+wxImage BitmapOut::ToImage() {
+  if (!DrawBitmap())
+    return wxImage();
   // Assign a resolution to the bitmap.
   wxImage img = m_bmp.ConvertToImage();
-  int resolution = m_cmn.GetScreenConfig().GetRecalcDC()->GetPPI().x;
-  img.SetOption(wxIMAGE_OPTION_RESOLUTION, resolution * m_cmn.GetScale());
+  img.SetOption(wxIMAGE_OPTION_RESOLUTION, GetResolution());
+  return img;
+}
 
+bool BitmapOut::ToPngFile(const wxString &file) {
+  if (!m_isOk)
+    return false;
+  wxSize size = m_cmn.GetScaledSize();
+  if ((size.x <= 0) || (size.y <= 0))
+    return false;
+  wxFileOutputStream stream(file);
+  if (!stream.IsOk())
+    return false;
+  PngWriter png(stream, size.x, size.y, GetResolution());
+
+  // Only one tile of the image is in memory at any time. The cells that
+  // aren't in the current tile aren't drawn.
+  auto config = m_cmn.GetConfiguration();
+  auto scale = m_cmn.GetScale();
+  auto bgColor = config->GetStyle(TS_TEXT_BACKGROUND)->GetColor();
+  int tileHeight = std::min(TileHeight, size.y);
+  wxBitmap tile(size.x, tileHeight, 24);
+  if (!tile.IsOk())
+    return false;
+  wxMemoryDC dc(tile);
+  if (!dc.IsOk())
+    return false;
+  m_cmn.SetRecalculationContext(&dc);
+  config->SetRecalcContext(dc);
+  for (int top = 0; top < size.y; top += tileHeight) {
+    dc.SetDeviceOrigin(0, -top);
+    dc.SetUserScale(scale, scale);
+    dc.SetPen(wxNullPen);
+    dc.SetBackground(*(wxTheBrushList->FindOrCreateBrush(bgColor,
+                                                         wxBRUSHSTYLE_SOLID)));
+    dc.Clear();
+    config->ClipToDrawRegion(true);
+    config->SetUpdateRegion(wxRect(0, static_cast<int>(std::floor(top / scale)),
+                                   m_cmn.GetSize().x,
+                                   static_cast<int>(std::ceil(tileHeight / scale)) + 1));
+    m_cmn.Draw(m_tree.get());
+    dc.SelectObject(wxNullBitmap);
+    wxImage image = tile.ConvertToImage();
+    dc.SelectObject(tile);
+    if (!image.IsOk())
+      break;
+    png.AddLines(image.GetData(), std::min(tileHeight, size.y - top));
+  }
+  m_cmn.SetRecalculationContext(&m_dc);
+  config->SetRecalcContext(m_dc);
+  config->ClipToDrawRegion(false);
+  return png.Finish();
+}
+
+wxSize BitmapOut::ToFile(const wxString &file) {
   bool success = false;
   if (file.EndsWith(wxS(".bmp")))
-    success = img.SaveFile(file, wxBITMAP_TYPE_BMP);
+    success = ToImage().SaveFile(file, wxBITMAP_TYPE_BMP);
   else if (file.EndsWith(wxS(".xpm")))
-    success = img.SaveFile(file, wxBITMAP_TYPE_XPM);
+    success = ToImage().SaveFile(file, wxBITMAP_TYPE_XPM);
   else if (file.EndsWith(wxS(".jpg")))
-    success = img.SaveFile(file, wxBITMAP_TYPE_JPEG);
+    success = ToImage().SaveFile(file, wxBITMAP_TYPE_JPEG);
   else {
+    // .png files are written tile by tile, so even huge images can be written.
     if (file.EndsWith(wxS(".png")))
-      success = img.SaveFile(file, wxBITMAP_TYPE_PNG);
+      success = ToPngFile(file);
     else
-      success = img.SaveFile(file + wxS(".png"), wxBITMAP_TYPE_PNG);
+      success = ToPngFile(file + wxS(".png"));
   }
 
   if (success)
@@ -136,12 +213,17 @@ wxSize BitmapOut::ToFile(const wxString &file) {
     return wxDefaultSize;
 }
 
-std::unique_ptr<wxBitmapDataObject> BitmapOut::GetDataObject() const {
-  return m_isOk ? std::make_unique<wxBitmapDataObject>(GetBitmap()) : nullptr;
+wxBitmap BitmapOut::GetBitmap() {
+  DrawBitmap();
+  return m_bmp;
 }
 
-bool BitmapOut::ToClipboard() const {
-  if (!m_isOk)
+std::unique_ptr<wxBitmapDataObject> BitmapOut::GetDataObject() {
+  return DrawBitmap() ? std::make_unique<wxBitmapDataObject>(m_bmp) : nullptr;
+}
+
+bool BitmapOut::ToClipboard() {
+  if (!DrawBitmap())
     return false;
   wxASSERT_MSG(!wxTheClipboard->IsOpened(),
                _("Bug: The clipboard is already opened"));
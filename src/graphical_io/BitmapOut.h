@@ -52,7 +52,8 @@ public:
     \param maxSize maxSize tells the maximum size [in square pixels] that will be rendered.
     -1 means: No limit.
 
-    \return true, if the bitmap could be created.
+    \return true, if the cells could be laid out and the bitmap doesn't
+    exceed maxSize. The bitmap itself is only drawn when it is needed.
   */
   bool Render(std::unique_ptr<Cell> &&tree, long int maxSize = -1);
 
@@ -61,17 +62,33 @@ public:
 
   /*! Exports this bitmap to a file
 
+    .png files are drawn and written in tiles of TileHeight lines, so the
+    size of the image isn't limited by the memory a bitmap may use.
+
     \return The size of the bitmap in millimeters. Sizes <0 indicate that the export has failed.
   */
   wxSize ToFile(const wxString &file);
 
+  /*! Converts the bitmap to an image that knows its resolution
+
+    Saving the image is the slow part of ToFile(). Unlike the bitmap, the
+    image may be saved by a background thread.
+  */
+  wxImage ToImage();
+
+  //! The size ToFile() returns if it succeeds
+  wxSize GetScaledSize() const { return m_cmn.GetScaledSize(); }
+
   //! Returns the bitmap representation of the list of cells that was passed to SetData()
-  wxBitmap GetBitmap() const { return m_bmp; }
+  wxBitmap GetBitmap();
 
-  std::unique_ptr<wxBitmapDataObject> GetDataObject() const;
+  std::unique_ptr<wxBitmapDataObject> GetDataObject();
 
   //! Copies the bitmap representation of the list of cells that was passed to SetData()
-  bool ToClipboard() const;
+  bool ToClipboard();
+
+  //! The number of lines of the tiles ToFile() draws .png files in
+  static constexpr int TileHeight = 512;
 
 private:
   std::unique_ptr<Cell> m_tree;
@@ -79,9 +96,17 @@ private:
   wxBitmap m_bmp;
   wxMemoryDC m_dc;
   bool m_isOk = false;
+  //! Does m_bmp contain the whole bitmap?
+  bool m_bitmapDrawn = false;
 
   bool Layout(long int maxSize = -1);
+  //! Draws the whole bitmap into m_bmp, if that hasn't been done yet
+  bool DrawBitmap();
   void Draw();
+  //! Draws the image tile by tile into a .png file
+  bool ToPngFile(const wxString &file);
+  //! The resolution of the bitmap in pixels per inch
+  double GetResolution() const;
 };
 
 #endif // BITMAPOUT_H
@@ -41,7 +41,6 @@ OutCommon::OutCommon(const Configuration * const *configuration, const wxString
                  ? wxFileName::CreateTempFileName(wxS("wxmaxima_"))
                  : filename),
       m_configuration(configuration), m_scale(scale), m_fullWidth(fullWidth) {
-    m_thisconfig.ShowCodeCells(m_oldconfig->ShowCodeCells());
     m_thisconfig.SetWorkSheet((*configuration)->GetWorkSheet());
 
     //    *m_configuration = &m_thisconfig;
@@ -123,7 +123,7 @@ private:
   wxString m_filename;
   const Configuration * const *m_configuration;
   const Configuration *m_oldconfig = *m_configuration;
-  Configuration m_thisconfig{ {}, Configuration::temporary };
+  Configuration m_thisconfig{ *m_oldconfig, {} };
   //! How many times the natural resolution do we want this output to be?
   double m_scale = 1.0;
   //! The size of the current output
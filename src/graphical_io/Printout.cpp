@@ -38,8 +38,9 @@
 #include <wx/log.h>
 
 
-Printout::Printout(wxString title, GroupCell *tree, double scaleFactor)
-  : wxPrintout(title), m_configuration(GetDC(), Configuration::temporary),
+Printout::Printout(wxString title, const Configuration &configuration,
+                   GroupCell *tree, double scaleFactor)
+  : wxPrintout(title), m_configuration(configuration, GetDC()),
     m_configPointer(&m_configuration),
     m_scaleFactor(scaleFactor),
     m_printing(&m_configuration)
@@ -56,8 +57,7 @@ Printout::Printout(wxString title, GroupCell *tree, double scaleFactor)
 
   // Create our own copy of the worksheet that uses our private configuration
   if (tree) {
-    m_configuration.ShowCodeCells(tree->GetConfiguration()->ShowCodeCells());
-    m_configuration.ShowBrackets(tree->GetConfiguration()->PrintBrackets());
+    m_configuration.ShowBrackets(configuration.PrintBrackets());
     auto copy = tree->CopyList();
     copy->SetConfigurationList(m_configPointer);
     m_tree = std::move(copy);
@@ -84,31 +84,23 @@ bool Printout::OnPrintPage(int num) {
   dc->SetBackground(*wxWHITE_BRUSH);
   dc->Clear();
 
-  // Set the canvas size
-  wxCoord pageWidth, pageHeight;
-  dc->GetSize(&pageWidth, &pageHeight);
-  pageWidth -= m_configuration.PrintMargin_Left() +
-    m_configuration.PrintMargin_Right();
-  pageHeight -= m_configuration.PrintMargin_Top() +
-    m_configuration.PrintMargin_Bot();
-  m_configuration.SetCanvasSize(wxSize(pageWidth,pageHeight));
-  wxLogMessage(_("printOut: Setting the page size to (%li,%li)"),
-               static_cast<long>(pageWidth),
-               static_cast<long>(pageHeight));
-  GroupCell *group = m_pages[static_cast<size_t>(num) - 1]->GetGroup();
-  if (!group)
-    return true;
-  if (group->GetGroupType() == GC_TYPE_PAGEBREAK)
-    group = group->GetNext();
+  const Page &page = m_pages[static_cast<size_t>(num) - 1];
+  GroupCell *group = page.firstGroup;
   if (!group)
     return true;
 
+  // A print preview renders the page in the size its zoom factor dictates.
+  // Scaling the page we have laid out is much faster than breaking the
+  // worksheet into pages anew.
+  FitThisSizeToPage(m_layoutPageSize);
+  double scale, scaleY;
+  dc->GetUserScale(&scale, &scaleY);
+
   // Move the origin so the cell we want to print first appears on the top
   // of our page
   wxPoint deviceOrigin(
-                       m_configuration.PrintMargin_Left(),
-                       m_configuration.PrintMargin_Top() -
-                       m_pages[static_cast<size_t>(num) - 1]->GetRect(true).GetTop());
+                       wxRound(scale * m_configuration.PrintMargin_Left()),
+                       wxRound(scale * (m_configuration.PrintMargin_Top() - page.top)));
   wxLogMessage(_("Printout: Setting the device origin to %lix%li"),
                static_cast<long>(deviceOrigin.x),
                static_cast<long>(deviceOrigin.y)
@@ -116,32 +108,17 @@ bool Printout::OnPrintPage(int num) {
   dc->SetDeviceOrigin(deviceOrigin.x, deviceOrigin.y);
 
   // Print the page contents
-  const Cell *end = NULL;
-  wxCoord startpoint;
-  wxCoord endpoint;
-  startpoint = m_pages[static_cast<size_t>(num) - 1]->GetRect(true).GetTop();
-
-  if (m_pages.size() > (unsigned)num) {
-    endpoint = m_pages[num]->GetRect(true).GetTop() - 1;
-    end = m_pages[num];
-  }
-  else {
-    endpoint = startpoint + pageHeight;
-  }
-
   dc->DestroyClippingRegion();
-  wxCoord len = endpoint - startpoint;
   wxLogMessage(_("Printout: Printing the region %li-%li"),
-               static_cast<long>(startpoint),
-               static_cast<long>(endpoint));
-  dc->SetClippingRegion(0, startpoint, pageWidth, len);
+               static_cast<long>(page.top),
+               static_cast<long>(page.bottom));
+  dc->SetClippingRegion(0, page.top, m_configuration.GetCanvasSize().x,
+                        page.bottom - page.top);
 
   while (group && (group->GetGroupType() != GC_TYPE_PAGEBREAK)) {
-    {
-      group->Draw(group->GetGroup()->GetCurrentPoint(), dc, dc);
-      if(end && (group == end->GetGroup()))
-        break;
-    }
+    group->Draw(group->GetCurrentPoint(), dc, dc);
+    if (group == page.lastGroup)
+      break;
     group = group->GetNext();
   }
   return true;
@@ -155,6 +132,7 @@ bool Printout::OnBeginDocument(int startPage, int endPage) {
 }
 
 void Printout::BreakPages() {
+  m_pages.clear();
   if (m_tree == NULL)
     return;
   wxSize canvasSize = m_configuration.GetCanvasSize();
@@ -162,8 +140,9 @@ void Printout::BreakPages() {
   wxLogMessage(_("Printout: Composing a list of all line starts as possible locations for page breaks"));
   std::vector <Cell*> lineStarts;
   for (GroupCell &gr : OnList(m_tree.get())) {
-    // Drawing a GroupCell makes it calculate the position of its output cells.
-    gr.Draw(gr.GetCurrentPoint(), GetDC(), GetDC());
+    // Tell the output cells where they are placed. Drawing them would do the
+    // same, but would take much longer.
+    gr.UpdateOutputPositions();
     // We can introduce a break after the input part of any group cell.
     if(gr.GetPrompt())
       lineStarts.push_back(gr.GetPrompt());
@@ -183,31 +162,50 @@ void Printout::BreakPages() {
 
   wxLogMessage(_("Composing a list of the line starts we can use as page starts"));
   // The 1st page starts at the beginning of the document
-  GroupCell *group = m_tree.get();
-  m_pages.push_back(group);
-  
-  // Now see where the next pages should start    
+  std::vector<const Cell *> pageStarts;
+  pageStarts.push_back(m_tree.get());
+
+  // Now see where the next pages should start
   for (const auto &i : lineStarts) {
     wxCoord pageStart = 0;
-    pageStart = m_pages[m_pages.size() - 1]->GetRect(true).GetTop();
+    pageStart = pageStarts[pageStarts.size() - 1]->GetRect(true).GetTop();
     wxCoord pageEnd = i->GetRect(true).GetBottom();
     if(i->GetNext())
       pageEnd = i->GetNext()->GetRect(true).GetBottom();
     if(pageEnd - pageStart > canvasSize.y)
       {
-        if(i != m_pages[m_pages.size() - 1])
+        if(i != pageStarts[pageStarts.size() - 1])
           {
             wxCoord pageHeight = i->GetRect(true).GetTop() - pageStart;
             wxLogMessage(_("Printout: PageStart=%li, PageHeight=%li, canvasSize=%li"),
                          static_cast<long>(pageStart),
                          static_cast<long>(pageHeight),
                          static_cast<long>(canvasSize.y));
-            m_pages.push_back(i);
+            pageStarts.push_back(i);
           }
         else
           wxLogMessage(_("Printout: Cannot find a suitable point for a page break!"));
       }
   }
+
+  // Remember which part of the worksheet each page shows, so printing a page
+  // doesn't need to search for it
+  for (std::size_t i = 0; i < pageStarts.size(); i++) {
+    Page page;
+    page.start = pageStarts[i];
+    page.firstGroup = page.start->GetGroup();
+    if (page.firstGroup && (page.firstGroup->GetGroupType() == GC_TYPE_PAGEBREAK))
+      page.firstGroup = page.firstGroup->GetNext();
+    page.top = page.start->GetRect(true).GetTop();
+    if (i + 1 < pageStarts.size()) {
+      page.lastGroup = pageStarts[i + 1]->GetGroup();
+      page.bottom = pageStarts[i + 1]->GetRect(true).GetTop() - 1;
+    } else {
+      page.lastGroup = NULL;
+      page.bottom = page.top + canvasSize.y;
+    }
+    m_pages.push_back(page);
+  }
 }
 
 void Printout::GetPageInfo(int *minPage, int *maxPage, int *fromPage,
@@ -230,10 +228,27 @@ void Printout::OnPreparePrinting() {
   // size one would get on an 300dpi printer => we need to correct the scale
   // factor for the DPI rate, too. It seems that for a 75dpi and a 300dpi
   // printer the scaling factor is 1.0.
+  //
+  // The worksheet is laid out in the pixels of the printer, not in the ones
+  // of the DC: The DC of a print preview only has the size the preview's
+  // current zoom factor dictates.
   wxSize printPPI;
-  printPPI = GetDC()->GetPPI();
+  GetPPIPrinter(&printPPI.x, &printPPI.y);
   wxLogMessage(_("Printout: Print ppi: %lix%li"),
                static_cast<long>(printPPI.x), static_cast<long>(printPPI.y));
+  wxSize pageSize;
+  GetPageSizePixels(&pageSize.x, &pageSize.y);
+
+  // Breaking the worksheet into pages is what takes long. If nothing it
+  // depends on has changed we can keep the pages we already have.
+  if ((!m_pages.empty()) && (pageSize == m_layoutPageSize) && (printPPI == m_layoutPPI) &&
+      (m_configuration.PrintScale() == m_layoutPrintScale)) {
+    wxLogMessage(_("Printout: Reusing the page breaks we already know"));
+    return;
+  }
+
+  // Measure the text in the units we will draw it in
+  FitThisSizeToPage(pageSize);
 
   double scaleFactor = printPPI.x / DPI_REFERENCE *
     m_configuration.PrintScale();
@@ -251,8 +266,8 @@ void Printout::OnPreparePrinting() {
   //   wxString("Printer Parameters"));
   // dialog.ShowModal();
 
-  int pageWidth, pageHeight;
-  GetDC()->GetSize(&pageWidth, &pageHeight);
+  int pageWidth = pageSize.x;
+  int pageHeight = pageSize.y;
   pageWidth -= m_configuration.PrintMargin_Left() +
     m_configuration.PrintMargin_Right();
   pageHeight -= m_configuration.PrintMargin_Top() +
@@ -270,6 +285,9 @@ void Printout::OnPreparePrinting() {
   m_configuration.LineWidth_em(10000);
   Recalculate();
   BreakPages();
+  m_layoutPageSize = pageSize;
+  m_layoutPPI = printPPI;
+  m_layoutPrintScale = m_configuration.PrintScale();
 }
 
 void Printout::Recalculate() {
@@ -282,15 +300,10 @@ void Printout::Recalculate() {
   m_configuration.SetRecalcContext(*GetDC());
   m_tree->ResetSize();
 
-  int pageWidth, pageHeight;
-  GetPageSizePixels(&pageWidth, &pageHeight);
-
   //  marginX += m_configuration.Scale_Px(m_configuration.GetBaseIndent());
 
-  m_configuration.RecalculateForce();
-  for (GroupCell &group : OnList(m_tree.get()))
-    group.Recalculate();
-
+  // GroupCell::Recalculate() already recalculates its output after breaking
+  // its lines => a single pass suffices.
   m_configuration.RecalculateForce();
   for (GroupCell &group : OnList(m_tree.get()))
     group.Recalculate();
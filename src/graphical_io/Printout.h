@@ -41,9 +41,20 @@
 class Printout : public wxPrintout
 {
 public:
-  Printout(wxString title, GroupCell *tree, double scaleFactor);
+  /*! The constructor
+
+    \param title The title of the print job
+    \param configuration The configuration of the worksheet. The printout
+    takes its settings from it.
+    \param tree The worksheet to print. Is copied.
+    \param scaleFactor The content scale factor of the screen
+  */
+  Printout(wxString title, const Configuration &configuration, GroupCell *tree,
+           double scaleFactor);
 
   /* Determine which cells are the Right places to start a page
+
+     Only lays out the worksheet, but doesn't draw it.
    */
   void BreakPages();
 
@@ -63,10 +74,33 @@ public:
   virtual void OnPreparePrinting() override;
 
 private:
+  //! A page of the printout
+  struct Page
+  {
+    //! The cell we determined to be the right page start
+    const Cell *start;
+    //! The first GroupCell that is drawn on this page
+    GroupCell *firstGroup;
+    //! The last GroupCell that is drawn on this page. NULL = all until the next page break.
+    const GroupCell *lastGroup;
+    //! The y coordinates of the region of the worksheet this page shows
+    wxCoord top, bottom;
+  };
   //! The copy of the worksheet we print
   std::unique_ptr<GroupCell> m_tree;
-  //! The cells we determined to be the right page starts
-  std::vector<const Cell *> m_pages;
+  //! The pages the worksheet has been broken into
+  std::vector<Page> m_pages;
+  /*! The size of the page [in printer pixels] m_pages has been calculated for
+
+    The worksheet is laid out in printer pixels. A print preview renders its
+    pages into DCs of the size the zoom factor dictates: These DCs only get
+    scaled to the page instead of a new layout of the worksheet.
+  */
+  wxSize m_layoutPageSize;
+  //! The PPI rate of the printer m_pages has been calculated for
+  wxSize m_layoutPPI;
+  //! The print scale m_pages has been calculated for
+  double m_layoutPrintScale = -1;
   //! The config that is active during printing
   Configuration m_configuration;
   //! A pointer to m_configuration we can point to
@@ -26,6 +26,7 @@
 */
 
 #include "main.h"
+#include "BatchRenderer.h"
 #include "Maxima.h"
 #include "Dirstructure.h"
 #include "wxMathml.h"
@@ -127,6 +128,17 @@ static const wxCmdLineEntryDesc cmdLineDesc[] = {
    "Run the file and exit afterwards. Halts on questions and stops on "
    "errors.",
    wxCMD_LINE_VAL_NONE, 0},
+  {wxCMD_LINE_OPTION, "", "render",
+   "Render the outputs of the files to images in the directory <str> and exit "
+   "without opening a window.",
+   wxCMD_LINE_VAL_STRING, 0},
+  {wxCMD_LINE_OPTION, "", "render-format",
+   "The format --render writes the images in: png (default) or svg.",
+   wxCMD_LINE_VAL_STRING, 0},
+  {wxCMD_LINE_OPTION, "", "render-cells",
+   "Make --render only render the outputs of the cells with these numbers, "
+   "for example 1,4,7-9.",
+   wxCMD_LINE_VAL_STRING, 0},
   {wxCMD_LINE_SWITCH, "", "logtostderr",
    "Log all \"debug messages\" sidebar messages to stderr, too.",
    wxCMD_LINE_VAL_NONE, 0},
@@ -458,6 +470,41 @@ bool MyApp::OnInit() {
     exit(0);
   }
 
+  wxString renderDir;
+  if (cmdLineParser.Found(wxS("render"), &renderDir)) {
+    wxString format = wxS("png");
+    cmdLineParser.Found(wxS("render-format"), &format);
+    if ((format != wxS("png")) && (format != wxS("svg"))) {
+      wxMessageOutputStderr().Printf("Unknown render format: %s\n", format);
+      exit(1);
+    }
+    BatchRenderer renderer(renderDir, (format == wxS("svg")) ?
+                           BatchRenderer::svg : BatchRenderer::png);
+    wxString cells;
+    if (cmdLineParser.Found(wxS("render-cells"), &cells) &&
+        !renderer.SelectCells(cells)) {
+      wxMessageOutputStderr().Printf("Cannot read the cell list: %s\n", cells);
+      exit(1);
+    }
+    std::vector<wxString> files;
+    if (cmdLineParser.Found(wxS("o"), &file))
+      files.push_back(file);
+    for (unsigned int i = 0; i < cmdLineParser.GetParamCount(); i++)
+      files.push_back(cmdLineParser.GetParam(i));
+    int exitCode = 0;
+    for (const auto &i : files) {
+      wxFileName fileName(i);
+      fileName.MakeAbsolute();
+      if (!renderer.Render(fileName.GetFullPath())) {
+        wxMessageOutputStderr().Printf("Cannot render all outputs of %s\n", i);
+        exitCode = 1;
+      }
+    }
+    wxMessageOutput::Get()->Printf("%li images written\n",
+                                   static_cast<long>(renderer.GetImages()));
+    exit(exitCode);
+  }
+
   if (cmdLineParser.Found(wxS("b"))) {
     evalOnStartup = true;
     exitAfterEval = true;
@@ -25,6 +25,13 @@
   and wxWidgets provides nanoSVG it fails to build with a linker error.
   CMake tests for that before deciding if to include nanoSVG.cpp in the
   wxMaxima sources.
+
+  If it is run it doubles as a benchmark for rasterizing svg plots: It
+  renders the svg files given on the command line (or, if there are none,
+  a generated image that resembles a typical gnuplot plot) both in one piece
+  and split into the parallel bands RasterBands.h provides, and prints the
+  timings. Compile it with something like
+  g++ -O2 -std=c++14 -I. nanoSVGTest.cpp ThreadPool.cpp -o nanoSVGTest -lpthread
 */
 
 /*
@@ -34,16 +41,102 @@
   Appveyor
 */
 #include <stdio.h>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
 #define NANOSVG_IMPLEMENTATION
 #define NANOSVGRAST_IMPLEMENTATION
 #define NANOSVG_ALL_COLOR_KEYWORDS
 #include "nanoSVG/nanosvg.h"
 #include "nanoSVG/nanosvgrast.h"
+#include "RasterBands.h"
+
+//! Creates an svg that resembles what gnuplot's svg terminal generates for a 2d plot
+static std::string GnuplotLikeSvg() {
+  std::string svg =
+    "<svg width=\"600\" height=\"400\" viewBox=\"0 0 600 400\" "
+    "xmlns=\"http://www.w3.org/2000/svg\">\n"
+    "<rect x=\"0\" y=\"0\" width=\"600\" height=\"400\" fill=\"none\"/>\n";
+  // The grid and the tics
+  for (int i = 0; i <= 10; i++) {
+    svg += "<path stroke=\"gray\" stroke-width=\"0.5\" d=\"M" + std::to_string(50 + i * 50) +
+      ",20 L" + std::to_string(50 + i * 50) + ",360\"/>\n";
+    svg += "<path stroke=\"gray\" stroke-width=\"0.5\" d=\"M50," + std::to_string(20 + i * 34) +
+      " L550," + std::to_string(20 + i * 34) + "\"/>\n";
+  }
+  // A few curves with many points each, as plot2d generates them
+  const char *colors[] = {"#0000ff", "#ff0000", "#008000", "#ff00ff"};
+  for (int curve = 0; curve < 4; curve++) {
+    svg += "<path fill=\"none\" stroke=\"" + std::string(colors[curve]) +
+      "\" stroke-width=\"1.5\" d=\"";
+    for (int i = 0; i <= 2000; i++) {
+      double x = 50 + i * 0.25;
+      double y = 190 - 150 * std::sin(i * 0.01 * (curve + 1)) * std::exp(-i * 0.0005 * curve);
+      svg += (i == 0 ? "M" : " L") + std::to_string(x) + "," + std::to_string(y);
+    }
+    svg += "\"/>\n";
+  }
+  // A filled area, as with the "filledcurves" style
+  svg += "<path fill=\"#a0a0ff\" fill-opacity=\"0.5\" d=\"M50,360";
+  for (int i = 0; i <= 500; i++)
+    svg += " L" + std::to_string(50 + i) + "," + std::to_string(360 - 100 * std::fabs(std::sin(i * 0.02)));
+  svg += " L550,360 Z\"/>\n</svg>\n";
+  return svg;
+}
+
+//! Renders image at size width x height in the given number of bands and returns the time in ms
+static double Benchmark(NSVGimage *image, int width, int height, int bands, int repetitions) {
+  std::vector<NSVGrasterizer *> rasterizers;
+  for (int i = 0; i < bands; i++)
+    rasterizers.push_back(nsvgCreateRasterizer());
+  std::vector<unsigned char> rgba(static_cast<std::size_t>(width) * height * 4);
+  float scale = static_cast<float>(width) / image->width;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < repetitions; i++)
+    RasterBands::Rasterize(height, bands, [&](int band, int firstLine, int lines) {
+      nsvgRasterize(rasterizers[band], image, 0, -firstLine, scale,
+                    rgba.data() + static_cast<std::size_t>(firstLine) * width * 4,
+                    width, lines, width * 4);
+    });
+  auto end = std::chrono::steady_clock::now();
+  for (auto rast : rasterizers)
+    nsvgDeleteRasterizer(rast);
+  return std::chrono::duration<double, std::milli>(end - start).count() / repetitions;
+}
+
+static void BenchmarkImage(const char *name, NSVGimage *image) {
+  if (!image) {
+    printf("%s: cannot parse\n", name);
+    return;
+  }
+  const int widths[] = {600, 1200, 2400};
+  for (int width : widths) {
+    int height = static_cast<int>(width * image->height / image->width);
+    int bands = RasterBands::NumberOfBands(width, height);
+    double single = Benchmark(image, width, height, 1, 5);
+    double parallel = Benchmark(image, width, height, bands, 5);
+    printf("%s %ix%i: 1 band %.2f ms, %i bands %.2f ms\n",
+           name, width, height, single, bands, parallel);
+  }
+}
 
 int main(int argc, char* argv[]) {
-  struct NSVGimage* image;
-  image = nsvgParseFromFile("test.svg", "px", 96);
-  WXUNUSED(image);
+  if (argc < 2) {
+    std::string svg = GnuplotLikeSvg();
+    std::vector<char> buffer(svg.begin(), svg.end());
+    buffer.push_back('\0');
+    NSVGimage *image = nsvgParse(buffer.data(), "px", 96);
+    BenchmarkImage("gnuplot-like plot", image);
+    if (image)
+      nsvgDelete(image);
+  }
+  for (int i = 1; i < argc; i++) {
+    NSVGimage *image = nsvgParseFromFile(argv[i], "px", 96);
+    BenchmarkImage(argv[i], image);
+    if (image)
+      nsvgDelete(image);
+  }
   return 0;
 }
-
@@ -33,6 +33,8 @@
 #include <wx/sizer.h>
 #include <wx/dcbuffer.h>
 #include <wx/settings.h>
+#include <wx/time.h>
+#include <unordered_set>
 
 void CharButton::MouseOverTextIs(bool mouseOver) {
   if (m_mouseOverText != mouseOver) {
@@ -67,6 +69,17 @@ void CharButton::MouseLeftText(wxMouseEvent &event) {
   event.Skip();
 }
 
+void CharButton::OnProbeIdle(wxIdleEvent &event) {
+  ProbeQueuedButtons();
+  if (m_renderabilityQueue.empty()) {
+    Disconnect(wxEVT_IDLE, wxIdleEventHandler(CharButton::OnProbeIdle), NULL, this);
+    m_prober = NULL;
+  }
+  else
+    event.RequestMore();
+  event.Skip();
+}
+
 void CharButton::OnIdleEvent(wxIdleEvent &event) {
   Disconnect(wxEVT_IDLE, wxIdleEventHandler(CharButton::OnIdleEvent), NULL, this);
   if (!m_backgroundColorChangeNeeded)
@@ -110,7 +123,7 @@ CharButton::CharButton(wxWindow *parent, wxWindow *worksheet,
                        Configuration *config, const Definition &def,
                        bool forceShow)
   : wxPanel(parent, wxID_ANY), m_char(def.symbol), m_configuration(config),
-    m_description(def.description), m_worksheet(worksheet) {
+    m_description(def.description), m_forceShow(forceShow), m_worksheet(worksheet) {
   Connect(wxEVT_SIZE, wxSizeEventHandler(CharButton::OnSize));
   wxBoxSizer *sizer = new wxBoxSizer(wxHORIZONTAL);
   m_buttonText = new wxStaticText(this, -1, wxString(m_char));
@@ -136,14 +149,48 @@ CharButton::CharButton(wxWindow *parent, wxWindow *worksheet,
   m_buttonText->Connect(wxEVT_LEFT_UP,
                         wxCommandEventHandler(CharButton::CharButtonPressed),
                         NULL, this);
-  if (!(forceShow || m_configuration->FontRendersChar(m_char))) {
-    Hide();
+  if (!ApplyRenderability(false)) {
+    // Finding out if the fonts can render our char is slow: Defer that to
+    // idle time so populating the sidebars doesn't block the startup.
+    m_renderabilityUnknown = true;
+    m_renderabilityQueue.push_back(this);
+    if (!m_prober)
+      ChooseProber();
   }
+}
+
+CharButton::~CharButton() {
+  if (m_renderabilityUnknown)
+    m_renderabilityQueue.remove(this);
+  if (m_prober == this) {
+    m_prober = NULL;
+    ChooseProber();
+  }
+}
+
+void CharButton::ChooseProber() {
+  if (m_renderabilityQueue.empty())
+    return;
+  m_prober = m_renderabilityQueue.front();
+  m_prober->Connect(wxEVT_IDLE, wxIdleEventHandler(CharButton::OnProbeIdle), NULL, m_prober);
+}
 
+bool CharButton::ApplyRenderability(bool probe) {
   wxFont mathFont =
     m_configuration->GetStyle(TS_MATH)->GetFont();
   wxFont textFont =
     m_configuration->GetStyle(TS_CODE_DEFAULT)->GetFont();
+  if (!probe) {
+    if ((!m_forceShow && !Configuration::FontRenderabilityKnown(m_char)) ||
+        (mathFont.IsOk() && !Configuration::FontRenderabilityKnown(m_char, mathFont)) ||
+        (textFont.IsOk() && !Configuration::FontRenderabilityKnown(m_char, textFont)))
+      return false;
+  }
+
+  if (!(m_forceShow || m_configuration->FontRendersChar(m_char))) {
+    Hide();
+  }
+
   if (((!mathFont.IsOk()) ||
        m_configuration->FontRendersChar(m_char, mathFont)) ||
       ((!textFont.IsOk()) ||
@@ -155,4 +202,24 @@ CharButton::CharButton(wxWindow *parent, wxWindow *worksheet,
                _("(Might not be displayed correctly in at least one of the "
                  "worksheet fonts)"));
   }
+  return true;
 }
+
+void CharButton::ProbeQueuedButtons() {
+  // Keep each batch short enough not to make the GUI feel sluggish.
+  wxLongLong batchStart = wxGetLocalTimeMillis();
+  std::unordered_set<wxWindow *> changedParents;
+  while ((!m_renderabilityQueue.empty()) && (wxGetLocalTimeMillis() - batchStart < 20)) {
+    CharButton *button = m_renderabilityQueue.front();
+    m_renderabilityQueue.pop_front();
+    button->m_renderabilityUnknown = false;
+    button->ApplyRenderability(true);
+    if (!button->IsShown())
+      changedParents.insert(button->GetParent());
+  }
+  for (auto parent : changedParents)
+    parent->Layout();
+}
+
+std::list<CharButton *> CharButton::m_renderabilityQueue;
+CharButton *CharButton::m_prober = NULL;
@@ -33,6 +33,7 @@
 #include "Configuration.h"
 #include <wx/panel.h>
 #include <wx/stattext.h>
+#include <list>
 
 /*! This class generates a pane containing the last commands that were issued.
 
@@ -57,6 +58,7 @@ public:
   CharButton(wxWindow *parent, wxWindow *worksheet, Configuration *config,
              const Definition &def,
              bool forceShow = false);
+  ~CharButton();
   wxWindow *GetTextObject() const { return m_buttonText; }
 protected:
   wchar_t m_char;
@@ -64,6 +66,8 @@ protected:
   void CharButtonPressed(wxCommandEvent &event);
   void OnSize(wxSizeEvent &event);
   void OnIdleEvent(wxIdleEvent &event);
+  //! Probes the next batch of queued buttons. Connected to m_prober only.
+  void OnProbeIdle(wxIdleEvent &event);
   void MouseOverPanel(wxMouseEvent &event);
   void MouseOverText(wxMouseEvent &event);
   void MouseLeftPanel(wxMouseEvent &event);
@@ -74,6 +78,28 @@ protected:
   wxString m_description;
 
 private:
+  /*! Hides the button or greys it out if our fonts cannot render its char
+
+    \param probe false = Only use what we already know about the fonts and
+    return false, if that isn't enough. true = Draw the char, if necessary.
+  */
+  bool ApplyRenderability(bool probe);
+  //! Finds out about the renderability of the next few queued buttons
+  static void ProbeQueuedButtons();
+  //! Makes the first queued button the one whose idle events drive the probes
+  static void ChooseProber();
+  //! The buttons whose renderability we haven't found out about, yet
+  static std::list<CharButton *> m_renderabilityQueue;
+  /*! The only button whose idle events probe the queued buttons
+
+    If every queued button asked for more idle events they would keep the
+    CPU busy even while there is nothing to do.
+  */
+  static CharButton *m_prober;
+  //! Show this button even if the font cannot render its char?
+  bool m_forceShow;
+  //! True while this button waits in m_renderabilityQueue
+  bool m_renderabilityUnknown = false;
   bool m_mouseOverPanel = false;
   bool m_mouseOverText = false;
   bool m_backgroundColorChangeNeeded = false;
@@ -84,6 +84,9 @@
 #include "Version.h"
 #include "WXMformat.h"
 #include "WXMXformat.h"
+#include "WxmxArchive.h"
+#include "WxmxRecovery.h"
+#include "LayoutCache.h"
 #include "wxMathml.h"
 #include "wxMaxima.h"
 #include <wx/app.h>
@@ -343,6 +346,19 @@ wxMaxima::wxMaxima(wxWindow *parent, int id,
   if(GetWorksheet())
     GetWorksheet()->SetDropTarget(new MyDropTarget(this));
 #endif
+  // Menu commands are handled in TryBefore(). These are the ways the user can
+  // change the worksheet directly.
+  if(GetWorksheet())
+    {
+      GetWorksheet()->Connect(wxEVT_KEY_DOWN, wxEventHandler(wxMaxima::OnWorksheetInput),
+                              NULL, this);
+      GetWorksheet()->Connect(wxEVT_LEFT_DOWN, wxEventHandler(wxMaxima::OnWorksheetInput),
+                              NULL, this);
+      GetWorksheet()->Connect(wxEVT_MIDDLE_UP, wxEventHandler(wxMaxima::OnWorksheetInput),
+                              NULL, this);
+      GetWorksheet()->Connect(SIDEBARKEYEVENT, wxEventHandler(wxMaxima::OnWorksheetInput),
+                              NULL, this);
+    }
 
   StatusMaximaBusy(StatusBar::MaximaStatus::disconnected);
 
@@ -1228,6 +1244,8 @@ wxMaxima::wxMaxima(wxWindow *parent, int id,
           wxCommandEventHandler(wxMaxima::SimplifyMenu), NULL, this);
   Connect(wxID_PRINT, wxEVT_MENU, wxCommandEventHandler(wxMaxima::PrintMenu),
           NULL, this);
+  Connect(wxID_PREVIEW, wxEVT_MENU, wxCommandEventHandler(wxMaxima::PrintMenu),
+          NULL, this);
   Connect(wxID_ZOOM_IN, wxEVT_MENU, wxCommandEventHandler(wxMaxima::EditMenu),
           NULL, this);
   Connect(wxID_ZOOM_OUT, wxEVT_MENU, wxCommandEventHandler(wxMaxima::EditMenu),
@@ -1859,6 +1877,8 @@ void wxMaxima::StartAutoSaveTimer() {
 }
 
 wxMaxima::~wxMaxima() {
+  FinishBackgroundSave(false);
+  m_verifySaveTask.CancelAndWait();
   // If the gnuplot processes still exist we sever bonds with them
   // so they don't inform us about anything if wxMaxima no more
   // exists
@@ -1952,6 +1972,7 @@ bool MyDropTarget::OnDropFiles(wxCoord WXUNUSED(x), wxCoord WXUNUSED(y),
                                const wxArrayString &files) {
   if(!m_wxmax->GetWorksheet())
     return false;
+  m_wxmax->FinishReadingDocument();
 
   bool success = true;
   for(const auto &file:files)
@@ -3886,10 +3907,10 @@ void wxMaxima::VariableActionOperators(const wxString &value) {
             if (innernode) {
               wxString content = innernode->GetContent();
               if ((!content.IsEmpty()) &&
-                  (m_configuration.m_maximaOperators.find(content) ==
-                   m_configuration.m_maximaOperators.end())) {
+                  (m_configuration.MaximaOperators().find(content) ==
+                   m_configuration.MaximaOperators().end())) {
                 if ((content.at(0) > '9') || (content.at(0) < '0')) {
-                  m_configuration.m_maximaOperators[content] = 1;
+                  m_configuration.AddMaximaOperator(content);
                   if (!newOperators.IsEmpty())
                     newOperators += wxS(", ");
                   newOperators += content;
@@ -4160,9 +4181,13 @@ bool wxMaxima::OpenMACFile(const wxString &file, Worksheet *document,
   bool xMaximaFile = file.Lower().EndsWith(wxS(".out"));
 
   // open mac file
-  wxTextFile inputFile(file);
+  std::unique_ptr<Format::DocumentReader> reader(
+    new Format::DocumentReader(std::unique_ptr<wxInputStream>(new wxFFileInputStream(file)),
+                               xMaximaFile ? Format::DocumentReader::xMaxima :
+                               Format::DocumentReader::mac,
+                               &m_configuration));
 
-  if (!inputFile.Open()) {
+  if (!reader->IsOk()) {
     LoggingMessageBox(_("wxMaxima encountered an error loading ") + file,
                       _("Error"), wxOK | wxICON_EXCLAMATION);
     StatusMaximaBusy(StatusBar::MaximaStatus::waiting);
@@ -4173,7 +4198,7 @@ bool wxMaxima::OpenMACFile(const wxString &file, Worksheet *document,
   if (clearDocument)
     document->ClearDocument();
 
-  auto tree = Format::ParseMACFile(inputFile, xMaximaFile, &m_configuration);
+  auto tree = ReadDocumentStart(std::move(reader), clearDocument);
 
   document->InsertGroupCells(std::move(tree), nullptr);
 
@@ -4219,9 +4244,9 @@ bool wxMaxima::OpenWXMFile(const wxString &file, Worksheet *document,
   //  wxWindowUpdateLocker noUpdates(document);
 
   // open wxm file
-  wxTextFile inputFile(file);
+  std::unique_ptr<wxInputStream> inputFile(new wxFFileInputStream(file));
 
-  if (!inputFile.Open()) {
+  if (!inputFile->IsOk()) {
     LoggingMessageBox(_("wxMaxima encountered an error loading ") + file + " " + _("(Maybe a permission problem?)"),
                       _("Error"), wxOK | wxICON_EXCLAMATION);
     StatusMaximaBusy(StatusBar::MaximaStatus::waiting);
@@ -4229,15 +4254,16 @@ bool wxMaxima::OpenWXMFile(const wxString &file, Worksheet *document,
     return false;
   }
 
-  if (inputFile.GetFirstLine() != Format::WXMFirstLine) {
-    inputFile.Close();
+  std::unique_ptr<Format::DocumentReader> reader(
+    new Format::DocumentReader(std::move(inputFile), Format::DocumentReader::wxm,
+                               &m_configuration));
+  if (!reader->IsOk()) {
     LoggingMessageBox(_("wxMaxima encountered an error loading ") + file + " " + _(" (File format (WXM version 1, first line of the file) not recognized)"), // FIXME: The error message could be improved...
                       _("Error"), wxOK | wxICON_EXCLAMATION);
     return false;
   }
 
-  auto tree = Format::ParseWXMFile(inputFile, &m_configuration);
-  inputFile.Close();
+  auto tree = ReadDocumentStart(std::move(reader), clearDocument);
 
   // from here on code is identical for wxm and wxmx
   if (clearDocument) {
@@ -4274,39 +4300,131 @@ bool wxMaxima::OpenWXMFile(const wxString &file, Worksheet *document,
   return true;
 }
 
-wxString wxMaxima::ReadPotentiallyUnclosedTag(wxStringTokenizer &lines,
-                                              wxString firstLine) {
-  wxString result = firstLine + wxS("\n");
-  wxString closingTag = firstLine;
-  m_xmlOpeningTagName.Replace(&closingTag, wxS("</\\1>"));
+std::unique_ptr<GroupCell> wxMaxima::ReadDocumentStart(
+  std::unique_ptr<Format::DocumentReader> &&reader, bool clearDocument) {
+  // The file we read until now belonged to the document we are replacing
+  m_documentReader.reset();
+  m_documentReaderTail = nullptr;
 
-  while (lines.HasMoreTokens()) {
-    wxString line = lines.GetNextToken();
-    if ((line.Contains(wxS("<line"))) || (line.Contains(wxS("</line"))) ||
-        (!line.Contains(wxS("<")))) {
-      // TODO: Handle broken line tags and line tags that are split into lines.
-      result += line + wxS("\n");
-    } else {
-      if (line.Contains(wxS("</")))
-        break;
-      else {
-        if (line.Contains(wxS("<")))
-          result += ReadPotentiallyUnclosedTag(lines, line);
-        else
-          result += line + wxS("\n");
-      }
-    }
+  if (!clearDocument || m_evalOnStartup || m_exitAfterEval) {
+    CellListBuilder<GroupCell> tree;
+    while (!reader->Eof())
+      tree.Append(reader->Read());
+    return tree.TakeHead();
   }
-  if (!m_xmlOpeningTag.Matches(firstLine))
-    return wxEmptyString;
-  else {
-    result += closingTag + wxS("\n");
-    return result;
+
+  auto tree = reader->Read();
+  if (!reader->Eof()) {
+    m_documentReader = std::move(reader);
+    if (tree)
+      m_documentReaderTail = tree->last();
   }
+  return tree;
+}
+
+void wxMaxima::ReadDocumentPart() {
+  if (!m_documentReader)
+    return;
+  auto cells = m_documentReader->Read();
+  if (m_documentReader->Eof()) {
+    m_documentReader.reset();
+    StatusText(_("File opened"));
+  } else
+    StatusText(wxString::Format(_("Reading the file: %i%%"),
+                                m_documentReader->GetProgress()), false);
+  if (!cells)
+    return;
+
+  // The cells we append are part of the file the user has opened, not edits.
+  Worksheet *worksheet = GetWorksheet();
+  bool saved = worksheet->IsSaved();
+  GroupCell *where = m_documentReaderTail;
+  if (!where)
+    where = worksheet->GetLastCellInWorksheet();
+  m_documentReaderTail = worksheet->InsertGroupCells(std::move(cells), where, nullptr);
+  worksheet->SetSaved(saved);
+  m_scheduleUpdateToc = true;
 }
 
-wxRegEx wxMaxima::m_xmlOpeningTagName(wxS(".*<([a-zA-Z0-9_]*)[ >].*"));
-wxRegEx wxMaxima::m_xmlOpeningTag(wxS("<[^/].*>"));
+void wxMaxima::FinishReadingDocument() {
+  if (!m_documentReader)
+    return;
+  wxBusyCursor crs;
+  while (m_documentReader)
+    ReadDocumentPart();
+}
+
+void wxMaxima::OnWorksheetInput(wxEvent &event) {
+  FinishReadingDocument();
+  event.Skip();
+}
+
+bool wxMaxima::TryBefore(wxEvent &event) {
+  if (m_documentReader) {
+    wxEventType type = event.GetEventType();
+    if ((type == wxEVT_MENU) || (type == wxEVT_BUTTON) ||
+        (type == wxEVT_FIND) || (type == wxEVT_FIND_NEXT) ||
+        (type == wxEVT_FIND_REPLACE) || (type == wxEVT_FIND_REPLACE_ALL))
+      FinishReadingDocument();
+  }
+  return wxMaximaFrame::TryBefore(event);
+}
+
+std::string wxMaxima::RecoverWXMXContents(wxInputStream &contents) {
+  WxmxRecovery recovery;
+  std::vector<char> buffer(1 << 16);
+  while (contents.IsOk() && !contents.Eof()) {
+    contents.Read(buffer.data(), buffer.size());
+    recovery.Feed(buffer.data(), contents.LastRead());
+  }
+  std::string recovered = recovery.Finish();
+  if (recovered.empty())
+    return recovered;
+
+  wxString report;
+  std::size_t reported = 0;
+  for (const auto &loss : recovery.GetLosses()) {
+    wxString where;
+    if (loss.cell > 0)
+      where = wxString::Format(_("Cell %li: "), static_cast<long>(loss.cell));
+    wxString element = wxString::FromUTF8(loss.element.c_str());
+    wxString what;
+    switch (loss.kind) {
+    case WxmxRecovery::Loss::output:
+      what = _("The output was incomplete and has been dropped.");
+      break;
+    case WxmxRecovery::Loss::emptyCell:
+      what = _("Nothing of this cell could be read.");
+      break;
+    case WxmxRecovery::Loss::unclosed:
+      what = wxString::Format(_("The <%s> tag wasn't closed."), element);
+      break;
+    case WxmxRecovery::Loss::strayEndTag:
+      what = wxString::Format(_("A </%s> tag that didn't close anything has been dropped."),
+                              element);
+      break;
+    case WxmxRecovery::Loss::badMarkup:
+      what = _("Broken XML markup has been dropped.");
+      break;
+    case WxmxRecovery::Loss::badChar:
+      what = _("Characters that weren't valid have been replaced.");
+      break;
+    }
+    if (loss.count > 1)
+      what += wxString::Format(_(" (%li times)"), static_cast<long>(loss.count));
+    wxLogMessage(_("Recovering a damaged .wxmx file: %s"), where + what);
+    // Don't make the message box higher than the screen
+    if (reported++ < 20)
+      report += where + what + wxS("\n");
+  }
+  if (reported > 20)
+    report += wxString::Format(_("...and %li more problems (see the log window)\n"),
+                               static_cast<long>(reported - 20));
+  if (!report.IsEmpty())
+    LoggingMessageBox(_("The file was damaged. wxMaxima has recovered what it could:\n\n") +
+                      report, _("Warning"), wxOK | wxICON_WARNING);
+  return recovered;
+}
 
 bool wxMaxima::OpenWXMXFile(const wxString &file, Worksheet *document,
                             bool clearDocument) {
@@ -4333,6 +4451,7 @@ bool wxMaxima::OpenWXMXFile(const wxString &file, Worksheet *document,
   //    an entry that creates valid empty .wxmx files.
   if (wxFile(file, wxFile::read).Eof()) {
     document->ClearDocument();
+    m_documentReader.reset();
     StartMaxima();
 
     if(GetWorksheet())
@@ -4363,132 +4482,33 @@ bool wxMaxima::OpenWXMXFile(const wxString &file, Worksheet *document,
 #endif
 
   if (!xmldoc.IsOk()) {
-    // If we cannot read the file a typical error in old wxMaxima versions was
-    // to include a letter of ascii code 27 in content.xml. Let's filter this
-    // char out.
-
-    wxString contents;
+    // A typical error in old wxMaxima versions was to include a letter of
+    // ascii code 27 in content.xml. Other files might have been cut off or
+    // damaged otherwise. The recovery reads the file only once and fixes
+    // all of these problems at the same time.
+    wxLogMessage(_("Trying to recover a broken .wxmx file."));
+    std::string recovered;
     if (contentsEntry) {
       // Re-open the file.
       wxmxContents.OpenEntry(*contentsEntry);
-      // Read the file into a string
-      wxTextInputStream istream1(wxmxContents, wxS('\t'),
-                                 wxConvAuto(wxFONTENCODING_UTF8));
-      while (!wxmxContents.Eof())
-        contents += istream1.ReadLine() + wxS("\n");
+      recovered = RecoverWXMXContents(wxmxContents);
     } else {
-      wxLogMessage(_("Trying to recover a broken .wxmx file."));
-      // Let's try to recover the uncompressed text from a truncated .zip file
+      // content.xml isn't compressed, so we can try to find it in a .zip
+      // file that is too badly damaged for wxZipInputStream
+      wxLogMessage(_("Trying to extract content.xml out of a broken .zip file."));
       wxFileInputStream input(file);
-      if (input.IsOk()) {
-        wxLogMessage(_("Trying to extract content.xml out of a broken .zip file."));
-        wxTextInputStream text(input, wxS('\t'),
-                               wxConvAuto(wxFONTENCODING_UTF8));
-        while (input.IsOk() && !input.Eof()) {
-          contents = text.ReadLine();
-          if (contents.StartsWith(wxS("<wxMaximaDocument"))) {
-            contents += wxS("\n");
-            break;
-          }
-        }
-        while (input.IsOk() && !input.Eof()) {
-          wxString line = text.ReadLine();
-          if ((!input.Eof()) || (line != wxEmptyString)) {
-            if (line.StartsWith(wxS("</wxMaximaDocument>"))) {
-              contents += wxS("</wxMaximaDocument>\n");
-              break;
-            } else
-              contents += line + wxS("\n");
-          }
-        }
-      }
+      if (input.IsOk())
+        recovered = RecoverWXMXContents(input);
     }
-    // Remove the illegal character
-    contents.Replace(wxS('\u001b'), wxS("\u238B"));
 
-    {
-      // Write the string into a memory buffer
-      wxMemoryOutputStream ostream;
-      wxTextOutputStream txtstrm(ostream);
-      txtstrm.WriteString(contents);
-      wxMemoryInputStream istream(ostream);
-
-      // Try to load the file from the memory buffer.
+    if (!recovered.empty()) {
+      wxMemoryInputStream istream(recovered.data(), recovered.size());
 #if wxCHECK_VERSION(3, 3, 0)
       xmldoc.Load(istream, wxXMLDOC_KEEP_WHITESPACE_NODES);
 #else
       xmldoc.Load(istream, wxS("UTF-8"), wxXMLDOC_KEEP_WHITESPACE_NODES);
 #endif
     }
-
-    // If the xml document still cannot be loaded let's extract only the input
-    // cells.
-    if (!xmldoc.IsOk()) {
-      wxLogMessage(_("Trying to discard all output."));
-      contents.Replace(wxS("><"), wxS(">\n<"));
-      wxStringTokenizer lines(contents, wxS("\n"), wxTOKEN_RET_EMPTY_ALL);
-      wxString contents_inputOnly;
-      while (lines.HasMoreTokens()) {
-        wxString line = lines.GetNextToken();
-        if (line.Contains(wxS("<output"))) {
-          while (lines.HasMoreTokens() && (!line.Contains(wxS("</output>"))))
-            line = lines.GetNextToken();
-        } else {
-          contents_inputOnly += line + wxS("\n");
-        }
-      }
-      contents = contents_inputOnly;
-
-      {
-        // Write the string into a memory buffer
-        wxMemoryOutputStream ostream;
-        wxTextOutputStream txtstrm(ostream);
-        txtstrm.WriteString(contents);
-        wxMemoryInputStream istream(ostream);
-
-        // Try to load the file from the memory buffer.
-#if wxCHECK_VERSION(3, 3, 0)
-        xmldoc.Load(istream, wxXMLDOC_KEEP_WHITESPACE_NODES);
-#else
-        xmldoc.Load(istream, wxS("UTF-8"), wxXMLDOC_KEEP_WHITESPACE_NODES);
-#endif
-      }
-    }
-
-    // If even that cannot be loaded let's try to reconstruct the closing
-    // markers.
-    if (!xmldoc.IsOk()) {
-      wxLogMessage(_("Trying to reconstruct the xml closing markers."));
-      wxStringTokenizer lines(contents, wxS("\n"), wxTOKEN_RET_EMPTY_ALL);
-      wxString contents_reconstructed;
-      wxString line;
-      while (lines.HasMoreTokens() &&
-             (!line.Contains(wxS("<wxMaximaDocument")))) {
-        line = lines.GetNextToken();
-        contents_reconstructed += line;
-      }
-      while (lines.HasMoreTokens()) {
-        line = lines.GetNextToken();
-        if (line.Contains(wxS("<cell")))
-          contents_reconstructed += ReadPotentiallyUnclosedTag(lines, line);
-      }
-      contents_reconstructed += wxS("</wxMaximaDocument>\n");
-      contents = contents_reconstructed;
-      {
-        // Write the string into a memory buffer
-        wxMemoryOutputStream ostream;
-        wxTextOutputStream txtstrm(ostream);
-        txtstrm.WriteString(contents);
-        wxMemoryInputStream istream(ostream);
-
-        // Try to load the file from the memory buffer.
-#if wxCHECK_VERSION(3, 3, 0)
-        xmldoc.Load(istream, wxXMLDOC_KEEP_WHITESPACE_NODES);
-#else
-        xmldoc.Load(istream, wxS("UTF-8"), wxXMLDOC_KEEP_WHITESPACE_NODES);
-#endif
-      }
-    }
   }
   if (!xmldoc.IsOk()) {
     LoggingMessageBox(_("wxMaxima cannot read the xml contents of ") + file,
@@ -4551,6 +4571,7 @@ bool wxMaxima::OpenWXMXFile(const wxString &file, Worksheet *document,
   // from here on code is identical for wxm and wxmx
   if (clearDocument) {
     document->ClearDocument();
+    m_documentReader.reset();
     StartMaxima();
     long int zoom = 100;
     if (!(doczoom.ToLong(&zoom)))
@@ -4566,6 +4587,16 @@ bool wxMaxima::OpenWXMXFile(const wxString &file, Worksheet *document,
       GetWorksheet()->m_currentFile = file;
     ResetTitle(true, true);
     document->SetSaved(true);
+    // The central directory already knows content.xml's checksum, so
+    // identifying the document for the layout cache costs nearly nothing.
+    std::shared_ptr<const WxmxArchive> archive = WxmxArchive::Open(file);
+    const wxZipEntry *contents = archive ? archive->GetEntry(wxS("content.xml")) : nullptr;
+    if (contents) {
+      uint32_t crc = contents->GetCrc();
+      int64_t size = contents->GetSize();
+      document->SetDocumentHash(LayoutCache::Hash(&crc, sizeof(crc),
+                                                  LayoutCache::Hash(&size, sizeof(size))));
+    }
   } else
     ResetTitle(false);
 
@@ -4665,6 +4696,7 @@ bool wxMaxima::OpenXML(const wxString &file, Worksheet *document) {
   auto tree = CreateTreeFromXMLNode(xmlcells, file);
 
   document->ClearDocument();
+  m_documentReader.reset();
   StartMaxima();
   document->InsertGroupCells(
                              std::move(tree)); // this also requests a recalculate
@@ -5135,6 +5167,14 @@ void wxMaxima::OnIdle(wxIdleEvent &event) {
       }
   }
 
+  // Read the next part of a file we are opening once the part that is
+  // visible has been laid out.
+  if (m_documentReader) {
+    ReadDocumentPart();
+    event.RequestMore();
+    return;
+  }
+
   // If nothing which is visible has changed nothing that would cause us to need
   // update the menus and toolbars has.
   if (GetWorksheet()->UpdateControlsNeeded()) {
@@ -5289,27 +5329,28 @@ void wxMaxima::PrintMenu(wxCommandEvent &event) {
     return;
   GetWorksheet()->CloseAutoCompletePopup();
 
+  wxPrintDialogData printDialogData;
+  if (m_printData)
+    printDialogData.SetPrintData(*m_printData);
+  wxString title(_("wxMaxima document"));
+
+  if (GetWorksheet()->m_currentFile.Length()) {
+    wxString suffix;
+    wxFileName::SplitPath(GetWorksheet()->m_currentFile, NULL, NULL, &title,
+                          &suffix);
+    title << wxS(".") << suffix;
+  }
+
   switch (event.GetId()) {
   case wxID_PRINT: {
-    wxPrintDialogData printDialogData;
-    if (m_printData)
-      printDialogData.SetPrintData(*m_printData);
     wxPrinter printer(&printDialogData);
-    wxString title(_("wxMaxima document"));
-
-    if (GetWorksheet()->m_currentFile.Length()) {
-      wxString suffix;
-      wxFileName::SplitPath(GetWorksheet()->m_currentFile, NULL, NULL, &title,
-                            &suffix);
-      title << wxS(".") << suffix;
-    }
-
     {
       // Redraws during printing might end up on paper => temporarily block all
       // redraw events for the console
       //      wxWindowUpdateLocker noUpdates(GetWorksheet());
       wxEventBlocker blocker(GetWorksheet());
-      Printout printout(title, GetWorksheet()->GetTree(), GetContentScaleFactor());
+      Printout printout(title, m_configuration, GetWorksheet()->GetTree(),
+                        GetContentScaleFactor());
       wxBusyCursor crs;
       if (printer.Print(this, &printout, true)) {
         m_printData = std::unique_ptr<wxPrintData>(
@@ -5320,6 +5361,40 @@ void wxMaxima::PrintMenu(wxCommandEvent &event) {
     GetWorksheet()->RequestRedraw();
     break;
   }
+  case wxID_PREVIEW: {
+    // Redraws during rendering the preview might end up on its pages, too
+    // => block all events for the console as long as the preview is open
+    std::shared_ptr<wxEventBlocker> blocker =
+      std::make_shared<wxEventBlocker>(GetWorksheet());
+    // The preview gets a printout to display and one to print from. Both are
+    // copies of the worksheet, so the preview doesn't change if the worksheet
+    // does.
+    wxPrintPreview *preview = new wxPrintPreview(
+      new Printout(title, m_configuration, GetWorksheet()->GetTree(),
+                   GetContentScaleFactor()),
+      new Printout(title, m_configuration, GetWorksheet()->GetTree(),
+                   GetContentScaleFactor()),
+      &printDialogData);
+    if (!preview->IsOk()) {
+      delete preview;
+      LoggingMessageBox(_("Cannot show a print preview. Is a printer set up?"),
+                        _("Print Preview"), wxOK | wxICON_ERROR);
+      break;
+    }
+    wxPreviewFrame *frame = new wxPreviewFrame(preview, this, _("Print Preview"),
+                                               wxDefaultPosition, wxSize(800, 800));
+    frame->Bind(wxEVT_CLOSE_WINDOW, [this, blocker](wxCloseEvent &closeEvent) mutable {
+      blocker.reset();
+      if (GetWorksheet()) {
+        GetWorksheet()->Recalculate();
+        GetWorksheet()->RequestRedraw();
+      }
+      closeEvent.Skip();
+    });
+    frame->Initialize();
+    frame->Show();
+    break;
+  }
   }
 }
 
@@ -5375,10 +5450,12 @@ void wxMaxima::UpdateMenus() {
     m_MenuBar->EnableItem(EventIDs::popid_merge_cells,
                           GetWorksheet()->CanMergeSelection());
     m_MenuBar->EnableItem(wxID_PRINT, true);
+    m_MenuBar->EnableItem(wxID_PREVIEW, true);
   } else {
     m_MenuBar->EnableItem(EventIDs::popid_divide_cell, false);
     m_MenuBar->EnableItem(EventIDs::popid_merge_cells, false);
     m_MenuBar->EnableItem(wxID_PRINT, false);
+    m_MenuBar->EnableItem(wxID_PREVIEW, false);
   }
   double zf = m_configuration.GetZoomFactor();
   if (zf < Configuration::GetMaxZoomFactor())
@@ -5537,7 +5614,13 @@ bool wxMaxima::OpenFile(const wxString &file, const wxString &command) {
     return false;
   }
 
+  // An autosave of the old document might still use its temp file.
+  m_verifySaveTask.CancelAndWait();
+  FinishBackgroundSave();
+  m_documentReader.reset();
   m_lastPath = wxPathOnly(file);
+  // Measures how long it takes until the user sees the first plot.
+  Image::StartFirstPlotTimer();
   wxString unixFilename(file);
 #if defined __WXMSW__
   unixFilename.Replace(wxS("\\"), wxS("/"));
@@ -5667,6 +5750,12 @@ void wxMaxima::OnUpdateTOCEvent(wxCommandEvent &WXUNUSED(event))
 bool wxMaxima::SaveFile(bool forceSave) {
   // Show a busy cursor as long as we export a file.
   wxBusyCursor crs;
+  // Two saves mustn't write the same files at once. On MSW a file that is
+  // still being verified cannot be replaced.
+  m_verifySaveTask.CancelAndWait();
+  FinishBackgroundSave();
+  // Saving only a part of a file we are still reading would truncate it.
+  FinishReadingDocument();
 
   wxString file = GetWorksheet()->m_currentFile;
   wxString fileExt = wxS("wxmx");
@@ -5750,6 +5839,7 @@ bool wxMaxima::SaveFile(bool forceSave) {
         RemoveTempAutosavefile();
         if (file != m_tempfileName)
           GetWorksheet()->m_currentFile = file;
+        StartSaveVerification(file);
       }
     }
 
@@ -6015,6 +6105,11 @@ void wxMaxima::OnTimerEvent(wxTimerEvent &event) {
 bool wxMaxima::AutoSave() {
   if (!SaveNecessary())
     return true;
+  // If the last autosave hasn't finished, yet, or if we are still reading
+  // the file we try again next time.
+  if ((m_backgroundSave && (!m_backgroundSaveTask.Done())) || m_documentReader)
+    return true;
+  FinishBackgroundSave();
 
   bool savedWas = GetWorksheet()->IsSaved();
   wxString oldTempFile = m_tempfileName;
@@ -6025,25 +6120,37 @@ bool wxMaxima::AutoSave() {
 
   /* if the current filename is empty - the file was not saved under a given name - save it using a temporary file name */
   if (m_configuration.AutoSaveAsTempFile() || GetWorksheet()->m_currentFile.IsEmpty()) {
-    bool saved = Format::ExportToWXMX(GetWorksheet()->GetTree(), m_tempfileName,
-                                      &m_configuration,
-                                      &GetWorksheet()->GetCellPointers(),
-                                      m_variablesPane->GetVarnames(),
-                                      GetWorksheet()->GetHCaret());
-    wxFileName m_tempfileName_permissions(m_tempfileName);
-    m_tempfileName_permissions.SetPermissions(wxPOSIX_USER_READ | wxPOSIX_USER_WRITE);
-
     wxLogMessage(_("Autosaving as temp file %s"), m_tempfileName.utf8_str());
-    if ((m_tempfileName != oldTempFile) && saved) {
-      GetWorksheet()->SetSaved(true);
-      if (!oldTempFile.IsEmpty()) {
-        if (wxFileExists(oldTempFile)) {
-          wxLogMessage(_("Trying to remove the old temp file %s"), oldTempFile.utf8_str());
-          wxRemoveFile(oldTempFile);
+    if (m_configuration.UseThreads())
+      StartBackgroundSave(m_tempfileName, true, oldTempFile);
+    else {
+      bool saved = Format::ExportToWXMX(GetWorksheet()->GetTree(), m_tempfileName,
+                                        &m_configuration,
+                                        &GetWorksheet()->GetCellPointers(),
+                                        m_variablesPane->GetVarnames(),
+                                        GetWorksheet()->GetHCaret());
+      wxFileName m_tempfileName_permissions(m_tempfileName);
+      m_tempfileName_permissions.SetPermissions(wxPOSIX_USER_READ | wxPOSIX_USER_WRITE);
+
+      if ((m_tempfileName != oldTempFile) && saved) {
+        GetWorksheet()->SetSaved(true);
+        if (!oldTempFile.IsEmpty()) {
+          if (wxFileExists(oldTempFile)) {
+            wxLogMessage(_("Trying to remove the old temp file %s"), oldTempFile.utf8_str());
+            wxRemoveFile(oldTempFile);
+          }
         }
       }
+      RegisterAutoSaveFile();
     }
-    RegisterAutoSaveFile();
+  } else if (m_configuration.UseThreads() &&
+             GetWorksheet()->m_currentFile.Lower().EndsWith(wxS(".wxmx"))) {
+    wxLogMessage(_("Autosaving the .wxmx file as %s"), GetWorksheet()->m_currentFile.utf8_str());
+    StatusSaveStart();
+    StartBackgroundSave(GetWorksheet()->m_currentFile, false, wxEmptyString);
+    // Edits the user makes while we save mark the worksheet as unsaved again.
+    // If saving fails FinishBackgroundSave() does so, too.
+    savedWas = true;
   } else {
     wxLogMessage(_("Autosaving the .wxmx file as %s"), GetWorksheet()->m_currentFile.utf8_str());
     savedWas = SaveFile(false);
@@ -6057,6 +6164,109 @@ bool wxMaxima::AutoSave() {
   return savedWas;
 }
 
+void wxMaxima::StartBackgroundSave(const wxString &file, bool tempFile,
+                                   const wxString &oldTempFile) {
+  m_verifySaveTask.CancelAndWait();
+  FinishBackgroundSave();
+  FinishReadingDocument();
+  // Creating the snapshot is the only part of saving that needs the worksheet.
+  m_backgroundSave.reset(new BackgroundSave);
+  m_backgroundSave->snapshot =
+    Format::CreateWXMXSnapshot(GetWorksheet()->GetTree(), &m_configuration,
+                               &GetWorksheet()->GetCellPointers(),
+                               m_variablesPane->GetVarnames(),
+                               GetWorksheet()->GetHCaret());
+  m_backgroundSave->file = file;
+  m_backgroundSave->tempFile = tempFile;
+  m_backgroundSave->oldTempFile = oldTempFile;
+  BackgroundSave *save = m_backgroundSave.get();
+  m_backgroundSaveTask = ThreadPool::Get().Submit(ThreadPool::prefetch, [this, save] {
+    std::string invalidXml;
+    save->success = Format::WriteWXMX(*save->snapshot, save->file, save->error,
+                                      invalidXml);
+    save->finished = true;
+    // The result is processed in the GUI thread. If a newer save has been
+    // started in the meantime this one has been processed already.
+    CallAfter([this, save] {
+      if ((m_backgroundSave.get() == save) && save->finished)
+        FinishBackgroundSave();
+    });
+  });
+}
+
+void wxMaxima::FinishBackgroundSave(bool verify) {
+  if (!m_backgroundSave)
+    return;
+  m_backgroundSaveTask.Wait();
+  // Destroys the snapshot in the GUI thread once we are done.
+  std::unique_ptr<BackgroundSave> save = std::move(m_backgroundSave);
+
+  if (save->tempFile) {
+    if (save->success) {
+      wxFileName permissions(save->file);
+      permissions.SetPermissions(wxPOSIX_USER_READ | wxPOSIX_USER_WRITE);
+      if ((!save->oldTempFile.IsEmpty()) && (save->oldTempFile != save->file) &&
+          wxFileExists(save->oldTempFile)) {
+        wxLogMessage(_("Trying to remove the old temp file %s"), save->oldTempFile.utf8_str());
+        wxRemoveFile(save->oldTempFile);
+      }
+      if (m_tempfileName == save->file)
+        RegisterAutoSaveFile();
+    } else {
+      wxLogMessage(_("Autosaving as temp file %s failed: %s"), save->file.utf8_str(),
+                   save->error.utf8_str());
+      // Keep the last temp file that is known to be good
+      if (m_tempfileName == save->file) {
+        if (wxFileExists(save->file))
+          wxRemoveFile(save->file);
+        m_tempfileName = save->oldTempFile;
+      }
+    }
+  } else {
+    if (save->success) {
+      RemoveTempAutosavefile();
+      StatusSaveFinished();
+      if (verify)
+        StartSaveVerification(save->file);
+    } else {
+      wxLogMessage(_("Autosaving %s failed: %s"), save->file.utf8_str(),
+                   save->error.utf8_str());
+      GetWorksheet()->SetSaved(false);
+      ResetTitle(false, true);
+      StatusSaveFailed();
+    }
+  }
+}
+
+void wxMaxima::StartSaveVerification(const wxString &file) {
+  m_verifySaveTask.CancelAndWait();
+  if (!m_configuration.UseThreads() || !m_configuration.VerifySavedFiles())
+    return;
+  ThreadPool::CancellationToken token;
+  m_verifySaveTask = ThreadPool::Get().Submit(ThreadPool::indexing, [this, file, token] {
+    wxString error;
+    if (Format::VerifyWXMX(file, error, token))
+      return;
+    if (token.IsCancelled()) {
+      wxLogMessage(_("The saved file %s hasn't been verified: %s"), file.utf8_str(),
+                   error.utf8_str());
+      return;
+    }
+    CallAfter([this, file, error] {
+      wxLogMessage(_("Verifying the saved file %s failed: %s"), file.utf8_str(),
+                   error.utf8_str());
+      if (GetWorksheet() && (GetWorksheet()->m_currentFile == file)) {
+        GetWorksheet()->SetSaved(false);
+        ResetTitle(false, true);
+      }
+      LoggingMessageBox(wxString::Format(_("The file %s has been saved, but reading "
+                                           "it again failed: %s\nPlease save the "
+                                           "document again."), file, error),
+                        _("Error!"), wxOK | wxICON_ERROR);
+    });
+  }, token);
+}
+
 void wxMaxima::FileMenu(wxCommandEvent &event) {
   if(!GetWorksheet())
     return;
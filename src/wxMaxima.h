@@ -31,9 +31,12 @@
 #ifndef WXMAXIMA_H
 #define WXMAXIMA_H
 
+#include <atomic>
 #include <vector>
 #include "wxMaximaFrame.h"
+#include "WXMformat.h"
 #include "WXMXformat.h"
+#include "ThreadPool.h"
 #include "MathParser.h"
 #include "MaximaIPC.h"
 #include "Dirstructure.h"
@@ -248,13 +251,13 @@ protected:
                   wxString label8 = {}, wxString defaultval8 = {}, wxString tooltip8 = {},
                   wxString label9 = {}, wxString defaultval9 = {}, wxString tooltip9 = {}
     );
-  //! Reads a potentially unclosed XML tag and closes it
-  wxString ReadPotentiallyUnclosedTag(wxStringTokenizer &lines, wxString firstLine);
+  /*! Recovers what can be read from the content.xml of a damaged .wxmx file
 
-  //! Finds the name of an opening tag
-  static wxRegEx m_xmlOpeningTagName;
-  //! Looks if this opening tag is actually complete.
-  static wxRegEx m_xmlOpeningTag;
+    \param contents The uncompressed content.xml, or the whole file, if the
+    .zip archive is too badly damaged to find content.xml in it.
+    \return The recovered document, or an empty string.
+  */
+  std::string RecoverWXMXContents(wxInputStream &contents);
   //! The gnuplot process info
   wxProcess *m_gnuplotProcess = NULL;
   //! Info about the gnuplot process we start for querying the terminals it supports
@@ -263,6 +266,12 @@ protected:
   bool m_isActive = true;
   //! Called when this window is focussed or defocussed.
   void OnFocus(wxFocusEvent &event);
+  /*! Sees every event this window handles before its handlers do
+
+    Reads the rest of the file we are opening before any command, so no
+    command acts on only the part of the document we have read so far.
+  */
+  bool TryBefore(wxEvent &event) override;
 
   //! Forwards the keyboard focus to a text control that might need it
   void PassKeyboardFocus();
@@ -664,6 +673,35 @@ protected:
   //! Opens a wxm file
   bool OpenWXMFile(const wxString &file, Worksheet *document, bool clearDocument = true);
 
+  /*! Reads the first part of a .wxm or .mac file
+
+    If the file is opened as a document of its own the rest of the file is
+    read in the background while the user already sees the first cells.
+    Cells that are inserted into an existing document and documents that
+    are to be evaluated at once are read completely.
+    \return The cells that have been read
+  */
+  std::unique_ptr<GroupCell> ReadDocumentStart(std::unique_ptr<Format::DocumentReader> &&reader,
+                                               bool clearDocument);
+  //! Appends the next part of the file m_documentReader reads to the worksheet
+  void ReadDocumentPart();
+  //! Reads the rest of the file we are opening, if there is one, before a command needs all of it
+  void FinishReadingDocument();
+  /*! Reads the rest of the file we are opening before the user edits the worksheet
+
+    Connected to the events the worksheet changes its contents on. Skips the
+    event, so the worksheet still handles it.
+  */
+  void OnWorksheetInput(wxEvent &event);
+  //! Reads the rest of the .wxm or .mac file we are opening
+  std::unique_ptr<Format::DocumentReader> m_documentReader;
+  /*! The last cell m_documentReader has added to the worksheet
+
+    The next part of the file goes after this cell, not after cells the user
+    might have added to the end of the worksheet meanwhile.
+  */
+  CellPtr<GroupCell> m_documentReaderTail;
+
   //! Opens a wxmx file
   bool OpenWXMXFile(const wxString &file, Worksheet *document, bool clearDocument = true);
 
@@ -838,6 +876,53 @@ private:
 
   //! Starts a single-shot of m_autoSaveTimer.
   void StartAutoSaveTimer();
+
+  //! A save of the worksheet that runs in the background
+  struct BackgroundSave
+  {
+    //! What to save. Only created and destroyed in the GUI thread.
+    std::unique_ptr<Format::WXMXSnapshot> snapshot;
+    //! The file to save to
+    wxString file;
+    //! Is file an autosave temp file instead of the file the user has opened?
+    bool tempFile = false;
+    //! The temp file of the last autosave, to be removed once the save has succeeded
+    wxString oldTempFile;
+    //! The result. Written by the background task.
+    bool success = false;
+    //! What went wrong. Written by the background task.
+    wxString error;
+    /*! Set by the background task once success and error are known
+
+      The task itself counts as done only after its work has returned, which
+      might be after the GUI thread has been told to process the result.
+    */
+    std::atomic<bool> finished{false};
+  };
+  //! The save m_backgroundSaveTask does
+  std::unique_ptr<BackgroundSave> m_backgroundSave;
+  //! Writes m_backgroundSave to disk
+  ThreadPool::Task m_backgroundSaveTask;
+  /*! Saves a snapshot of the worksheet as .wxmx file in the background
+
+    The user can continue editing while the file is written.
+  */
+  void StartBackgroundSave(const wxString &file, bool tempFile, const wxString &oldTempFile);
+  /*! Waits for the background save to end, if there is one, and processes its result
+
+    \param verify false = Don't start checking the saved file in the background,
+    which would need this object after the check.
+  */
+  void FinishBackgroundSave(bool verify = true);
+  //! Reads the .wxmx file we have saved last again and checks its checksums
+  ThreadPool::Task m_verifySaveTask;
+  /*! Checks in the background if all data in a .wxmx file we have saved is intact
+
+    Saving itself only compares the sizes and checksums the archive's
+    directory lists with the data it has written. Does nothing unless
+    Configuration::VerifySavedFiles() is set.
+  */
+  void StartSaveVerification(const wxString &file);
 };
 
 #if wxUSE_DRAG_AND_DROP
@@ -619,6 +619,7 @@ void wxMaximaFrame::SetupFileMenu() {
                      _("Export document to a HTML or LaTeX file"),
                      wxITEM_NORMAL);
   m_FileMenu->AppendSeparator();
+  m_FileMenu->Append(wxID_PREVIEW, _("Print Pre&view..."), _("Show how the document will look like on paper"));
   m_FileMenu->Append(wxID_PRINT, _("&Print...\tCtrl+P"), _("Print document"));
 
   m_FileMenu->AppendSeparator();
@@ -123,6 +123,23 @@ SCENARIO("AFontSize compares") {
   CHECK_COMPARE(size3_4, size1_4,  !,  !, !! );
 }
 
+SCENARIO("AFontSize quantises its value into cache keys") {
+  GIVEN("Two sizes that differ by less than half a size unit") {
+    AFontSize sizeA(20.0f);
+    AFontSize sizeB(20.0f + Size_Unit / 4);
+    THEN("they map to the same key") {
+      REQUIRE(sizeA.GetUnits() == sizeB.GetUnits());
+    }
+  }
+  GIVEN("Two sizes that differ by a size unit") {
+    AFontSize sizeA(20.0f);
+    AFontSize sizeB(20.0f + Size_Unit);
+    THEN("they map to different keys") {
+      REQUIRE(sizeA.GetUnits() != sizeB.GetUnits());
+    }
+  }
+}
+
 SCENARIO("AFontSize is assignable and copy-constructible") {
   AFontSize sizeA;
   sizeA = size1_4;
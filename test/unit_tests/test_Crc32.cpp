@@ -0,0 +1,53 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+#define CATCH_CONFIG_RUNNER
+#include "Crc32.cpp"
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+
+SCENARIO("Crc32 calculates the checksum zip files use") {
+  REQUIRE(Crc32::Compute("", 0) == 0);
+  REQUIRE(Crc32::Compute("123456789", 9) == 0xCBF43926U);
+  const std::string fox = "The quick brown fox jumps over the lazy dog";
+  REQUIRE(Crc32::Compute(fox.data(), fox.size()) == 0x414FA339U);
+}
+
+SCENARIO("Crc32 can calculate the checksum of data that comes in parts") {
+  std::vector<unsigned char> data(1000);
+  for (std::size_t i = 0; i < data.size(); i++)
+    data[i] = static_cast<unsigned char>(i * 7 + i / 13);
+  uint32_t whole = Crc32::Compute(data.data(), data.size());
+  for (std::size_t split = 0; split <= data.size(); split += 37) {
+    uint32_t crc = Crc32::Update(0, data.data(), split);
+    crc = Crc32::Update(crc, data.data() + split, data.size() - split);
+    REQUIRE(crc == whole);
+  }
+}
+
+// If we don't provide our own main when compiling on MinGW
+// we currently get an error message that WinMain@16 is missing
+// (https://github.com/catchorg/Catch2/issues/1287)
+int main(int argc, const char* argv[])
+{
+    return Catch::Session().run(argc, argv);
+}
@@ -0,0 +1,157 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+#define CATCH_CONFIG_RUNNER
+#include "ExportCache.cpp"
+#include "LayoutCache.cpp"
+#include <wx/file.h>
+#include <wx/ffile.h>
+#include <catch2/catch.hpp>
+
+//! A directory that exists as long as the object does
+class TestDirectory
+{
+public:
+  TestDirectory() : m_name(wxFileName::CreateTempFileName(wxS("wxmaxima_test_"))) {
+    wxRemoveFile(m_name);
+    wxMkdir(m_name);
+  }
+  ~TestDirectory() { wxFileName::Rmdir(m_name, wxPATH_RMDIR_RECURSIVE); }
+  const wxString &GetName() const { return m_name; }
+  void Write(const wxString &file, const wxString &contents) const {
+    wxFile out(m_name + wxS("/") + file, wxFile::write);
+    out.Write(contents);
+  }
+  wxString Read(const wxString &file) const {
+    wxString contents;
+    wxFFile in(m_name + wxS("/") + file);
+    in.ReadAll(&contents);
+    return contents;
+  }
+  bool Exists(const wxString &file) const { return wxFileExists(m_name + wxS("/") + file); }
+
+private:
+  wxString m_name;
+};
+
+//! Exports the files as the export of a document would: Reusing what can be reused.
+static std::size_t Export(const TestDirectory &dir,
+                          const std::vector<std::pair<wxString, wxString>> &files) {
+  ExportCache cache(dir.GetName());
+  for (const auto &file : files) {
+    uint64_t key = ExportCache::Key(file.second);
+    if (!cache.Reuse(file.first, key)) {
+      dir.Write(file.first, file.second);
+      cache.Stored(file.first, key);
+    }
+  }
+  REQUIRE(cache.Commit());
+  return cache.GetReused();
+}
+
+SCENARIO("ExportCache keys depend on all parts of the data") {
+  uint64_t key = ExportCache::Key(wxS("png"), ExportCache::Key(wxS("plot")));
+  REQUIRE(key == ExportCache::Key(wxS("png"), ExportCache::Key(wxS("plot"))));
+  REQUIRE(key != ExportCache::Key(wxS("svg"), ExportCache::Key(wxS("plot"))));
+  REQUIRE(key != ExportCache::Key(wxS("png"), ExportCache::Key(wxS("plot2"))));
+}
+
+SCENARIO("ExportCache reuses the files of the last export") {
+  TestDirectory dir;
+  REQUIRE(Export(dir, {{wxS("a.png"), wxS("A")}, {wxS("b.png"), wxS("B")}}) == 0);
+  REQUIRE(dir.Exists(ExportCache::ManifestName()));
+  WHEN("Nothing has changed") {
+    THEN("All files are reused") {
+      REQUIRE(Export(dir, {{wxS("a.png"), wxS("A")}, {wxS("b.png"), wxS("B")}}) == 2);
+      REQUIRE(dir.Read(wxS("a.png")) == wxS("A"));
+      REQUIRE(dir.Read(wxS("b.png")) == wxS("B"));
+    }
+  }
+  WHEN("One file has changed") {
+    THEN("Only the other one is reused") {
+      REQUIRE(Export(dir, {{wxS("a.png"), wxS("A")}, {wxS("b.png"), wxS("C")}}) == 1);
+      REQUIRE(dir.Read(wxS("b.png")) == wxS("C"));
+    }
+  }
+  WHEN("A file has been inserted before the others") {
+    THEN("The old files are reused under their new names") {
+      REQUIRE(Export(dir, {{wxS("a.png"), wxS("New")}, {wxS("b.png"), wxS("A")},
+                           {wxS("c.png"), wxS("B")}}) == 2);
+      REQUIRE(dir.Read(wxS("a.png")) == wxS("New"));
+      REQUIRE(dir.Read(wxS("b.png")) == wxS("A"));
+      REQUIRE(dir.Read(wxS("c.png")) == wxS("B"));
+      AND_THEN("They are reused again by the next export") {
+        REQUIRE(Export(dir, {{wxS("a.png"), wxS("New")}, {wxS("b.png"), wxS("A")},
+                             {wxS("c.png"), wxS("B")}}) == 3);
+      }
+    }
+  }
+  WHEN("A file isn't needed any more") {
+    Export(dir, {{wxS("a.png"), wxS("A")}});
+    THEN("It is deleted") {
+      REQUIRE(dir.Exists(wxS("a.png")));
+      REQUIRE(!dir.Exists(wxS("b.png")));
+    }
+  }
+  WHEN("Somebody else has changed a file") {
+    dir.Write(wxS("b.png"), wxS("Changed"));
+    THEN("It isn't reused") {
+      REQUIRE(Export(dir, {{wxS("a.png"), wxS("A")}, {wxS("b.png"), wxS("B")}}) == 1);
+      REQUIRE(dir.Read(wxS("b.png")) == wxS("B"));
+    }
+  }
+}
+
+SCENARIO("ExportCache remembers the sizes of the images") {
+  TestDirectory dir;
+  {
+    ExportCache cache(dir.GetName());
+    REQUIRE(!cache.Reuse(wxS("a.png"), 1));
+    dir.Write(wxS("a.png"), wxS("A"));
+    cache.Stored(wxS("a.png"), 1, wxSize(640, 480));
+    REQUIRE(cache.Commit());
+  }
+  ExportCache cache(dir.GetName());
+  wxSize size;
+  REQUIRE(cache.Reuse(wxS("b.png"), 1, &size));
+  REQUIRE(size == wxSize(640, 480));
+  REQUIRE(dir.Read(wxS("b.png")) == wxS("A"));
+}
+
+SCENARIO("ExportCache forgets everything if an export doesn't end") {
+  TestDirectory dir;
+  Export(dir, {{wxS("a.png"), wxS("A")}});
+  {
+    ExportCache cancelled(dir.GetName());
+    REQUIRE(!cancelled.Reuse(wxS("a.png"), ExportCache::Key(wxS("Other"))));
+    dir.Write(wxS("a.png"), wxS("B"));
+  }
+  REQUIRE(!dir.Exists(ExportCache::ManifestName()));
+  REQUIRE(Export(dir, {{wxS("a.png"), wxS("B")}}) == 0);
+}
+
+// If we don't provide our own main when compiling on MinGW
+// we currently get an error message that WinMain@16 is missing
+// (https://github.com/catchorg/Catch2/issues/1287)
+int main(int argc, const char* argv[])
+{
+    return Catch::Session().run(argc, argv);
+}
@@ -0,0 +1,90 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+
+#define CATCH_CONFIG_RUNNER
+#include "FontAttribs.cpp"
+#include "FontVariantCache.cpp"
+#include <catch2/catch.hpp>
+
+namespace {
+  //! The n-th of a series of font sizes that all are cached under different keys
+  AFontSize NthSize(std::size_t n) { return AFontSize(8.0f + n * 0.25f); }
+}
+
+SCENARIO("FontVariantCache returns the cached font") {
+  FontVariantCache cache("Sans");
+  wxFont font = cache.GetFont(NthSize(0), false, true, false, false, false);
+  REQUIRE(font.IsOk());
+  REQUIRE(font.GetWeight() == wxFONTWEIGHT_BOLD);
+  REQUIRE(cache.IsCached(NthSize(0), false, true, false, false, false));
+  REQUIRE(!cache.IsCached(NthSize(0), false, false, false, false, false));
+  std::size_t count = FontVariantCache::GetCachedFontCount();
+  cache.GetFont(NthSize(0), false, true, false, false, false);
+  REQUIRE(FontVariantCache::GetCachedFontCount() == count);
+  WHEN("The cache is cleared") {
+    cache.ClearCache();
+    THEN("The font is gone") {
+      REQUIRE(!cache.IsCached(NthSize(0), false, true, false, false, false));
+    }
+  }
+}
+
+SCENARIO("FontVariantCache drops the least recently used fonts of all faces") {
+  FontVariantCache sans("Sans");
+  FontVariantCache serif("Serif");
+  // Fill the cache with fonts of both faces
+  for (std::size_t i = 0; i < FontVariantCache::MaxCachedFonts / 2; i++) {
+    sans.GetFont(NthSize(i), false, false, false, false, false);
+    serif.GetFont(NthSize(i), false, false, false, false, false);
+  }
+  REQUIRE(FontVariantCache::GetCachedFontCount() == FontVariantCache::MaxCachedFonts);
+  // Use the oldest font again, so the second-oldest one is the least recently used
+  sans.GetFont(NthSize(0), false, false, false, false, false);
+
+  WHEN("More fonts are requested than fit into the cache") {
+    for (std::size_t i = 0; i < 3; i++)
+      sans.GetFont(NthSize(i), true, false, false, false, false);
+    THEN("The cache doesn't grow") {
+      REQUIRE(FontVariantCache::GetCachedFontCount() == FontVariantCache::MaxCachedFonts);
+    }
+    THEN("The least recently used fonts are dropped") {
+      REQUIRE(sans.IsCached(NthSize(0), false, false, false, false, false));
+      REQUIRE(!serif.IsCached(NthSize(0), false, false, false, false, false));
+      REQUIRE(!sans.IsCached(NthSize(1), false, false, false, false, false));
+      REQUIRE(!serif.IsCached(NthSize(1), false, false, false, false, false));
+      REQUIRE(sans.IsCached(NthSize(2), false, false, false, false, false));
+      REQUIRE(serif.IsCached(NthSize(2), false, false, false, false, false));
+    }
+    THEN("The new fonts are cached") {
+      for (std::size_t i = 0; i < 3; i++)
+        REQUIRE(sans.IsCached(NthSize(i), true, false, false, false, false));
+    }
+  }
+}
+
+// If we don't provide our own main when compiling on MinGW
+// we currently get an error message that WinMain@16 is missing
+// (https://github.com/catchorg/Catch2/issues/1287)
+int main(int argc, const char* argv[])
+{
+    return Catch::Session().run(argc, argv);
+}
@@ -0,0 +1,91 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+#define CATCH_CONFIG_RUNNER
+#include "GlyphCoverage.cpp"
+#include <wx/mstream.h>
+#include <catch2/catch.hpp>
+
+SCENARIO("GlyphCoverage knows nothing by default") {
+  GlyphCoverage coverage;
+  REQUIRE(coverage.IsEmpty());
+  REQUIRE(coverage.Get(wxUniChar(0x3b1)) == GlyphCoverage::unknown);
+  REQUIRE(coverage.Get(wxUniChar(0x1d400)) == GlyphCoverage::unknown);
+}
+
+SCENARIO("GlyphCoverage remembers what it is told") {
+  GlyphCoverage coverage;
+  coverage.Set(wxUniChar(0x3b1), true);
+  coverage.Set(wxUniChar(0x3b2), false);
+  coverage.Set(wxUniChar(0x1d400), true);
+  REQUIRE(!coverage.IsEmpty());
+  REQUIRE(coverage.Get(wxUniChar(0x3b1)) == GlyphCoverage::renders);
+  REQUIRE(coverage.Get(wxUniChar(0x3b2)) == GlyphCoverage::missing);
+  REQUIRE(coverage.Get(wxUniChar(0x3b3)) == GlyphCoverage::unknown);
+  REQUIRE(coverage.Get(wxUniChar(0x1d400)) == GlyphCoverage::renders);
+  WHEN("A char changes its state") {
+    coverage.Set(wxUniChar(0x3b1), false);
+    THEN("The new state is remembered") {
+      REQUIRE(coverage.Get(wxUniChar(0x3b1)) == GlyphCoverage::missing);
+    }
+  }
+  WHEN("The coverage is cleared") {
+    coverage.Clear();
+    THEN("Nothing is known any more") {
+      REQUIRE(coverage.IsEmpty());
+      REQUIRE(coverage.Get(wxUniChar(0x3b1)) == GlyphCoverage::unknown);
+    }
+  }
+}
+
+SCENARIO("GlyphCoverage survives a round trip through a stream") {
+  GlyphCoverage coverage;
+  coverage.Set(wxUniChar(0x41), true);
+  coverage.Set(wxUniChar(0x222b), false);
+  coverage.Set(wxUniChar(0x1d400), false);
+  wxMemoryOutputStream out;
+  coverage.Write(out);
+
+  wxMemoryInputStream in(out);
+  GlyphCoverage restored;
+  REQUIRE(restored.Read(in));
+  REQUIRE(restored.Get(wxUniChar(0x41)) == GlyphCoverage::renders);
+  REQUIRE(restored.Get(wxUniChar(0x222b)) == GlyphCoverage::missing);
+  REQUIRE(restored.Get(wxUniChar(0x1d400)) == GlyphCoverage::missing);
+  REQUIRE(restored.Get(wxUniChar(0x42)) == GlyphCoverage::unknown);
+}
+
+SCENARIO("GlyphCoverage rejects truncated data") {
+  wxMemoryOutputStream out;
+  out.PutC(0x7f);
+  wxMemoryInputStream in(out);
+  GlyphCoverage restored;
+  REQUIRE(!restored.Read(in));
+  REQUIRE(restored.IsEmpty());
+}
+
+// If we don't provide our own main when compiling on MinGW
+// we currently get an error message that WinMain@16 is missing
+// (https://github.com/catchorg/Catch2/issues/1287)
+int main(int argc, const char* argv[])
+{
+    return Catch::Session().run(argc, argv);
+}
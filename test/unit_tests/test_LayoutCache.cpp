@@ -0,0 +1,98 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+#define CATCH_CONFIG_RUNNER
+#include "LayoutCache.cpp"
+#include <wx/mstream.h>
+#include <catch2/catch.hpp>
+
+SCENARIO("LayoutCache hashes data in parts") {
+  const char data[] = "content.xml";
+  uint64_t whole = LayoutCache::Hash(data, sizeof(data));
+  uint64_t parts = LayoutCache::Hash(data + 4, sizeof(data) - 4, LayoutCache::Hash(data, 4));
+  REQUIRE(whole == parts);
+  REQUIRE(whole != LayoutCache::Hash(data, sizeof(data) - 1));
+}
+
+SCENARIO("LayoutCache finds what it has stored") {
+  LayoutCache cache;
+  REQUIRE(cache.Find(1) == nullptr);
+  cache.Store(1, {10, 20, 30});
+  cache.Store(2, {40});
+  REQUIRE(cache.Find(1) != nullptr);
+  REQUIRE(*cache.Find(1) == LayoutCache::Layout({10, 20, 30}));
+  REQUIRE(*cache.Find(2) == LayoutCache::Layout({40}));
+  REQUIRE(cache.Find(3) == nullptr);
+  WHEN("A layout is stored again") {
+    cache.Store(1, {50});
+    THEN("It replaces the old one") {
+      REQUIRE(cache.Size() == 2);
+      REQUIRE(*cache.Find(1) == LayoutCache::Layout({50}));
+    }
+  }
+}
+
+SCENARIO("LayoutCache drops the least recently used layout") {
+  LayoutCache cache(2);
+  cache.Store(1, {1});
+  cache.Store(2, {2});
+  REQUIRE(cache.Find(1) != nullptr);
+  cache.Store(3, {3});
+  REQUIRE(cache.Size() == 2);
+  REQUIRE(cache.Find(1) != nullptr);
+  REQUIRE(cache.Find(2) == nullptr);
+  REQUIRE(cache.Find(3) != nullptr);
+}
+
+SCENARIO("LayoutCache survives a round trip through a stream") {
+  LayoutCache cache;
+  cache.Store(0x123456789abcdefULL, {1, 2, 3});
+  cache.Store(7, {});
+  wxMemoryOutputStream out;
+  cache.Write(out);
+
+  wxMemoryInputStream in(out);
+  LayoutCache restored;
+  REQUIRE(restored.Read(in));
+  REQUIRE(restored.Size() == 2);
+  REQUIRE(*restored.Find(0x123456789abcdefULL) == LayoutCache::Layout({1, 2, 3}));
+  REQUIRE(restored.Find(7)->empty());
+}
+
+SCENARIO("LayoutCache rejects truncated data") {
+  LayoutCache cache;
+  cache.Store(1, {1, 2, 3});
+  wxMemoryOutputStream out;
+  cache.Write(out);
+  wxMemoryInputStream in(out.GetOutputStreamBuffer()->GetBufferStart(),
+                         out.GetSize() - 1);
+  LayoutCache restored;
+  REQUIRE(!restored.Read(in));
+  REQUIRE(restored.Size() == 0);
+}
+
+// If we don't provide our own main when compiling on MinGW
+// we currently get an error message that WinMain@16 is missing
+// (https://github.com/catchorg/Catch2/issues/1287)
+int main(int argc, const char* argv[])
+{
+    return Catch::Session().run(argc, argv);
+}
@@ -0,0 +1,208 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+#define CATCH_CONFIG_RUNNER
+#include "MaximaTokenizer.cpp"
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <cstdio>
+
+namespace {
+  //! Tokenizes a text from scratch
+  MaximaTokenizer::TokenList Tokenize(const wxString &text) {
+    return MaximaTokenizer(text, NULL).PopTokens();
+  }
+
+  bool SameTokens(const MaximaTokenizer::TokenList &a, const MaximaTokenizer::TokenList &b) {
+    if (a.size() != b.size())
+      return false;
+    for (std::size_t i = 0; i < a.size(); i++)
+      if ((a[i].GetText() != b[i].GetText()) || (a[i].GetTextStyle() != b[i].GetTextStyle()))
+        return false;
+    return true;
+  }
+
+  //! Retokenizes oldText after it has been edited to newText
+  MaximaTokenizer::TokenList Retokenize(const wxString &oldText, const wxString &newText,
+                                        MaximaTokenizer::Change *change = NULL) {
+    MaximaTokenizer::TokenList tokens = Tokenize(oldText);
+    MaximaTokenizer::Change result =
+      MaximaTokenizer::Retokenize(tokens, oldText, newText, NULL);
+    if (change)
+      *change = result;
+    return tokens;
+  }
+
+  //! A code cell of the given number of lines
+  wxString Code(std::size_t lines) {
+    wxString code;
+    for (std::size_t i = 0; i < lines; i++)
+      code += wxString::Format(
+        "f%lu(x, y) := block([a: 1.5e-3, b], /* step %lu */ a + b * sin(x)^2, \"s\")$\n",
+        static_cast<unsigned long>(i), static_cast<unsigned long>(i));
+    return code;
+  }
+}
+
+SCENARIO("Retokenizing gives the same tokens as tokenizing from scratch") {
+  const wxString text = "a: 1$\nb: f\n  (x);\n/* comment */ c: \"string\"$\nd: e+1;\n";
+  const std::vector<wxString> edits = {
+    // Edits within a line
+    "a: 12$\nb: f\n  (x);\n/* comment */ c: \"string\"$\nd: e+1;\n",
+    "a: 1$\nb: f\n  (x);\n/* comment */ c: \"str\"$\nd: e+1;\n",
+    // A word becomes a function name if a "(" is added after it
+    "a: 1$\nb: f\n  x);\n/* comment */ c: \"string\"$\nd: e+1;\n",
+    "a: 1$\nb: g\n  x;\nh\n(c);\n/* comment */ c: \"string\"$\nd: e+1;\n",
+    // A comment or a string that isn't closed extends over the following lines
+    "a: 1$\nb: f\n  (x);\n/* comment  c: \"string\"$\nd: e+1;\n",
+    "a: \"1$\nb: f\n  (x);\n/* comment */ c: \"string\"$\nd: e+1;\n",
+    // Line breaks that are added or deleted
+    "a: 1$b: f\n  (x);\n/* comment */ c: \"string\"$\nd: e+1;\n",
+    "a: 1$\n\nb: f\n  (x);\n/* comment */ c: \"string\"$\nd: e+1;\n",
+    "x\na: 1$\nb: f\n  (x);\n/* comment */ c: \"string\"$\nd: e+1;\n",
+    "a: 1$\nb: f\n  (x);\n/* comment */ c: \"string\"$\nd: e+1;\nx",
+    "a: 1$\nb: f\n  (x);\n/* comment */ c: \"string\"$\nd: e+1;",
+    "",
+    text
+  };
+  for (const auto &edit : edits) {
+    CAPTURE(edit);
+    REQUIRE(SameTokens(Retokenize(text, edit), Tokenize(edit)));
+    REQUIRE(SameTokens(Retokenize(edit, text), Tokenize(text)));
+  }
+}
+
+SCENARIO("Retokenizing replaces only the tokens near the edit") {
+  const wxString text = Code(1000);
+  wxString edited = text;
+  const std::size_t line = text.Find("f500(");
+  edited.insert(line + 8, "z");
+  MaximaTokenizer::Change change;
+  MaximaTokenizer::TokenList tokens = Retokenize(text, edited, &change);
+  REQUIRE(SameTokens(tokens, Tokenize(edited)));
+  // Only the line that contains the edit is re-tokenized
+  REQUIRE(change.removed < 50);
+  REQUIRE(change.removed == change.inserted);
+
+  WHEN("Nothing has changed") {
+    MaximaTokenizer::Change unchanged;
+    Retokenize(text, text, &unchanged);
+    THEN("No token is replaced") {
+      REQUIRE(unchanged.removed == 0);
+      REQUIRE(unchanged.inserted == 0);
+    }
+  }
+}
+
+SCENARIO("The tokenizer classifies characters and words") {
+  const MaximaTokenizer::TokenList tokens =
+    Tokenize(wxS("if x\u00A0then 15e\uFF0D3 else \u03B1\uFF0B\u00BD"));
+  const std::vector<std::pair<wxString, TextStyle>> expected = {
+    {"if", TS_CODE_FUNCTION}, {" ", TS_CODE_DEFAULT}, {"x", TS_CODE_VARIABLE},
+    {" ", TS_CODE_DEFAULT}, {"then", TS_CODE_FUNCTION}, {" ", TS_CODE_DEFAULT},
+    {"15e-3", TS_CODE_NUMBER}, {" ", TS_CODE_DEFAULT}, {"else", TS_CODE_FUNCTION},
+    {" ", TS_CODE_DEFAULT}, {wxS("\u03B1"), TS_CODE_VARIABLE}, {"+", TS_CODE_DEFAULT},
+    {wxS("\u00BD"), TS_CODE_NUMBER}
+  };
+  REQUIRE(tokens.size() == expected.size());
+  for (std::size_t i = 0; i < tokens.size(); i++) {
+    CAPTURE(i);
+    REQUIRE(tokens[i].GetText() == expected[i].first);
+    REQUIRE(tokens[i].GetTextStyle() == expected[i].second);
+  }
+  REQUIRE(MaximaTokenizer::IsAlpha(wxS('\u00B5')));
+  REQUIRE(!MaximaTokenizer::IsAlpha(wxS('\u2212')));
+  REQUIRE(MaximaTokenizer::IsSpace(wxS('\u00A0')));
+  REQUIRE(MaximaTokenizer::IsAlphaNum(wxS('_')));
+  REQUIRE(MaximaTokenizer::IsAlpha(wxUniChar(0x1F600)));
+}
+
+SCENARIO("The tokenizer recognizes lisp code") {
+  const MaximaTokenizer::TokenList tokens =
+    Tokenize(":Lisp-Quiet (print 1)\nto_lisp();(+ 1 2)(to-maxima)a");
+  REQUIRE(tokens.size() == 4);
+  REQUIRE(tokens[0].GetText() == ":Lisp-Quiet (print 1)");
+  REQUIRE(tokens[0].GetTextStyle() == TS_CODE_LISP);
+  REQUIRE(tokens[2].GetText() == "to_lisp();(+ 1 2)(to-maxima)");
+  REQUIRE(tokens[2].GetTextStyle() == TS_CODE_LISP);
+  REQUIRE(tokens[3].GetText() == "a");
+}
+
+// Not run by default. Run "test_MaximaTokenizer [benchmark]" to see the timings.
+TEST_CASE("Per-keystroke tokenizing time against the cell size", "[.][benchmark]") {
+  for (std::size_t lines : {100, 1000, 5000, 20000}) {
+    const wxString text = Code(lines);
+    MaximaTokenizer::TokenList tokens = Tokenize(text);
+    // Type a word in the middle of the cell, char by char
+    wxString current = text;
+    const std::size_t position = text.Find(wxString::Format("f%lu(", static_cast<unsigned long>(lines / 2)));
+    const wxString word = "newvariable";
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < word.Length(); i++) {
+      wxString edited = current;
+      edited.insert(position + i, wxString(word[i]));
+      MaximaTokenizer::Retokenize(tokens, current, edited, NULL);
+      current = edited;
+    }
+    auto end = std::chrono::steady_clock::now();
+    double incremental = std::chrono::duration<double, std::milli>(end - start).count() / word.Length();
+
+    start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < word.Length(); i++)
+      tokens = Tokenize(current);
+    end = std::chrono::steady_clock::now();
+    double full = std::chrono::duration<double, std::milli>(end - start).count() / word.Length();
+
+    REQUIRE(SameTokens(tokens, Tokenize(current)));
+    std::printf("%6lu lines: %8.3f ms per keystroke re-tokenizing, %8.3f ms tokenizing from scratch\n",
+                static_cast<unsigned long>(lines), incremental, full);
+  }
+}
+
+// Not run by default. Run "test_MaximaTokenizer [benchmark]" to see the timings.
+TEST_CASE("Tokenizing a 1 MB script", "[.][benchmark]") {
+  const wxString line = Code(1);
+  wxString script;
+  while (script.Length() < 1000000)
+    script += line;
+
+  const int runs = 10;
+  std::size_t tokens = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < runs; i++)
+    tokens = Tokenize(script).size();
+  auto end = std::chrono::steady_clock::now();
+  double time = std::chrono::duration<double, std::milli>(end - start).count() / runs;
+
+  REQUIRE(tokens > 0);
+  std::printf("%lu chars, %lu tokens: %8.3f ms, %8.3f MB/s\n",
+              static_cast<unsigned long>(script.Length()), static_cast<unsigned long>(tokens),
+              time, script.Length() / 1000.0 / time);
+}
+
+// If we don't provide our own main when compiling on MinGW
+// we currently get an error message that WinMain@16 is missing
+// (https://github.com/catchorg/Catch2/issues/1287)
+int main(int argc, const char* argv[])
+{
+    return Catch::Session().run(argc, argv);
+}
@@ -0,0 +1,98 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+#define CATCH_CONFIG_RUNNER
+#include "Crc32.cpp"
+#include "PngWriter.cpp"
+#include <algorithm>
+#include <vector>
+#include <wx/image.h>
+#include <wx/mstream.h>
+#include <catch2/catch.hpp>
+
+namespace {
+  //! A test pattern: Every pixel has another color
+  std::vector<unsigned char> Pattern(int width, int height) {
+    std::vector<unsigned char> rgb(3 * width * height);
+    for (std::size_t i = 0; i < rgb.size(); i++)
+      rgb[i] = static_cast<unsigned char>(i * 7 + i / 11);
+    return rgb;
+  }
+
+  wxImage Load(wxMemoryOutputStream &out) {
+    if (!wxImage::FindHandler(wxBITMAP_TYPE_PNG))
+      wxImage::AddHandler(new wxPNGHandler);
+    wxMemoryInputStream in(out);
+    return wxImage(in, wxBITMAP_TYPE_PNG);
+  }
+}
+
+SCENARIO("PngWriter writes images wxImage can read") {
+  const int width = 37, height = 23;
+  auto rgb = Pattern(width, height);
+  GIVEN("An image whose lines arrive in parts of different sizes") {
+    wxMemoryOutputStream out;
+    PngWriter png(out, width, height);
+    png.AddLines(rgb.data(), 1);
+    png.AddLines(rgb.data() + 3 * width, 10);
+    png.AddLines(rgb.data() + 3 * width * 11, height - 11);
+    REQUIRE(png.GetMissingLines() == 0);
+    REQUIRE(png.Finish());
+    THEN("The image contains the right pixels") {
+      wxImage image = Load(out);
+      REQUIRE(image.IsOk());
+      REQUIRE(image.GetWidth() == width);
+      REQUIRE(image.GetHeight() == height);
+      REQUIRE(std::vector<unsigned char>(image.GetData(), image.GetData() + rgb.size()) == rgb);
+    }
+  }
+}
+
+SCENARIO("PngWriter writes images that are larger than a chunk") {
+  const int width = 300, height = 400;
+  auto rgb = Pattern(width, height);
+  wxMemoryOutputStream out;
+  PngWriter png(out, width, height, 192);
+  for (int line = 0; line < height; line += 64)
+    png.AddLines(rgb.data() + 3 * width * line, std::min(64, height - line));
+  REQUIRE(png.Finish());
+  REQUIRE(out.GetSize() > PngWriter::ChunkSize);
+  wxImage image = Load(out);
+  REQUIRE(image.IsOk());
+  REQUIRE(std::vector<unsigned char>(image.GetData(), image.GetData() + rgb.size()) == rgb);
+}
+
+SCENARIO("PngWriter reports missing lines") {
+  wxMemoryOutputStream out;
+  PngWriter png(out, 10, 10);
+  auto rgb = Pattern(10, 5);
+  png.AddLines(rgb.data(), 5);
+  REQUIRE(png.GetMissingLines() == 5);
+  REQUIRE(!png.Finish());
+}
+
+// If we don't provide our own main when compiling on MinGW
+// we currently get an error message that WinMain@16 is missing
+// (https://github.com/catchorg/Catch2/issues/1287)
+int main(int argc, const char* argv[])
+{
+    return Catch::Session().run(argc, argv);
+}
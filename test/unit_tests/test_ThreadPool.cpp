@@ -0,0 +1,219 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+#define CATCH_CONFIG_RUNNER
+#include "ThreadPool.cpp"
+#include <catch2/catch.hpp>
+#include <chrono>
+
+SCENARIO("ThreadPool runs all tasks") {
+  ThreadPool pool(3);
+  std::atomic<int> sum(0);
+  std::vector<ThreadPool::Task> tasks;
+  for (int i = 1; i <= 100; i++)
+    tasks.push_back(pool.Submit(ThreadPool::prefetch, [&sum, i] { sum += i; }));
+  for (auto &task : tasks)
+    task.Wait();
+  REQUIRE(sum == 5050);
+  for (auto &task : tasks)
+    REQUIRE(!task.Pending());
+  REQUIRE(pool.GetStatistics().completed == 100);
+}
+
+SCENARIO("Waiting for a task that hasn't started runs it") {
+  ThreadPool pool(1);
+  std::mutex blocker;
+  blocker.lock();
+  // Keep the only worker busy
+  auto busy = pool.Submit(ThreadPool::visible, [&blocker] {
+    const std::lock_guard<std::mutex> lock(blocker);
+  });
+  std::thread::id ranIn;
+  auto task = pool.Submit(ThreadPool::indexing,
+                          [&ranIn] { ranIn = std::this_thread::get_id(); });
+  // Give the worker the chance to pick up the first task
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  task.Wait();
+  REQUIRE(ranIn == std::this_thread::get_id());
+  REQUIRE(pool.GetStatistics().ranInline >= 1);
+  blocker.unlock();
+  busy.Wait();
+}
+
+SCENARIO("Cancelled tasks don't start") {
+  ThreadPool pool(1);
+  std::mutex blocker;
+  blocker.lock();
+  auto busy = pool.Submit(ThreadPool::visible, [&blocker] {
+    const std::lock_guard<std::mutex> lock(blocker);
+  });
+  bool ran = false;
+  auto task = pool.Submit(ThreadPool::prefetch, [&ran] { ran = true; });
+  task.CancelAndWait();
+  blocker.unlock();
+  busy.Wait();
+  REQUIRE(!ran);
+  REQUIRE(pool.GetStatistics().cancelled == 1);
+}
+
+SCENARIO("Urgent tasks overtake less urgent ones") {
+  ThreadPool pool(1);
+  std::mutex blocker;
+  blocker.lock();
+  auto busy = pool.Submit(ThreadPool::visible, [&blocker] {
+    const std::lock_guard<std::mutex> lock(blocker);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  std::mutex orderLock;
+  std::vector<int> order;
+  auto indexing = pool.Submit(ThreadPool::indexing, [&] {
+    const std::lock_guard<std::mutex> lock(orderLock);
+    order.push_back(ThreadPool::indexing);
+  });
+  auto prefetch = pool.Submit(ThreadPool::prefetch, [&] {
+    const std::lock_guard<std::mutex> lock(orderLock);
+    order.push_back(ThreadPool::prefetch);
+  });
+  auto visible = pool.Submit(ThreadPool::visible, [&] {
+    const std::lock_guard<std::mutex> lock(orderLock);
+    order.push_back(ThreadPool::visible);
+  });
+  REQUIRE(pool.GetStatistics().queued[ThreadPool::prefetch] == 1);
+  blocker.unlock();
+  busy.Wait();
+  // Wait for the worker without running the tasks in this thread
+  while (!indexing.Done())
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  REQUIRE(order == std::vector<int>{ThreadPool::visible, ThreadPool::prefetch,
+                                    ThreadPool::indexing});
+  visible.Wait();
+  prefetch.Wait();
+  indexing.Wait();
+}
+
+SCENARIO("Reprioritized tasks run in the order of their new priority") {
+  ThreadPool pool(1);
+  std::mutex blocker;
+  blocker.lock();
+  auto busy = pool.Submit(ThreadPool::visible, [&blocker] {
+    const std::lock_guard<std::mutex> lock(blocker);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  std::mutex orderLock;
+  std::vector<int> order;
+  auto first = pool.Submit(ThreadPool::visible, [&] {
+    const std::lock_guard<std::mutex> lock(orderLock);
+    order.push_back(1);
+  });
+  auto second = pool.Submit(ThreadPool::indexing, [&] {
+    const std::lock_guard<std::mutex> lock(orderLock);
+    order.push_back(2);
+  });
+  first.SetPriority(ThreadPool::indexing);
+  second.SetPriority(ThreadPool::visible);
+  REQUIRE(first.GetPriority() == ThreadPool::indexing);
+  REQUIRE(pool.GetStatistics().queued[ThreadPool::visible] == 1);
+  REQUIRE(pool.GetStatistics().queued[ThreadPool::indexing] == 1);
+  blocker.unlock();
+  busy.Wait();
+  while (!first.Done())
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  REQUIRE(order == std::vector<int>{2, 1});
+  REQUIRE(pool.GetStatistics().reprioritized == 2);
+  first.Wait();
+  second.Wait();
+}
+
+SCENARIO("Reprioritizing tasks while they start keeps the queue counts right") {
+  ThreadPool pool(4);
+  std::vector<ThreadPool::Task> tasks;
+  for (int i = 0; i < 2000; i++)
+    tasks.push_back(pool.Submit(ThreadPool::prefetch, [] {}));
+  // Move the tasks back and forth while the workers are taking them
+  for (int round = 0; round < 4; round++)
+    for (auto &task : tasks)
+      task.SetPriority((round % 2 == 0) ? ThreadPool::visible : ThreadPool::indexing);
+  for (auto &task : tasks)
+    task.Wait();
+  auto statistics = pool.GetStatistics();
+  for (int priority = 0; priority < ThreadPool::NumberOfPriorities; priority++)
+    REQUIRE(statistics.queued[priority] == 0);
+  REQUIRE(statistics.completed == 2000);
+}
+
+SCENARIO("Cancel() tells if the task has been kept from starting") {
+  ThreadPool pool(1);
+  std::mutex blocker;
+  blocker.lock();
+  auto busy = pool.Submit(ThreadPool::visible, [&blocker] {
+    const std::lock_guard<std::mutex> lock(blocker);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  auto task = pool.Submit(ThreadPool::prefetch, [] {});
+  REQUIRE(task.Cancel());
+  REQUIRE(task.Done());
+  REQUIRE(pool.GetStatistics().queued[ThreadPool::prefetch] == 0);
+  // The running task cannot be kept from starting any more
+  REQUIRE(!busy.Cancel());
+  blocker.unlock();
+  busy.Wait();
+}
+
+SCENARIO("Idle workers steal tasks queued for busy ones") {
+  ThreadPool pool(2);
+  std::mutex blocker;
+  blocker.lock();
+  // A worker queues both tasks for itself and then blocks
+  ThreadPool::Task inner;
+  std::mutex innerLock;
+  auto outer = pool.Submit(ThreadPool::visible, [&] {
+    {
+      const std::lock_guard<std::mutex> lock(innerLock);
+      inner = pool.Submit(ThreadPool::prefetch, [] {});
+    }
+    const std::lock_guard<std::mutex> lock(blocker);
+  });
+  while (true) {
+    {
+      const std::lock_guard<std::mutex> lock(innerLock);
+      if (inner.Pending())
+        break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  {
+    const std::lock_guard<std::mutex> lock(innerLock);
+    while (!inner.Done())
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  REQUIRE(pool.GetStatistics().stolen >= 1);
+  blocker.unlock();
+  outer.Wait();
+  inner.Wait();
+}
+
+// If we don't provide our own main when compiling on MinGW
+// we currently get an error message that WinMain@16 is missing
+// (https://github.com/catchorg/Catch2/issues/1287)
+int main(int argc, const char* argv[])
+{
+    return Catch::Session().run(argc, argv);
+}
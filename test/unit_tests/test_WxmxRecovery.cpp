@@ -0,0 +1,160 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+#define CATCH_CONFIG_RUNNER
+#include "WxmxRecovery.cpp"
+#include "XmlStreamChecker.cpp"
+#include <catch2/catch.hpp>
+#include <cstdlib>
+
+//! Recovers a whole document
+static std::string Recover(const std::string &document,
+                           std::vector<WxmxRecovery::Loss> *losses = nullptr) {
+  WxmxRecovery recovery;
+  recovery.Feed(document);
+  std::string recovered = recovery.Finish();
+  if (losses)
+    *losses = recovery.GetLosses();
+  return recovered;
+}
+
+static bool WellFormed(const std::string &document) {
+  XmlStreamChecker checker;
+  checker.Feed(document);
+  return checker.Finish();
+}
+
+static const std::string header = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+static const std::string codeCell =
+  "<cell type=\"code\"><input><editor type=\"input\"><line>a:b&amp;c;</line>"
+  "</editor></input><output><mth><lbl>(%o1) </lbl><v>a</v></mth></output></cell>";
+
+SCENARIO("WxmxRecovery keeps intact documents") {
+  std::string document = header + "<wxMaximaDocument version=\"1.5\">" + codeCell +
+    "</wxMaximaDocument>\n";
+  std::vector<WxmxRecovery::Loss> losses;
+  REQUIRE(Recover(document, &losses) == document);
+  REQUIRE(losses.empty());
+  REQUIRE(Recover("no document here").empty());
+}
+
+SCENARIO("WxmxRecovery salvages truncated documents") {
+  std::string document = header + "<wxMaximaDocument version=\"1.5\">" + codeCell +
+    "<cell type=\"code\"><input><editor type=\"input\"><line>x:1;</line></editor></input>"
+    "<output><mth><lbl>(%o2) </lbl><v>x";
+  std::vector<WxmxRecovery::Loss> losses;
+  std::string recovered = Recover(document, &losses);
+  REQUIRE(WellFormed(recovered));
+  THEN("The input of the cell that was cut off is kept, its output is dropped") {
+    REQUIRE(recovered.find("<line>x:1;</line>") != std::string::npos);
+    REQUIRE(recovered.find("(%o2)") == std::string::npos);
+    REQUIRE(recovered.find("(%o1)") != std::string::npos);
+  }
+  THEN("The losses are reported") {
+    REQUIRE(losses.size() == 3);
+    REQUIRE(losses[0].kind == WxmxRecovery::Loss::output);
+    REQUIRE(losses[0].cell == 2);
+    REQUIRE(losses[1].kind == WxmxRecovery::Loss::unclosed);
+    REQUIRE(losses[1].element == "cell");
+    REQUIRE(losses[2].element == "wxMaximaDocument");
+  }
+}
+
+SCENARIO("WxmxRecovery repairs damaged markup") {
+  std::string document = std::string("PK\x03\x04 garbage <?xml version=\"1.0\"?>") +
+    "<wxMaximaDocument version=\"1.5\" a='1' a='2'>"
+    "<cell type=\"text\"><editor type=\"text\"><line>1 < 2 & \x1b \xff</line></editor></cell>"
+    "</line>"
+    "<cell type=\"code\"><input><editor type=\"input\"><line>y:2;</line></editor></input>"
+    "<output><mth><v>y</v></mth></output>"
+    "<cell type=\"code\"><input><editor type=\"input\"><line>z:3;</line></editor></input>"
+    "<output><mth><v>z</v><bad x=></mth></output></cell>"
+    "</wxMaximaDocument>garbage";
+  std::vector<WxmxRecovery::Loss> losses;
+  std::string recovered = Recover(document, &losses);
+  REQUIRE(WellFormed(recovered));
+  REQUIRE(recovered.find("<wxMaximaDocument version=\"1.5\" a=\"1\">") != std::string::npos);
+  REQUIRE(recovered.find("1 &lt; 2 &amp; \xe2\x8e\x8b \xef\xbf\xbd") != std::string::npos);
+  THEN("A cell that isn't closed before the next one starts keeps its output") {
+    REQUIRE(recovered.find("<v>y</v>") != std::string::npos);
+  }
+  THEN("An output that contains broken markup is dropped") {
+    REQUIRE(recovered.find("<v>z</v>") == std::string::npos);
+    REQUIRE(recovered.find("z:3;") != std::string::npos);
+  }
+  REQUIRE(recovered.find("garbage") == std::string::npos);
+  REQUIRE(!losses.empty());
+  REQUIRE(losses.back().kind == WxmxRecovery::Loss::output);
+  REQUIRE(losses.back().cell == 3);
+}
+
+SCENARIO("WxmxRecovery doesn't depend on how the data is split") {
+  std::string document = header + "<wxMaximaDocument version=\"1.5\">";
+  for (int i = 0; i < 20; i++)
+    document += codeCell + "<!-- comment --><![CDATA[<a & b>]]>\xce\xb1\n";
+  document += "</wxMaximaDocument>\n";
+
+  std::srand(42);
+  for (int i = 0; i < 500; i++) {
+    // Damage the document in a few places
+    std::string damaged = document;
+    int damages = std::rand() % 4;
+    for (int j = 0; j < damages; j++) {
+      std::size_t position = static_cast<std::size_t>(std::rand()) % damaged.size();
+      switch (std::rand() % 3) {
+      case 0:
+        damaged.resize(position);
+        break;
+      case 1:
+        damaged.erase(position, static_cast<std::size_t>(std::rand() % 20));
+        break;
+      default:
+        damaged[position] = static_cast<char>(std::rand());
+      }
+      if (damaged.empty())
+        break;
+    }
+
+    std::vector<WxmxRecovery::Loss> losses;
+    std::string whole = Recover(damaged, &losses);
+    INFO(damaged);
+    REQUIRE((whole.empty() || WellFormed(whole)));
+
+    WxmxRecovery recovery;
+    std::size_t position = 0;
+    while (position < damaged.size()) {
+      std::size_t length = static_cast<std::size_t>(std::rand() % 7);
+      length = std::min(length, damaged.size() - position);
+      recovery.Feed(damaged.data() + position, length);
+      position += length;
+    }
+    REQUIRE(recovery.Finish() == whole);
+    REQUIRE(recovery.GetLosses().size() == losses.size());
+  }
+}
+
+// If we don't provide our own main when compiling on MinGW
+// we currently get an error message that WinMain@16 is missing
+// (https://github.com/catchorg/Catch2/issues/1287)
+int main(int argc, const char* argv[])
+{
+    return Catch::Session().run(argc, argv);
+}
@@ -0,0 +1,101 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2026 wxMaxima Team (https://wxMaxima-developers.github.io/wxmaxima/)
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+#define CATCH_CONFIG_RUNNER
+#include "XmlStreamChecker.cpp"
+#include <catch2/catch.hpp>
+
+//! Checks a whole document
+static bool WellFormed(const std::string &document) {
+  XmlStreamChecker checker;
+  checker.Feed(document);
+  return checker.Finish();
+}
+
+SCENARIO("XmlStreamChecker accepts well-formed documents") {
+  REQUIRE(WellFormed("<a/>"));
+  REQUIRE(WellFormed("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                     "<!--   Created using wxMaxima   -->\n"
+                     "<wxMaximaDocument version=\"1.5\" zoom='100'>\n"
+                     "<cell type=\"code\"><input><editor type=\"input\">"
+                     "<line>a &lt; b &amp;&amp; c &#x3b1; &#945;</line>"
+                     "</editor></input></cell>\n"
+                     "<![CDATA[ <not a tag> ]]]>"
+                     "</wxMaximaDocument >\n"));
+  REQUIRE(WellFormed("<\xce\xb1 \xce\xb2=\"\xe2\x88\x9e\"/>"));
+  // Different tags may have attributes of the same name
+  REQUIRE(WellFormed("<a x='1'><b x='2' xx='3'/></a>"));
+}
+
+SCENARIO("XmlStreamChecker finds errors") {
+  REQUIRE(!WellFormed(""));
+  REQUIRE(!WellFormed("<a>"));
+  REQUIRE(!WellFormed("<a></b>"));
+  REQUIRE(!WellFormed("<a><b></a></b>"));
+  REQUIRE(!WellFormed("<a/><b/>"));
+  REQUIRE(!WellFormed("text<a/>"));
+  REQUIRE(!WellFormed("<a x=1/>"));
+  REQUIRE(!WellFormed("<a x=\"<\"/>"));
+  REQUIRE(!WellFormed("<a x=\"1\"y=\"2\"/>"));
+  REQUIRE(!WellFormed("<a x=\"1\" x=\"2\"/>"));
+  REQUIRE(!WellFormed("<a><b x='1' y='2' x = '3'></b></a>"));
+  REQUIRE(!WellFormed("<a>&nbsp;</a>"));
+  REQUIRE(!WellFormed("<a>&#1;</a>"));
+  REQUIRE(!WellFormed("<a>& b</a>"));
+  REQUIRE(!WellFormed("<a>]]></a>"));
+  REQUIRE(!WellFormed("<a><!-- a -- b --></a>"));
+  REQUIRE(!WellFormed("<a>\x01</a>"));
+  REQUIRE(!WellFormed("<a>\xc3</a>"));
+  REQUIRE(!WellFormed("<a>\xc0\xaf</a>"));
+  REQUIRE(!WellFormed("<a>\xed\xa0\x80</a>"));
+  REQUIRE(!WellFormed("<!DOCTYPE a><a/>"));
+}
+
+SCENARIO("XmlStreamChecker doesn't care how the document is split into chunks") {
+  std::string document =
+    "<doc a=\"&quot;\"><!-- \xe2\x88\x9e --><b>&#x3b1;</b><?pi x?></doc>";
+  for (std::size_t split = 0; split <= document.size(); split++) {
+    XmlStreamChecker checker;
+    checker.Feed(document.substr(0, split));
+    checker.Feed(document.substr(split));
+    REQUIRE(checker.Finish());
+  }
+}
+
+SCENARIO("XmlStreamChecker tells where the error is") {
+  XmlStreamChecker checker;
+  REQUIRE(checker.Feed("<a><b>"));
+  REQUIRE(!checker.Feed("</c>"));
+  REQUIRE(!checker.IsOk());
+  REQUIRE(!checker.GetError().empty());
+  REQUIRE(checker.GetErrorOffset() == 9);
+  // Input after the first error is ignored
+  REQUIRE(!checker.Feed("</b></a>"));
+  REQUIRE(!checker.Finish());
+}
+
+// If we don't provide our own main when compiling on MinGW
+// we currently get an error message that WinMain@16 is missing
+// (https://github.com/catchorg/Catch2/issues/1287)
+int main(int argc, const char* argv[])
+{
+    return Catch::Session().run(argc, argv);
+}